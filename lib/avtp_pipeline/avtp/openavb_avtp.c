@@ -47,6 +47,8 @@ https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
 #include "openavb_avtp.h"
 #include "openavb_rawsock.h"
 #include "openavb_mediaq.h"
+#include "openavb_avtp_rx_demux.h"
+#include "openavb_time.h"
 
 #define	AVB_LOG_COMPONENT	"AVTP"
 #include "openavb_log.h"
@@ -63,21 +65,32 @@ static openavbRC openAvtpSock(avtp_stream_t *pStream)
 	if (pStream->tx) {
 		pStream->rawsock = openavbRawsockOpen(pStream->ifname, FALSE, TRUE, ETHERTYPE_AVTP, pStream->frameLen, pStream->nbuffers);
 	}
+	else if (pStream->bRxDemux) {
+		// Frames come from the demultiplexer shared by all streams on this interface
+		if (openavbAvtpRxDemuxAdd(pStream)) {
+			AVB_RC_RET(OPENAVB_AVTP_SUCCESS);
+		}
+		AVB_RC_LOG_RET(AVB_RC(OPENAVB_AVTP_FAILURE | OPENAVB_RC_RAWSOCK_OPEN));
+	}
 	else {
-#ifndef UBUNTU
-		// This is the normal case for most of our supported platforms
-		pStream->rawsock = openavbRawsockOpen(pStream->ifname, TRUE, FALSE, ETHERTYPE_8021Q, pStream->frameLen, pStream->nbuffers);
-#else
-		pStream->rawsock = openavbRawsockOpen(pStream->ifname, TRUE, FALSE, ETHERTYPE_AVTP, pStream->frameLen, pStream->nbuffers);
-#endif
+		pStream->rawsock = openavbRawsockOpen(pStream->ifname, TRUE, FALSE, AVTP_RX_ETHERTYPE, pStream->frameLen, pStream->nbuffers);
 	}
 
 	if (pStream->rawsock != NULL) {
 		openavbSetRxSignalMode(pStream->rawsock, pStream->bRxSignalMode);
 
+		if (pStream->tx && pStream->bTxLaunchTime) {
+			// Reopened socket; turn launch time back on
+			openavbRawsockTxSetLaunchTime(pStream->rawsock, TRUE);
+		}
+
 		if (!pStream->tx) {
 			// Set the multicast address that we want to receive
 			openavbRawsockRxMulticast(pStream->rawsock, TRUE, pStream->dest_addr.ether_addr_octet);
+
+			if (pStream->bRxTimestamp && !openavbRawsockRxSetTimestamp(pStream->rawsock, TRUE)) {
+				AVB_LOG_WARNING("RX timestamps not supported by the rawsock");
+			}
 		}
 		AVB_RC_RET(OPENAVB_AVTP_SUCCESS);
 	}
@@ -110,6 +123,89 @@ static void processTimestampEval(avtp_stream_t *pStream, U8 *pHdr)
 	AVB_TRACE_EXIT(AVB_TRACE_AVTP_DETAIL);
 }
 
+// Add a frame to the flight recorder of the stream. timeNsec is when it was
+// sent or received (gPTP time).
+static void x_avtpFlightRecord(avtp_stream_t *pStream, U8 *pAvtpFrame, U32 avtpFrameLen, U64 timeNsec, U8 flags)
+{
+	U32 ts = 0;
+	if (avtpFrameLen >= HIDX_AVTP_TIMESPAMP32 + 4 && (pAvtpFrame[HIDX_AVTP_HIDE7_TV1] & 0x01)) {
+		ts = ntohl(*(U32 *)(&pAvtpFrame[HIDX_AVTP_TIMESPAMP32]));
+		flags |= AVTP_FLIGHT_TV;
+		if ((S32)(ts - (U32)timeNsec) < 0) {
+			flags |= AVTP_FLIGHT_LATE;
+		}
+	}
+
+	U32 mqDepth = openavbMediaQDepth(pStream->pMediaQ);
+	openavbAvtpFlightRecord(pStream->pFlight, timeNsec, ts, mqDepth > 0xFFFF ? 0xFFFF : mqDepth,
+		pAvtpFrame[AVTP_SEQ_NUM_OFFSET], flags);
+}
+
+
+static openavbRC fillAvtpHdr(avtp_stream_t *pStream, U8 *pFill)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_AVTP_DETAIL);
+
+	switch (pStream->pMapCB->map_avtp_version_cb()) {
+		default:
+			AVB_RC_LOG_RET(AVB_RC(OPENAVB_AVTP_FAILURE | OPENAVBAVTP_RC_INVALID_AVTP_VERSION));
+		case 0:
+			//
+			// - 1 bit 		cd (control/data indicator)	= 0 (stream data)
+			// - 7 bits 	subtype  					= as configured
+			*pFill++ = pStream->subtype & 0x7F;
+			// - 1 bit 		sv (stream valid)			= 1
+			// - 3 bits 	AVTP version				= binary 000
+			// - 1 bit		mr (media restart)			= toggled when clock changes
+			// - 1 bit		r (reserved)				= 0
+			// - 1 bit		gv (gateway valid)			= 0
+			// - 1 bit		tv (timestamp valid)		= 1
+			// TODO: set mr correctly
+			*pFill++ = 0x81;
+			// - 8 bits		sequence num				= increments with each frame
+			*pFill++ = pStream->avtp_sequence_num;
+			// - 7 bits		reserved					= 0;
+			// - 1 bit		tu (timestamp uncertain)	= 1 when no PTP sync
+			// TODO: set tu correctly
+			*pFill++ = 0;
+			// - 8 bytes    stream_id
+			memcpy(pFill, (U8 *)&pStream->streamIDnet, 8);
+			break;
+	}
+	AVB_RC_TRACE_RET(OPENAVB_AVTP_SUCCESS, AVB_TRACE_AVTP_DETAIL);
+}
+
+// Build the part of the TX frames that is the same in every frame: the
+// Ethernet header, the AVTP common header and whatever the mapping module
+// fills in with map_tx_hdr_cb.
+static openavbRC fillTxHdrTemplate(avtp_stream_t *pStream)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_AVTP);
+
+	openavbRawsockTxFillHdr(pStream->rawsock, pStream->txHdrTemplate, &pStream->ethHdrLen);
+	U8 *pAvtpHdr = pStream->txHdrTemplate + pStream->ethHdrLen;
+	U32 avtpHdrMax = sizeof(pStream->txHdrTemplate) - pStream->ethHdrLen;
+
+	openavbRC rc = fillAvtpHdr(pStream, pAvtpHdr);
+	if (IS_OPENAVB_FAILURE(rc)) {
+		AVB_RC_LOG_TRACE_RET(rc, AVB_TRACE_AVTP);
+	}
+	U32 avtpHdrLen = AVTP_STREAM_ID_OFFSET + 8;
+
+	if (pStream->pMapCB->map_tx_hdr_cb) {
+		U32 mapHdrLen = pStream->pMapCB->map_tx_hdr_cb(pStream->pMediaQ, pAvtpHdr, avtpHdrMax);
+		if (mapHdrLen > avtpHdrMax) {
+			AVB_LOGF_ERROR("Mapping header template too long (%u)", mapHdrLen);
+			AVB_RC_TRACE_RET(OPENAVB_AVTP_FAILURE, AVB_TRACE_AVTP);
+		}
+		if (mapHdrLen > avtpHdrLen) {
+			avtpHdrLen = mapHdrLen;
+		}
+	}
+
+	pStream->txHdrTemplateLen = pStream->ethHdrLen + avtpHdrLen;
+	AVB_RC_TRACE_RET(OPENAVB_AVTP_SUCCESS, AVB_TRACE_AVTP);
+}
 
 /* Initialize AVTP for talking
  */
@@ -125,6 +221,7 @@ openavbRC openavbAvtpTxInit(
 	U16 vlanID,
 	U8  vlanPCP,
 	U16 nbuffers,
+	U32 flightEvents,
 	void **pStream_out)
 {
 	AVB_TRACE_ENTRY(AVB_TRACE_AVTP);
@@ -202,6 +299,36 @@ openavbRC openavbAvtpTxInit(
 	// Set the fwmark - used to steer packets into the right traffic control queue
 	openavbRawsockTxSetMark(pStream->rawsock, fwmark);
 
+	// Build the header template copied into every frame
+	rc = fillTxHdrTemplate(pStream);
+	if (IS_OPENAVB_FAILURE(rc)) {
+		openavbRawsockClose(pStream->rawsock);
+		free(pStream);
+		AVB_RC_LOG_TRACE_RET(rc, AVB_TRACE_AVTP);
+	}
+
+	if (pStream->pMapCB->map_tx_ref_cb) {
+		// Room to hold the media queue item of every frame the rawsock can queue
+		pStream->txRefItemMax = nbuffers > 0 ? nbuffers : 1;
+		pStream->pTxRefItems = calloc(pStream->txRefItemMax, sizeof(media_q_item_t *));
+		if (!pStream->pTxRefItems) {
+			openavbRawsockClose(pStream->rawsock);
+			free(pStream);
+			AVB_RC_LOG_TRACE_RET(AVB_RC(OPENAVB_AVTP_FAILURE | OPENAVB_RC_OUT_OF_MEMORY), AVB_TRACE_AVTP);
+		}
+	}
+
+	if (pStream->pMapCB->map_tx_batch_cb) {
+		// Only worth it if the rawsock can hold more than one frame
+		int txFrameCount = openavbRawsockTxFrameCount(pStream->rawsock);
+		if (txFrameCount > 1) {
+			pStream->txBatchMax = txFrameCount < AVTP_TX_BATCH_MAX ? txFrameCount : AVTP_TX_BATCH_MAX;
+		}
+		AVB_LOGF_DEBUG("TX batch max %u", pStream->txBatchMax);
+	}
+
+	pStream->pFlight = openavbAvtpFlightOpen(streamID, TRUE, flightEvents);
+
 	*pStream_out = (void *)pStream;
 	AVB_RC_TRACE_RET(OPENAVB_AVTP_SUCCESS, AVB_TRACE_AVTP);
 }
@@ -233,7 +360,7 @@ static void inline rxDeliveryStats(avtp_rx_info_t *rxInfo,
 	else if ((tmNow->tv_sec > (rxInfo->lastTime.tv_sec + OPENAVB_AVTP_REPORT_INTERVAL))
 		|| ((tmNow->tv_sec == (rxInfo->lastTime.tv_sec + OPENAVB_AVTP_REPORT_INTERVAL))
 			&& (tmNow->tv_nsec > rxInfo->lastTime.tv_nsec))) {
-		AVB_LOGF_INFO("Stream %d seconds, %lu samples: %lu late, max=%lums, %lu early, max=%lums",
+		AVB_LOGRTF_INFO("Stream %d seconds, %lu samples: %lu late, max=%lums, %lu early, max=%lums",
 			OPENAVB_AVTP_REPORT_INTERVAL, (unsigned long)rxInfo->rxCnt,
 			(unsigned long)rxInfo->lateCnt, (unsigned long)rxInfo->maxLate / NANOSECONDS_PER_MSEC,
 			(unsigned long)rxInfo->earlyCnt, (unsigned long)rxInfo->maxEarly / NANOSECONDS_PER_MSEC);
@@ -253,37 +380,129 @@ static void inline rxDeliveryStats(avtp_rx_info_t *rxInfo,
 }
 #endif
 
-static openavbRC fillAvtpHdr(avtp_stream_t *pStream, U8 *pFill)
+// Get the unmodified timestamp from the mediaq item about to be sent by mapping
+static U64 avtpTxItemTime(avtp_stream_t *pStream)
 {
-	AVB_TRACE_ENTRY(AVB_TRACE_AVTP_DETAIL);
+	U64 timeNsec = 0;
+	media_q_item_t* item = openavbMediaQTailLock(pStream->pMediaQ, true);
+	if (item) {
+		timeNsec = item->pAvtpTime->timeNsec;
+		openavbMediaQTailUnlock(pStream->pMediaQ);
+	}
+	return timeNsec;
+}
 
-	switch (pStream->pMapCB->map_avtp_version_cb()) {
-		default:
-			AVB_RC_LOG_RET(AVB_RC(OPENAVB_AVTP_FAILURE | OPENAVBAVTP_RC_INVALID_AVTP_VERSION));
-		case 0:
-			//
-			// - 1 bit 		cd (control/data indicator)	= 0 (stream data)
-			// - 7 bits 	subtype  					= as configured
-			*pFill++ = pStream->subtype & 0x7F;
-			// - 1 bit 		sv (stream valid)			= 1
-			// - 3 bits 	AVTP version				= binary 000
-			// - 1 bit		mr (media restart)			= toggled when clock changes
-			// - 1 bit		r (reserved)				= 0
-			// - 1 bit		gv (gateway valid)			= 0
-			// - 1 bit		tv (timestamp valid)		= 1
-			// TODO: set mr correctly
-			*pFill++ = 0x81;
-			// - 8 bits		sequence num				= increments with each frame
-			*pFill++ = pStream->avtp_sequence_num;
-			// - 7 bits		reserved					= 0;
-			// - 1 bit		tu (timestamp uncertain)	= 1 when no PTP sync
-			// TODO: set tu correctly
-			*pFill++ = 0;
-			// - 8 bytes    stream_id
-			memcpy(pFill, (U8 *)&pStream->streamIDnet, 8);
-			break;
+// Pick the launch time of the next frame: the item time, but no earlier
+// than the configured lead from now and never closer than the configured
+// spacing to the previous frame. Frames of a whole interval can then be
+// handed over at once and still leave the wire paced. The lead covers the
+// way to the qdisc, as ETF drops frames whose launch time has passed.
+static U64 avtpTxLaunchTime(avtp_stream_t *pStream, U64 itemNsec)
+{
+	U64 nowNsec = 0;
+	CLOCK_GETTIME64(OPENAVB_CLOCK_WALLTIME, &nowNsec);
+	nowNsec += pStream->txLaunchLeadNsec;
+
+	U64 launchNsec = itemNsec > nowNsec ? itemNsec : nowNsec;
+	U64 nextNsec = pStream->lastLaunchNsec + pStream->txLaunchSpacingNsec;
+	if (launchNsec < nextNsec) {
+		launchNsec = nextNsec;
 	}
-	AVB_RC_TRACE_RET(OPENAVB_AVTP_SUCCESS, AVB_TRACE_AVTP_DETAIL);
+
+	pStream->lastLaunchNsec = launchNsec;
+	return launchNsec;
+}
+
+/* Send frames at their launch time
+ */
+bool openavbAvtpTxSetLaunchTime(void *pv, U32 spacingNsec, U32 leadNsec)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_AVTP);
+
+	avtp_stream_t *pStream = (avtp_stream_t *)pv;
+	if (!pStream || !pStream->tx || !pStream->rawsock) {
+		AVB_TRACE_EXIT(AVB_TRACE_AVTP);
+		return FALSE;
+	}
+
+	if (!openavbRawsockTxSetLaunchTime(pStream->rawsock, TRUE)) {
+		AVB_LOG_WARNING("Launch time not supported by the rawsock, sending frames on wakeup");
+		AVB_TRACE_EXIT(AVB_TRACE_AVTP);
+		return FALSE;
+	}
+
+	pStream->bTxLaunchTime = TRUE;
+	pStream->txLaunchSpacingNsec = spacingNsec;
+	pStream->txLaunchLeadNsec = leadNsec;
+	pStream->lastLaunchNsec = 0;
+
+	AVB_TRACE_EXIT(AVB_TRACE_AVTP);
+	return TRUE;
+}
+
+// Time a callback into the histogram, if there is one, between the
+// callback's <probe>_entry and <probe>_return static probes
+#define AVTP_CB_TIMED(pHist, call, probe)						\
+	AVB_TRACE_PROBE1(probe##_entry, pStream);					\
+	if (pHist) {												\
+		U64 cbStartNS, cbEndNS;									\
+		CLOCK_GETTIME64(OPENAVB_CLOCK_MONOTONIC, &cbStartNS);	\
+		call;													\
+		CLOCK_GETTIME64(OPENAVB_CLOCK_MONOTONIC, &cbEndNS);		\
+		openavbHistAdd(pHist, cbEndNS - cbStartNS);				\
+	}															\
+	else {														\
+		call;													\
+	}															\
+	AVB_TRACE_PROBE1(probe##_return, pStream);
+
+static inline void avtpIntfTx(avtp_stream_t *pStream)
+{
+	AVTP_CB_TIMED(pStream->pIntfCBHist, pStream->pIntfCB->intf_tx_cb(pStream->pMediaQ), intf_tx);
+}
+
+static inline void avtpIntfRx(avtp_stream_t *pStream)
+{
+	AVTP_CB_TIMED(pStream->pIntfCBHist, pStream->pIntfCB->intf_rx_cb(pStream->pMediaQ), intf_rx);
+}
+
+// Call the mapping module to fill in the AVTP frame. With map_tx_ref_cb, only
+// the header is filled in and the payload stays in *ppItem.
+static tx_cb_ret_t avtpTxMapCB(avtp_stream_t *pStream, U8 *pAvtpFrame, U32 *pAvtpFrameLen, media_q_item_t **ppItem)
+{
+	*ppItem = NULL;
+	if (pStream->pMapCB->map_tx_ref_cb) {
+		tx_cb_ret_t txCBResult = pStream->pMapCB->map_tx_ref_cb(pStream->pMediaQ, pAvtpFrame, pAvtpFrameLen, ppItem);
+		if (txCBResult != TX_CB_RET_PACKET_NOT_READY && *ppItem) {
+			pStream->bytes += (*ppItem)->dataLen;
+		}
+		return txCBResult;
+	}
+	return pStream->pMapCB->map_tx_cb(pStream->pMediaQ, pAvtpFrame, pAvtpFrameLen);
+}
+
+static tx_cb_ret_t avtpTxMap(avtp_stream_t *pStream, U8 *pAvtpFrame, U32 *pAvtpFrameLen, media_q_item_t **ppItem)
+{
+	tx_cb_ret_t txCBResult;
+	AVTP_CB_TIMED(pStream->pMapCBHist, txCBResult = avtpTxMapCB(pStream, pAvtpFrame, pAvtpFrameLen, ppItem), map_tx);
+	return txCBResult;
+}
+
+// Give back the media queue items referenced by queued frames
+static void avtpTxGiveRefItems(avtp_stream_t *pStream)
+{
+	U32 i;
+	for (i = 0; i < pStream->txRefItemCnt; i++) {
+		openavbMediaQTailItemGive(pStream->pMediaQ, pStream->pTxRefItems[i]);
+	}
+	pStream->txRefItemCnt = 0;
+}
+
+// Send the ready frames; after that their payload is no longer needed
+static void avtpTxSendRef(avtp_stream_t *pStream)
+{
+	openavbRawsockSend(pStream->rawsock);
+	avtpTxGiveRefItems(pStream);
 }
 
 /* Send a frame
@@ -297,69 +516,61 @@ openavbRC openavbAvtpTx(void *pv, bool bSend, bool txBlockingInIntf)
 		AVB_RC_LOG_TRACE_RET(AVB_RC(OPENAVB_AVTP_FAILURE | OPENAVB_RC_INVALID_ARGUMENT), AVB_TRACE_AVTP_DETAIL);
 	}
 
-	U8 * pAvtpFrame,*pFill;
+	U8 *pAvtpFrame;
 	U32 avtpFrameLen, frameLen;
 	tx_cb_ret_t txCBResult = TX_CB_RET_PACKET_NOT_READY;
+	media_q_item_t *pRefItem = NULL;
 
 	// Get a TX buf if we don't already have one.
 	//   (We keep the TX buf in our stream data, so that if we don't
 	//    get data from the mapping module, we can use the buf next time.)
 	if (!pStream->pBuf) {
+		if (pStream->txRefItemMax && pStream->txRefItemCnt >= pStream->txRefItemMax) {
+			// No room to hold another item until the queued frames are sent
+			avtpTxSendRef(pStream);
+		}
 
 		pStream->pBuf = (U8 *)openavbRawsockGetTxFrame(pStream->rawsock, TRUE, &frameLen);
 		if (pStream->pBuf) {
 			assert(frameLen >= pStream->frameLen);
-			// Fill in the Ethernet header
-			openavbRawsockTxFillHdr(pStream->rawsock, pStream->pBuf, &pStream->ethHdrLen);
 		}
 	}
 
 	if (pStream->pBuf) {
 		// AVTP frame starts right after the Ethernet header
-		pAvtpFrame = pFill = pStream->pBuf + pStream->ethHdrLen;
+		pAvtpFrame = pStream->pBuf + pStream->ethHdrLen;
 		avtpFrameLen = pStream->frameLen - pStream->ethHdrLen;
 
-		// Fill the AVTP Header. This must be done before calling the interface and mapping modules.
-		openavbRC rc = fillAvtpHdr(pStream, pFill);
-		if (IS_OPENAVB_FAILURE(rc)) {
-			AVB_RC_LOG_TRACE_RET(rc, AVB_TRACE_AVTP_DETAIL);
-		}
+		// Start from the header template; only the sequence number changes here.
+		// This must be done before calling the interface and mapping modules.
+		memcpy(pStream->pBuf, pStream->txHdrTemplate, pStream->txHdrTemplateLen);
+		pAvtpFrame[AVTP_SEQ_NUM_OFFSET] = pStream->avtp_sequence_num;
 
 		U64 timeNsec = 0;
 
 		if (!txBlockingInIntf) {
 			// Call interface module to read data
-			pStream->pIntfCB->intf_tx_cb(pStream->pMediaQ);
-
-#if IGB_LAUNCHTIME_ENABLED
-			// lets get unmodified timestamp from mediaq item about to be sent by mapping
-			media_q_item_t* item = openavbMediaQTailLock(pStream->pMediaQ, true);
-			if (item) {
-				timeNsec = item->pAvtpTime->timeNsec;
-				openavbMediaQTailUnlock(pStream->pMediaQ);
+			avtpIntfTx(pStream);
+
+			if (IGB_LAUNCHTIME_ENABLED || pStream->bTxLaunchTime) {
+				timeNsec = avtpTxItemTime(pStream);
 			}
-#endif
 
 			// Call mapping module to move data into AVTP frame
-			txCBResult = pStream->pMapCB->map_tx_cb(pStream->pMediaQ, pAvtpFrame, &avtpFrameLen);
+			txCBResult = avtpTxMap(pStream, pAvtpFrame, &avtpFrameLen, &pRefItem);
 
 			pStream->bytes += avtpFrameLen;
 		}
 		else {
 
-#if IGB_LAUNCHTIME_ENABLED
-			// lets get unmodified timestamp from mediaq item about to be sent by mapping
-			media_q_item_t* item = openavbMediaQTailLock(pStream->pMediaQ, true);
-			if (item) {
-				timeNsec = item->pAvtpTime->timeNsec;
-				openavbMediaQTailUnlock(pStream->pMediaQ);
+			if (IGB_LAUNCHTIME_ENABLED || pStream->bTxLaunchTime) {
+				timeNsec = avtpTxItemTime(pStream);
 			}
-#endif
 
 			// Blocking in interface mode. Pull from media queue for tx first
-			if ((txCBResult = pStream->pMapCB->map_tx_cb(pStream->pMediaQ, pAvtpFrame, &avtpFrameLen)) == TX_CB_RET_PACKET_NOT_READY) {
+			if ((txCBResult = avtpTxMap(pStream, pAvtpFrame, &avtpFrameLen, &pRefItem)) == TX_CB_RET_PACKET_NOT_READY) {
 				// Call interface module to read data
-				pStream->pIntfCB->intf_tx_cb(pStream->pMediaQ);
+				avtpIntfTx(pStream);
 			}
 			else {
 				pStream->bytes += avtpFrameLen;
@@ -376,15 +587,44 @@ openavbRC openavbAvtpTx(void *pv, bool bSend, bool txBlockingInIntf)
 
 			// Increment the sequence number now that we are sure this is a good packet.
 			pStream->avtp_sequence_num++;
+			if (pStream->bTxLaunchTime) {
+				timeNsec = avtpTxLaunchTime(pStream, timeNsec);
+			}
+			if (pStream->pFlight) {
+				U64 sentNsec = timeNsec;
+				if (!pStream->bTxLaunchTime) {
+					CLOCK_GETTIME64(OPENAVB_CLOCK_WALLTIME, &sentNsec);
+				}
+				x_avtpFlightRecord(pStream, pAvtpFrame, avtpFrameLen, sentNsec, AVTP_FLIGHT_TX);
+			}
 			// Mark the frame "ready to send".
-			openavbRawsockTxFrameReady(pStream->rawsock, pStream->pBuf, avtpFrameLen + pStream->ethHdrLen, timeNsec);
-			// Send if requested
-			if (bSend)
-				openavbRawsockSend(pStream->rawsock);
+			if (pRefItem) {
+				// The payload is sent from the media queue item, which is held until then
+				openavbRawsockTxFrameReadyRef(pStream->rawsock, pStream->pBuf, avtpFrameLen + pStream->ethHdrLen,
+					pRefItem->pPubData, pRefItem->dataLen, timeNsec);
+				pStream->pTxRefItems[pStream->txRefItemCnt++] = pRefItem;
+			}
+			else {
+				openavbRawsockTxFrameReady(pStream->rawsock, pStream->pBuf, avtpFrameLen + pStream->ethHdrLen, timeNsec);
+			}
 			// Drop our reference to it
 			pStream->pBuf = NULL;
+			// Send if requested
+			if (bSend)
+				avtpTxSendRef(pStream);
 		}
 		else {
+			if (pRefItem) {
+				// Paused; the frame isn't sent
+				openavbMediaQTailItemGive(pStream->pMediaQ, pRefItem);
+			}
+			else if (pStream->txRefItemCnt) {
+				// No data; send what is queued rather than hold media queue
+				// items the interface may be waiting for.
+				if (openavbRawsockRelTxFrame(pStream->rawsock, pStream->pBuf))
+					pStream->pBuf = NULL;
+				avtpTxSendRef(pStream);
+			}
 			AVB_RC_TRACE_RET(OPENAVB_AVTP_FAILURE, AVB_TRACE_AVTP_DETAIL);
 		}
 	}
@@ -395,6 +635,123 @@ openavbRC openavbAvtpTx(void *pv, bool bSend, bool txBlockingInIntf)
 	AVB_RC_TRACE_RET(OPENAVB_AVTP_SUCCESS, AVB_TRACE_AVTP_DETAIL);
 }
 
+/* Send the frames of a transmit interval
+ */
+U32 openavbAvtpTxBatch(void *pv, U32 nFrames)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_AVTP_DETAIL);
+
+	avtp_stream_t *pStream = (avtp_stream_t *)pv;
+	if (!pStream) {
+		AVB_TRACE_EXIT(AVB_TRACE_AVTP_DETAIL);
+		return 0;
+	}
+
+	U32 nSent = 0;
+
+	if (!pStream->txBatchMax) {
+		// One frame at a time
+		while (nSent < nFrames) {
+			if (IS_OPENAVB_FAILURE(openavbAvtpTx(pv, nSent + 1 == nFrames, FALSE)))
+				break;
+			nSent++;
+		}
+		AVB_TRACE_EXIT(AVB_TRACE_AVTP_DETAIL);
+		return nSent;
+	}
+
+	U8 *pFrames[AVTP_TX_BATCH_MAX];
+	U8 *pAvtpFrames[AVTP_TX_BATCH_MAX];
+	U32 avtpFrameLens[AVTP_TX_BATCH_MAX];
+
+	while (nSent < nFrames) {
+		U32 nBufs = nFrames - nSent;
+		if (nBufs > pStream->txBatchMax) {
+			nBufs = pStream->txBatchMax;
+		}
+
+		// Get the TX bufs, only waiting for the first one. Each starts from
+		// the header template with its own sequence number.
+		U32 i, nGot, nFilled;
+		for (nGot = 0; nGot < nBufs; nGot++) {
+			U32 frameLen;
+			U8 *pBuf = (U8 *)openavbRawsockGetTxFrame(pStream->rawsock, nGot == 0, &frameLen);
+			if (!pBuf) {
+				break;
+			}
+			assert(frameLen >= pStream->frameLen);
+
+			memcpy(pBuf, pStream->txHdrTemplate, pStream->txHdrTemplateLen);
+			pFrames[nGot] = pBuf;
+			pAvtpFrames[nGot] = pBuf + pStream->ethHdrLen;
+			pAvtpFrames[nGot][AVTP_SEQ_NUM_OFFSET] = pStream->avtp_sequence_num + nGot;
+			avtpFrameLens[nGot] = pStream->frameLen - pStream->ethHdrLen;
+		}
+		if (!nGot) {
+			break;
+		}
+
+		// Call interface module to read data
+		avtpIntfTx(pStream);
+
+		U64 timeNsec = 0;
+		if (IGB_LAUNCHTIME_ENABLED || pStream->bTxLaunchTime) {
+			timeNsec = avtpTxItemTime(pStream);
+		}
+
+		// Call mapping module to move data into the AVTP frames
+		AVTP_CB_TIMED(pStream->pMapCBHist, nFilled = pStream->pMapCB->map_tx_batch_cb(pStream->pMediaQ, pAvtpFrames, avtpFrameLens, nGot), map_tx);
+		if (nFilled > nGot) {
+			nFilled = nGot;
+		}
+		if (pStream->bPause) {
+			nFilled = 0;
+		}
+
+		// Give back the bufs not filled, last one first as only the last
+		// buf handed out can be released.
+		for (i = nGot; i > nFilled; i--) {
+			openavbRawsockRelTxFrame(pStream->rawsock, pFrames[i - 1]);
+		}
+
+		U64 sentNsec = 0;
+		if (pStream->pFlight && !pStream->bTxLaunchTime) {
+			CLOCK_GETTIME64(OPENAVB_CLOCK_WALLTIME, &sentNsec);
+		}
+
+		for (i = 0; i < nFilled; i++) {
+			if (pStream->tsEval) {
+				processTimestampEval(pStream, pAvtpFrames[i]);
+			}
+
+			pStream->avtp_sequence_num++;
+			pStream->bytes += avtpFrameLens[i];
+
+			U64 launchNsec = timeNsec;
+			if (pStream->bTxLaunchTime) {
+				launchNsec = avtpTxLaunchTime(pStream, timeNsec);
+				sentNsec = launchNsec;
+			}
+			if (pStream->pFlight) {
+				x_avtpFlightRecord(pStream, pAvtpFrames[i], avtpFrameLens[i], sentNsec, AVTP_FLIGHT_TX);
+			}
+			openavbRawsockTxFrameReady(pStream->rawsock, pFrames[i], avtpFrameLens[i] + pStream->ethHdrLen, launchNsec);
+		}
+		nSent += nFilled;
+
+		if (!nFilled) {
+			break;
+		}
+	}
+
+	if (nSent) {
+		openavbRawsockSend(pStream->rawsock);
+	}
+
+	AVB_TRACE_EXIT(AVB_TRACE_AVTP_DETAIL);
+	return nSent;
+}
+
 openavbRC openavbAvtpRxInit(
 	media_q_t *pMediaQ,
 	openavb_map_cb_t *pMapCB,
@@ -404,6 +761,9 @@ openavbRC openavbAvtpRxInit(
 	U8 *daddr,
 	U16 nbuffers,
 	bool rxSignalMode,
+	bool rxDemux,
+	bool rxTimestamp,
+	U32 flightEvents,
 	void **pStream_out)
 {
 	AVB_TRACE_ENTRY(AVB_TRACE_AVTP);
@@ -426,7 +786,6 @@ openavbRC openavbAvtpRxInit(
 		AVB_RC_LOG_TRACE_RET(AVB_RC(OPENAVB_AVTP_FAILURE | OPENAVB_RC_OUT_OF_MEMORY), AVB_TRACE_AVTP);
 	}
 	pStream->tx = FALSE;
-	pStream->nLost = -1;
 
 	pStream->pMediaQ = pMediaQ;
 	pStream->pMapCB = pMapCB;
@@ -453,9 +812,26 @@ openavbRC openavbAvtpRxInit(
 	pStream->ifname = strdup(ifname);
 	pStream->nbuffers = nbuffers;
 	pStream->bRxSignalMode = rxSignalMode;
+	pStream->bRxDemux = rxDemux;
+	pStream->bRxTimestamp = rxTimestamp;
+
+	// Open the recorder before the socket, frames may arrive right away
+	pStream->pFlight = openavbAvtpFlightOpen(streamID, FALSE, flightEvents);
+
+	if (pStream->bRxDemux) {
+		SEM_ERR_T(err);
+		SEM_INIT(pStream->rxDemuxSem, 0, err);
+		SEM_LOG_ERR(err);
+	}
 
 	openavbRC rc = openAvtpSock(pStream);
 	if (IS_OPENAVB_FAILURE(rc)) {
+		if (pStream->bRxDemux) {
+			SEM_ERR_T(err);
+			SEM_DESTROY(pStream->rxDemuxSem, err);
+			SEM_LOG_ERR(err);
+		}
+		openavbAvtpFlightClose(pStream->pFlight);
 		free(pStream);
 		AVB_RC_LOG_TRACE_RET(rc, AVB_TRACE_AVTP);
 	}
@@ -467,11 +843,59 @@ openavbRC openavbAvtpRxInit(
 	AVB_RC_TRACE_RET(OPENAVB_AVTP_SUCCESS, AVB_TRACE_AVTP);
 }
 
-static void x_avtpRxFrame(avtp_stream_t *pStream, U8 *pFrame, U32 frameLen)
+// Publish the margins collected since the last snapshot when the reader
+// asked for a new one, then start over
+static void x_avtpRxMarginSnap(avtp_stream_t *pStream)
+{
+	U32 req = __atomic_load_n(&pStream->rxMarginReq, __ATOMIC_ACQUIRE);
+	if (req == pStream->rxMarginAck) {
+		return;
+	}
+
+	U32 seq = pStream->rxMarginSeq;
+	__atomic_store_n(&pStream->rxMarginSeq, seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	pStream->rxMarginSnap = pStream->rxMargin;
+	__atomic_store_n(&pStream->rxMarginSeq, seq + 2, __ATOMIC_RELEASE);
+
+	pStream->rxMargin.cnt = 0;
+	pStream->rxMarginAck = req;
+}
+
+// Record the margin between the arrival of a frame and its presentation time
+static void x_avtpRxMargin(avtp_stream_t *pStream, U8 *pFrame, U32 frameLen, U64 rxTimeNsec)
+{
+	x_avtpRxMarginSnap(pStream);
+
+	// Only for the common stream header with a valid timestamp
+	if (frameLen < HIDX_AVTP_TIMESPAMP32 + 4 || !(pFrame[HIDX_AVTP_HIDE7_TV1] & 0x01)) {
+		return;
+	}
+
+	U32 ts = ntohl(*(U32 *)(&pFrame[HIDX_AVTP_TIMESPAMP32]));
+	S32 margin = (S32)(ts - (U32)rxTimeNsec);
+	avtp_rx_margin_t *pMargin = &pStream->rxMargin;
+
+	if (pMargin->cnt == 0) {
+		pMargin->min = pMargin->max = margin;
+		pMargin->sum = 0;
+	}
+	else if (margin < pMargin->min) {
+		pMargin->min = margin;
+	}
+	else if (margin > pMargin->max) {
+		pMargin->max = margin;
+	}
+	pMargin->sum += margin;
+	pMargin->cnt++;
+}
+
+static void x_avtpRxFrame(avtp_stream_t *pStream, U8 *pFrame, U32 frameLen, U64 rxTimeNsec)
 {
 	AVB_TRACE_ENTRY(AVB_TRACE_AVTP_DETAIL);
 	IF_LOG_INTERVAL(4096) AVB_LOGF_DEBUG("pFrame=%p, len=%u", pFrame, frameLen);
 	U8 subtype, flags, flags2, rxSeq, nLost, avtpVersion;
+	U8 flightFlags = 0;
 	U8 *pRead = pFrame;
 
 	// AVTP Header
@@ -488,20 +912,32 @@ static void x_avtpRxFrame(avtp_stream_t *pStream, U8 *pFrame, U32 frameLen)
 
 			rxSeq = *pRead++;
 
-			if (pStream->nLost == -1) {
+			if (!pStream->bRxSeqValid) {
 				// first frame received, don't check for mismatch
-				pStream->nLost = 0;
+				pStream->bRxSeqValid = TRUE;
 			}
 			else if (pStream->avtp_sequence_num != rxSeq) {
 				nLost = (rxSeq - pStream->avtp_sequence_num)
 					+ (rxSeq < pStream->avtp_sequence_num ? 256 : 0);
-				AVB_LOGF_INFO("AVTP sequence mismatch: expected: %3u,\tgot: %3u,\tlost %3d",
+				AVB_LOGRTF_INFO("AVTP sequence mismatch: expected: %3u,\tgot: %3u,\tlost %3d",
 					pStream->avtp_sequence_num, rxSeq, nLost);
-				pStream->nLost += nLost;
+				__atomic_add_fetch(&pStream->nLost, nLost, __ATOMIC_RELAXED);
+				if (pStream->pFlight) {
+					flightFlags |= AVTP_FLIGHT_GAP;
+					openavbAvtpFlightGap(pStream->pFlight);
+				}
 			}
 			pStream->avtp_sequence_num = rxSeq + 1;
 
-			pStream->bytes += frameLen;
+			if (pStream->pFlight) {
+				U64 recordNsec = rxTimeNsec;
+				if (!recordNsec) {
+					CLOCK_GETTIME64(OPENAVB_CLOCK_WALLTIME, &recordNsec);
+				}
+				x_avtpFlightRecord(pStream, pFrame, frameLen, recordNsec, flightFlags);
+			}
+
+			__atomic_add_fetch(&pStream->bytes, frameLen, __ATOMIC_RELAXED);
 
 			flags2 = *pRead++;
 			IF_LOG_INTERVAL(4096) AVB_LOGF_DEBUG("subtype=%u, sv=%u, ver=%u, mr=%u, tv=%u tu=%u",
@@ -510,11 +946,16 @@ static void x_avtpRxFrame(avtp_stream_t *pStream, U8 *pFrame, U32 frameLen)
 
 			pRead += 8;
 
+			if (rxTimeNsec) {
+				x_avtpRxMargin(pStream, pFrame, frameLen, rxTimeNsec);
+			}
+
 			if (pStream->tsEval) {
 				processTimestampEval(pStream, pFrame);
 			}
 
-			pStream->pMapCB->map_rx_cb(pStream->pMediaQ, pFrame, frameLen);
+			pStream->pMediaQ->rxTimeNsec = rxTimeNsec;
+			AVTP_CB_TIMED(pStream->pMapCBHist, pStream->pMapCB->map_rx_cb(pStream->pMediaQ, pFrame, frameLen), map_rx);
 
 			// NOTE : This is a redundant call. It is handled in avtpTryRx()
 			// pStream->pIntfCB->intf_rx_cb(pStream->pMediaQ);
@@ -536,6 +977,55 @@ static void x_avtpRxFrame(avtp_stream_t *pStream, U8 *pFrame, U32 frameLen)
 	AVB_TRACE_EXIT(AVB_TRACE_AVTP_DETAIL);
 }
 
+void openavbAvtpRxDemuxFrame(avtp_stream_t *pStream, U8 *pAvtpPdu, U32 avtpPduLen, U64 rxTimeNsec)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_AVTP_DETAIL);
+
+	x_avtpRxFrame(pStream, pAvtpPdu, avtpPduLen, pStream->bRxTimestamp ? rxTimeNsec : 0);
+
+	// Wake up the stream task
+	SEM_ERR_T(err);
+	SEM_POST(pStream->rxDemuxSem, err);
+	SEM_LOG_ERR(err);
+
+	AVB_TRACE_EXIT(AVB_TRACE_AVTP_DETAIL);
+}
+
+/*
+ * Wait for frames delivered by the RX demultiplexer.
+ *
+ * The frames have already been passed to the mapping module by the
+ * demultiplexer thread. This only takes care of the interface module.
+ */
+static void avtpTryRxDemux(avtp_stream_t *pStream)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_AVTP_DETAIL);
+
+	U32 timeout;
+	SEM_ERR_T(err);
+
+	if (!openavbMediaQUsecTillTail(pStream->pMediaQ, &timeout)) {
+		// No mediaQ item available therefore wait for a new packet
+		SEM_TIMEDWAIT_USEC(pStream->rxDemuxSem, AVTP_MAX_BLOCK_USEC, err);
+	}
+	else if (timeout == 0) {
+		// Process the pending media queue item
+		avtpIntfRx(pStream);
+	}
+	else {
+		if (timeout > AVTP_MAX_BLOCK_USEC)
+			timeout = AVTP_MAX_BLOCK_USEC;
+		if (timeout < RAWSOCK_MIN_TIMEOUT_USEC)
+			timeout = RAWSOCK_MIN_TIMEOUT_USEC;
+
+		SEM_TIMEDWAIT_USEC(pStream->rxDemuxSem, timeout, err);
+		if (!SEM_IS_ERR_NONE(err))
+			avtpIntfRx(pStream);
+	}
+
+	AVB_TRACE_EXIT(AVB_TRACE_AVTP_DETAIL);
+}
+
 /*
  * Try to receive some data.
  *
@@ -567,7 +1057,7 @@ static void avtpTryRx(avtp_stream_t *pStream)
 		}
 		else if (timeout == 0) {
 			// Process the pending media queue item and after check for available incoming packets
-			pStream->pIntfCB->intf_rx_cb(pStream->pMediaQ);
+			avtpIntfRx(pStream);
 
 			// Previously would check for new packets but disabled to favor presentation times.
 			// pBuf = (U8 *)openavbRawsockGetRxFrame(pStream->rawsock, OPENAVB_RAWSOCK_NONBLOCK, &offsetToFrame, &frameLen);
@@ -580,7 +1070,7 @@ static void avtpTryRx(avtp_stream_t *pStream)
 
 			pBuf = (U8 *)openavbRawsockGetRxFrame(pStream->rawsock, timeout, &offsetToFrame, &frameLen);
 			if (!pBuf)
-				pStream->pIntfCB->intf_rx_cb(pStream->pMediaQ);
+				avtpIntfRx(pStream);
 		}
 	}
 
@@ -591,13 +1081,42 @@ static void avtpTryRx(avtp_stream_t *pStream)
 	else {
 		pAvtpPdu = pBuf + offsetToFrame + hdrLen;
 		avtpPduLen = frameLen - hdrLen;
-		x_avtpRxFrame(pStream, pAvtpPdu, avtpPduLen);
+		x_avtpRxFrame(pStream, pAvtpPdu, avtpPduLen,
+			pStream->bRxTimestamp ? openavbAvtpRxTimestamp(&hdrInfo) : 0);
 	}
 	openavbRawsockRelRxFrame(pStream->rawsock, pBuf);
 
 	AVB_TRACE_EXIT(AVB_TRACE_AVTP_DETAIL);
 }
 
+U64 openavbAvtpRxTimestamp(hdr_info_t *pHdrInfo)
+{
+	U64 tsNsec = ((U64)pHdrInfo->ts.tv_sec * NANOSECONDS_PER_SECOND) + pHdrInfo->ts.tv_nsec;
+	U64 timeNsec = 0;
+
+	if (tsNsec == 0) {
+		return 0;
+	}
+
+	if (pHdrInfo->ts_hw) {
+		// Network card clock, which gPTP tracks
+		if (!CLOCK_LOCAL_TO_WALLTIME(tsNsec, &timeNsec)) {
+			return 0;
+		}
+	}
+	else {
+		// Kernel timestamp in CLOCK_REALTIME; apply the current offset to gPTP
+		U64 nowRealtime, nowWalltime;
+		if (!CLOCK_GETTIME64(OPENAVB_CLOCK_REALTIME, &nowRealtime)
+			|| !CLOCK_GETTIME64(OPENAVB_CLOCK_WALLTIME, &nowWalltime)) {
+			return 0;
+		}
+		timeNsec = nowWalltime - (nowRealtime - tsNsec);
+	}
+
+	return timeNsec;
+}
+
 int openavbAvtpTxBufferLevel(void *pv)
 {
 	avtp_stream_t *pStream = (avtp_stream_t *)pv;
@@ -615,6 +1134,9 @@ int openavbAvtpRxBufferLevel(void *pv)
 		AVB_RC_LOG(AVB_RC(OPENAVB_AVTP_FAILURE | OPENAVB_RC_INVALID_ARGUMENT));
 		return 0;
 	}
+	if (pStream->bRxDemux) {
+		return openavbAvtpRxDemuxBufLevel(pStream);
+	}
 	return openavbRawsockRxBufLevel(pStream->rawsock);
 }
 
@@ -625,9 +1147,61 @@ int openavbAvtpLost(void *pv)
 		// Quietly return. Since this can be called before a stream is available.
 		return 0;
 	}
-	int count = pStream->nLost;
-	pStream->nLost = 0;
-	return count;
+	return __atomic_exchange_n(&pStream->nLost, 0, __ATOMIC_RELAXED);
+}
+
+// Retries of a snapshot read that raced with its update
+#define RX_MARGIN_READ_RETRIES	4
+
+U32 openavbAvtpRxMargin(void *pv, S32 *pMinUsec, S32 *pAvgUsec, S32 *pMaxUsec)
+{
+	avtp_stream_t *pStream = (avtp_stream_t *)pv;
+	if (!pStream) {
+		return 0;
+	}
+
+	if (!pStream->bRxDemux) {
+		// Frames are received by this thread, so take the snapshot right away
+		pStream->rxMarginReq++;
+		x_avtpRxMarginSnap(pStream);
+	}
+
+	avtp_rx_margin_t snap;
+	U32 seq1 = 0, seq2 = 1;
+	int i;
+	for (i = 0; i < RX_MARGIN_READ_RETRIES; i++) {
+		seq1 = __atomic_load_n(&pStream->rxMarginSeq, __ATOMIC_ACQUIRE);
+		snap = pStream->rxMarginSnap;
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		seq2 = __atomic_load_n(&pStream->rxMarginSeq, __ATOMIC_RELAXED);
+		if (!(seq1 & 1) && seq1 == seq2) {
+			break;
+		}
+	}
+
+	if (pStream->bRxDemux) {
+		// The demultiplexer thread takes the next snapshot with its next frame
+		__atomic_store_n(&pStream->rxMarginReq, pStream->rxMarginReq + 1, __ATOMIC_RELEASE);
+	}
+
+	if ((seq1 & 1) || seq1 != seq2 || seq1 == pStream->rxMarginSeqRead || snap.cnt == 0) {
+		return 0;
+	}
+	pStream->rxMarginSeqRead = seq1;
+
+	*pMinUsec = snap.min / 1000;
+	*pAvgUsec = (S32)(snap.sum / snap.cnt / 1000);
+	*pMaxUsec = snap.max / 1000;
+	return snap.cnt;
+}
+
+void openavbAvtpSetCBHist(void *pv, openavb_hist_t *pIntfCBHist, openavb_hist_t *pMapCBHist)
+{
+	avtp_stream_t *pStream = (avtp_stream_t *)pv;
+	if (pStream) {
+		pStream->pIntfCBHist = pIntfCBHist;
+		pStream->pMapCBHist = pMapCBHist;
+	}
 }
 
 U64 openavbAvtpBytes(void *pv)
@@ -638,9 +1212,20 @@ U64 openavbAvtpBytes(void *pv)
 		return 0;
 	}
 
-	U64 bytes = pStream->bytes;
-	pStream->bytes = 0;
-	return bytes;
+	return __atomic_exchange_n(&pStream->bytes, 0, __ATOMIC_RELAXED);
+}
+
+void openavbAvtpPending(void *pv, U32 *pLost, U64 *pBytes)
+{
+	avtp_stream_t *pStream = (avtp_stream_t *)pv;
+	if (!pStream) {
+		*pLost = 0;
+		*pBytes = 0;
+		return;
+	}
+
+	*pLost = __atomic_load_n(&pStream->nLost, __ATOMIC_RELAXED);
+	*pBytes = __atomic_load_n(&pStream->bytes, __ATOMIC_RELAXED);
 }
 
 openavbRC openavbAvtpRx(void *pv)
@@ -653,7 +1238,10 @@ openavbRC openavbAvtpRx(void *pv)
 	}
 
 	// Check our socket, and potentially receive some data.
-	avtpTryRx(pStream);
+	if (pStream->bRxDemux)
+		avtpTryRxDemux(pStream);
+	else
+		avtpTryRx(pStream);
 
 	// See if there's a complete (re-assembled) data sample.
 	if (pStream->info.rx.bComplete) {
@@ -710,6 +1298,11 @@ void openavbAvtpShutdownTalker(void *pv)
 
 	avtp_stream_t *pStream = (avtp_stream_t *)pv;
 	if (pStream) {
+		// Frames still queued are dropped with the rawsock
+		avtpTxGiveRefItems(pStream);
+		if (pStream->pTxRefItems)
+			free(pStream->pTxRefItems);
+
 		pStream->pIntfCB->intf_end_cb(pStream->pMediaQ);
 		pStream->pMapCB->map_end_cb(pStream->pMediaQ);
 
@@ -719,6 +1312,8 @@ void openavbAvtpShutdownTalker(void *pv)
 			pStream->rawsock = NULL;
 		}
 
+		openavbAvtpFlightClose(pStream->pFlight);
+
 		if (pStream->ifname)
 			free(pStream->ifname);
 
@@ -742,9 +1337,20 @@ void openavbAvtpShutdownListener(void *pv)
 			pStream->rawsock = NULL;
 		}
 
+		// or stop receiving from the demultiplexer
+		if (pStream->bRxDemux) {
+			openavbAvtpRxDemuxRemove(pStream);
+
+			SEM_ERR_T(err);
+			SEM_DESTROY(pStream->rxDemuxSem, err);
+			SEM_LOG_ERR(err);
+		}
+
 		pStream->pIntfCB->intf_end_cb(pStream->pMediaQ);
 		pStream->pMapCB->map_end_cb(pStream->pMediaQ);
 
+		openavbAvtpFlightClose(pStream->pFlight);
+
 		if (pStream->ifname)
 			free(pStream->ifname);
 
@@ -43,6 +43,8 @@ https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
 #include "openavb_map_pub.h"
 #include "openavb_rawsock.h"
 #include "openavb_timestamp.h"
+#include "openavb_hist_pub.h"
+#include "openavb_avtp_flight.h"
 
 #define ETHERTYPE_AVTP 0x22F0
 #define ETHERTYPE_8021Q 0x8100
@@ -57,6 +59,22 @@ https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
 
 // AVTP Headers
 #define AVTP_COMMON_STREAM_DATA_HDR_LEN	24
+// Offset of the stream ID in a stream data AVTPDU
+#define AVTP_STREAM_ID_OFFSET			4
+// Offset of the sequence number in a stream data AVTPDU
+#define AVTP_SEQ_NUM_OFFSET				2
+// Room for the AVTP headers in the TX header template
+#define AVTP_TX_HDR_TEMPLATE_MAX		64
+// Most frames handed to map_tx_batch_cb in one call
+#define AVTP_TX_BATCH_MAX				32
+
+// Ethertype the RX sockets are opened with
+#ifndef UBUNTU
+// This is the normal case for most of our supported platforms
+#define AVTP_RX_ETHERTYPE	ETHERTYPE_8021Q
+#else
+#define AVTP_RX_ETHERTYPE	ETHERTYPE_AVTP
+#endif
 
 //#define OPENAVB_AVTP_REPORT_RX_STATS 1
 #define OPENAVB_AVTP_REPORT_INTERVAL 100
@@ -81,6 +99,14 @@ typedef struct {
 	media_q_t 				mediaq;
 } avtp_state_t;
 
+// Arrival to presentation time margins (nsec) of the received frames
+typedef struct {
+	U32 cnt;
+	S32 min;
+	S32 max;
+	S64 sum;
+} avtp_rx_margin_t;
+
 
 /* Info associated with an AVTP stream (RX or TX).
  *
@@ -131,12 +157,71 @@ typedef struct
 	U8* pBuf;
 	// Ethernet header length
 	U32 ethHdrLen;
+	// Start of every TX frame: Ethernet header, AVTP common header and the
+	// constant part of the mapping header. Built once in openavbAvtpTxInit.
+	U8 txHdrTemplate[ETH_HDR_LEN_VLAN + AVTP_TX_HDR_TEMPLATE_MAX];
+	U32 txHdrTemplateLen;
+
+	// Zero-copy TX related (mapping module has map_tx_ref_cb)
+	// Media queue items whose payload is referenced by frames not sent yet
+	media_q_item_t **pTxRefItems;
+	U32 txRefItemCnt;
+	U32 txRefItemMax;
+
+	// Batched TX related (mapping module has map_tx_batch_cb)
+	// Most frames filled per call; 0 if the frames are filled one by one
+	U32 txBatchMax;
+
+	// Launch time related
+	// Frames carry a launch time; the kernel (ETF / taprio) sends them
+	bool bTxLaunchTime;
+	// Minimum time between the launch times of consecutive frames
+	U32 txLaunchSpacingNsec;
+	// Minimum time between now and the launch time of a frame
+	U32 txLaunchLeadNsec;
+	// Launch time of the last frame sent
+	U64 lastLaunchNsec;
 	
 	// Timestamp evaluation related
 	openavb_timestamp_eval_t tsEval;
 
+	// RX demultiplexer related
+	// Frames are received by a demultiplexer shared with other streams
+	bool bRxDemux;
+	// The demultiplexer and the next stream in its hash bucket
+	void *pRxDemux;
+	void *pRxDemuxNext;
+	// Posted by the demultiplexer for each frame delivered to this stream
+	SEM_T(rxDemuxSem)
+
+	// RX timestamp related
+	// Received frames are timestamped by the kernel or network card
+	bool bRxTimestamp;
+	// Margin between arrival and AVTP presentation time (nsec) since the last
+	// snapshot. Only written by the thread receiving the frames.
+	avtp_rx_margin_t rxMargin;
+	// Snapshot of the last interval, odd rxMarginSeq while it is being written
+	U32 rxMarginSeq;
+	avtp_rx_margin_t rxMarginSnap;
+	// A new snapshot is taken when rxMarginReq, written by the reader,
+	// differs from rxMarginAck, written by the thread receiving the frames.
+	U32 rxMarginReq;
+	U32 rxMarginAck;
+	// rxMarginSeq of the last snapshot returned to the reader
+	U32 rxMarginSeqRead;
+
+	// Histograms of the interface and mapping module callback durations (nsec). NULL if not wanted.
+	openavb_hist_t *pIntfCBHist;
+	openavb_hist_t *pMapCBHist;
+
+	// Flight recorder of the frames sent or received. NULL if not wanted.
+	avtp_flight_t *pFlight;
+
 	// Stat related	
-	// RX frames lost
+	// An RX frame has been received, so avtp_sequence_num can be checked
+	bool bRxSeqValid;
+	// RX frames lost. nLost and bytes are reset by the reader with an atomic
+	// exchange, so they are updated atomically.
 	int nLost;
 	// Bytes sent or recieved
 	U64 bytes;
@@ -158,10 +243,20 @@ openavbRC openavbAvtpTxInit(media_q_t *pMediaQ,
 					U16 vlanID,
 					U8  vlanPCP,
 					U16 nbuffers,
+					U32 flightEvents,
 					void **pStream_out);
 
 openavbRC openavbAvtpTx(void *pv, bool bSend, bool txBlockingInIntf);
 
+// Send up to nFrames frames and returns how many were sent. Stops early
+// when the mapping module has no more data.
+U32 openavbAvtpTxBatch(void *pv, U32 nFrames);
+
+// Send frames at their launch time (media item time), at least spacingNsec apart
+// and at least leadNsec after they are handed to the rawsock.
+// Returns FALSE if the rawsock can't do it.
+bool openavbAvtpTxSetLaunchTime(void *pv, U32 spacingNsec, U32 leadNsec);
+
 openavbRC openavbAvtpRxInit(media_q_t *pMediaQ, 
 					openavb_map_cb_t *pMapCB,
 					openavb_intf_cb_t *pIntfCB,
@@ -170,10 +265,20 @@ openavbRC openavbAvtpRxInit(media_q_t *pMediaQ,
 					U8* destAddr,
 					U16 nbuffers,
 					bool rxSignalMode,
+					bool rxDemux,
+					bool rxTimestamp,
+					U32 flightEvents,
 					void **pStream_out);
 
 openavbRC openavbAvtpRx(void *handle);
 
+// Process a frame for a stream. Called by the RX demultiplexer.
+// rxTimeNsec is the arrival time of the frame, 0 if not known.
+void openavbAvtpRxDemuxFrame(avtp_stream_t *pStream, U8 *pAvtpPdu, U32 avtpPduLen, U64 rxTimeNsec);
+
+// Convert the RX timestamp of a frame to gPTP wall time. Returns 0 if there is none.
+U64 openavbAvtpRxTimestamp(hdr_info_t *pHdrInfo);
+
 void openavbAvtpConfigTimsstampEval(void *handle, U32 tsInterval, U32 reportInterval, bool smoothing, U32 tsMaxJitter, U32 tsMaxDrift);
 
 void openavbAvtpPause(void *handle, bool bPause);
@@ -189,4 +294,19 @@ int openavbAvtpLost(void *handle);
 
 U64 openavbAvtpBytes(void *handle);
 
+// Get the lost frames and bytes counted since the last openavbAvtpLost()
+// and openavbAvtpBytes() calls, without resetting them.
+void openavbAvtpPending(void *handle, U32 *pLost, U64 *pBytes);
+
+// Get the minimum, average and maximum margin (usec) between arrival and
+// presentation time of the frames received since the last call. With the RX
+// demultiplexer, the figures are those of the interval before, up to the
+// first frame received after the last call.
+// Returns the number of frames the figures are based on, 0 if there are none.
+U32 openavbAvtpRxMargin(void *handle, S32 *pMinUsec, S32 *pAvgUsec, S32 *pMaxUsec);
+
+// Collect the durations of the interface and mapping module callbacks (nsec)
+// into the histograms. Either can be NULL.
+void openavbAvtpSetCBHist(void *handle, openavb_hist_t *pIntfCBHist, openavb_hist_t *pMapCBHist);
+
 #endif //AVB_AVTP_H
@@ -0,0 +1,487 @@
+/*************************************************************************************************************
+Copyright (c) 2012-2015, Symphony Teleca Corporation, a Harman International Industries, Incorporated company
+Copyright (c) 2016-2017, Harman International Industries, Incorporated
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS LISTED "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS LISTED BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Attributions: The inih library portion of the source code is licensed from
+Brush Technology and Ben Hoyt - Copyright (c) 2009, Brush Technology and Copyright (c) 2009, Ben Hoyt.
+Complete license and copyright information can be found at
+https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
+*************************************************************************************************************/
+
+/*
+* MODULE SUMMARY : AVTP flight recorder.
+*
+* Recording an event is a handful of stores into the stream's ring by the
+* thread that sends or receives the frame, without any lock. The rings never
+* fill up, the oldest event is overwritten instead.
+*
+* A dump is written by a thread of its own. It copies all rings under the
+* list lock and writes the events to a text file in the dump directory
+* outside of it. Events that were overwritten while being copied are left
+* out. Dumps caused by a sequence gap wait a little, so the file also holds
+* the frames that followed the gap, and are written at most every
+* AVTP_FLIGHT_HOLDOFF_SEC seconds. They rotate through AVTP_FLIGHT_GAP_DUMPS
+* file names, so a lossy link can't fill up the dump directory.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "openavb_platform.h"
+#include "openavb_types.h"
+#include "openavb_trace.h"
+#include "openavb_avtp_flight.h"
+
+#define	AVB_LOG_COMPONENT	"AVTP"
+#include "openavb_log.h"
+
+// Reasons for a dump
+#define AVTP_FLIGHT_DUMP_REQUEST	0x01
+#define AVTP_FLIGHT_DUMP_GAP		0x02
+
+// Time to keep recording after a sequence gap before the dump is taken
+#define AVTP_FLIGHT_POST_GAP_MSEC	100
+
+// Minimum time between dumps caused by sequence gaps
+#define AVTP_FLIGHT_HOLDOFF_SEC		10
+
+// Number of dumps caused by sequence gaps kept, the oldest is replaced
+#define AVTP_FLIGHT_GAP_DUMPS		8
+
+#define AVTP_FLIGHT_DEFAULT_DIR		"/tmp"
+
+THREAD_TYPE(avtpFlightThread);
+
+// Copy of one recorder taken for a dump
+typedef struct {
+	AVBStreamID_t streamID;
+	bool tx;
+	U32 gaps;
+	// Copy of the ring and the oldest event in it that is valid
+	avtp_flight_event_t *pEvents;
+	U32 first;
+	U32 count;
+	U32 mask;
+} avtp_flight_copy_t;
+
+static avtp_flight_t *gAvtpFlightList;
+static char *gAvtpFlightDir;
+static U32 gAvtpFlightDumpCnt;
+static U32 gAvtpFlightGapDumpCnt;
+
+// Protects the list of recorders and the dump directory
+static MUTEX_HANDLE(gAvtpFlightMutex);
+#define FLIGHT_LOCK() { MUTEX_CREATE_ERR(); MUTEX_LOCK(gAvtpFlightMutex); MUTEX_LOG_ERR("Mutex lock failure"); }
+#define FLIGHT_UNLOCK() { MUTEX_CREATE_ERR(); MUTEX_UNLOCK(gAvtpFlightMutex); MUTEX_LOG_ERR("Mutex unlock failure"); }
+
+// Dump thread and its wakeups. Pending dump reasons are or'ed into
+// gAvtpFlightRequests; the semaphore is only posted by the first one.
+static bool gAvtpFlightRunning;
+static U32 gAvtpFlightRequests;
+static SEM_T(gAvtpFlightSem)
+static THREAD_DEFINITON(avtpFlightThread);
+
+static void x_avtpFlightRequest(U32 reason)
+{
+	if (!__atomic_fetch_or(&gAvtpFlightRequests, reason, __ATOMIC_RELEASE)) {
+		SEM_ERR_T(err);
+		SEM_POST(gAvtpFlightSem, err);
+		(void)err;
+	}
+}
+
+// Copy the events of a recorder that can't have been overwritten while copying
+static void x_avtpFlightCopy(avtp_flight_t *pFlight, avtp_flight_copy_t *pCopy)
+{
+	U32 size = pFlight->mask + 1;
+
+	U32 head1 = __atomic_load_n(&pFlight->head, __ATOMIC_ACQUIRE);
+	memcpy(pCopy->pEvents, pFlight->events, size * sizeof(avtp_flight_event_t));
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	U32 head2 = __atomic_load_n(&pFlight->head, __ATOMIC_RELAXED);
+
+	// Events up to head2 - size may have been overwritten while copying, the
+	// last one by the event being written when head2 was read. Keep the
+	// events after it that were complete when head1 was read.
+	U32 count = 0;
+	if (head2 - head1 < size - 1) {
+		count = size - 1 - (head2 - head1);
+	}
+	if (count > head1) {
+		count = head1;
+	}
+
+	pCopy->streamID = pFlight->streamID;
+	pCopy->tx = pFlight->tx;
+	pCopy->gaps = __atomic_load_n(&pFlight->gaps, __ATOMIC_RELAXED);
+	pCopy->first = (head1 - count) & pFlight->mask;
+	pCopy->count = count;
+	pCopy->mask = pFlight->mask;
+}
+
+static void x_avtpFlightWriteEvents(FILE *pFile, avtp_flight_copy_t *pCopy)
+{
+	fprintf(pFile, "# stream " STREAMID_FORMAT " %s, %u events, %u sequence gaps\n",
+		STREAMID_ARGS(&pCopy->streamID), pCopy->tx ? "talker" : "listener", pCopy->count, pCopy->gaps);
+	fprintf(pFile, "# time_nsec delta_nsec seq avtp_timestamp margin_nsec mq_depth flags\n");
+
+	U64 lastNsec = 0;
+	U32 i1;
+	for (i1 = 0; i1 < pCopy->count; i1++) {
+		avtp_flight_event_t *pEvent = &pCopy->pEvents[(pCopy->first + i1) & pCopy->mask];
+		S64 delta = i1 ? (S64)(pEvent->timeNsec - lastNsec) : 0;
+		char flags[32];
+
+		lastNsec = pEvent->timeNsec;
+
+		snprintf(flags, sizeof(flags), "%s%s%s%s",
+			pEvent->flags & AVTP_FLIGHT_TX ? "tx" : "rx",
+			pEvent->flags & AVTP_FLIGHT_TV ? ",tv" : "",
+			pEvent->flags & AVTP_FLIGHT_LATE ? ",late" : "",
+			pEvent->flags & AVTP_FLIGHT_GAP ? ",gap" : "");
+
+		if (pEvent->flags & AVTP_FLIGHT_TV) {
+			// The AVTP timestamp is the low 32 bits of the presentation time
+			S32 margin = (S32)(pEvent->avtpTimestamp - (U32)pEvent->timeNsec);
+			fprintf(pFile, "%" PRIu64 " %" PRId64 " %u %" PRIu32 " %" PRId32 " %u %s\n",
+				pEvent->timeNsec, delta, pEvent->seq, pEvent->avtpTimestamp, margin, pEvent->mqDepth, flags);
+		}
+		else {
+			fprintf(pFile, "%" PRIu64 " %" PRId64 " %u - - %u %s\n",
+				pEvent->timeNsec, delta, pEvent->seq, pEvent->mqDepth, flags);
+		}
+	}
+	fprintf(pFile, "\n");
+}
+
+static void x_avtpFlightWrite(U32 reasons)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_AVTP);
+
+	avtp_flight_copy_t *pCopies = NULL;
+	U32 nCopies = 0;
+	char path[PATH_MAX];
+	time_t now = time(NULL);
+	struct tm tmNow;
+	char sNow[32];
+
+	localtime_r(&now, &tmNow);
+	strftime(sNow, sizeof(sNow), "%Y%m%d-%H%M%S", &tmNow);
+
+	FLIGHT_LOCK();
+	{
+		avtp_flight_t *pFlight;
+		U32 nEvents = 0;
+		for (pFlight = gAvtpFlightList; pFlight; pFlight = pFlight->pNext) {
+			nCopies++;
+			nEvents += pFlight->mask + 1;
+		}
+
+		// One allocation for the copies and their events
+		if (nCopies) {
+			pCopies = malloc(nCopies * sizeof(avtp_flight_copy_t) + (size_t)nEvents * sizeof(avtp_flight_event_t));
+		}
+		if (pCopies) {
+			avtp_flight_event_t *pEvents = (avtp_flight_event_t *)(pCopies + nCopies);
+			U32 i1 = 0;
+			for (pFlight = gAvtpFlightList; pFlight; pFlight = pFlight->pNext, i1++) {
+				pCopies[i1].pEvents = pEvents;
+				x_avtpFlightCopy(pFlight, &pCopies[i1]);
+				pEvents += pFlight->mask + 1;
+			}
+		}
+
+		if (reasons & AVTP_FLIGHT_DUMP_REQUEST) {
+			snprintf(path, sizeof(path), "%s/avtp_flight_%s_%u.txt", gAvtpFlightDir, sNow, ++gAvtpFlightDumpCnt);
+		}
+		else {
+			snprintf(path, sizeof(path), "%s/avtp_flight_gap_%u.txt", gAvtpFlightDir, gAvtpFlightGapDumpCnt++ % AVTP_FLIGHT_GAP_DUMPS);
+		}
+	}
+	FLIGHT_UNLOCK();
+
+	if (!nCopies) {
+		AVB_LOG_INFO("Flight recorder dump skipped; no stream is recording");
+		AVB_TRACE_EXIT(AVB_TRACE_AVTP);
+		return;
+	}
+	if (!pCopies) {
+		AVB_LOG_ERROR("Flight recorder dump; malloc failed");
+		AVB_TRACE_EXIT(AVB_TRACE_AVTP);
+		return;
+	}
+
+	// The dump directory may be world writable (/tmp), so never follow a
+	// link or write into a file that already exists. A rotated gap dump
+	// is removed first; unlink() removes a link, not what it points to.
+	if (!(reasons & AVTP_FLIGHT_DUMP_REQUEST) && unlink(path) < 0 && errno != ENOENT) {
+		AVB_LOGF_WARNING("Flight recorder dump; can't remove %s: %s", path, strerror(errno));
+	}
+	FILE *pFile = NULL;
+	int fd = open(path, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0600);
+	if (fd >= 0) {
+		pFile = fdopen(fd, "w");
+		if (!pFile) {
+			int fdopenErr = errno;
+			close(fd);
+			errno = fdopenErr;
+		}
+	}
+	if (!pFile) {
+		AVB_LOGF_ERROR("Flight recorder dump; can't create %s: %s", path, strerror(errno));
+		free(pCopies);
+		AVB_TRACE_EXIT(AVB_TRACE_AVTP);
+		return;
+	}
+
+	fprintf(pFile, "# AVTP flight recorder %s, %s\n", sNow,
+		(reasons & AVTP_FLIGHT_DUMP_REQUEST) ? "requested" : "sequence gap");
+
+	U32 i1;
+	for (i1 = 0; i1 < nCopies; i1++) {
+		x_avtpFlightWriteEvents(pFile, &pCopies[i1]);
+	}
+
+	if (fclose(pFile) != 0) {
+		AVB_LOGF_ERROR("Flight recorder dump; error writing %s: %s", path, strerror(errno));
+	}
+	else {
+		AVB_LOGF_INFO("Flight recorder dump of %u streams written to %s", nCopies, path);
+	}
+
+	free(pCopies);
+
+	AVB_TRACE_EXIT(AVB_TRACE_AVTP);
+}
+
+static void *avtpFlightThreadFn(void *pv)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_AVTP);
+
+	U64 holdoffNsec = 0;
+
+	while (TRUE) {
+		SEM_ERR_T(err);
+		SEM_WAIT(gAvtpFlightSem, err);
+		if (!SEM_IS_ERR_NONE(err)) {
+			continue;
+		}
+		if (!gAvtpFlightRunning) {
+			break;
+		}
+
+		U32 reasons = __atomic_exchange_n(&gAvtpFlightRequests, 0, __ATOMIC_ACQUIRE);
+
+		if (!(reasons & AVTP_FLIGHT_DUMP_REQUEST)) {
+			U64 nowNsec;
+			CLOCK_GETTIME64(OPENAVB_CLOCK_MONOTONIC, &nowNsec);
+			if (nowNsec < holdoffNsec) {
+				continue;
+			}
+			holdoffNsec = nowNsec + AVTP_FLIGHT_HOLDOFF_SEC * NANOSECONDS_PER_SECOND;
+
+			// Let the frames that followed the gap be recorded too
+			SLEEP_MSEC(AVTP_FLIGHT_POST_GAP_MSEC);
+		}
+
+		if (reasons) {
+			x_avtpFlightWrite(reasons);
+		}
+	}
+
+	AVB_TRACE_EXIT(AVB_TRACE_AVTP);
+	return NULL;
+}
+
+bool openavbAvtpFlightInitialize(void)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_AVTP);
+
+	gAvtpFlightList = NULL;
+	gAvtpFlightRequests = 0;
+	gAvtpFlightDir = strdup(AVTP_FLIGHT_DEFAULT_DIR);
+
+	MUTEX_ATTR_HANDLE(mta);
+	MUTEX_ATTR_INIT(mta);
+	MUTEX_ATTR_SET_TYPE(mta, MUTEX_ATTR_TYPE_DEFAULT);
+	MUTEX_ATTR_SET_NAME(mta, "gAvtpFlightMutex");
+	MUTEX_CREATE_ERR();
+	MUTEX_CREATE(gAvtpFlightMutex, mta);
+	MUTEX_LOG_ERR("Error creating mutex");
+	if (MUTEX_IS_ERR) {
+		AVB_TRACE_EXIT(AVB_TRACE_AVTP);
+		return FALSE;
+	}
+
+	SEM_ERR_T(err);
+	SEM_INIT(gAvtpFlightSem, 0, err);
+	SEM_LOG_ERR(err);
+
+	// The dump thread runs with default scheduling, below the stream threads
+	bool errResult;
+	gAvtpFlightRunning = TRUE;
+	THREAD_CREATE(avtpFlightThread, avtpFlightThread, NULL, avtpFlightThreadFn, NULL);
+	THREAD_CHECK_ERROR(avtpFlightThread, "Thread / task creation failed", errResult);
+	if (errResult) {
+		gAvtpFlightRunning = FALSE;
+		SEM_DESTROY(gAvtpFlightSem, err);
+		SEM_LOG_ERR(err);
+		MUTEX_DESTROY(gAvtpFlightMutex);
+		MUTEX_LOG_ERR("Error destroying mutex");
+		AVB_TRACE_EXIT(AVB_TRACE_AVTP);
+		return FALSE;
+	}
+
+	AVB_TRACE_EXIT(AVB_TRACE_AVTP);
+	return TRUE;
+}
+
+void openavbAvtpFlightFinalize(void)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_AVTP);
+
+	if (gAvtpFlightRunning) {
+		gAvtpFlightRunning = FALSE;
+
+		SEM_ERR_T(err);
+		SEM_POST(gAvtpFlightSem, err);
+		SEM_LOG_ERR(err);
+		THREAD_JOIN(avtpFlightThread, NULL);
+
+		SEM_DESTROY(gAvtpFlightSem, err);
+		SEM_LOG_ERR(err);
+
+		if (gAvtpFlightList) {
+			AVB_LOG_WARNING("Flight recorder still in use");
+		}
+
+		MUTEX_CREATE_ERR();
+		MUTEX_DESTROY(gAvtpFlightMutex);
+		MUTEX_LOG_ERR("Error destroying mutex");
+	}
+
+	free(gAvtpFlightDir);
+	gAvtpFlightDir = NULL;
+
+	AVB_TRACE_EXIT(AVB_TRACE_AVTP);
+}
+
+bool openavbAvtpFlightSetDir(const char *dir)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_AVTP);
+
+	if (!dir || !*dir || !gAvtpFlightRunning) {
+		AVB_TRACE_EXIT(AVB_TRACE_AVTP);
+		return FALSE;
+	}
+
+	char *newDir = strdup(dir);
+	if (!newDir) {
+		AVB_TRACE_EXIT(AVB_TRACE_AVTP);
+		return FALSE;
+	}
+
+	FLIGHT_LOCK();
+	free(gAvtpFlightDir);
+	gAvtpFlightDir = newDir;
+	FLIGHT_UNLOCK();
+
+	AVB_TRACE_EXIT(AVB_TRACE_AVTP);
+	return TRUE;
+}
+
+avtp_flight_t *openavbAvtpFlightOpen(AVBStreamID_t *streamID, bool tx, U32 nEvents)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_AVTP);
+
+	if (!gAvtpFlightRunning || nEvents == 0) {
+		AVB_TRACE_EXIT(AVB_TRACE_AVTP);
+		return NULL;
+	}
+
+	if (nEvents > AVTP_FLIGHT_MAX_EVENTS) {
+		nEvents = AVTP_FLIGHT_MAX_EVENTS;
+	}
+	U32 size = 2;
+	while (size < nEvents) {
+		size <<= 1;
+	}
+
+	avtp_flight_t *pFlight = calloc(1, sizeof(avtp_flight_t) + size * sizeof(avtp_flight_event_t));
+	if (!pFlight) {
+		AVB_LOG_ERROR("Flight recorder; malloc failed");
+		AVB_TRACE_EXIT(AVB_TRACE_AVTP);
+		return NULL;
+	}
+	pFlight->streamID = *streamID;
+	pFlight->tx = tx;
+	pFlight->mask = size - 1;
+
+	FLIGHT_LOCK();
+	pFlight->pNext = gAvtpFlightList;
+	gAvtpFlightList = pFlight;
+	FLIGHT_UNLOCK();
+
+	AVB_TRACE_EXIT(AVB_TRACE_AVTP);
+	return pFlight;
+}
+
+void openavbAvtpFlightClose(avtp_flight_t *pFlight)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_AVTP);
+
+	if (pFlight) {
+		FLIGHT_LOCK();
+		avtp_flight_t **ppFlight = &gAvtpFlightList;
+		while (*ppFlight && *ppFlight != pFlight) {
+			ppFlight = &(*ppFlight)->pNext;
+		}
+		if (*ppFlight) {
+			*ppFlight = pFlight->pNext;
+		}
+		FLIGHT_UNLOCK();
+
+		free(pFlight);
+	}
+
+	AVB_TRACE_EXIT(AVB_TRACE_AVTP);
+}
+
+void openavbAvtpFlightDump(void)
+{
+	if (gAvtpFlightRunning) {
+		x_avtpFlightRequest(AVTP_FLIGHT_DUMP_REQUEST);
+	}
+}
+
+void openavbAvtpFlightGap(avtp_flight_t *pFlight)
+{
+	__atomic_store_n(&pFlight->gaps, pFlight->gaps + 1, __ATOMIC_RELAXED);
+	x_avtpFlightRequest(AVTP_FLIGHT_DUMP_GAP);
+}
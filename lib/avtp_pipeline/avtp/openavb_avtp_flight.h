@@ -0,0 +1,116 @@
+/*************************************************************************************************************
+Copyright (c) 2012-2015, Symphony Teleca Corporation, a Harman International Industries, Incorporated company
+Copyright (c) 2016-2017, Harman International Industries, Incorporated
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS LISTED "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS LISTED BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Attributions: The inih library portion of the source code is licensed from
+Brush Technology and Ben Hoyt - Copyright (c) 2009, Brush Technology and Copyright (c) 2009, Ben Hoyt.
+Complete license and copyright information can be found at
+https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
+*************************************************************************************************************/
+
+/*
+* HEADER SUMMARY : AVTP flight recorder.
+*
+* A stream with a flight recorder keeps an event for each of the last frames
+* it sent or received in a fixed size ring. The rings of all streams are
+* written to a file on request, or when a listener sees a sequence gap, so
+* the frames leading up to a glitch can be looked at afterwards.
+*/
+
+#ifndef AVB_AVTP_FLIGHT_H
+#define AVB_AVTP_FLIGHT_H 1
+
+#include "openavb_types.h"
+
+// Event flags
+#define AVTP_FLIGHT_TX		0x01	// Frame sent, received otherwise
+#define AVTP_FLIGHT_TV		0x02	// AVTP timestamp valid
+#define AVTP_FLIGHT_LATE	0x04	// Presentation time already past
+#define AVTP_FLIGHT_GAP		0x08	// First frame after a sequence gap
+
+// Largest ring, in events
+#define AVTP_FLIGHT_MAX_EVENTS	(1 << 20)
+
+// One frame sent or received
+typedef struct {
+	// gPTP time the frame was received, or sent (its launch time if it has one)
+	U64 timeNsec;
+	// AVTP timestamp if AVTP_FLIGHT_TV is set
+	U32 avtpTimestamp;
+	// Media queue items queued at the time
+	U16 mqDepth;
+	U8 seq;
+	U8 flags;
+} avtp_flight_event_t;
+
+typedef struct avtp_flight {
+	// Next recorder in the list
+	struct avtp_flight *pNext;
+	AVBStreamID_t streamID;
+	bool tx;
+	// Sequence gaps seen
+	U32 gaps;
+	// Ring size - 1. The size is a power of 2.
+	U32 mask;
+	// Events recorded. Only written by the thread that records the events.
+	U32 head;
+	avtp_flight_event_t events[];
+} avtp_flight_t;
+
+// Create / destroy the global flight recorder state and the dump thread.
+bool openavbAvtpFlightInitialize(void);
+void openavbAvtpFlightFinalize(void);
+
+// Directory the dumps are written to. Defaults to /tmp.
+bool openavbAvtpFlightSetDir(const char *dir);
+
+// Create a recorder holding the last nEvents (rounded up to a power of 2) events.
+avtp_flight_t *openavbAvtpFlightOpen(AVBStreamID_t *streamID, bool tx, U32 nEvents);
+void openavbAvtpFlightClose(avtp_flight_t *pFlight);
+
+// Request a dump of all recorders. Only wakes the dump thread, so it can be
+// called from a signal handler.
+void openavbAvtpFlightDump(void);
+
+// Note a sequence gap. Requests a dump unless one was written recently.
+void openavbAvtpFlightGap(avtp_flight_t *pFlight);
+
+// Record an event. Only called by the thread that sends or receives the frames of the stream.
+static inline void openavbAvtpFlightRecord(avtp_flight_t *pFlight, U64 timeNsec, U32 avtpTimestamp, U16 mqDepth, U8 seq, U8 flags)
+{
+	U32 head = pFlight->head;
+	avtp_flight_event_t *pEvent = &pFlight->events[head & pFlight->mask];
+
+	// The dump thread must not see any part of the new event before the
+	// previous head. It then knows which copied events may be torn.
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	pEvent->timeNsec = timeNsec;
+	pEvent->avtpTimestamp = avtpTimestamp;
+	pEvent->mqDepth = mqDepth;
+	pEvent->seq = seq;
+	pEvent->flags = flags;
+	__atomic_store_n(&pFlight->head, head + 1, __ATOMIC_RELEASE);
+}
+
+#endif //AVB_AVTP_FLIGHT_H
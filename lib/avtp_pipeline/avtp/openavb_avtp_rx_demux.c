@@ -0,0 +1,402 @@
+/*************************************************************************************************************
+Copyright (c) 2012-2015, Symphony Teleca Corporation, a Harman International Industries, Incorporated company
+Copyright (c) 2016-2017, Harman International Industries, Incorporated
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS LISTED "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS LISTED BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Attributions: The inih library portion of the source code is licensed from
+Brush Technology and Ben Hoyt - Copyright (c) 2009, Brush Technology and Copyright (c) 2009, Ben Hoyt.
+Complete license and copyright information can be found at
+https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
+*************************************************************************************************************/
+
+/*
+* MODULE SUMMARY : Shared AVTP RX demultiplexer.
+*
+* Without the demultiplexer every listener stream opens its own raw socket, so
+* the kernel copies each AVTP frame on the interface once per listener and every
+* listener throws away the frames of the other streams. With the demultiplexer
+* one socket and one thread per interface receive all AVTP frames. The thread
+* looks the stream ID up in a hash table and passes the frame to the mapping
+* module of the matching stream, then wakes the stream task so that the
+* interface module can pick up the media queue items.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "openavb_platform.h"
+#include "openavb_types.h"
+#include "openavb_trace.h"
+#include "openavb_avtp.h"
+#include "openavb_avtp_rx_demux.h"
+#include "openavb_rawsock.h"
+
+#define	AVB_LOG_COMPONENT	"AVTP"
+#include "openavb_log.h"
+
+// Number of stream ID hash buckets. Must be a power of 2.
+#define AVTP_RX_DEMUX_HASH_SIZE		64
+
+// Frame size used for the shared socket. Large enough for any stream.
+#define AVTP_RX_DEMUX_FRAME_SIZE	(1500 + ETH_HDR_LEN_VLAN)
+
+// Minimum number of frames in the shared socket buffer
+#define AVTP_RX_DEMUX_MIN_BUFFERS	1024
+
+// Maximum time the demultiplexer thread blocks before checking if it should stop
+#define AVTP_RX_DEMUX_BLOCK_USEC	(100 * MICROSECONDS_PER_MSEC)
+
+THREAD_TYPE(avtpRxDemuxThread);
+
+typedef struct avtp_rx_demux {
+	// Next demultiplexer in the list
+	struct avtp_rx_demux *pNext;
+	// Interface name (with the rawsock type prefix)
+	char *ifname;
+	// The shared rawsock
+	void *rawsock;
+	// Thread running flag
+	bool bRunning;
+	// Number of streams registered
+	U32 streamCount;
+	// Received frames are timestamped (some stream asked for it)
+	bool bRxTimestamp;
+	// Registered streams by stream ID, chained through pRxDemuxNext
+	avtp_stream_t *pBucket[AVTP_RX_DEMUX_HASH_SIZE];
+	// Protects the hash table while the thread delivers a frame
+	MUTEX_HANDLE(mutex);
+	// Receive thread
+	THREAD_DEFINITON(avtpRxDemuxThread);
+} avtp_rx_demux_t;
+
+static avtp_rx_demux_t *gAvtpRxDemuxList;
+
+// Protects the list of demultiplexers
+static MUTEX_HANDLE(gAvtpRxDemuxMutex);
+#define DEMUX_LIST_LOCK() { MUTEX_CREATE_ERR(); MUTEX_LOCK(gAvtpRxDemuxMutex); MUTEX_LOG_ERR("Mutex lock failure"); }
+#define DEMUX_LIST_UNLOCK() { MUTEX_CREATE_ERR(); MUTEX_UNLOCK(gAvtpRxDemuxMutex); MUTEX_LOG_ERR("Mutex unlock failure"); }
+
+#define DEMUX_LOCK(pDemux) { MUTEX_CREATE_ERR(); MUTEX_LOCK((pDemux)->mutex); MUTEX_LOG_ERR("Mutex lock failure"); }
+#define DEMUX_UNLOCK(pDemux) { MUTEX_CREATE_ERR(); MUTEX_UNLOCK((pDemux)->mutex); MUTEX_LOG_ERR("Mutex unlock failure"); }
+
+// FNV-1a hash of the 8 byte stream ID
+static inline U32 x_avtpRxDemuxHash(const U8 *pStreamID)
+{
+	U32 hash = 2166136261u;
+	int i1;
+	for (i1 = 0; i1 < 8; i1++) {
+		hash = (hash ^ pStreamID[i1]) * 16777619u;
+	}
+	return hash & (AVTP_RX_DEMUX_HASH_SIZE - 1);
+}
+
+// Hand a frame to every stream registered for its stream ID
+static void x_avtpRxDemuxDispatch(avtp_rx_demux_t *pDemux, U8 *pAvtpPdu, U32 avtpPduLen, U64 rxTimeNsec)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_AVTP_DETAIL);
+
+	// Only stream data AVTPDUs (cd bit clear, sv bit set) are delivered.
+	if (avtpPduLen < AVTP_STREAM_ID_OFFSET + 8 || (pAvtpPdu[0] & 0x80) || !(pAvtpPdu[1] & 0x80)) {
+		AVB_TRACE_EXIT(AVB_TRACE_AVTP_DETAIL);
+		return;
+	}
+
+	U8 *pStreamID = pAvtpPdu + AVTP_STREAM_ID_OFFSET;
+	U32 bucket = x_avtpRxDemuxHash(pStreamID);
+
+	DEMUX_LOCK(pDemux);
+	avtp_stream_t *pStream = pDemux->pBucket[bucket];
+	while (pStream) {
+		if (memcmp(pStream->streamIDnet, pStreamID, 8) == 0) {
+			openavbAvtpRxDemuxFrame(pStream, pAvtpPdu, avtpPduLen, rxTimeNsec);
+		}
+		pStream = pStream->pRxDemuxNext;
+	}
+	DEMUX_UNLOCK(pDemux);
+
+	AVB_TRACE_EXIT(AVB_TRACE_AVTP_DETAIL);
+}
+
+static void *avtpRxDemuxThreadFn(void *pv)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_AVTP);
+
+	avtp_rx_demux_t *pDemux = (avtp_rx_demux_t *)pv;
+	U8         *pBuf;          // pointer to buffer containing rcvd frame, if any
+	U32         offsetToFrame; // offset into pBuf where Ethernet frame begins (bytes)
+	U32         frameLen;      // length of the Ethernet frame (bytes)
+	int         hdrLen;        // length of the Ethernet frame header (bytes)
+	hdr_info_t  hdrInfo;       // Ethernet header contents
+
+	while (pDemux->bRunning) {
+		pBuf = (U8 *)openavbRawsockGetRxFrame(pDemux->rawsock, AVTP_RX_DEMUX_BLOCK_USEC, &offsetToFrame, &frameLen);
+		if (!pBuf)
+			continue;
+
+		hdrLen = openavbRawsockRxParseHdr(pDemux->rawsock, pBuf, &hdrInfo);
+		if (hdrLen < 0) {
+			AVB_RC_LOG(AVB_RC(OPENAVB_AVTP_FAILURE | OPENAVBAVTP_RC_PARSING_FRAME_HEADER));
+		}
+		else if (hdrInfo.ethertype == ETHERTYPE_AVTP) {
+			x_avtpRxDemuxDispatch(pDemux, pBuf + offsetToFrame + hdrLen, frameLen - hdrLen,
+				pDemux->bRxTimestamp ? openavbAvtpRxTimestamp(&hdrInfo) : 0);
+		}
+		openavbRawsockRelRxFrame(pDemux->rawsock, pBuf);
+	}
+
+	AVB_TRACE_EXIT(AVB_TRACE_AVTP);
+	return NULL;
+}
+
+bool openavbAvtpRxDemuxInitialize(void)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_AVTP);
+
+	gAvtpRxDemuxList = NULL;
+
+	MUTEX_ATTR_HANDLE(mta);
+	MUTEX_ATTR_INIT(mta);
+	MUTEX_ATTR_SET_TYPE(mta, MUTEX_ATTR_TYPE_DEFAULT);
+	MUTEX_ATTR_SET_NAME(mta, "gAvtpRxDemuxMutex");
+	MUTEX_CREATE_ERR();
+	MUTEX_CREATE(gAvtpRxDemuxMutex, mta);
+	MUTEX_LOG_ERR("Error creating mutex");
+
+	AVB_TRACE_EXIT(AVB_TRACE_AVTP);
+	return !MUTEX_IS_ERR;
+}
+
+void openavbAvtpRxDemuxFinalize(void)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_AVTP);
+
+	if (gAvtpRxDemuxList) {
+		AVB_LOG_WARNING("RX demultiplexer still in use");
+	}
+
+	MUTEX_CREATE_ERR();
+	MUTEX_DESTROY(gAvtpRxDemuxMutex);
+	MUTEX_LOG_ERR("Error destroying mutex");
+
+	AVB_TRACE_EXIT(AVB_TRACE_AVTP);
+}
+
+static avtp_rx_demux_t *x_avtpRxDemuxOpen(const char *ifname, avtp_stream_t *pStream)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_AVTP);
+
+	avtp_rx_demux_t *pDemux = calloc(1, sizeof(avtp_rx_demux_t));
+	if (!pDemux) {
+		AVB_LOG_ERROR("RX demultiplexer; malloc failed");
+		AVB_TRACE_EXIT(AVB_TRACE_AVTP);
+		return NULL;
+	}
+
+	U32 nbuffers = pStream->nbuffers > AVTP_RX_DEMUX_MIN_BUFFERS ? pStream->nbuffers : AVTP_RX_DEMUX_MIN_BUFFERS;
+	pDemux->rawsock = openavbRawsockOpen(ifname, TRUE, FALSE, AVTP_RX_ETHERTYPE, AVTP_RX_DEMUX_FRAME_SIZE, nbuffers);
+	if (!pDemux->rawsock) {
+		AVB_LOGF_ERROR("RX demultiplexer; failed to open rawsock on %s", ifname);
+		free(pDemux);
+		AVB_TRACE_EXIT(AVB_TRACE_AVTP);
+		return NULL;
+	}
+	openavbSetRxSignalMode(pDemux->rawsock, pStream->bRxSignalMode);
+	pDemux->ifname = strdup(ifname);
+
+	{
+		MUTEX_ATTR_HANDLE(mta);
+		MUTEX_ATTR_INIT(mta);
+		MUTEX_ATTR_SET_TYPE(mta, MUTEX_ATTR_TYPE_DEFAULT);
+		MUTEX_ATTR_SET_NAME(mta, "AvtpRxDemuxMutex");
+		MUTEX_CREATE_ERR();
+		MUTEX_CREATE(pDemux->mutex, mta);
+		MUTEX_LOG_ERR("Could not create/initialize 'AvtpRxDemuxMutex' mutex");
+	}
+
+	// The thread inherits the scheduling settings of the first listener.
+	bool errResult;
+	pDemux->bRunning = TRUE;
+	THREAD_CREATE(avtpRxDemuxThread, pDemux->avtpRxDemuxThread, NULL, avtpRxDemuxThreadFn, pDemux);
+	THREAD_CHECK_ERROR(pDemux->avtpRxDemuxThread, "Thread / task creation failed", errResult);
+	if (errResult) {
+		MUTEX_CREATE_ERR();
+		MUTEX_DESTROY(pDemux->mutex);
+		MUTEX_LOG_ERR("Error destroying mutex");
+		openavbRawsockClose(pDemux->rawsock);
+		free(pDemux->ifname);
+		free(pDemux);
+		AVB_TRACE_EXIT(AVB_TRACE_AVTP);
+		return NULL;
+	}
+
+	AVB_LOGF_INFO("RX demultiplexer started on %s", ifname);
+
+	AVB_TRACE_EXIT(AVB_TRACE_AVTP);
+	return pDemux;
+}
+
+static void x_avtpRxDemuxClose(avtp_rx_demux_t *pDemux)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_AVTP);
+
+	THREAD_JOIN(pDemux->avtpRxDemuxThread, NULL);
+
+	openavbRawsockClose(pDemux->rawsock);
+
+	{
+		MUTEX_CREATE_ERR();
+		MUTEX_DESTROY(pDemux->mutex);
+		MUTEX_LOG_ERR("Error destroying mutex");
+	}
+
+	AVB_LOGF_INFO("RX demultiplexer stopped on %s", pDemux->ifname);
+
+	free(pDemux->ifname);
+	free(pDemux);
+
+	AVB_TRACE_EXIT(AVB_TRACE_AVTP);
+}
+
+bool openavbAvtpRxDemuxAdd(avtp_stream_t *pStream)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_AVTP);
+
+	if (!pStream || !pStream->ifname) {
+		AVB_RC_LOG(AVB_RC(OPENAVB_AVTP_FAILURE | OPENAVB_RC_INVALID_ARGUMENT));
+		AVB_TRACE_EXIT(AVB_TRACE_AVTP);
+		return FALSE;
+	}
+
+	// Use the TPACKET_V3 ring buffer implementation unless a rawsock type was given
+	char ifname[IFNAMSIZ + 10];
+	if (strchr(pStream->ifname, ':')) {
+		snprintf(ifname, sizeof(ifname), "%s", pStream->ifname);
+	} else {
+		snprintf(ifname, sizeof(ifname), "ring3:%s", pStream->ifname);
+	}
+
+	DEMUX_LIST_LOCK();
+
+	avtp_rx_demux_t *pDemux = gAvtpRxDemuxList;
+	while (pDemux && strcmp(pDemux->ifname, ifname) != 0) {
+		pDemux = pDemux->pNext;
+	}
+
+	if (!pDemux) {
+		pDemux = x_avtpRxDemuxOpen(ifname, pStream);
+		if (!pDemux) {
+			DEMUX_LIST_UNLOCK();
+			AVB_TRACE_EXIT(AVB_TRACE_AVTP);
+			return FALSE;
+		}
+		pDemux->pNext = gAvtpRxDemuxList;
+		gAvtpRxDemuxList = pDemux;
+	}
+
+	DEMUX_LOCK(pDemux);
+
+	// Set the multicast address that we want to receive
+	openavbRawsockRxMulticast(pDemux->rawsock, TRUE, pStream->dest_addr.ether_addr_octet);
+
+	if (pStream->bRxTimestamp && !pDemux->bRxTimestamp) {
+		if (openavbRawsockRxSetTimestamp(pDemux->rawsock, TRUE)) {
+			pDemux->bRxTimestamp = TRUE;
+		}
+		else {
+			AVB_LOG_WARNING("RX timestamps not supported by the rawsock");
+		}
+	}
+
+	U32 bucket = x_avtpRxDemuxHash(pStream->streamIDnet);
+	pStream->pRxDemuxNext = pDemux->pBucket[bucket];
+	pDemux->pBucket[bucket] = pStream;
+	pStream->pRxDemux = pDemux;
+	pDemux->streamCount++;
+
+	DEMUX_UNLOCK(pDemux);
+
+	DEMUX_LIST_UNLOCK();
+
+	AVB_TRACE_EXIT(AVB_TRACE_AVTP);
+	return TRUE;
+}
+
+void openavbAvtpRxDemuxRemove(avtp_stream_t *pStream)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_AVTP);
+
+	if (!pStream || !pStream->pRxDemux) {
+		AVB_TRACE_EXIT(AVB_TRACE_AVTP);
+		return;
+	}
+
+	avtp_rx_demux_t *pDemux = (avtp_rx_demux_t *)pStream->pRxDemux;
+	bool bStop = FALSE;
+
+	DEMUX_LIST_LOCK();
+
+	DEMUX_LOCK(pDemux);
+
+	avtp_stream_t **ppStream = &pDemux->pBucket[x_avtpRxDemuxHash(pStream->streamIDnet)];
+	while (*ppStream && *ppStream != pStream) {
+		ppStream = (avtp_stream_t **)&(*ppStream)->pRxDemuxNext;
+	}
+	if (*ppStream) {
+		*ppStream = pStream->pRxDemuxNext;
+		pDemux->streamCount--;
+		openavbRawsockRxMulticast(pDemux->rawsock, FALSE, pStream->dest_addr.ether_addr_octet);
+	}
+	pStream->pRxDemux = NULL;
+	pStream->pRxDemuxNext = NULL;
+
+	if (pDemux->streamCount == 0) {
+		pDemux->bRunning = FALSE;
+		bStop = TRUE;
+	}
+
+	DEMUX_UNLOCK(pDemux);
+
+	if (bStop) {
+		avtp_rx_demux_t **ppDemux = &gAvtpRxDemuxList;
+		while (*ppDemux && *ppDemux != pDemux) {
+			ppDemux = &(*ppDemux)->pNext;
+		}
+		if (*ppDemux) {
+			*ppDemux = pDemux->pNext;
+		}
+
+		x_avtpRxDemuxClose(pDemux);
+	}
+
+	DEMUX_LIST_UNLOCK();
+
+	AVB_TRACE_EXIT(AVB_TRACE_AVTP);
+}
+
+int openavbAvtpRxDemuxBufLevel(avtp_stream_t *pStream)
+{
+	avtp_rx_demux_t *pDemux = (avtp_rx_demux_t *)pStream->pRxDemux;
+	if (!pDemux) {
+		return 0;
+	}
+	return openavbRawsockRxBufLevel(pDemux->rawsock);
+}
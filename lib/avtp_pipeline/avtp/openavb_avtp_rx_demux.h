@@ -0,0 +1,60 @@
+/*************************************************************************************************************
+Copyright (c) 2012-2015, Symphony Teleca Corporation, a Harman International Industries, Incorporated company
+Copyright (c) 2016-2017, Harman International Industries, Incorporated
+All rights reserved.
+ 
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ 
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ 
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS LISTED "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS LISTED BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ 
+Attributions: The inih library portion of the source code is licensed from 
+Brush Technology and Ben Hoyt - Copyright (c) 2009, Brush Technology and Copyright (c) 2009, Ben Hoyt. 
+Complete license and copyright information can be found at 
+https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
+*************************************************************************************************************/
+
+/*
+* HEADER SUMMARY : Shared AVTP RX demultiplexer.
+*
+* Listener streams that use the demultiplexer don't open their own raw socket.
+* A single socket per interface receives the frames for all of them and hands
+* each frame to the stream with the matching stream ID.
+*/
+
+#ifndef AVB_AVTP_RX_DEMUX_H
+#define AVB_AVTP_RX_DEMUX_H 1
+
+#include "openavb_avtp.h"
+
+// Create / destroy the global demultiplexer state.
+bool openavbAvtpRxDemuxInitialize(void);
+void openavbAvtpRxDemuxFinalize(void);
+
+// Start delivering the frames of a stream. Opens the interface socket and
+// starts the demultiplexer thread when this is the first stream on it.
+bool openavbAvtpRxDemuxAdd(avtp_stream_t *pStream);
+
+// Stop delivering frames to a stream. On return the demultiplexer thread no
+// longer uses the stream.
+void openavbAvtpRxDemuxRemove(avtp_stream_t *pStream);
+
+// RX buffer level of the socket shared by the stream.
+int openavbAvtpRxDemuxBufLevel(avtp_stream_t *pStream);
+
+#endif //AVB_AVTP_RX_DEMUX_H
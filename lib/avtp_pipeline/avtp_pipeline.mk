@@ -1,6 +1,8 @@
 AVB_FEATURE_ENDPOINT ?= 1
 IGB_LAUNCHTIME_ENABLED ?= 0
 AVB_FEATURE_GSTREAMER ?= 0
+AVB_FEATURE_XDP ?= 0
+AVB_FEATURE_USDT ?= 1
 PLATFORM_TOOLCHAIN ?= generic
 
 .PHONY: all clean
@@ -24,4 +26,6 @@ build/Makefile:
 	      -DAVB_FEATURE_ENDPOINT=$(AVB_FEATURE_ENDPOINT) \
 	      -DIGB_LAUNCHTIME_ENABLED=$(IGB_LAUNCHTIME_ENABLED) \
 	      -DAVB_FEATURE_GSTREAMER=$(AVB_FEATURE_GSTREAMER) \
+	      -DAVB_FEATURE_XDP=$(AVB_FEATURE_XDP) \
+	      -DAVB_FEATURE_USDT=$(AVB_FEATURE_USDT) \
 	      ..
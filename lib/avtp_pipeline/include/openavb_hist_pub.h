@@ -0,0 +1,99 @@
+/*************************************************************************************************************
+Copyright (c) 2012-2015, Symphony Teleca Corporation, a Harman International Industries, Incorporated company
+Copyright (c) 2016-2017, Harman International Industries, Incorporated
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS LISTED "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS LISTED BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Attributions: The inih library portion of the source code is licensed from
+Brush Technology and Ben Hoyt - Copyright (c) 2009, Brush Technology and Copyright (c) 2009, Ben Hoyt.
+Complete license and copyright information can be found at
+https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
+*************************************************************************************************************/
+
+/*
+* MODULE SUMMARY : Fixed memory log-linear histogram Public
+*/
+
+#ifndef OPENAVB_HIST_PUB_H
+#define OPENAVB_HIST_PUB_H 1
+
+#include "openavb_types_pub.h"
+
+/** \file
+ * Fixed memory log-linear histogram.
+ *
+ * Each power of 2 range is split into OPENAVB_HIST_SUB_CNT linear buckets,
+ * so a value is known to within 1/OPENAVB_HIST_SUB_CNT of itself.
+ * Negative values are counted by magnitude in separate buckets.
+ */
+
+/// Number of bits of a value kept below its most significant bit
+#define OPENAVB_HIST_SUB_BITS	3
+/// Linear buckets per power of 2
+#define OPENAVB_HIST_SUB_CNT	(1 << OPENAVB_HIST_SUB_BITS)
+/// Magnitudes of 2^OPENAVB_HIST_MAX_BITS and above share the last bucket
+#define OPENAVB_HIST_MAX_BITS	36
+/// Buckets for each sign
+#define OPENAVB_HIST_BUCKETS	((OPENAVB_HIST_MAX_BITS - OPENAVB_HIST_SUB_BITS + 1) * OPENAVB_HIST_SUB_CNT)
+
+/** Histogram.
+ */
+typedef struct {
+	/// Number of values added
+	U32 count;
+	/// Smallest value added
+	S64 min;
+	/// Largest value added
+	S64 max;
+	/// Sum of the values added
+	S64 sum;
+	/// Counts of the values >= 0
+	U32 pos[OPENAVB_HIST_BUCKETS];
+	/// Counts of the values < 0, by magnitude
+	U32 neg[OPENAVB_HIST_BUCKETS];
+} openavb_hist_t;
+
+/** Clear a histogram.
+ *
+ * \param pHist Pointer to the histogram
+ */
+void openavbHistClear(openavb_hist_t *pHist);
+
+/** Add a value to a histogram.
+ *
+ * \param pHist Pointer to the histogram
+ * \param val The value to add
+ */
+void openavbHistAdd(openavb_hist_t *pHist, S64 val);
+
+/** Get a percentile of the values in a histogram.
+ *
+ * The result is the upper bound of the bucket holding the percentile,
+ * limited to the range of the values added.
+ *
+ * \param pHist Pointer to the histogram
+ * \param percent The percentile to get (0.0 to 100.0)
+ * \return The value of the percentile, 0 if the histogram is empty
+ */
+S64 openavbHistPercentile(const openavb_hist_t *pHist, double percent);
+
+#endif // OPENAVB_HIST_PUB_H
@@ -188,6 +188,22 @@ typedef void (*openavb_intf_set_stream_uid_t)(media_q_t *pMediaQ, U16 stream_uid
  */
 typedef void (*openavb_intf_enable_fixed_timestamp)(media_q_t *pMediaQ, bool enable, U32 transmitInterval, U32 batchFactor);
 
+/** Wait for transmit data callback.
+ *
+ * Used by the talker when tx_intf_wakeup is set: instead of sleeping a fixed
+ * interval, the talker thread blocks in this callback until the interface has
+ * the data for a full media queue item (for example, an audio period captured
+ * on the device clock), then sends whatever the interface has produced.
+ *
+ * \param pMediaQ A pointer to the media queue for this stream
+ * \param timeoutUsec Longest time to wait, in microseconds
+ * \return TRUE if data for a media queue item is ready, FALSE on timeout
+ *
+ * \note  This callback is optional, does not need to be implemented in the
+ * interface module.
+ */
+typedef bool (*openavb_intf_tx_wait_cb_t)(media_q_t *pMediaQ, U32 timeoutUsec);
+
 /** Interface callbacks structure.
  */
 typedef struct {
@@ -217,6 +233,8 @@ typedef struct {
 	openavb_intf_set_stream_uid_t  intf_set_stream_uid_cb;
 	/// Enable fixed timestamp callback
 	openavb_intf_enable_fixed_timestamp intf_enable_fixed_timestamp;
+	/// Wait for transmit data callback
+	openavb_intf_tx_wait_cb_t		intf_tx_wait_cb;
 } openavb_intf_cb_t;
 
 /** Main initialization entry point into the interface module.
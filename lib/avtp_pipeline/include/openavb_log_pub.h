@@ -136,10 +136,16 @@ static const bool OPENAVB_LOG_PULL_MODE = FALSE;
 #define LOG_QUEUE_MSG_LEN		256
 #define LOG_QUEUE_MSG_SIZE		(LOG_QUEUE_MSG_LEN + 1)
 #define LOG_QUEUE_MSG_CNT		82
-#define LOG_QUEUE_SLEEP_MSEC	100
+#define LOG_QUEUE_SLEEP_MSEC	20
 
 // RT (RealTime logging) related defines
-#define LOG_RT_QUEUE_CNT		128
+// Each thread using the RT log calls gets its own ring of LOG_RT_RING_CNT
+// records (must be a power of 2). A record holds the format pointer, a
+// timestamp and up to LOG_RT_MAX_ARGS raw arguments; the text is only
+// rendered when the ring is drained. Records that don't fit are dropped
+// and counted, the RT thread never blocks.
+#define LOG_RT_RING_CNT			256
+#define LOG_RT_MAX_ARGS			8
 #define LOG_RT_BEGIN			TRUE
 #define LOG_RT_ITEM				TRUE
 #define LOG_RT_END				TRUE
@@ -194,6 +200,21 @@ void avbLogFn(
 
 void avbLogRT(int level, bool bBegin, bool bItem, bool bEnd, char *pFormat, log_rt_datatype_t dataType, void *pVar);
 
+// Queue a message on the calling thread's RT log ring. Safe to use from the
+// RT threads: no locking and no formatting is done by the caller.
+// The format must be a string literal, %s arguments must point to strings
+// that outlive the message (e.g. literals) and '*' width/precision and
+// long double conversions are not supported.
+void avbLogRTFn(
+	int level,
+	const char *tag,
+	const char *company,
+	const char *component,
+	const char *path,
+	int line,
+	const char *fmt,
+	...);
+
 void avbLogBuffer(
 	int level,
 	const U8 *pData,
@@ -217,6 +238,12 @@ void avbLogBuffer(
             avbLogRT(0, bBegin, bItem, bEnd, pFormat, dataType, pVar); \
     }
 
+#define avbLogRTFn2(level, tag, company, component, path, line, fmt, ...) \
+    {\
+        if (level <= AVB_LOG_LEVEL) \
+            avbLogRTFn(0, tag, company, component, path, line, fmt, __VA_ARGS__); \
+    }
+
 #define avbLogBuffer2(level, pData, dataLen, lineLen, company, component, path, line) \
     {\
         if (level <= AVB_LOG_LEVEL) \
@@ -244,6 +271,12 @@ void avbLogBuffer(
 #define AVB_LOGRT_STATUS(BEGIN, ITEM, END, FMT, TYPE, VAL)	avbLogRT2(AVB_LOG_LEVEL_STATUS, BEGIN, ITEM, END, FMT, TYPE, VAL)
 #define AVB_LOGRT_DEBUG(BEGIN, ITEM, END, FMT, TYPE, VAL)	avbLogRT2(AVB_LOG_LEVEL_DEBUG, BEGIN, ITEM, END, FMT, TYPE, VAL)
 #define AVB_LOGRT_VERBOSE(BEGIN, ITEM, END, FMT, TYPE, VAL)	avbLogRT2(AVB_LOG_LEVEL_VERBOSE, BEGIN, ITEM, END, FMT, TYPE, VAL)
+#define AVB_LOGRTF_ERROR(FMT, ...)    avbLogRTFn2(AVB_LOG_LEVEL_ERROR,   "ERROR",   AVB_LOG_COMPANY, AVB_LOG_COMPONENT, __FILE__, __LINE__, FMT, __VA_ARGS__)
+#define AVB_LOGRTF_WARNING(FMT, ...)  avbLogRTFn2(AVB_LOG_LEVEL_WARNING, "WARNING", AVB_LOG_COMPANY, AVB_LOG_COMPONENT, __FILE__, __LINE__, FMT, __VA_ARGS__)
+#define AVB_LOGRTF_INFO(FMT, ...)     avbLogRTFn2(AVB_LOG_LEVEL_INFO,    "INFO",    AVB_LOG_COMPANY, AVB_LOG_COMPONENT, __FILE__, __LINE__, FMT, __VA_ARGS__)
+#define AVB_LOGRTF_STATUS(FMT, ...)   avbLogRTFn2(AVB_LOG_LEVEL_STATUS,  "STATUS",  AVB_LOG_COMPANY, AVB_LOG_COMPONENT, __FILE__, __LINE__, FMT, __VA_ARGS__)
+#define AVB_LOGRTF_DEBUG(FMT, ...)    avbLogRTFn2(AVB_LOG_LEVEL_DEBUG,   "DEBUG",   AVB_LOG_COMPANY, AVB_LOG_COMPONENT, __FILE__, __LINE__, FMT, __VA_ARGS__)
+#define AVB_LOGRTF_VERBOSE(FMT, ...)  avbLogRTFn2(AVB_LOG_LEVEL_VERBOSE, "VERBOSE", AVB_LOG_COMPANY, AVB_LOG_COMPONENT, __FILE__, __LINE__, FMT, __VA_ARGS__)
 #define AVB_LOG_BUFFER(LEVEL, DATA, DATALEN, LINELINE)   avbLogBuffer2(LEVEL, DATA, DATALEN, LINELINE, AVB_LOG_COMPANY, AVB_LOG_COMPONENT, __FILE__, __LINE__)
 #else
 #define AVB_LOGF_DEV(LEVEL, FMT, ...)
@@ -266,6 +299,12 @@ void avbLogBuffer(
 #define AVB_LOGRT_STATUS(BEGIN, ITEM, END, FMT, TYPE, VAL)
 #define AVB_LOGRT_DEBUG(BEGIN, ITEM, END, FMT, TYPE, VAL)
 #define AVB_LOGRT_VERBOSE(BEGIN, ITEM, END, FMT, TYPE, VAL)
+#define AVB_LOGRTF_ERROR(FMT, ...)
+#define AVB_LOGRTF_WARNING(FMT, ...)
+#define AVB_LOGRTF_INFO(FMT, ...)
+#define AVB_LOGRTF_STATUS(FMT, ...)
+#define AVB_LOGRTF_DEBUG(FMT, ...)
+#define AVB_LOGRTF_VERBOSE(FMT, ...)
 #define AVB_LOG_BUFFER(LEVEL, DATA, DATALEN, LINELINE)
 #endif	// AVB_LOG_ON
 
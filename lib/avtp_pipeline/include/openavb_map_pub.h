@@ -120,6 +120,60 @@ typedef void (*openavb_map_tx_init_cb_t)(media_q_t *pMediaQ);
  */
 typedef tx_cb_ret_t(*openavb_map_tx_cb_t)(media_q_t *pMediaQ, U8 *pData, U32 *datalen);
 
+/** Talker callback that leaves the payload in the media queue item.
+ *
+ * Same as openavb_map_tx_cb_t(), but only the AVTP header is written to pData.
+ * Instead of being copied, the payload is sent straight from the media queue
+ * item, which the mapping module takes with openavbMediaQTailItemTake() and
+ * returns in ppItem. The AVTP layer gives the item back with
+ * openavbMediaQTailItemGive() once the frame has been sent.
+ * \param pMediaQ A pointer to the media queue for this stream
+ * \param pData pointer to the AVTP header
+ * \param[out] dataLen length of the AVTP header
+ * \param[out] ppItem the taken item; its pPubData and dataLen are the payload
+ * \return One of enum \ref tx_cb_ret_t values.
+ *
+ * \note This callback is optional, does not need to be implemented in the
+ * mapping module. When set, it is used instead of openavb_map_tx_cb_t().
+ */
+typedef tx_cb_ret_t(*openavb_map_tx_ref_cb_t)(media_q_t *pMediaQ, U8 *pData, U32 *dataLen, media_q_item_t **ppItem);
+
+/** Fill the constant part of the talker's AVTP header.
+ *
+ * Called once when the talker starts, after the general and transmit
+ * initialize callbacks. pHdr holds the AVTP common header; the mapping
+ * module adds the format specific fields that are the same in every frame.
+ * The result is copied into each frame before openavb_map_tx_cb_t() is
+ * called, which then only has to set the fields that change.
+ * \param pMediaQ A pointer to the media queue for this stream
+ * \param pHdr pointer to the start of the AVTP header
+ * \param hdrLen room available at pHdr
+ * \return Number of bytes from pHdr to copy into each frame; 0 if none.
+ *
+ * \note This callback is optional, does not need to be implemented in the
+ * mapping module.
+ */
+typedef U32(*openavb_map_tx_hdr_cb_t)(media_q_t *pMediaQ, U8 *pHdr, U32 hdrLen);
+
+/** Fill several AVTP frames in one call.
+ *
+ * Same as openavb_map_tx_cb_t(), but for up to nFrames frames of a transmit
+ * interval at once, so the media queue item is locked only once for them.
+ * Each frame already holds the header template and its sequence number.
+ * \param pMediaQ A pointer to the media queue for this stream
+ * \param ppData pointers to the AVTP headers of the frames
+ * \param[in,out] pDataLen per frame, room available on input and length of
+ *        the AVTP frame on output
+ * \param nFrames number of frames in ppData and pDataLen
+ * \return Number of frames filled, from the first one on; 0 if no data is
+ *         ready.
+ *
+ * \note This callback is optional, does not need to be implemented in the
+ * mapping module. When set, the talker uses it instead of
+ * openavb_map_tx_cb_t() if the raw socket can hold several TX frames.
+ */
+typedef U32(*openavb_map_tx_batch_cb_t)(media_q_t *pMediaQ, U8 **ppData, U32 *pDataLen, U32 nFrames);
+
 /** A call to this callback indicates that this mapping module will be
  * a listener.
  *
@@ -208,6 +262,12 @@ typedef struct {
 	openavb_map_set_src_bitrate_cb_t    map_set_src_bitrate_cb;
 	/// Max interval frames callback.
 	openavb_map_get_max_interval_frames_cb_t map_get_max_interval_frames_cb;
+	/// Transmit callback without payload copy.
+	openavb_map_tx_ref_cb_t				map_tx_ref_cb;
+	/// Constant AVTP header callback.
+	openavb_map_tx_hdr_cb_t				map_tx_hdr_cb;
+	/// Transmit callback for several frames.
+	openavb_map_tx_batch_cb_t			map_tx_batch_cb;
 } openavb_map_cb_t;
 
 /** Main initialization entry point into the mapping module.
@@ -76,4 +76,42 @@ https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
 #define AVB_TRACE_HAL_ETHER_DETAIL		0
 #define AVB_TRACE_HAL_TASK_TIMER		0
 #define AVB_TRACE_DEBUG					0
+
+// The detail features trace the per frame paths. Release builds never
+// compile them in, whatever is set above.
+#if defined(RELEASE_BUILD) || defined(MINSIZEREL_BUILD)
+#undef AVB_TRACE_AVTP_DETAIL
+#define AVB_TRACE_AVTP_DETAIL			0
+#undef AVB_TRACE_AVTP_TIME_DETAIL
+#define AVB_TRACE_AVTP_TIME_DETAIL		0
+#undef AVB_TRACE_MEDIAQ_DETAIL
+#define AVB_TRACE_MEDIAQ_DETAIL			0
+#undef AVB_TRACE_RAWSOCK_DETAIL
+#define AVB_TRACE_RAWSOCK_DETAIL		0
+#undef AVB_TRACE_TL_DETAIL
+#define AVB_TRACE_TL_DETAIL				0
+#undef AVB_TRACE_FQTSS_DETAIL
+#define AVB_TRACE_FQTSS_DETAIL			0
+#undef AVB_TRACE_HAL_ETHER_DETAIL
+#define AVB_TRACE_HAL_ETHER_DETAIL		0
+#endif
+
+// Static probes for perf, bpftrace and systemtap (provider "openavb").
+// An unattached probe is a nop plus a note section entry, so they stay in
+// production builds. Arguments must be integers or pointers.
+#if AVB_FEATURE_USDT
+#include <sys/sdt.h>
+#define AVB_TRACE_PROBE(NAME)						DTRACE_PROBE(openavb, NAME)
+#define AVB_TRACE_PROBE1(NAME, A1)					DTRACE_PROBE1(openavb, NAME, A1)
+#define AVB_TRACE_PROBE2(NAME, A1, A2)				DTRACE_PROBE2(openavb, NAME, A1, A2)
+#define AVB_TRACE_PROBE3(NAME, A1, A2, A3)			DTRACE_PROBE3(openavb, NAME, A1, A2, A3)
+#define AVB_TRACE_PROBE4(NAME, A1, A2, A3, A4)		DTRACE_PROBE4(openavb, NAME, A1, A2, A3, A4)
+#else
+#define AVB_TRACE_PROBE(NAME)
+#define AVB_TRACE_PROBE1(NAME, A1)
+#define AVB_TRACE_PROBE2(NAME, A1, A2)
+#define AVB_TRACE_PROBE3(NAME, A1, A2, A3)
+#define AVB_TRACE_PROBE4(NAME, A1, A2, A3, A4)
+#endif
+
 #endif // AVB_TRACE_H
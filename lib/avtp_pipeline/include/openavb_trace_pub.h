@@ -87,6 +87,14 @@ https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
 #define AVB_TRACE_INTF_LINE				0
 #define AVB_TRACE_HOST					0
 
+// Release builds never compile in the detail features
+#if defined(RELEASE_BUILD) || defined(MINSIZEREL_BUILD)
+#undef AVB_TRACE_MAP_DETAIL
+#define AVB_TRACE_MAP_DETAIL			0
+#undef AVB_TRACE_INTF_DETAIL
+#define AVB_TRACE_INTF_DETAIL			0
+#endif
+
 #define TRACE_VAR1(x, y) x ## y
 #define TRACE_VAR2(x, y) TRACE_VAR1(x, y)
 
@@ -110,6 +110,9 @@ typedef struct {
 	// Ratio precalc
 	float ratio;
 
+	// Frames generated so far, for the phase of the tone
+	U32 runningFrameCnt;
+
 	// Index to into the melody string
 	U32 melodyIdx;
 
@@ -393,6 +396,7 @@ void openavbIntfToneGenTxInitCB(media_q_t *pMediaQ)
 		}
 		
 		pPvtData->melodyIdx = 0;
+		pPvtData->runningFrameCnt = 0;
 	}
 
 	AVB_TRACE_EXIT(AVB_TRACE_INTF);
@@ -477,7 +481,6 @@ bool openavbIntfToneGenTxCB(media_q_t *pMediaQ)
 			}
 
 			// Tone on
-			static U32 runningFrameCnt = 0;
 			U32 frameCnt;
 			U32 channelCnt;
 			U8 *pData = pMediaQItem->pPubData;
@@ -518,7 +521,7 @@ bool openavbIntfToneGenTxCB(media_q_t *pMediaQ)
 				}
 				pPvtData->freqCountdown--;
 
-				float value = SIN(2 * PI * (runningFrameCnt++ % pPubMapUncmpAudioInfo->audioRate) * pPvtData->ratio) * pPvtData->volume;
+				float value = SIN(2 * PI * (pPvtData->runningFrameCnt++ % pPubMapUncmpAudioInfo->audioRate) * pPvtData->ratio) * pPvtData->volume;
 
 				for (channelCnt = 0; channelCnt < pPubMapUncmpAudioInfo->audioChannels - pPvtData->fvChannels; channelCnt++) {
 					if (pPvtData->audioType == AVB_AUDIO_TYPE_INT) {
@@ -0,0 +1,245 @@
+/*************************************************************************************************************
+Copyright (c) 2012-2015, Symphony Teleca Corporation, a Harman International Industries, Incorporated company
+Copyright (c) 2016-2017, Harman International Industries, Incorporated
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS LISTED "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS LISTED BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Attributions: The inih library portion of the source code is licensed from
+Brush Technology and Ben Hoyt - Copyright (c) 2009, Brush Technology and Copyright (c) 2009, Ben Hoyt.
+Complete license and copyright information can be found at
+https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
+*************************************************************************************************************/
+
+/*
+ * MODULE SUMMARY : AAF sample layout conversion
+ */
+
+#include <string.h>
+#include "openavb_aaf_conv.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define AAF_CONV_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define AAF_CONV_NEON 1
+#endif
+
+// Same layout in and out
+static void x_convCopy(const aaf_conv_t *pConv, U8 *pOut, const U8 *pIn, U32 nSamples)
+{
+	memcpy(pOut, pIn, nSamples * pConv->inBytes);
+}
+
+// One scalar version per sample size pair, so the compiler knows the strides.
+// Padding bytes read byte 0 and mask it off; no branch per byte.
+#define AAF_CONV_SCALAR(IB, OB) \
+static void x_convScalar##IB##OB(const aaf_conv_t *pConv, U8 *pOut, const U8 *pIn, U32 nSamples) \
+{ \
+	U8 * restrict o = pOut; \
+	const U8 * restrict i = pIn; \
+	const U8 s0 = pConv->map[0] & 0x03, s1 = pConv->map[1] & 0x03; \
+	const U8 s2 = pConv->map[2] & 0x03, s3 = pConv->map[3] & 0x03; \
+	const U8 k0 = (pConv->map[0] == AAF_CONV_ZERO) ? 0x00 : 0xFF; \
+	const U8 k1 = (pConv->map[1] == AAF_CONV_ZERO) ? 0x00 : 0xFF; \
+	const U8 k2 = (pConv->map[2] == AAF_CONV_ZERO) ? 0x00 : 0xFF; \
+	const U8 k3 = (pConv->map[3] == AAF_CONV_ZERO) ? 0x00 : 0xFF; \
+	while (nSamples--) { \
+		o[0] = i[s0] & k0; \
+		if (OB > 1) o[1] = i[s1] & k1; \
+		if (OB > 2) o[2] = i[s2] & k2; \
+		if (OB > 3) o[3] = i[s3] & k3; \
+		i += IB; \
+		o += OB; \
+	} \
+}
+
+AAF_CONV_SCALAR(1, 1)
+AAF_CONV_SCALAR(1, 2)
+AAF_CONV_SCALAR(1, 3)
+AAF_CONV_SCALAR(1, 4)
+AAF_CONV_SCALAR(2, 1)
+AAF_CONV_SCALAR(2, 2)
+AAF_CONV_SCALAR(2, 3)
+AAF_CONV_SCALAR(2, 4)
+AAF_CONV_SCALAR(3, 1)
+AAF_CONV_SCALAR(3, 2)
+AAF_CONV_SCALAR(3, 3)
+AAF_CONV_SCALAR(3, 4)
+AAF_CONV_SCALAR(4, 1)
+AAF_CONV_SCALAR(4, 2)
+AAF_CONV_SCALAR(4, 3)
+AAF_CONV_SCALAR(4, 4)
+
+// Indexed by [inBytes - 1][outBytes - 1]
+static const aaf_conv_fn_t s_convScalar[4][4] = {
+	{ x_convScalar11, x_convScalar12, x_convScalar13, x_convScalar14 },
+	{ x_convScalar21, x_convScalar22, x_convScalar23, x_convScalar24 },
+	{ x_convScalar31, x_convScalar32, x_convScalar33, x_convScalar34 },
+	{ x_convScalar41, x_convScalar42, x_convScalar43, x_convScalar44 },
+};
+
+// The SIMD versions load and store whole 16 byte blocks, of which only
+// blockSamples samples are used. They stop while a full block still fits
+// in both buffers and leave the rest to the scalar loop.
+#define BLOCK_FITS(pConv, n)	((n) * (pConv)->inBytes >= 16 && (n) * (pConv)->outBytes >= 16)
+
+#if AAF_CONV_X86
+__attribute__((target("ssse3")))
+static void x_convSsse3(const aaf_conv_t *pConv, U8 *pOut, const U8 *pIn, U32 nSamples)
+{
+	const __m128i mask = _mm_loadu_si128((const __m128i *)pConv->blockMask);
+	const U32 inStep = pConv->blockSamples * pConv->inBytes;
+	const U32 outStep = pConv->blockSamples * pConv->outBytes;
+
+	while (BLOCK_FITS(pConv, nSamples)) {
+		__m128i v = _mm_loadu_si128((const __m128i *)pIn);
+		_mm_storeu_si128((__m128i *)pOut, _mm_shuffle_epi8(v, mask));
+		pIn += inStep;
+		pOut += outStep;
+		nSamples -= pConv->blockSamples;
+	}
+	pConv->scalarFn(pConv, pOut, pIn, nSamples);
+}
+
+__attribute__((target("avx2")))
+static void x_convAvx2(const aaf_conv_t *pConv, U8 *pOut, const U8 *pIn, U32 nSamples)
+{
+	const __m128i mask128 = _mm_loadu_si128((const __m128i *)pConv->blockMask);
+	const __m256i mask = _mm256_broadcastsi128_si256(mask128);
+	const U32 inStep = pConv->blockSamples * pConv->inBytes;
+	const U32 outStep = pConv->blockSamples * pConv->outBytes;
+
+	// Two blocks per iteration, one in each 128 bit lane
+	while (nSamples >= pConv->blockSamples && BLOCK_FITS(pConv, nSamples - pConv->blockSamples)) {
+		__m256i v = _mm256_inserti128_si256(
+			_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)pIn)),
+			_mm_loadu_si128((const __m128i *)(pIn + inStep)), 1);
+		v = _mm256_shuffle_epi8(v, mask);
+		// Low block first; the high block overwrites its unused tail
+		_mm_storeu_si128((__m128i *)pOut, _mm256_castsi256_si128(v));
+		_mm_storeu_si128((__m128i *)(pOut + outStep), _mm256_extracti128_si256(v, 1));
+		pIn += 2 * inStep;
+		pOut += 2 * outStep;
+		nSamples -= 2 * pConv->blockSamples;
+	}
+	while (BLOCK_FITS(pConv, nSamples)) {
+		__m128i v = _mm_loadu_si128((const __m128i *)pIn);
+		_mm_storeu_si128((__m128i *)pOut, _mm_shuffle_epi8(v, mask128));
+		pIn += inStep;
+		pOut += outStep;
+		nSamples -= pConv->blockSamples;
+	}
+	pConv->scalarFn(pConv, pOut, pIn, nSamples);
+}
+#endif
+
+#if AAF_CONV_NEON
+static void x_convNeon(const aaf_conv_t *pConv, U8 *pOut, const U8 *pIn, U32 nSamples)
+{
+	// Table lookups with an index >= 16 give zero, as AAF_CONV_ZERO does
+	const uint8x16_t mask = vld1q_u8(pConv->blockMask);
+	const U32 inStep = pConv->blockSamples * pConv->inBytes;
+	const U32 outStep = pConv->blockSamples * pConv->outBytes;
+
+	while (BLOCK_FITS(pConv, nSamples)) {
+		vst1q_u8(pOut, vqtbl1q_u8(vld1q_u8(pIn), mask));
+		pIn += inStep;
+		pOut += outStep;
+		nSamples -= pConv->blockSamples;
+	}
+	pConv->scalarFn(pConv, pOut, pIn, nSamples);
+}
+#endif
+
+bool openavbAafConvInit(aaf_conv_t *pConv, U8 inBytes, bool inLittleEndian, U8 outBytes, bool outLittleEndian)
+{
+	if (!pConv || inBytes < 1 || inBytes > 4 || outBytes < 1 || outBytes > 4) {
+		return FALSE;
+	}
+
+	memset(pConv, 0, sizeof(*pConv));
+	pConv->inBytes = inBytes;
+	pConv->outBytes = outBytes;
+
+	// Byte j of the output is significance rank c (0 = most significant).
+	// Ranks the input doesn't have are padding.
+	U8 j, s;
+	for (j = 0; j < outBytes; j++) {
+		U8 c = outLittleEndian ? outBytes - 1 - j : j;
+		if (c < inBytes) {
+			pConv->map[j] = inLittleEndian ? inBytes - 1 - c : c;
+		}
+		else {
+			pConv->map[j] = AAF_CONV_ZERO;
+		}
+	}
+
+	pConv->blockSamples = 16 / (inBytes > outBytes ? inBytes : outBytes);
+	memset(pConv->blockMask, AAF_CONV_ZERO, sizeof(pConv->blockMask));
+	for (s = 0; s < pConv->blockSamples; s++) {
+		for (j = 0; j < outBytes; j++) {
+			U8 src = pConv->map[j];
+			pConv->blockMask[s * outBytes + j] = (src == AAF_CONV_ZERO) ? AAF_CONV_ZERO : s * inBytes + src;
+		}
+	}
+
+	if (inBytes == outBytes && inLittleEndian == outLittleEndian) {
+		pConv->fn = pConv->scalarFn = x_convCopy;
+		return TRUE;
+	}
+
+	pConv->scalarFn = s_convScalar[inBytes - 1][outBytes - 1];
+	pConv->fn = pConv->scalarFn;
+#if AAF_CONV_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		pConv->fn = x_convAvx2;
+	}
+	else if (__builtin_cpu_supports("ssse3")) {
+		pConv->fn = x_convSsse3;
+	}
+#elif AAF_CONV_NEON
+	pConv->fn = x_convNeon;
+#endif
+	return TRUE;
+}
+
+const char *openavbAafConvName(const aaf_conv_t *pConv)
+{
+	if (pConv->fn == x_convCopy) {
+		return "copy";
+	}
+#if AAF_CONV_X86
+	if (pConv->fn == x_convAvx2) {
+		return "avx2";
+	}
+	if (pConv->fn == x_convSsse3) {
+		return "ssse3";
+	}
+#elif AAF_CONV_NEON
+	if (pConv->fn == x_convNeon) {
+		return "neon";
+	}
+#endif
+	return "scalar";
+}
@@ -0,0 +1,84 @@
+/*************************************************************************************************************
+Copyright (c) 2012-2015, Symphony Teleca Corporation, a Harman International Industries, Incorporated company
+Copyright (c) 2016-2017, Harman International Industries, Incorporated
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS LISTED "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS LISTED BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Attributions: The inih library portion of the source code is licensed from
+Brush Technology and Ben Hoyt - Copyright (c) 2009, Brush Technology and Copyright (c) 2009, Ben Hoyt.
+Complete license and copyright information can be found at
+https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
+*************************************************************************************************************/
+
+/*
+ * HEADER SUMMARY : AAF sample layout conversion
+ *
+ * Converts audio samples between the layout on the wire (big endian, 1 to 4
+ * bytes) and the layout in media queue items (1 to 4 bytes in either byte
+ * order). Integer samples are padded or truncated at the least
+ * significant end (IEEE 1722-2016 Clause 7.3.4); 32 bit float samples only
+ * have their byte order changed.
+ *
+ * Every conversion is a fixed byte permutation of each sample, so a single
+ * byte shuffle per 16 bytes does the work where the CPU has one (SSSE3, AVX2,
+ * NEON). The implementation is picked at run time when the conversion is set
+ * up.
+ */
+
+#ifndef OPENAVB_AAF_CONV_H
+#define OPENAVB_AAF_CONV_H 1
+
+#include "openavb_types_pub.h"
+
+struct aaf_conv;
+typedef void (*aaf_conv_fn_t)(const struct aaf_conv *pConv, U8 *pOut, const U8 *pIn, U32 nSamples);
+
+typedef struct aaf_conv {
+	// Bytes per sample in and out
+	U8 inBytes;
+	U8 outBytes;
+	// Source byte of each output byte of a sample; AAF_CONV_ZERO for padding
+	U8 map[4];
+	// Same for a block of samples fitting in 16 bytes (in and out)
+	U8 blockMask[16];
+	U8 blockSamples;
+	// Implementation picked for this conversion and CPU
+	aaf_conv_fn_t fn;
+	// Plain C implementation, also used for what is left over by fn
+	aaf_conv_fn_t scalarFn;
+} aaf_conv_t;
+
+#define AAF_CONV_ZERO 0x80
+
+// Set up a conversion. Returns FALSE for unsupported sample sizes.
+bool openavbAafConvInit(aaf_conv_t *pConv, U8 inBytes, bool inLittleEndian, U8 outBytes, bool outLittleEndian);
+
+// Convert nSamples samples from pIn to pOut. The buffers must not overlap.
+static inline void openavbAafConv(const aaf_conv_t *pConv, U8 *pOut, const U8 *pIn, U32 nSamples)
+{
+	pConv->fn(pConv, pOut, pIn, nSamples);
+}
+
+// Name of the implementation used by a conversion (for logging)
+const char *openavbAafConvName(const aaf_conv_t *pConv);
+
+#endif  // OPENAVB_AAF_CONV_H
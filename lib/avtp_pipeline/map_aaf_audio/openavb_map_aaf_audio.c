@@ -44,6 +44,7 @@ https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
 #include "openavb_mediaq_pub.h"
 #include "openavb_map_pub.h"
 #include "openavb_map_aaf_audio_pub.h"
+#include "openavb_aaf_conv.h"
 
 #define	AVB_LOG_COMPONENT	"AAF Mapping"
 #include "openavb_log_pub.h"
@@ -155,6 +156,11 @@ typedef struct {
 
 	bool mediaQItemSyncTS;
 
+	// Sample layout conversion between media queue items and AAF payloads
+	aaf_conv_t txConv;
+	aaf_conv_t rxConv;
+	aaf_sample_format_t rxConvFormat;
+
 } pvt_data_t;
 
 static void x_calculateSizes(media_q_t *pMediaQ)
@@ -251,7 +257,6 @@ static void x_calculateSizes(media_q_t *pMediaQ)
 					pPubMapInfo->packetSampleSizeBytes = 3;
 					pPvtData->aaf_bit_depth = 20;
 					break;
-					// would require byte-by-byte copy
 				case AVB_AUDIO_BIT_DEPTH_8BIT:
 					pPvtData->aaf_format = AAF_FORMAT_INT_24;
 					pPubMapInfo->itemSampleSizeBytes = 1;
@@ -437,6 +442,18 @@ void openavbMapAVTPAudioGenInitCB(media_q_t *pMediaQ)
 		x_calculateSizes(pMediaQ);
 		openavbMediaQSetSize(pMediaQ, pPvtData->itemCount, pPubMapInfo->itemSize);
 
+		// AAF samples are big-endian on the wire.
+		if (openavbAafConvInit(&pPvtData->txConv,
+				pPubMapInfo->itemSampleSizeBytes, pPubMapInfo->audioEndian == AVB_AUDIO_ENDIAN_LITTLE,
+				pPubMapInfo->packetSampleSizeBytes, FALSE)) {
+			AVB_LOGF_INFO("Sample conversion: %s", openavbAafConvName(&pPvtData->txConv));
+		}
+		else {
+			AVB_LOGF_ERROR("Unsupported sample sizes: %u byte items, %u byte packets",
+				pPubMapInfo->itemSampleSizeBytes, pPubMapInfo->packetSampleSizeBytes);
+		}
+		pPvtData->rxConvFormat = AAF_FORMAT_UNSPEC;
+
 		pPvtData->dataValid = TRUE;
 	}
 	AVB_TRACE_EXIT(AVB_TRACE_MAP);
@@ -456,10 +473,93 @@ void openavbMapAVTPAudioTxInitCB(media_q_t *pMediaQ)
 	AVB_TRACE_EXIT(AVB_TRACE_MAP);
 }
 
+// Fill the header fields that are the same in every packet this talker sends.
+U32 openavbMapAVTPAudioTxHdrCB(media_q_t *pMediaQ, U8 *pHdr, U32 hdrLen)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_MAP);
+
+	if (!pMediaQ || hdrLen < TOTAL_HEADER_SIZE) {
+		AVB_TRACE_EXIT(AVB_TRACE_MAP);
+		return 0;
+	}
+
+	media_q_pub_map_aaf_audio_info_t *pPubMapInfo = pMediaQ->pPubMapInfo;
+	pvt_data_t *pPvtData = pMediaQ->pPvtMapInfo;
+	if (!pPvtData) {
+		AVB_LOG_ERROR("Private mapping module data not allocated.");
+		AVB_TRACE_EXIT(AVB_TRACE_MAP);
+		return 0;
+	}
+
+	U32 *pHdrFormat = (U32 *)(pHdr + AVTP_V0_HEADER_SIZE + 4);
+	U32 tmp32;
+
+	// - 4 bytes	format info (format, sample rate, channels per frame, bit depth)
+	tmp32 = pPvtData->aaf_format << 24;
+	tmp32 |= pPvtData->aaf_rate  << 20;
+	tmp32 |= pPubMapInfo->audioChannels << 8;
+	tmp32 |= pPvtData->aaf_bit_depth;
+	*pHdrFormat++ = htonl(tmp32);
+
+	// - 4 bytes	packet info (data length, evt field)
+	tmp32 = pPvtData->payloadSize << 16;
+	tmp32 |= pPvtData->aaf_event_field << 8;
+	*pHdrFormat++ = htonl(tmp32);
+
+	// Set (clear) sparse mode flag
+	if (pPvtData->sparseMode == TS_SPARSE_MODE_ENABLED) {
+		pHdr[HIDX_AVTP_HIDE7_SP] |= SP_M0_BIT;
+	} else {
+		pHdr[HIDX_AVTP_HIDE7_SP] &= ~SP_M0_BIT;
+	}
+
+	AVB_TRACE_EXIT(AVB_TRACE_MAP);
+	return TOTAL_HEADER_SIZE;
+}
+
 // CORE_TODO: This callback should be updated to work in a similar way the uncompressed audio mapping. With allowing AVTP packets to be built
 //  from multiple media queue items. This allows interface to set into the media queue blocks of audio frames to properly correspond to
 //  a SYT_INTERVAL. Additionally the public data member sytInterval needs to be set in the same way the uncompressed audio mapping does.
 // This talker callback will be called for each AVB observation interval.
+// Set the AVTP timestamp and its valid and uncertain flags of a TX frame
+static void x_fillTimestamp(pvt_data_t *pPvtData, U8 *pHdrV0, media_q_item_t *pMediaQItem)
+{
+	U32 *pHdr = (U32 *)(pHdrV0 + AVTP_V0_HEADER_SIZE);
+
+	// timestamp set in the interface module, here just validate
+	// In sparse mode, the timestamp valid flag should be set every eighth AAF AVPTDU.
+	if (pPvtData->sparseMode == TS_SPARSE_MODE_ENABLED && (pHdrV0[HIDX_AVTP_SEQ_NUM] & 0x07) != 0) {
+		// Skip over this timestamp, as using sparse mode.
+		pHdrV0[HIDX_AVTP_HIDE7_TV1] &= ~0x01;
+		pHdrV0[HIDX_AVTP_HIDE7_TU1] &= ~0x01;
+		*pHdr = 0; // Clear the timestamp field
+	}
+	else if (!openavbAvtpTimeTimestampIsValid(pMediaQItem->pAvtpTime)) {
+		// Error getting the timestamp.  Clear timestamp valid flag.
+		AVB_LOG_ERROR("Unable to get the timestamp value");
+		pHdrV0[HIDX_AVTP_HIDE7_TV1] &= ~0x01;
+		pHdrV0[HIDX_AVTP_HIDE7_TU1] &= ~0x01;
+		*pHdr = 0; // Clear the timestamp field
+	}
+	else {
+		// Add the max transit time.
+		openavbAvtpTimeAddUSec(pMediaQItem->pAvtpTime, pPvtData->maxTransitUsec);
+
+		// Set timestamp valid flag
+		pHdrV0[HIDX_AVTP_HIDE7_TV1] |= 0x01;
+
+		// Set (clear) timestamp uncertain flag
+		if (openavbAvtpTimeTimestampIsUncertain(pMediaQItem->pAvtpTime))
+			pHdrV0[HIDX_AVTP_HIDE7_TU1] |= 0x01;
+		else pHdrV0[HIDX_AVTP_HIDE7_TU1] &= ~0x01;
+
+		// - 4 bytes	avtp_timestamp
+		*pHdr = htonl(openavbAvtpTimeGetAvtpTimestamp(pMediaQItem->pAvtpTime));
+
+		openavbAvtpTimeSetTimestampValid(pMediaQItem->pAvtpTime, FALSE);
+	}
+}
+
 tx_cb_ret_t openavbMapAVTPAudioTxCB(media_q_t *pMediaQ, U8 *pData, U32 *dataLen)
 {
 	media_q_item_t *pMediaQItem = NULL;
@@ -501,9 +601,14 @@ tx_cb_ret_t openavbMapAVTPAudioTxCB(media_q_t *pMediaQ, U8 *pData, U32 *dataLen)
 		return TX_CB_RET_PACKET_NOT_READY;
 	}
 
-	U32 tmp32;
+	if (!pPvtData->txConv.fn) {
+		AVB_LOG_ERROR("Audio sample format not configured");
+		openavbMediaQTailUnlock(pMediaQ);
+		AVB_TRACE_EXIT(AVB_TRACE_MAP_DETAIL);
+		return TX_CB_RET_PACKET_NOT_READY;
+	}
+
 	U8 *pHdrV0 = pData;
-	U32 *pHdr = (U32 *)(pData + AVTP_V0_HEADER_SIZE);
 	U8  *pPayload = pData + TOTAL_HEADER_SIZE;
 
 	U32 bytesProcessed = 0;
@@ -511,57 +616,10 @@ tx_cb_ret_t openavbMapAVTPAudioTxCB(media_q_t *pMediaQ, U8 *pData, U32 *dataLen)
 		pMediaQItem = openavbMediaQTailLock(pMediaQ, TRUE);
 		if (pMediaQItem && pMediaQItem->pPubData && pMediaQItem->dataLen > 0) {
 
-			// timestamp set in the interface module, here just validate
-			// In sparse mode, the timestamp valid flag should be set every eighth AAF AVPTDU.
-			if (pPvtData->sparseMode == TS_SPARSE_MODE_ENABLED && (pHdrV0[HIDX_AVTP_SEQ_NUM] & 0x07) != 0) {
-				// Skip over this timestamp, as using sparse mode.
-				pHdrV0[HIDX_AVTP_HIDE7_TV1] &= ~0x01;
-				pHdrV0[HIDX_AVTP_HIDE7_TU1] &= ~0x01;
-				*pHdr++ = 0; // Clear the timestamp field
-			}
-			else if (!openavbAvtpTimeTimestampIsValid(pMediaQItem->pAvtpTime)) {
-				// Error getting the timestamp.  Clear timestamp valid flag.
-				AVB_LOG_ERROR("Unable to get the timestamp value");
-				pHdrV0[HIDX_AVTP_HIDE7_TV1] &= ~0x01;
-				pHdrV0[HIDX_AVTP_HIDE7_TU1] &= ~0x01;
-				*pHdr++ = 0; // Clear the timestamp field
-			}
-			else {
-				// Add the max transit time.
-				openavbAvtpTimeAddUSec(pMediaQItem->pAvtpTime, pPvtData->maxTransitUsec);
+			x_fillTimestamp(pPvtData, pHdrV0, pMediaQItem);
 
-				// Set timestamp valid flag
-				pHdrV0[HIDX_AVTP_HIDE7_TV1] |= 0x01;
-
-				// Set (clear) timestamp uncertain flag
-				if (openavbAvtpTimeTimestampIsUncertain(pMediaQItem->pAvtpTime))
-					pHdrV0[HIDX_AVTP_HIDE7_TU1] |= 0x01;
-				else pHdrV0[HIDX_AVTP_HIDE7_TU1] &= ~0x01;
-
-				// - 4 bytes	avtp_timestamp
-				*pHdr++ = htonl(openavbAvtpTimeGetAvtpTimestamp(pMediaQItem->pAvtpTime));
-
-				openavbAvtpTimeSetTimestampValid(pMediaQItem->pAvtpTime, FALSE);
-			}
-
-			// - 4 bytes	format info (format, sample rate, channels per frame, bit depth)
-			tmp32 = pPvtData->aaf_format << 24;
-			tmp32 |= pPvtData->aaf_rate  << 20;
-			tmp32 |= pPubMapInfo->audioChannels << 8;
-			tmp32 |= pPvtData->aaf_bit_depth;
-			*pHdr++ = htonl(tmp32);
-
-			// - 4 bytes	packet info (data length, evt field)
-			tmp32 = pPvtData->payloadSize << 16;
-			tmp32 |= pPvtData->aaf_event_field << 8;
-			*pHdr++ = htonl(tmp32);
-
-			// Set (clear) sparse mode flag
-			if (pPvtData->sparseMode == TS_SPARSE_MODE_ENABLED) {
-				pHdrV0[HIDX_AVTP_HIDE7_SP] |= SP_M0_BIT;
-			} else {
-				pHdrV0[HIDX_AVTP_HIDE7_SP] &= ~SP_M0_BIT;
-			}
+			// Format info, packet info and the sparse mode flag come from the
+			// header template (openavbMapAVTPAudioTxHdrCB).
 
 			if ((pMediaQItem->dataLen - pMediaQItem->readIdx) < pPvtData->payloadSize) {
 				// This should not happen so we will just toss it away.
@@ -571,7 +629,8 @@ tx_cb_ret_t openavbMapAVTPAudioTxCB(media_q_t *pMediaQ, U8 *pData, U32 *dataLen)
 				return TX_CB_RET_PACKET_NOT_READY;
 			}
 
-			memcpy(pPayload, (uint8_t *)pMediaQItem->pPubData + pMediaQItem->readIdx, pPvtData->payloadSize);
+			openavbAafConv(&pPvtData->txConv, pPayload, (uint8_t *)pMediaQItem->pPubData + pMediaQItem->readIdx,
+				pPvtData->payloadSize / pPubMapInfo->packetSampleSizeBytes);
 			bytesProcessed += pPvtData->payloadSize;
 
 			pMediaQItem->readIdx += pPvtData->payloadSize;
@@ -596,6 +655,94 @@ tx_cb_ret_t openavbMapAVTPAudioTxCB(media_q_t *pMediaQ, U8 *pData, U32 *dataLen)
 	return TX_CB_RET_PACKET_READY;
 }
 
+// Fill as many AAF packets as the tail media queue item holds, up to nFrames,
+// with the item locked only once.
+U32 openavbMapAVTPAudioTxBatchCB(media_q_t *pMediaQ, U8 **ppData, U32 *pDataLen, U32 nFrames)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_MAP_DETAIL);
+
+	if (!pMediaQ) {
+		AVB_LOG_ERROR("Mapping module invalid MediaQ");
+		AVB_TRACE_EXIT(AVB_TRACE_MAP_DETAIL);
+		return 0;
+	}
+
+	if (!ppData || !pDataLen) {
+		AVB_LOG_ERROR("Mapping module data or data length argument incorrect.");
+		AVB_TRACE_EXIT(AVB_TRACE_MAP_DETAIL);
+		return 0;
+	}
+
+	media_q_pub_map_aaf_audio_info_t *pPubMapInfo = pMediaQ->pPubMapInfo;
+	pvt_data_t *pPvtData = pMediaQ->pPvtMapInfo;
+	if (!pPvtData) {
+		AVB_LOG_ERROR("Private mapping module data not allocated.");
+		AVB_TRACE_EXIT(AVB_TRACE_MAP_DETAIL);
+		return 0;
+	}
+
+	if (!pPvtData->txConv.fn) {
+		AVB_LOG_ERROR("Audio sample format not configured");
+		AVB_TRACE_EXIT(AVB_TRACE_MAP_DETAIL);
+		return 0;
+	}
+
+	if (!openavbMediaQIsAvailableBytes(pMediaQ, pPvtData->payloadSize, TRUE)) {
+		AVB_LOG_VERBOSE("Not enough bytes are ready");
+		AVB_TRACE_EXIT(AVB_TRACE_MAP_DETAIL);
+		return 0;
+	}
+
+	media_q_item_t *pMediaQItem = openavbMediaQTailLock(pMediaQ, TRUE);
+	if (!pMediaQItem) {
+		AVB_TRACE_EXIT(AVB_TRACE_MAP_DETAIL);
+		return 0;
+	}
+	if (!pMediaQItem->pPubData || pMediaQItem->dataLen == 0) {
+		openavbMediaQTailPull(pMediaQ);
+		AVB_TRACE_EXIT(AVB_TRACE_MAP_DETAIL);
+		return 0;
+	}
+
+	U32 nFilled;
+	for (nFilled = 0; nFilled < nFrames; nFilled++) {
+		if ((pMediaQItem->dataLen - pMediaQItem->readIdx) < pPvtData->payloadSize) {
+			break;
+		}
+		if ((pDataLen[nFilled] - TOTAL_HEADER_SIZE) < pPvtData->payloadSize) {
+			AVB_LOG_ERROR("Not enough room in packet for payload");
+			break;
+		}
+
+		U8 *pHdrV0 = ppData[nFilled];
+		x_fillTimestamp(pPvtData, pHdrV0, pMediaQItem);
+
+		openavbAafConv(&pPvtData->txConv, pHdrV0 + TOTAL_HEADER_SIZE, (uint8_t *)pMediaQItem->pPubData + pMediaQItem->readIdx,
+			pPvtData->payloadSize / pPubMapInfo->packetSampleSizeBytes);
+		pMediaQItem->readIdx += pPvtData->payloadSize;
+
+		// Set out bound data length (entire packet length)
+		pDataLen[nFilled] = pPvtData->payloadSize + TOTAL_HEADER_SIZE;
+	}
+
+	if (pMediaQItem->readIdx >= pMediaQItem->dataLen) {
+		// Finished reading the entire item
+		openavbMediaQTailPull(pMediaQ);
+	}
+	else if (!nFilled && nFrames) {
+		// This should not happen so we will just toss it away.
+		AVB_LOG_ERROR("Not enough data in media queue item for packet");
+		openavbMediaQTailPull(pMediaQ);
+	}
+	else {
+		// More to read next time
+		openavbMediaQTailUnlock(pMediaQ);
+	}
+
+	AVB_TRACE_EXIT(AVB_TRACE_MAP_DETAIL);
+	return nFilled;
+}
+
 // A call to this callback indicates that this mapping module will be
 // a listener. Any listener initialization can be done in this function.
 void openavbMapAVTPAudioRxInitCB(media_q_t *pMediaQ)
@@ -775,51 +922,31 @@ bool openavbMapAVTPAudioRxCB(media_q_t *pMediaQ, U8 *pData, U32 dataLen)
 					}
 				}
 				if (dataValid) {
-					if (!dataConversionEnabled) {
-						// Just use the raw incoming data, and ignore the incoming bit_depth.
-						if (pPubMapInfo->intf_rx_translate_cb) {
-							pPubMapInfo->intf_rx_translate_cb(pMediaQ, pPayload, pPvtData->payloadSize);
-						}
-
-						memcpy((uint8_t *)pMediaQItem->pPubData + pMediaQItem->dataLen, pPayload, pPvtData->payloadSize);
-					}
-					else {
-						static U8 s_audioBuffer[1500];
-						U8 *pInData = pPayload;
-						U8 *pInDataEnd = pPayload + payloadLen;
-						U8 *pOutData = s_audioBuffer;
-						int nInSampleLength = 6 - incoming_aaf_format; // Calculate the number of integer bytes per sample received
-						int nOutSampleLength = 6 - pPvtData->aaf_format; // Calculate the number of integer bytes per sample we want
-						int i;
-						if (nInSampleLength < nOutSampleLength) {
-							// We need to pad the data supplied.
-							while (pInData < pInDataEnd) {
-								for (i = 0; i < nInSampleLength; ++i) {
-									*pOutData++ = *pInData++;
-								}
-								for ( ; i < nOutSampleLength; ++i) {
-									*pOutData++ = 0; // Value specified in Clause 7.3.4.
-								}
-							}
+					if (incoming_aaf_format != pPvtData->rxConvFormat) {
+						// Integer formats may differ in size; the item always gets the configured one.
+						U8 inBytes = dataConversionEnabled ? 6 - incoming_aaf_format : pPubMapInfo->packetSampleSizeBytes;
+						if (openavbAafConvInit(&pPvtData->rxConv,
+								inBytes, FALSE,
+								pPubMapInfo->itemSampleSizeBytes, pPubMapInfo->audioEndian == AVB_AUDIO_ENDIAN_LITTLE)) {
+							pPvtData->rxConvFormat = incoming_aaf_format;
+							AVB_LOGF_INFO("Sample conversion: format %d => %d (%s)",
+								incoming_aaf_format, pPvtData->aaf_format, openavbAafConvName(&pPvtData->rxConv));
 						}
 						else {
-							// We need to truncate the data supplied.
-							while (pInData < pInDataEnd) {
-								for (i = 0; i < nOutSampleLength; ++i) {
-									*pOutData++ = *pInData++;
-								}
-								pInData += (nInSampleLength - nOutSampleLength);
-							}
-						}
-						if (pOutData - s_audioBuffer != pPvtData->payloadSize) {
-							AVB_LOGF_ERROR("Output not expected size (%d instead of %d)", pOutData - s_audioBuffer, pPvtData->payloadSize);
-						}
-
-						if (pPubMapInfo->intf_rx_translate_cb) {
-							pPubMapInfo->intf_rx_translate_cb(pMediaQ, s_audioBuffer, pPvtData->payloadSize);
+							IF_LOG_INTERVAL(1000) AVB_LOGF_ERROR("Unsupported sample conversion: format %d => %d",
+								incoming_aaf_format, pPvtData->aaf_format);
+							dataValid = FALSE;
 						}
+					}
+				}
+				if (dataValid) {
+					// Convert straight into the item, then let the interface adjust it in place.
+					U8 *pItemData = (U8 *)pMediaQItem->pPubData + pMediaQItem->dataLen;
+					openavbAafConv(&pPvtData->rxConv, pItemData, pPayload,
+						pPvtData->payloadSize / pPubMapInfo->itemSampleSizeBytes);
 
-						memcpy((uint8_t *)pMediaQItem->pPubData + pMediaQItem->dataLen, s_audioBuffer, pPvtData->payloadSize);
+					if (pPubMapInfo->intf_rx_translate_cb) {
+						pPubMapInfo->intf_rx_translate_cb(pMediaQ, pItemData, pPvtData->payloadSize);
 					}
 
 					pMediaQItem->dataLen += pPvtData->payloadSize;
@@ -908,6 +1035,8 @@ extern DLL_EXPORT bool openavbMapAVTPAudioInitialize(media_q_t *pMediaQ, openavb
 		pMapCB->map_gen_init_cb = openavbMapAVTPAudioGenInitCB;
 		pMapCB->map_tx_init_cb = openavbMapAVTPAudioTxInitCB;
 		pMapCB->map_tx_cb = openavbMapAVTPAudioTxCB;
+		pMapCB->map_tx_hdr_cb = openavbMapAVTPAudioTxHdrCB;
+		pMapCB->map_tx_batch_cb = openavbMapAVTPAudioTxBatchCB;
 		pMapCB->map_rx_init_cb = openavbMapAVTPAudioRxInitCB;
 		pMapCB->map_rx_cb = openavbMapAVTPAudioRxCB;
 		pMapCB->map_end_cb = openavbMapAVTPAudioEndCB;
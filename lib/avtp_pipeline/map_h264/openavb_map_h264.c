@@ -251,8 +251,9 @@ void openavbMapH264TxInitCB(media_q_t *pMediaQ)
 	AVB_TRACE_EXIT(AVB_TRACE_MAP);
 }
 
-// This talker callback will be called for each AVB observation interval.
-tx_cb_ret_t openavbMapH264TxCB(media_q_t *pMediaQ, U8 *pData, U32 *dataLen)
+// Build the next AVTP packet. Without ppItem the payload is copied into it,
+// otherwise the media queue item is taken and returned in *ppItem.
+static tx_cb_ret_t x_mapH264Tx(media_q_t *pMediaQ, U8 *pData, U32 *dataLen, media_q_item_t **ppItem)
 {
 	AVB_TRACE_ENTRY(AVB_TRACE_MAP_DETAIL);
 	if (pMediaQ && pData && dataLen) {
@@ -311,11 +312,22 @@ tx_cb_ret_t openavbMapH264TxCB(media_q_t *pMediaQ, U8 *pData, U32 *dataLen)
 				*(U32 *)(&pHdr[HIDX_H264_TIMESTAMP32]) =
 						htonl(((media_q_item_map_h264_pub_data_t *)pMediaQItem->pPubMapData)->timestamp);
 
+				*(U16 *)(&pHdr[HIDX_STREAM_DATA_LEN16]) = htons(pMediaQItem->dataLen);
+
+				if (ppItem) {
+					// The payload is sent from the item; only the header goes in the packet.
+					*dataLen = TOTAL_HEADER_SIZE;
+					*ppItem = pMediaQItem;
+
+					AVB_TRACE_LINE(AVB_TRACE_MAP_LINE);
+					AVB_TRACE_EXIT(AVB_TRACE_MAP_DETAIL);
+					openavbMediaQTailItemTake(pMediaQ, pMediaQItem);
+					return TX_CB_RET_PACKET_READY;
+				}
+
 				// Copy the h264 rtp payload into the outgoing avtp packet.
 				memcpy(pPayload, pMediaQItem->pPubData, pMediaQItem->dataLen);
 
-				*(U16 *)(&pHdr[HIDX_STREAM_DATA_LEN16]) = htons(pMediaQItem->dataLen);
-
 				// Set out bound data length (entire packet length)
 				*dataLen = pMediaQItem->dataLen + TOTAL_HEADER_SIZE;
 
@@ -337,6 +349,23 @@ tx_cb_ret_t openavbMapH264TxCB(media_q_t *pMediaQ, U8 *pData, U32 *dataLen)
 	return TX_CB_RET_PACKET_NOT_READY;
 }
 
+// This talker callback will be called for each AVB observation interval.
+tx_cb_ret_t openavbMapH264TxCB(media_q_t *pMediaQ, U8 *pData, U32 *dataLen)
+{
+	return x_mapH264Tx(pMediaQ, pData, dataLen, NULL);
+}
+
+// Same as openavbMapH264TxCB() but the payload isn't copied. It is sent
+// from the returned media queue item, which AVTP gives back once sent.
+tx_cb_ret_t openavbMapH264TxRefCB(media_q_t *pMediaQ, U8 *pData, U32 *dataLen, media_q_item_t **ppItem)
+{
+	if (!ppItem) {
+		return TX_CB_RET_PACKET_NOT_READY;
+	}
+	*ppItem = NULL;
+	return x_mapH264Tx(pMediaQ, pData, dataLen, ppItem);
+}
+
 // A call to this callback indicates that this mapping module will be
 // a listener. Any listener initialization can be done in this function.
 void openavbMapH264RxInitCB(media_q_t *pMediaQ)
@@ -451,6 +480,7 @@ extern DLL_EXPORT bool openavbMapH264Initialize(media_q_t *pMediaQ, openavb_map_
 		pMapCB->map_gen_init_cb = openavbMapH264GenInitCB;
 		pMapCB->map_tx_init_cb = openavbMapH264TxInitCB;
 		pMapCB->map_tx_cb = openavbMapH264TxCB;
+		pMapCB->map_tx_ref_cb = openavbMapH264TxRefCB;
 		pMapCB->map_rx_init_cb = openavbMapH264RxInitCB;
 		pMapCB->map_rx_cb = openavbMapH264RxCB;
 		pMapCB->map_end_cb = openavbMapH264EndCB;
@@ -217,8 +217,9 @@ void openavbMapMjpegTxInitCB(media_q_t *pMediaQ)
 	AVB_TRACE_EXIT(AVB_TRACE_MAP);
 }
 
-// This talker callback will be called for each AVB observation interval.
-tx_cb_ret_t openavbMapMjpegTxCB(media_q_t *pMediaQ, U8 *pData, U32 *dataLen)
+// Build the next AVTP packet. Without ppItem the payload is copied into it,
+// otherwise the media queue item is taken and returned in *ppItem.
+static tx_cb_ret_t x_mapMjpegTx(media_q_t *pMediaQ, U8 *pData, U32 *dataLen, media_q_item_t **ppItem)
 {
 	AVB_TRACE_ENTRY(AVB_TRACE_MAP_DETAIL);
 	if (pMediaQ && pData && dataLen) {
@@ -286,11 +287,22 @@ tx_cb_ret_t openavbMapMjpegTxCB(media_q_t *pMediaQ, U8 *pData, U32 *dataLen)
 					pHdr[HIDX_M11_M01_EVT2_RESV2] = 0x00;
 				}
 
+				*(U16 *)(&pHdr[HIDX_STREAM_DATA_LEN16]) = pMediaQItem->dataLen;
+
+				if (ppItem) {
+					// The payload is sent from the item; only the header goes in the packet.
+					*dataLen = TOTAL_HEADER_SIZE;
+					*ppItem = pMediaQItem;
+
+					AVB_TRACE_LINE(AVB_TRACE_MAP_LINE);
+					AVB_TRACE_EXIT(AVB_TRACE_MAP_DETAIL);
+					openavbMediaQTailItemTake(pMediaQ, pMediaQItem);
+					return TX_CB_RET_PACKET_READY;
+				}
+
 				// Copy the JPEG fragment into the outgoing avtp packet.
 				memcpy(pPayload, pMediaQItem->pPubData, pMediaQItem->dataLen);
 
-				*(U16 *)(&pHdr[HIDX_STREAM_DATA_LEN16]) = pMediaQItem->dataLen;
-
 				// Set out bound data length (entire packet length)
 				*dataLen = pMediaQItem->dataLen + TOTAL_HEADER_SIZE;
 
@@ -312,6 +324,23 @@ tx_cb_ret_t openavbMapMjpegTxCB(media_q_t *pMediaQ, U8 *pData, U32 *dataLen)
 	return TX_CB_RET_PACKET_NOT_READY;
 }
 
+// This talker callback will be called for each AVB observation interval.
+tx_cb_ret_t openavbMapMjpegTxCB(media_q_t *pMediaQ, U8 *pData, U32 *dataLen)
+{
+	return x_mapMjpegTx(pMediaQ, pData, dataLen, NULL);
+}
+
+// Same as openavbMapMjpegTxCB() but the payload isn't copied. It is sent
+// from the returned media queue item, which AVTP gives back once sent.
+tx_cb_ret_t openavbMapMjpegTxRefCB(media_q_t *pMediaQ, U8 *pData, U32 *dataLen, media_q_item_t **ppItem)
+{
+	if (!ppItem) {
+		return TX_CB_RET_PACKET_NOT_READY;
+	}
+	*ppItem = NULL;
+	return x_mapMjpegTx(pMediaQ, pData, dataLen, ppItem);
+}
+
 // A call to this callback indicates that this mapping module will be
 // a listener. Any listener initialization can be done in this function.
 void openavbMapMjpegRxInitCB(media_q_t *pMediaQ)
@@ -411,6 +440,7 @@ extern DLL_EXPORT bool openavbMapMjpegInitialize(media_q_t *pMediaQ, openavb_map
 		pMapCB->map_gen_init_cb = openavbMapMjpegGenInitCB;
 		pMapCB->map_tx_init_cb = openavbMapMjpegTxInitCB;
 		pMapCB->map_tx_cb = openavbMapMjpegTxCB;
+		pMapCB->map_tx_ref_cb = openavbMapMjpegTxRefCB;
 		pMapCB->map_rx_init_cb = openavbMapMjpegRxInitCB;
 		pMapCB->map_rx_cb = openavbMapMjpegRxCB;
 		pMapCB->map_end_cb = openavbMapMjpegEndCB;
@@ -0,0 +1,285 @@
+/*************************************************************************************************************
+Copyright (c) 2012-2015, Symphony Teleca Corporation, a Harman International Industries, Incorporated company
+Copyright (c) 2016-2017, Harman International Industries, Incorporated
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS LISTED "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS LISTED BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Attributions: The inih library portion of the source code is licensed from
+Brush Technology and Ben Hoyt - Copyright (c) 2009, Brush Technology and Copyright (c) 2009, Ben Hoyt.
+Complete license and copyright information can be found at
+https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
+*************************************************************************************************************/
+
+/*
+ * MODULE SUMMARY : AM824 quadlet packing for the 61883-6 mapping
+ */
+
+#include <string.h>
+#include <arpa/inet.h>
+#include "openavb_am824.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define AM824_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define AM824_NEON 1
+#endif
+
+// Plain C versions. These work on whole words like the original loops did,
+// which beats a byte by byte shuffle when there is no vector unit for it.
+// WORD24 takes the sample out of a word loaded from a 24 bit sample, and
+// SAMPLE24 places a sample in a word to be stored over one.
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define AM824_HOST_LE 1
+#define LOAD24(p)		((U32)(p)[0] | ((U32)(p)[1] << 8) | ((U32)(p)[2] << 16))
+#define STORE24(p, v)	((p)[0] = (U8)(v), (p)[1] = (U8)((v) >> 8), (p)[2] = (U8)((v) >> 16))
+#define WORD24(w)		((w) & 0x00ffffff)
+#define SAMPLE24(v)		(v)
+#else
+#define AM824_HOST_LE 0
+#define LOAD24(p)		(((U32)(p)[0] << 16) | ((U32)(p)[1] << 8) | (U32)(p)[2])
+#define STORE24(p, v)	((p)[0] = (U8)((v) >> 16), (p)[1] = (U8)((v) >> 8), (p)[2] = (U8)(v))
+#define WORD24(w)		((w) >> 8)
+#define SAMPLE24(v)		((v) << 8)
+#endif
+
+static void x_pack16Scalar(const am824_shuffle_t *pShuf, U8 *pOut, const U8 *pIn, U32 nSamples)
+{
+	const U32 label = (U32)pShuf->set[0] << 24;
+	while (nSamples--) {
+		U16 sample;
+		memcpy(&sample, pIn, 2);
+		U32 quadlet = htonl(label | ((U32)sample << 8));
+		memcpy(pOut, &quadlet, 4);
+		pIn += 2;
+		pOut += 4;
+	}
+}
+
+// A 24 bit sample is loaded as a whole word, which reaches one byte into the
+// next sample. The last one is loaded byte by byte to stay inside the item.
+static void x_pack24Scalar(const am824_shuffle_t *pShuf, U8 *pOut, const U8 *pIn, U32 nSamples)
+{
+	const U32 label = (U32)pShuf->set[0] << 24;
+	U32 quadlet;
+	if (!nSamples) {
+		return;
+	}
+	while (--nSamples) {
+		U32 word;
+		memcpy(&word, pIn, 4);
+		quadlet = htonl(label | WORD24(word));
+		memcpy(pOut, &quadlet, 4);
+		pIn += 3;
+		pOut += 4;
+	}
+	quadlet = htonl(label | LOAD24(pIn));
+	memcpy(pOut, &quadlet, 4);
+}
+
+static void x_unpack16Scalar(const am824_shuffle_t *pShuf, U8 *pOut, const U8 *pIn, U32 nSamples)
+{
+	while (nSamples--) {
+		U32 quadlet;
+		memcpy(&quadlet, pIn, 4);
+		U16 sample = (U16)(ntohl(quadlet) >> 8);
+		memcpy(pOut, &sample, 2);
+		pIn += 4;
+		pOut += 2;
+	}
+}
+
+// Same for storing: each word's extra byte is overwritten by the next
+// sample, and the last sample is stored byte by byte.
+static void x_unpack24Scalar(const am824_shuffle_t *pShuf, U8 *pOut, const U8 *pIn, U32 nSamples)
+{
+	U32 quadlet;
+	if (!nSamples) {
+		return;
+	}
+	while (--nSamples) {
+		memcpy(&quadlet, pIn, 4);
+		U32 word = SAMPLE24(ntohl(quadlet));
+		memcpy(pOut, &word, 4);
+		pIn += 4;
+		pOut += 3;
+	}
+	memcpy(&quadlet, pIn, 4);
+	quadlet = ntohl(quadlet);
+	STORE24(pOut, quadlet);
+}
+
+// The SIMD versions load and store whole 16 byte blocks of which only
+// AM824_BLOCK_SAMPLES samples are used, so they stop while a full block
+// still fits in both buffers and leave the rest to the scalar version.
+#define BLOCK_FITS(pShuf, n)	((n) * (pShuf)->inBytes >= 16 && (n) * (pShuf)->outBytes >= 16)
+
+#if AM824_X86
+__attribute__((target("ssse3")))
+static void x_shuffleSsse3(const am824_shuffle_t *pShuf, U8 *pOut, const U8 *pIn, U32 nSamples)
+{
+	const __m128i mask = _mm_loadu_si128((const __m128i *)pShuf->blockMask);
+	const __m128i set = _mm_loadu_si128((const __m128i *)pShuf->blockSet);
+	const U32 inStep = AM824_BLOCK_SAMPLES * pShuf->inBytes;
+	const U32 outStep = AM824_BLOCK_SAMPLES * pShuf->outBytes;
+
+	while (BLOCK_FITS(pShuf, nSamples)) {
+		__m128i v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)pIn), mask);
+		_mm_storeu_si128((__m128i *)pOut, _mm_or_si128(v, set));
+		pIn += inStep;
+		pOut += outStep;
+		nSamples -= AM824_BLOCK_SAMPLES;
+	}
+	pShuf->scalarFn(pShuf, pOut, pIn, nSamples);
+}
+
+__attribute__((target("avx2")))
+static void x_shuffleAvx2(const am824_shuffle_t *pShuf, U8 *pOut, const U8 *pIn, U32 nSamples)
+{
+	const __m128i mask128 = _mm_loadu_si128((const __m128i *)pShuf->blockMask);
+	const __m128i set128 = _mm_loadu_si128((const __m128i *)pShuf->blockSet);
+	const __m256i mask = _mm256_broadcastsi128_si256(mask128);
+	const __m256i set = _mm256_broadcastsi128_si256(set128);
+	const U32 inStep = AM824_BLOCK_SAMPLES * pShuf->inBytes;
+	const U32 outStep = AM824_BLOCK_SAMPLES * pShuf->outBytes;
+
+	// Two blocks per iteration, one in each 128 bit lane
+	while (nSamples >= AM824_BLOCK_SAMPLES && BLOCK_FITS(pShuf, nSamples - AM824_BLOCK_SAMPLES)) {
+		__m256i v = _mm256_inserti128_si256(
+			_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)pIn)),
+			_mm_loadu_si128((const __m128i *)(pIn + inStep)), 1);
+		v = _mm256_or_si256(_mm256_shuffle_epi8(v, mask), set);
+		// Low block first; the high block overwrites its unused tail
+		_mm_storeu_si128((__m128i *)pOut, _mm256_castsi256_si128(v));
+		_mm_storeu_si128((__m128i *)(pOut + outStep), _mm256_extracti128_si256(v, 1));
+		pIn += 2 * inStep;
+		pOut += 2 * outStep;
+		nSamples -= 2 * AM824_BLOCK_SAMPLES;
+	}
+	while (BLOCK_FITS(pShuf, nSamples)) {
+		__m128i v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)pIn), mask128);
+		_mm_storeu_si128((__m128i *)pOut, _mm_or_si128(v, set128));
+		pIn += inStep;
+		pOut += outStep;
+		nSamples -= AM824_BLOCK_SAMPLES;
+	}
+	pShuf->scalarFn(pShuf, pOut, pIn, nSamples);
+}
+#endif
+
+#if AM824_NEON
+static void x_shuffleNeon(const am824_shuffle_t *pShuf, U8 *pOut, const U8 *pIn, U32 nSamples)
+{
+	// Table lookups with an index >= 16 give zero, as AM824_ZERO does
+	const uint8x16_t mask = vld1q_u8(pShuf->blockMask);
+	const uint8x16_t set = vld1q_u8(pShuf->blockSet);
+	const U32 inStep = AM824_BLOCK_SAMPLES * pShuf->inBytes;
+	const U32 outStep = AM824_BLOCK_SAMPLES * pShuf->outBytes;
+
+	while (BLOCK_FITS(pShuf, nSamples)) {
+		vst1q_u8(pOut, vorrq_u8(vqtbl1q_u8(vld1q_u8(pIn), mask), set));
+		pIn += inStep;
+		pOut += outStep;
+		nSamples -= AM824_BLOCK_SAMPLES;
+	}
+	pShuf->scalarFn(pShuf, pOut, pIn, nSamples);
+}
+#endif
+
+static void x_initShuffle(am824_shuffle_t *pShuf, U8 inBytes, U8 outBytes, am824_shuffle_fn_t scalarFn)
+{
+	U8 s, j;
+
+	pShuf->inBytes = inBytes;
+	pShuf->outBytes = outBytes;
+	memset(pShuf->blockMask, AM824_ZERO, sizeof(pShuf->blockMask));
+	memset(pShuf->blockSet, 0, sizeof(pShuf->blockSet));
+	for (s = 0; s < AM824_BLOCK_SAMPLES; s++) {
+		for (j = 0; j < outBytes; j++) {
+			U8 src = pShuf->map[j];
+			pShuf->blockMask[s * outBytes + j] = (src == AM824_ZERO) ? AM824_ZERO : s * inBytes + src;
+			pShuf->blockSet[s * outBytes + j] = pShuf->set[j];
+		}
+	}
+
+	pShuf->scalarFn = scalarFn;
+	pShuf->fn = scalarFn;
+#if AM824_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		pShuf->fn = x_shuffleAvx2;
+	}
+	else if (__builtin_cpu_supports("ssse3")) {
+		pShuf->fn = x_shuffleSsse3;
+	}
+#elif AM824_NEON
+	pShuf->fn = x_shuffleNeon;
+#endif
+}
+
+bool openavbAm824Init(am824_conv_t *pConv, U8 sampleBytes, U8 label)
+{
+	U8 c;
+
+	if (!pConv || sampleBytes < 2 || sampleBytes > 3) {
+		return FALSE;
+	}
+
+	memset(pConv, 0, sizeof(*pConv));
+
+	// Quadlet: label, then the sample most significant byte first, zero padded.
+	// c is the significance rank (0 = most significant) of a sample byte.
+	pConv->pack.map[0] = AM824_ZERO;
+	pConv->pack.set[0] = label;
+	for (c = 0; c < 3; c++) {
+		if (c < sampleBytes) {
+			U8 itemIdx = AM824_HOST_LE ? sampleBytes - 1 - c : c;
+			pConv->pack.map[1 + c] = itemIdx;
+			pConv->unpack.map[itemIdx] = 1 + c;
+		}
+		else {
+			pConv->pack.map[1 + c] = AM824_ZERO;
+		}
+	}
+
+	x_initShuffle(&pConv->pack, sampleBytes, 4, sampleBytes == 2 ? x_pack16Scalar : x_pack24Scalar);
+	x_initShuffle(&pConv->unpack, 4, sampleBytes, sampleBytes == 2 ? x_unpack16Scalar : x_unpack24Scalar);
+	return TRUE;
+}
+
+const char *openavbAm824Name(const am824_conv_t *pConv)
+{
+#if AM824_X86
+	if (pConv->pack.fn == x_shuffleAvx2) {
+		return "avx2";
+	}
+	if (pConv->pack.fn == x_shuffleSsse3) {
+		return "ssse3";
+	}
+#elif AM824_NEON
+	if (pConv->pack.fn == x_shuffleNeon) {
+		return "neon";
+	}
+#endif
+	return "scalar";
+}
@@ -0,0 +1,94 @@
+/*************************************************************************************************************
+Copyright (c) 2012-2015, Symphony Teleca Corporation, a Harman International Industries, Incorporated company
+Copyright (c) 2016-2017, Harman International Industries, Incorporated
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS LISTED "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS LISTED BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Attributions: The inih library portion of the source code is licensed from
+Brush Technology and Ben Hoyt - Copyright (c) 2009, Brush Technology and Copyright (c) 2009, Ben Hoyt.
+Complete license and copyright information can be found at
+https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
+*************************************************************************************************************/
+
+/*
+ * HEADER SUMMARY : AM824 quadlet packing for the 61883-6 mapping
+ *
+ * Packs 16 or 24 bit samples from media queue items (host byte order) into
+ * big endian AM824 quadlets with the label in the first byte, and unpacks
+ * them again. Each direction is a fixed per-sample byte shuffle plus an OR
+ * of the label, done 4 samples at a time with SSSE3, AVX2 or NEON where the
+ * CPU has them, picked at run time.
+ */
+
+#ifndef OPENAVB_AM824_H
+#define OPENAVB_AM824_H 1
+
+#include "openavb_types_pub.h"
+
+struct am824_shuffle;
+typedef void (*am824_shuffle_fn_t)(const struct am824_shuffle *pShuf, U8 *pOut, const U8 *pIn, U32 nSamples);
+
+// One direction (pack or unpack) of an AM824 conversion
+typedef struct am824_shuffle {
+	// Bytes per sample in and out
+	U8 inBytes;
+	U8 outBytes;
+	// Source byte of each output byte of a sample; AM824_ZERO if none
+	U8 map[4];
+	// Constant ORed into each output byte of a sample (the label)
+	U8 set[4];
+	// Same as map and set for a block of AM824_BLOCK_SAMPLES samples
+	U8 blockMask[16];
+	U8 blockSet[16];
+	// Implementation picked for this CPU, and the plain C one it falls back on
+	am824_shuffle_fn_t fn;
+	am824_shuffle_fn_t scalarFn;
+} am824_shuffle_t;
+
+typedef struct {
+	am824_shuffle_t pack;
+	am824_shuffle_t unpack;
+} am824_conv_t;
+
+#define AM824_ZERO 0x80
+#define AM824_BLOCK_SAMPLES 4
+
+// Set up packing for 2 or 3 byte samples with the given label.
+// Returns FALSE for other sample sizes.
+bool openavbAm824Init(am824_conv_t *pConv, U8 sampleBytes, U8 label);
+
+// Pack nSamples item samples into quadlets. The buffers must not overlap.
+static inline void openavbAm824Pack(const am824_conv_t *pConv, U8 *pQuadlets, const U8 *pItem, U32 nSamples)
+{
+	pConv->pack.fn(&pConv->pack, pQuadlets, pItem, nSamples);
+}
+
+// Unpack nSamples quadlets into item samples. The buffers must not overlap.
+static inline void openavbAm824Unpack(const am824_conv_t *pConv, U8 *pItem, const U8 *pQuadlets, U32 nSamples)
+{
+	pConv->unpack.fn(&pConv->unpack, pItem, pQuadlets, nSamples);
+}
+
+// Name of the implementation in use (for logging)
+const char *openavbAm824Name(const am824_conv_t *pConv);
+
+#endif  // OPENAVB_AM824_H
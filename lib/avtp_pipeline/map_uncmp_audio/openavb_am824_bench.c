@@ -0,0 +1,201 @@
+/*************************************************************************************************************
+Copyright (c) 2012-2015, Symphony Teleca Corporation, a Harman International Industries, Incorporated company
+Copyright (c) 2016-2017, Harman International Industries, Incorporated
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS LISTED "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS LISTED BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Attributions: The inih library portion of the source code is licensed from
+Brush Technology and Ben Hoyt - Copyright (c) 2009, Brush Technology and Copyright (c) 2009, Ben Hoyt.
+Complete license and copyright information can be found at
+https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
+*************************************************************************************************************/
+
+
+/*
+ * MODULE SUMMARY : Benchmark for the AM824 quadlet packing
+ *
+ * Checks every implementation of openavb_am824 against the per-sample loops
+ * the 61883-6 mapping used before, then times one packet (48 frames of 8
+ * channels) for each sample size and direction. Build with
+ * "make openavb_am824_bench" in the build directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include "openavb_am824.h"
+
+#define LABEL			0x40
+#define PACKET_SAMPLES	(48 * 8)
+#define CHECK_SAMPLES	80
+#define ITERATIONS		200000
+#define CANARY			0xA5
+
+// Slack after each buffer: the old loops access a byte past the last sample
+#define SLACK			16
+
+static U8 s_items[PACKET_SAMPLES * 3 + SLACK];
+static U8 s_quadlets[PACKET_SAMPLES * 4 + SLACK];
+static U8 s_out[PACKET_SAMPLES * 4 + SLACK];
+static U8 s_ref[PACKET_SAMPLES * 4 + SLACK];
+
+// The loops of openavbMapUncmpAudioTxCB and openavbMapUncmpAudioRxCB before
+// openavb_am824. Little endian hosts only, as they were.
+static void x_oldPack(const am824_shuffle_t *pShuf, U8 *pOut, const U8 *pIn, U32 nSamples)
+{
+	const U32 label = (U32)LABEL << 24;
+	while (nSamples--) {
+		if (pShuf->inBytes == 2) {
+			S32 sample = *(S16 *)pIn;
+			sample &= 0x0000ffff;
+			sample = sample << 8;
+			sample |= label;
+			*(U32 *)pOut = htonl(sample);
+			pIn += 2;
+		}
+		else {
+			S32 sample = *(S32 *)pIn;
+			sample &= 0x00ffffff;
+			sample |= label;
+			*(U32 *)pOut = htonl(sample);
+			pIn += 3;
+		}
+		pOut += 4;
+	}
+}
+
+static void x_oldUnpack(const am824_shuffle_t *pShuf, U8 *pOut, const U8 *pIn, U32 nSamples)
+{
+	while (nSamples--) {
+		S32 sample = ntohl(*(S32 *)pIn);
+		if (pShuf->outBytes == 2) {
+			*(S16 *)pOut = (sample & 0x00ffffff) >> 8;
+			pOut += 2;
+		}
+		else {
+			*(S32 *)pOut = sample & 0x00ffffff;
+			pOut += 3;
+		}
+		pIn += 4;
+	}
+}
+
+static void x_fill(U8 *p, U32 len)
+{
+	U32 i;
+	for (i = 0; i < len; i++) {
+		p[i] = rand();
+	}
+}
+
+// Compare fn with the old loop for 0 to CHECK_SAMPLES samples, and check
+// that fn writes nothing past the last sample.
+static int x_check(const char *name, const am824_shuffle_t *pShuf, am824_shuffle_fn_t fn, am824_shuffle_fn_t oldFn)
+{
+	U32 n, i;
+	for (n = 0; n <= CHECK_SAMPLES; n++) {
+		U32 outLen = n * pShuf->outBytes;
+		U8 *pIn = pShuf->inBytes == 4 ? s_quadlets : s_items;
+		x_fill(pIn, n * pShuf->inBytes + SLACK);
+		if (pShuf->inBytes == 4) {
+			// Received quadlets carry the label
+			for (i = 0; i < n; i++) {
+				pIn[i * 4] = LABEL;
+			}
+		}
+		oldFn(pShuf, s_ref, pIn, n);
+		memset(s_out, CANARY, sizeof(s_out));
+		fn(pShuf, s_out, pIn, n);
+		if (memcmp(s_out, s_ref, outLen) != 0) {
+			printf("%s: wrong output for %u samples\n", name, n);
+			return 1;
+		}
+		for (i = outLen; i < outLen + SLACK; i++) {
+			if (s_out[i] != CANARY) {
+				printf("%s: wrote past the end for %u samples\n", name, n);
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+static double x_time(const am824_shuffle_t *pShuf, am824_shuffle_fn_t fn)
+{
+	const U8 *pIn = pShuf->inBytes == 4 ? s_quadlets : s_items;
+	struct timespec t0, t1;
+	U32 i;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (i = 0; i < ITERATIONS; i++) {
+		fn(pShuf, s_out, pIn, PACKET_SAMPLES);
+		// Keep the compiler from dropping or merging the calls
+		__asm__ __volatile__("" : : "r"(s_out) : "memory");
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	return ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / ITERATIONS;
+}
+
+int main(int argc, char *argv[])
+{
+	U8 sampleBytes;
+	int errors = 0;
+
+	x_fill(s_items, sizeof(s_items));
+	x_fill(s_quadlets, sizeof(s_quadlets));
+
+	for (sampleBytes = 2; sampleBytes <= 3; sampleBytes++) {
+		am824_conv_t conv;
+		if (!openavbAm824Init(&conv, sampleBytes, LABEL)) {
+			printf("openavbAm824Init failed for %u byte samples\n", sampleBytes);
+			return 1;
+		}
+
+		int bits = sampleBytes * 8;
+		char name[64];
+		snprintf(name, sizeof(name), "%d bit pack %s", bits, openavbAm824Name(&conv));
+		errors += x_check(name, &conv.pack, conv.pack.fn, x_oldPack);
+		snprintf(name, sizeof(name), "%d bit pack scalar", bits);
+		errors += x_check(name, &conv.pack, conv.pack.scalarFn, x_oldPack);
+		snprintf(name, sizeof(name), "%d bit unpack %s", bits, openavbAm824Name(&conv));
+		errors += x_check(name, &conv.unpack, conv.unpack.fn, x_oldUnpack);
+		snprintf(name, sizeof(name), "%d bit unpack scalar", bits);
+		errors += x_check(name, &conv.unpack, conv.unpack.scalarFn, x_oldUnpack);
+
+		if (sampleBytes == 2) {
+			printf("ns per packet of %u samples    old     %-7s scalar\n", PACKET_SAMPLES, openavbAm824Name(&conv));
+		}
+		printf("  %d bit pack               %7.0f %7.0f %7.0f\n", bits,
+			x_time(&conv.pack, x_oldPack), x_time(&conv.pack, conv.pack.fn), x_time(&conv.pack, conv.pack.scalarFn));
+		printf("  %d bit unpack             %7.0f %7.0f %7.0f\n", bits,
+			x_time(&conv.unpack, x_oldUnpack), x_time(&conv.unpack, conv.unpack.fn), x_time(&conv.unpack, conv.unpack.scalarFn));
+	}
+
+	if (errors) {
+		printf("%d checks failed\n", errors);
+		return 1;
+	}
+	return 0;
+}
@@ -41,6 +41,7 @@ https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
 #include "openavb_mediaq_pub.h"
 #include "openavb_map_pub.h"
 #include "openavb_map_uncmp_audio_pub.h"
+#include "openavb_am824.h"
 
 // DEBUG Uncomment to turn on logging for just this module.
 #define AVB_LOG_ON	1
@@ -143,6 +144,9 @@ typedef struct {
 
 	U32 AM824_label;
 
+	// AM824 quadlet packing for the configured sample size
+	am824_conv_t am824;
+
 	U32 maxPayloadSize;
 
 	// Data block continuity counter
@@ -280,6 +284,10 @@ static void x_calculateSizes(media_q_t *pMediaQ)
 				break;
 		}
 
+		if (openavbAm824Init(&pPvtData->am824, pPubMapInfo->itemSampleSizeBytes, pPvtData->AM824_label >> 24)) {
+			AVB_LOGF_INFO("AM824 packing: %s", openavbAm824Name(&pPvtData->am824));
+		}
+
 	}
 
 	AVB_TRACE_EXIT(AVB_TRACE_MAP);
@@ -425,6 +433,43 @@ void openavbMapUncmpAudioTxInitCB(media_q_t *pMediaQ)
 	AVB_TRACE_EXIT(AVB_TRACE_MAP);
 }
 
+// Fill the header fields that are the same in every packet this talker sends.
+U32 openavbMapUncmpAudioTxHdrCB(media_q_t *pMediaQ, U8 *pHdr, U32 hdrLen)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_MAP);
+
+	if (!pMediaQ || hdrLen < TOTAL_HEADER_SIZE) {
+		AVB_TRACE_EXIT(AVB_TRACE_MAP);
+		return 0;
+	}
+
+	media_q_pub_map_uncmp_audio_info_t *pPubMapInfo = pMediaQ->pPubMapInfo;
+	pvt_data_t *pPvtData = pMediaQ->pPvtMapInfo;
+	if (!pPvtData) {
+		AVB_LOG_ERROR("Private mapping module data not allocated.");
+		AVB_TRACE_EXIT(AVB_TRACE_MAP);
+		return 0;
+	}
+
+	//pHdr[HIDX_AVTP_TIMESTAMP32] = 0x00;			// Set per packet
+	*(U32 *)(&pHdr[HIDX_GATEWAY32]) = 0x00000000;
+	*(U16 *)(&pHdr[HIDX_DATALEN16]) = htons((pPubMapInfo->framesPerPacket * pPubMapInfo->packetFrameSizeBytes) + CIP_HEADER_SIZE);
+	pHdr[HIDX_TAG2_CHANNEL6] = (1 << 6) | 0x1f;
+	pHdr[HIDX_TCODE4_SY4] = (0x0a << 4) | 0;
+
+	// CIP header
+	pHdr[HIDX_CIP2_SID6] = (0x00 << 6) | 0x3f;
+	pHdr[HIDX_DBS8] = pPubMapInfo->audioChannels;
+	pHdr[HIDX_FN2_QPC3_SPH1_RSV2] = (0x00 << 6) | (0x00 << 3) | (0x00 << 2) | 0x00;
+	// pHdr[HIDX_DBC8] = 0; 						// Set per packet
+	pHdr[HIDX_CIP2_FMT6] = (0x02 << 6) | 0x10;
+	pHdr[HIDX_FDF5_SFC3] = 0x00 << 3 | pPvtData->cip_sfc;
+	*(U16 *)(&pHdr[HIDX_SYT16]) = 0xffff;
+
+	AVB_TRACE_EXIT(AVB_TRACE_MAP);
+	return TOTAL_HEADER_SIZE;
+}
+
 // This talker callback will be called for each AVB observation interval.
 tx_cb_ret_t openavbMapUncmpAudioTxCB(media_q_t *pMediaQ, U8 *pData, U32 *dataLen)
 {
@@ -445,25 +490,18 @@ tx_cb_ret_t openavbMapUncmpAudioTxCB(media_q_t *pMediaQ, U8 *pData, U32 *dataLen
 		return TX_CB_RET_PACKET_NOT_READY;
 	}
 
+	if (!pPvtData->am824.pack.fn) {
+		AVB_LOG_ERROR("Audio sample size not configured.");
+		AVB_TRACE_EXIT(AVB_TRACE_MAP_DETAIL);
+		return TX_CB_RET_PACKET_NOT_READY;
+	}
+
 	if (openavbMediaQIsAvailableBytes(pMediaQ, pPubMapInfo->itemFrameSizeBytes * pPubMapInfo->framesPerPacket, TRUE)) {
 		U8 *pHdr = pData;
 		U8 *pPayload = pData + TOTAL_HEADER_SIZE;
 
-		//pHdr[HIDX_AVTP_TIMESTAMP32] = 0x00;			// Set later
-		*(U32 *)(&pHdr[HIDX_GATEWAY32]) = 0x00000000;
-		//pHdr[HIDX_DATALEN16] = 0x00;					// Set Later
-		pHdr[HIDX_TAG2_CHANNEL6] = (1 << 6) | 0x1f;
-		pHdr[HIDX_TCODE4_SY4] = (0x0a << 4) | 0;
-
-		// Set the majority of the CIP header now.
-		pHdr[HIDX_CIP2_SID6] = (0x00 << 6) | 0x3f;
-		pHdr[HIDX_DBS8] = pPubMapInfo->audioChannels;
-
-		pHdr[HIDX_FN2_QPC3_SPH1_RSV2] = (0x00 << 6) | (0x00 << 3) | (0x00 << 2) | 0x00;
-		// pHdr[HIDX_DBC8] = 0; 						// Set later
-		pHdr[HIDX_CIP2_FMT6] = (0x02 << 6) | 0x10;
-		pHdr[HIDX_FDF5_SFC3] = 0x00 << 3 | pPvtData->cip_sfc;
-		*(U16 *)(&pHdr[HIDX_SYT16]) = 0xffff;
+		// The constant header fields, stream_data_len included, come from the
+		// header template (openavbMapUncmpAudioTxHdrCB).
 
 		U32 framesProcessed = 0;
 		U8 *pAVTPDataUnit = pPayload;
@@ -496,37 +534,30 @@ tx_cb_ret_t openavbMapUncmpAudioTxCB(media_q_t *pMediaQ, U8 *pData, U32 *dataLen
 
 				}
 
-				while (framesProcessed < pPubMapInfo->framesPerPacket && pMediaQItem->readIdx < pMediaQItem->dataLen) {
-					int i1;
-					for (i1 = 0; i1 < pPubMapInfo->audioChannels; i1++) {
-						if (pPubMapInfo->itemSampleSizeBytes == 2) {
-							S32 sample = *(S16 *)pItemData;
-							sample &= 0x0000ffff;
-							sample = sample << 8;
-							sample |= pPvtData->AM824_label;
-							sample = htonl(sample);
-							*(U32 *)(pAVTPDataUnit) = sample;
-							pAVTPDataUnit += 4;
-							pItemData += 2;
-						}
-						else {
-							S32 sample = *(S32 *)pItemData;
-							sample &= 0x00ffffff;
-							sample |= pPvtData->AM824_label;
-							sample = htonl(sample);
-							*(U32 *)(pAVTPDataUnit) = sample;
-							pAVTPDataUnit += 4;
-							pItemData += 3;
-						}
-					}
-					framesProcessed++;
+				// Pack as many whole frames as this item and the packet allow in one go
+				U32 frames = (pMediaQItem->dataLen - pMediaQItem->readIdx) / pPubMapInfo->itemFrameSizeBytes;
+				if (frames > pPubMapInfo->framesPerPacket - framesProcessed) {
+					frames = pPubMapInfo->framesPerPacket - framesProcessed;
+				}
+				if (frames == 0) {
+					// A partial frame at the end of the item can't be sent
+					IF_LOG_INTERVAL(1000) AVB_LOG_ERROR("Media queue item does not hold whole frames");
+					pMediaQItem->readIdx = pMediaQItem->dataLen;
+				}
+
+				openavbAm824Pack(&pPvtData->am824, pAVTPDataUnit, pItemData, frames * pPubMapInfo->audioChannels);
+				pAVTPDataUnit += frames * pPubMapInfo->packetFrameSizeBytes;
+				pMediaQItem->readIdx += frames * pPubMapInfo->itemFrameSizeBytes;
+				framesProcessed += frames;
+
+				U32 i1;
+				for (i1 = 0; i1 < frames; i1++) {
 					if (dbc % sytInt == 0) {
 						*(U32 *)(&pHdr[HIDX_AVTP_TIMESTAMP32]) = htonl(openavbAvtpTimeGetAvtpTimestamp(pMediaQItem->pAvtpTime));
 
 						timestampSet = TRUE;
 					}
 					dbc++;
-					pMediaQItem->readIdx += pPubMapInfo->itemFrameSizeBytes;
 				}
 
 				if (pMediaQItem->readIdx >= pMediaQItem->dataLen) {
@@ -549,12 +580,10 @@ tx_cb_ret_t openavbMapUncmpAudioTxCB(media_q_t *pMediaQ, U8 *pData, U32 *dataLen
 			pHdr[HIDX_AVTP_HIDE7_TV1] &= ~0x01;
 		}
 
-		// Set the block continutity and data length
+		// Set the block continutity
 		pHdr[HIDX_DBC8] = pPvtData->DBC;
 		pPvtData->DBC = dbc;
 
-		*(U16 *)(&pHdr[HIDX_DATALEN16]) = htons((pPubMapInfo->framesPerPacket * pPubMapInfo->packetFrameSizeBytes) + CIP_HEADER_SIZE);
-
 		// Set out bound data length (entire packet length)
 		*dataLen = (pPubMapInfo->framesPerPacket * pPubMapInfo->packetFrameSizeBytes) + TOTAL_HEADER_SIZE;
 
@@ -583,6 +612,13 @@ bool openavbMapUncmpAudioRxCB(media_q_t *pMediaQ, U8 *pData, U32 dataLen)
 		U8 *pHdr = pData;
 		U8 *pPayload = pData + TOTAL_HEADER_SIZE;
 		media_q_pub_map_uncmp_audio_info_t *pPubMapInfo = pMediaQ->pPubMapInfo;
+		pvt_data_t *pPvtData = pMediaQ->pPvtMapInfo;
+
+		if (!pPvtData->am824.unpack.fn) {
+			IF_LOG_INTERVAL(1000) AVB_LOG_ERROR("Audio sample size not configured.");
+			AVB_TRACE_EXIT(AVB_TRACE_MAP_DETAIL);
+			return FALSE;
+		}
 
 		//pHdr[HIDX_AVTP_TIMESTAMP32];
 		//pHdr[HIDX_GATEWAY32];
@@ -620,7 +656,6 @@ bool openavbMapUncmpAudioRxCB(media_q_t *pMediaQ, U8 *pData, U32 dataLen)
 
 				// Get the timestamp
 				U32 timestamp = ntohl(*(U32 *)(&pHdr[HIDX_AVTP_TIMESTAMP32]));
-				pvt_data_t *pPvtData = pMediaQ->pPvtMapInfo;
 				if ((pPvtData->audioMcr != AVB_MCR_NONE) && tsValid && !tsUncertain) {
 					// MCR mode set and timestamp is valid, and timestamp uncertain is not set
 					openavbAvtpTimePushMCR(pMediaQItem->pAvtpTime, timestamp);
@@ -645,27 +680,15 @@ bool openavbMapUncmpAudioRxCB(media_q_t *pMediaQ, U8 *pData, U32 dataLen)
 					openavbAvtpTimeSetTimestampUncertain(pMediaQItem->pAvtpTime, tsUncertain);
 				}
 
-				while (((pAVTPDataUnit + pPubMapInfo->packetFrameSizeBytes) <= pAVTPDataUnitEnd) && ((pItemData + pPubMapInfo->itemFrameSizeBytes) <= pItemDataEnd)) {
-					int i1;
-					for (i1 = 0; i1 < pPubMapInfo->audioChannels; i1++) {
-						if (pPubMapInfo->itemSampleSizeBytes == 2) {
-							S32 sample = ntohl(*(S32 *)pAVTPDataUnit);
-							sample = sample * 1;
-							*(S16 *)(pItemData) = (sample & 0x00ffffff) >> 8;
-							pAVTPDataUnit += 4;
-							pItemData += 2;
-							itemSizeWritten += 2;
-						}
-						else {
-							S32 sample = ntohl(*(S32 *)pAVTPDataUnit);
-							sample = sample * 1;
-							*(S32 *)(pItemData) = sample & 0x00ffffff;
-							pAVTPDataUnit += 4;
-							pItemData += 3;
-							itemSizeWritten += 3;
-						}
-					}
+				// Unpack as many whole frames as the packet has and the item can take
+				U32 frames = (pAVTPDataUnitEnd - pAVTPDataUnit) / pPubMapInfo->packetFrameSizeBytes;
+				U32 itemFrames = (pItemDataEnd - pItemData) / pPubMapInfo->itemFrameSizeBytes;
+				if (frames > itemFrames) {
+					frames = itemFrames;
 				}
+				openavbAm824Unpack(&pPvtData->am824, pItemData, pAVTPDataUnit, frames * pPubMapInfo->audioChannels);
+				pAVTPDataUnit += frames * pPubMapInfo->packetFrameSizeBytes;
+				itemSizeWritten = frames * pPubMapInfo->itemFrameSizeBytes;
 
 				pMediaQItem->dataLen += itemSizeWritten;
 
@@ -733,6 +756,7 @@ extern DLL_EXPORT bool openavbMapUncmpAudioInitialize(media_q_t *pMediaQ, openav
 		pMapCB->map_gen_init_cb = openavbMapUncmpAudioGenInitCB;
 		pMapCB->map_tx_init_cb = openavbMapUncmpAudioTxInitCB;
 		pMapCB->map_tx_cb = openavbMapUncmpAudioTxCB;
+		pMapCB->map_tx_hdr_cb = openavbMapUncmpAudioTxHdrCB;
 		pMapCB->map_rx_init_cb = openavbMapUncmpAudioRxInitCB;
 		pMapCB->map_rx_cb = openavbMapUncmpAudioRxCB;
 		pMapCB->map_end_cb = openavbMapUncmpAudioEndCB;
@@ -44,9 +44,12 @@ https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
 #define	AVB_LOG_COMPONENT	"Media Queue"
 #include "openavb_log.h"
 
-static MUTEX_HANDLE(gMediaQMutex);
-#define MEDIAQ_LOCK() { MUTEX_CREATE_ERR(); MUTEX_LOCK(gMediaQMutex); MUTEX_LOG_ERR("Mutex Lock failure"); }
-#define MEDIAQ_UNLOCK() { MUTEX_CREATE_ERR(); MUTEX_UNLOCK(gMediaQMutex); MUTEX_LOG_ERR("Mutex Unlock failure"); }
+#define MEDIAQ_LOCK(pInfo) { MUTEX_CREATE_ERR(); MUTEX_LOCK((pInfo)->mutex); MUTEX_LOG_ERR("Mutex Lock failure"); }
+#define MEDIAQ_UNLOCK(pInfo) { MUTEX_CREATE_ERR(); MUTEX_UNLOCK((pInfo)->mutex); MUTEX_LOG_ERR("Mutex Unlock failure"); }
+
+// Lockless mode index access. The producer only writes pushPos and the consumer only writes pullPos.
+#define MEDIAQ_LOAD_ACQ(pVal)			__atomic_load_n((pVal), __ATOMIC_ACQUIRE)
+#define MEDIAQ_STORE_REL(pVal, val)		__atomic_store_n((pVal), (val), __ATOMIC_RELEASE)
 
 //#define DUMP_HEAD_PUSH 		1
 //#define DUMP_TAIL_PULL 		1
@@ -58,6 +61,19 @@ FILE *pFileHeadPush = 0;
 FILE *pFileTailPull = 0;
 #endif
 
+typedef struct {
+	// Lockless mode: set by the producer on a slot it had to skip because the
+	// item was still taken. Cleared by the consumer.
+	bool skip;
+
+	// Data length of the item when it was pushed.
+	U32 pushedLen;
+
+	// Running totals of items and bytes pushed up to and including this slot.
+	U32 pushedItems;
+	U32 pushedBytes;
+} media_q_item_info_t;
+
 typedef struct {
 	// Maximum number of items the queue can hold.
 	int itemCount;
@@ -89,8 +105,185 @@ typedef struct {
 	// Maximum stale tail
 	U32 maxStaleTailUsec;
 
+	// Mutex used for Head and Tail access when threadSafeOn is set.
+	MUTEX_HANDLE(mutex);
+
+	// Determines if the single producer / single consumer lockless ring is used.
+	// When set head and tail are not used, pushPos and pullPos are used instead.
+	bool locklessOn;
+
+	// Lockless mode: producer position. Runs from 0 to (2 * itemCount) - 1 so
+	// that a full queue can be told apart from an empty one.
+	U32 pushPos;
+
+	// Lockless mode: consumer position. Same range as pushPos.
+	U32 pullPos;
+
+	// Per item bookkeeping. Parallel to pItems.
+	media_q_item_info_t *pItemInfo;
+
+	// Index of the most recently pushed item. As items are pushed in
+	// presentation order it has the latest presentation time in the queue.
+	int lastPushIdx;
+
+	// Running totals of items and bytes pushed. Owned by the producer.
+	U32 pushedItems;
+	U32 pushedBytes;
+
+	// Running totals of items and bytes pulled or taken. Owned by the consumer.
+	U32 pulledItems;
+	U32 pulledBytes;
+
+	// Margin between presentation and pull time of the items pulled. Owned by the consumer.
+	openavb_hist_t *pPullMarginHist;
+
 } media_q_info_t;
 
+static U32 x_openavbMediaQLocklessNext(media_q_info_t *pMediaQInfo, U32 pos)
+{
+	return (++pos >= (U32)(pMediaQInfo->itemCount * 2)) ? 0 : pos;
+}
+
+static int x_openavbMediaQLocklessIdx(media_q_info_t *pMediaQInfo, U32 pos)
+{
+	return (pos >= (U32)pMediaQInfo->itemCount) ? pos - pMediaQInfo->itemCount : pos;
+}
+
+static U32 x_openavbMediaQLocklessFill(media_q_info_t *pMediaQInfo, U32 pushPos, U32 pullPos)
+{
+	return (pushPos >= pullPos) ? pushPos - pullPos : pushPos + (pMediaQInfo->itemCount * 2) - pullPos;
+}
+
+// Returns the index of the item that the producer will fill next or -1 if the queue is full.
+// In lockless mode this must only be called from the producer thread.
+static int x_openavbMediaQHeadIdx(media_q_info_t *pMediaQInfo)
+{
+	if (!pMediaQInfo->locklessOn) {
+		return pMediaQInfo->head;
+	}
+
+	U32 pushPos = pMediaQInfo->pushPos;
+	while (x_openavbMediaQLocklessFill(pMediaQInfo, pushPos, MEDIAQ_LOAD_ACQ(&pMediaQInfo->pullPos)) < (U32)pMediaQInfo->itemCount) {
+		int idx = x_openavbMediaQLocklessIdx(pMediaQInfo, pushPos);
+		if (!MEDIAQ_LOAD_ACQ(&pMediaQInfo->pItems[idx].taken)) {
+			return idx;
+		}
+
+		// The item hasn't been given back yet. Leave it in place and let the consumer step over the slot.
+		pMediaQInfo->pItemInfo[idx].skip = TRUE;
+		pMediaQInfo->pItemInfo[idx].pushedItems = pMediaQInfo->pushedItems;
+		pMediaQInfo->pItemInfo[idx].pushedBytes = pMediaQInfo->pushedBytes;
+		pushPos = x_openavbMediaQLocklessNext(pMediaQInfo, pushPos);
+		MEDIAQ_STORE_REL(&pMediaQInfo->pushPos, pushPos);
+	}
+	return -1;
+}
+
+// Returns the index of the item that the consumer will pull next or -1 if the queue is empty.
+// In lockless mode this must only be called from the consumer thread.
+static int x_openavbMediaQTailIdx(media_q_info_t *pMediaQInfo)
+{
+	if (!pMediaQInfo->locklessOn) {
+		return pMediaQInfo->tail;
+	}
+
+	U32 pullPos = pMediaQInfo->pullPos;
+	while (pullPos != MEDIAQ_LOAD_ACQ(&pMediaQInfo->pushPos)) {
+		int idx = x_openavbMediaQLocklessIdx(pMediaQInfo, pullPos);
+		if (!pMediaQInfo->pItemInfo[idx].skip) {
+			return idx;
+		}
+
+		pMediaQInfo->pItemInfo[idx].skip = FALSE;
+		pullPos = x_openavbMediaQLocklessNext(pMediaQInfo, pullPos);
+		MEDIAQ_STORE_REL(&pMediaQInfo->pullPos, pullPos);
+	}
+	return -1;
+}
+
+// Returns the index one past the last queued item, or -1 if the queue is full. Used to bound scans from the tail.
+static int x_openavbMediaQEndIdx(media_q_info_t *pMediaQInfo)
+{
+	if (!pMediaQInfo->locklessOn) {
+		return pMediaQInfo->head;
+	}
+
+	U32 pushPos = MEDIAQ_LOAD_ACQ(&pMediaQInfo->pushPos);
+	if (x_openavbMediaQLocklessFill(pMediaQInfo, pushPos, pMediaQInfo->pullPos) >= (U32)pMediaQInfo->itemCount) {
+		return -1;
+	}
+	return x_openavbMediaQLocklessIdx(pMediaQInfo, pushPos);
+}
+
+static bool x_openavbMediaQItemQueued(media_q_info_t *pMediaQInfo, int idx)
+{
+	return !pMediaQInfo->pItems[idx].taken && !pMediaQInfo->pItemInfo[idx].skip;
+}
+
+// Records a pushed item in the running totals. Called by the producer before the item is published.
+static void x_openavbMediaQPushed(media_q_info_t *pMediaQInfo, int idx)
+{
+	media_q_item_info_t *pInfo = &pMediaQInfo->pItemInfo[idx];
+	pInfo->pushedLen = pMediaQInfo->pItems[idx].dataLen;
+	pMediaQInfo->pushedItems++;
+	pMediaQInfo->pushedBytes += pInfo->pushedLen;
+	pInfo->pushedItems = pMediaQInfo->pushedItems;
+	pInfo->pushedBytes = pMediaQInfo->pushedBytes;
+	MEDIAQ_STORE_REL(&pMediaQInfo->lastPushIdx, idx);
+}
+
+// Records a pulled or taken item in the running totals. Called by the consumer.
+static void x_openavbMediaQPulled(media_q_info_t *pMediaQInfo, int idx)
+{
+	pMediaQInfo->pulledItems++;
+	pMediaQInfo->pulledBytes += pMediaQInfo->pItemInfo[idx].pushedLen;
+
+	if (pMediaQInfo->pPullMarginHist) {
+		avtp_time_t *pAvtpTime = pMediaQInfo->pItems[idx].pAvtpTime;
+		if (pAvtpTime && pAvtpTime->bTimestampValid && !pAvtpTime->bTimestampUncertain) {
+			U64 nowNS;
+			CLOCK_GETTIME64(OPENAVB_CLOCK_WALLTIME, &nowNS);
+			openavbHistAdd(pMediaQInfo->pPullMarginHist, (S64)(pAvtpTime->timeNsec - nowNS));
+		}
+	}
+}
+
+// Gets the number of items and bytes that are queued. Only valid when the queue isn't empty.
+static void x_openavbMediaQQueued(media_q_info_t *pMediaQInfo, U32 *pItems, U32 *pBytes)
+{
+	U32 pushedItems = pMediaQInfo->pushedItems;
+	U32 pushedBytes = pMediaQInfo->pushedBytes;
+
+	if (pMediaQInfo->locklessOn) {
+		// The producer totals may already include an item that isn't published yet.
+		// Use the totals stored with the last published slot instead.
+		U32 pushPos = MEDIAQ_LOAD_ACQ(&pMediaQInfo->pushPos);
+		if (pushPos == 0) {
+			pushPos = pMediaQInfo->itemCount * 2;
+		}
+		media_q_item_info_t *pInfo = &pMediaQInfo->pItemInfo[x_openavbMediaQLocklessIdx(pMediaQInfo, pushPos - 1)];
+		pushedItems = pInfo->pushedItems;
+		pushedBytes = pInfo->pushedBytes;
+	}
+
+	*pItems = pushedItems - pMediaQInfo->pulledItems;
+	*pBytes = pushedBytes - pMediaQInfo->pulledBytes;
+}
+
+// Checks the readiness of the queued items against nSecTime using only the oldest and newest item.
+// Returns 0 if none are ready, 1 if all are ready and -1 if only some are.
+static int x_openavbMediaQReadiness(media_q_info_t *pMediaQInfo, int tailIdx, U64 nSecTime)
+{
+	if (!openavbAvtpTimeIsPastTime(pMediaQInfo->pItems[tailIdx].pAvtpTime, nSecTime)) {
+		return 0;
+	}
+	int lastIdx = MEDIAQ_LOAD_ACQ(&pMediaQInfo->lastPushIdx);
+	if (openavbAvtpTimeIsPastTime(pMediaQInfo->pItems[lastIdx].pAvtpTime, nSecTime)) {
+		return 1;
+	}
+	return -1;
+}
+
 static void x_openavbMediaQIncrementHead(media_q_info_t *pMediaQInfo)	
 {
 	AVB_TRACE_ENTRY(AVB_TRACE_MEDIAQ_DETAIL);
@@ -169,8 +362,9 @@ void x_openavbMediaQPurgeStaleTail(media_q_t *pMediaQ)
 				while (bMore) {
 					bMore = FALSE;
 					if (pMediaQInfo->itemCount > 0) {
-						if (pMediaQInfo->tail > -1) {
-							media_q_item_t *pTail = &pMediaQInfo->pItems[pMediaQInfo->tail];
+						int tailIdx = x_openavbMediaQTailIdx(pMediaQInfo);
+						if (tailIdx > -1) {
+							media_q_item_t *pTail = &pMediaQInfo->pItems[tailIdx];
 	
 							if (pTail) {
 								pMediaQInfo->tailLocked = TRUE;
@@ -234,6 +428,22 @@ media_q_t* openavbMediaQCreate()
 			pMediaQInfo->maxLatencyUsec = 0;
 			pMediaQInfo->threadSafeOn = FALSE;
 			pMediaQInfo->maxStaleTailUsec = MICROSECONDS_PER_SECOND;
+			pMediaQInfo->locklessOn = FALSE;
+			pMediaQInfo->pushPos = 0;
+			pMediaQInfo->pullPos = 0;
+			pMediaQInfo->lastPushIdx = 0;
+			pMediaQInfo->pushedItems = 0;
+			pMediaQInfo->pushedBytes = 0;
+			pMediaQInfo->pulledItems = 0;
+			pMediaQInfo->pulledBytes = 0;
+
+			MUTEX_ATTR_HANDLE(mta);
+			MUTEX_ATTR_INIT(mta);
+			MUTEX_ATTR_SET_TYPE(mta, MUTEX_ATTR_TYPE_DEFAULT);
+			MUTEX_ATTR_SET_NAME(mta, "mediaQMutex");
+			MUTEX_CREATE_ERR();
+			MUTEX_CREATE(pMediaQInfo->mutex, mta);
+			MUTEX_LOG_ERR("Error creating mutex");
 		}
 		else {
 			openavbMediaQDelete(pMediaQ);
@@ -252,6 +462,11 @@ void openavbMediaQThreadSafeOn(media_q_t *pMediaQ)
 	if (pMediaQ) {
 		if (pMediaQ->pPvtMediaQInfo) {
 			media_q_info_t *pMediaQInfo = (media_q_info_t *)(pMediaQ->pPvtMediaQInfo);
+			if (pMediaQInfo->locklessOn) {
+				// Callers asking for thread safety may have more than one producer. Mutex protection wins.
+				AVB_LOG_INFO("MediaQ lockless mode replaced by mutex protection");
+				pMediaQInfo->locklessOn = FALSE;
+			}
 			pMediaQInfo->threadSafeOn = TRUE;
 		}
 	}
@@ -259,6 +474,25 @@ void openavbMediaQThreadSafeOn(media_q_t *pMediaQ)
 	AVB_TRACE_EXIT(AVB_TRACE_MEDIAQ);
 }
 
+void openavbMediaQLocklessOn(media_q_t *pMediaQ)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_MEDIAQ);
+
+	if (pMediaQ) {
+		if (pMediaQ->pPvtMediaQInfo) {
+			media_q_info_t *pMediaQInfo = (media_q_info_t *)(pMediaQ->pPvtMediaQInfo);
+			if (pMediaQInfo->threadSafeOn) {
+				AVB_LOG_INFO("MediaQ already mutex protected; lockless mode not enabled");
+			}
+			else {
+				pMediaQInfo->locklessOn = TRUE;
+			}
+		}
+	}
+
+	AVB_TRACE_EXIT(AVB_TRACE_MEDIAQ);
+}
+
 
 
 bool openavbMediaQSetSize(media_q_t *pMediaQ, int itemCount, int itemSize)
@@ -278,7 +512,8 @@ bool openavbMediaQSetSize(media_q_t *pMediaQ, int itemCount, int itemSize)
 			if (!pMediaQInfo->pItems)
 			{
 				pMediaQInfo->pItems = calloc(itemCount, sizeof(media_q_item_t));
-				if (pMediaQInfo->pItems) {
+				pMediaQInfo->pItemInfo = calloc(itemCount, sizeof(media_q_item_info_t));
+				if (pMediaQInfo->pItems && pMediaQInfo->pItemInfo) {
 					pMediaQInfo->itemCount = itemCount;
 					pMediaQInfo->itemSize = itemSize;
 
@@ -455,6 +690,15 @@ bool openavbMediaQDelete(media_q_t *pMediaQ)
 				free(pMediaQInfo->pItems);
 				pMediaQInfo->pItems = NULL;
 			}
+			if (pMediaQInfo->pItemInfo) {
+				free(pMediaQInfo->pItemInfo);
+				pMediaQInfo->pItemInfo = NULL;
+			}
+			{
+				MUTEX_CREATE_ERR();
+				MUTEX_DESTROY(pMediaQInfo->mutex);
+				MUTEX_LOG_ERR("Error destroying mutex");
+			}
 			free(pMediaQ->pPvtMediaQInfo);
 			pMediaQ->pPvtMediaQInfo = NULL;
 
@@ -515,6 +759,20 @@ void openavbMediaQSetMaxStaleTail(media_q_t *pMediaQ, U32 maxStaleTailUsec)
 	AVB_TRACE_EXIT(AVB_TRACE_MEDIAQ);
 }
 
+void openavbMediaQSetPullMarginHist(media_q_t *pMediaQ, openavb_hist_t *pHist)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_MEDIAQ);
+
+	if (pMediaQ) {
+		if (pMediaQ->pPvtMediaQInfo) {
+			media_q_info_t *pMediaQInfo = (media_q_info_t *)(pMediaQ->pPvtMediaQInfo);
+			pMediaQInfo->pPullMarginHist = pHist;
+		}
+	}
+
+	AVB_TRACE_EXIT(AVB_TRACE_MEDIAQ);
+}
+
 media_q_item_t *openavbMediaQHeadLock(media_q_t *pMediaQ)
 {
 	AVB_TRACE_ENTRY(AVB_TRACE_MEDIAQ_DETAIL);
@@ -523,18 +781,19 @@ media_q_item_t *openavbMediaQHeadLock(media_q_t *pMediaQ)
 		if (pMediaQ->pPvtMediaQInfo) {
 			media_q_info_t *pMediaQInfo = (media_q_info_t *)(pMediaQ->pPvtMediaQInfo);
 			if (pMediaQInfo->threadSafeOn) {
-				MEDIAQ_LOCK();
+				MEDIAQ_LOCK(pMediaQInfo);
 			}
 			if (pMediaQInfo->itemCount > 0) {
-				if (pMediaQInfo->head > -1) {
+				int headIdx = x_openavbMediaQHeadIdx(pMediaQInfo);
+				if (headIdx > -1) {
 					pMediaQInfo->headLocked = TRUE;
 					AVB_TRACE_EXIT(AVB_TRACE_MEDIAQ_DETAIL);
 					// Mutex (LOCK()) if acquired stays locked
-					return &pMediaQInfo->pItems[pMediaQInfo->head];
+					return &pMediaQInfo->pItems[headIdx];
 				}
 			}
 			if (pMediaQInfo->threadSafeOn) {
-				MEDIAQ_UNLOCK();
+				MEDIAQ_UNLOCK(pMediaQInfo);
 			}
 		}
 	}
@@ -551,10 +810,10 @@ void openavbMediaQHeadUnlock(media_q_t *pMediaQ)
 		if (pMediaQ->pPvtMediaQInfo) {
 			media_q_info_t *pMediaQInfo = (media_q_info_t *)(pMediaQ->pPvtMediaQInfo);
 			if (pMediaQInfo->itemCount > 0) {
-				if (pMediaQInfo->head > -1) {
+				if (pMediaQInfo->headLocked) {
 					pMediaQInfo->headLocked = FALSE;
 					if (pMediaQInfo->threadSafeOn) {
-						MEDIAQ_UNLOCK();
+						MEDIAQ_UNLOCK(pMediaQInfo);
 					}
 				}
 			}
@@ -571,11 +830,12 @@ bool openavbMediaQHeadPush(media_q_t *pMediaQ)
 		if (pMediaQ->pPvtMediaQInfo) {
 			media_q_info_t *pMediaQInfo = (media_q_info_t *)(pMediaQ->pPvtMediaQInfo);
 			if (pMediaQInfo->itemCount > 0) {
-				if (pMediaQInfo->head > -1) {
-					media_q_item_t *pHead = &pMediaQInfo->pItems[pMediaQInfo->head];
+				int headIdx = x_openavbMediaQHeadIdx(pMediaQInfo);
+				if (headIdx > -1) {
+					media_q_item_t *pHead = &pMediaQInfo->pItems[headIdx];
 
 #if DUMP_HEAD_PUSH
-					media_q_item_t *pMediaQItem = &pMediaQInfo->pItems[pMediaQInfo->head];
+					media_q_item_t *pMediaQItem = &pMediaQInfo->pItems[headIdx];
 					if (!pFileHeadPush) {
 						char filename[128];
 						sprintf(filename, "headpush_%5.5d.dat", GET_PID());
@@ -588,18 +848,27 @@ bool openavbMediaQHeadPush(media_q_t *pMediaQ)
 					}
 #endif
 
-					// If tail not set, set it now
-					if (pMediaQInfo->tail == -1) {
-						pMediaQInfo->tail = pMediaQInfo->head;
-					}
-					
 					pHead->readIdx = 0;		// Reset read index
 
-					x_openavbMediaQIncrementHead(pMediaQInfo);
+					x_openavbMediaQPushed(pMediaQInfo, headIdx);
+					AVB_TRACE_PROBE2(mediaq_push, pMediaQ, pHead->dataLen);
+
+					if (pMediaQInfo->locklessOn) {
+						// Publishes the item to the consumer
+						MEDIAQ_STORE_REL(&pMediaQInfo->pushPos, x_openavbMediaQLocklessNext(pMediaQInfo, pMediaQInfo->pushPos));
+					}
+					else {
+						// If tail not set, set it now
+						if (pMediaQInfo->tail == -1) {
+							pMediaQInfo->tail = pMediaQInfo->head;
+						}
+
+						x_openavbMediaQIncrementHead(pMediaQInfo);
+					}
 
 					pMediaQInfo->headLocked = FALSE;
 					if (pMediaQInfo->threadSafeOn) {
-						MEDIAQ_UNLOCK();
+						MEDIAQ_UNLOCK(pMediaQInfo);
 					}
 
 					AVB_TRACE_EXIT(AVB_TRACE_MEDIAQ_DETAIL);
@@ -625,17 +894,18 @@ media_q_item_t* openavbMediaQTailLock(media_q_t *pMediaQ, bool ignoreTimestamp)
 		if (pMediaQ->pPvtMediaQInfo) {
 			media_q_info_t *pMediaQInfo = (media_q_info_t *)(pMediaQ->pPvtMediaQInfo);
 			if (pMediaQInfo->threadSafeOn) {
-				MEDIAQ_LOCK();
+				MEDIAQ_LOCK(pMediaQInfo);
 			}
 			if (pMediaQInfo->itemCount > 0) {
-				if (pMediaQInfo->tail > -1) {
-					media_q_item_t *pTail = &pMediaQInfo->pItems[pMediaQInfo->tail];
+				int tailIdx = x_openavbMediaQTailIdx(pMediaQInfo);
+				if (tailIdx > -1) {
+					media_q_item_t *pTail = &pMediaQInfo->pItems[tailIdx];
 
 					// Check if tail item is ready.
 					if (!ignoreTimestamp) {
 						if (!openavbAvtpTimeIsPast(pTail->pAvtpTime)) {
 							if (pMediaQInfo->threadSafeOn) {
-								MEDIAQ_UNLOCK();
+								MEDIAQ_UNLOCK(pMediaQInfo);
 							}
 							AVB_TRACE_EXIT(AVB_TRACE_MEDIAQ_DETAIL);
 							return NULL;
@@ -649,7 +919,7 @@ media_q_item_t* openavbMediaQTailLock(media_q_t *pMediaQ, bool ignoreTimestamp)
 				}
 			}
 			if (pMediaQInfo->threadSafeOn) {
-				MEDIAQ_UNLOCK();
+				MEDIAQ_UNLOCK(pMediaQInfo);
 			}
 		}
 	}
@@ -666,10 +936,10 @@ void openavbMediaQTailUnlock(media_q_t *pMediaQ)
 		if (pMediaQ->pPvtMediaQInfo) {
 			media_q_info_t *pMediaQInfo = (media_q_info_t *)(pMediaQ->pPvtMediaQInfo);
 			if (pMediaQInfo->itemCount > 0) {
-				if (pMediaQInfo->tail > -1) {
+				if (pMediaQInfo->tailLocked) {
 					pMediaQInfo->tailLocked = FALSE;
 					if (pMediaQInfo->threadSafeOn) {
-						MEDIAQ_UNLOCK();
+						MEDIAQ_UNLOCK(pMediaQInfo);
 					}
 				}
 			}
@@ -686,11 +956,12 @@ bool openavbMediaQTailPull(media_q_t *pMediaQ)
 		if (pMediaQ->pPvtMediaQInfo) {
 			media_q_info_t *pMediaQInfo = (media_q_info_t *)(pMediaQ->pPvtMediaQInfo);
 			if (pMediaQInfo->itemCount > 0) {
-				if (pMediaQInfo->tail > -1) {
-					media_q_item_t *pTail = &pMediaQInfo->pItems[pMediaQInfo->tail];
+				int tailIdx = x_openavbMediaQTailIdx(pMediaQInfo);
+				if (tailIdx > -1) {
+					media_q_item_t *pTail = &pMediaQInfo->pItems[tailIdx];
 
 #if DUMP_TAIL_PULL
-					media_q_item_t *pMediaQItem = &pMediaQInfo->pItems[pMediaQInfo->tail];
+					media_q_item_t *pMediaQItem = &pMediaQInfo->pItems[tailIdx];
 					if (!pFileTailPull) {
 						char filename[128];
 						sprintf(filename, "tailpull_%5.5d.dat", GET_PID());
@@ -703,19 +974,28 @@ bool openavbMediaQTailPull(media_q_t *pMediaQ)
 					}
 #endif
 
-					// If head not set, set it now
-					if (pMediaQInfo->head == -1) {
-						pMediaQInfo->head = pMediaQInfo->tail;
-					}
+					x_openavbMediaQPulled(pMediaQInfo, tailIdx);
+					AVB_TRACE_PROBE2(mediaq_pull, pMediaQ, pTail->dataLen);
 
 					pTail->readIdx = 0;		// Reset read index
 					pTail->dataLen = 0;		// Clears out the data
 
-					x_openavbMediaQIncrementTail(pMediaQInfo);
+					if (pMediaQInfo->locklessOn) {
+						// Hands the item back to the producer
+						MEDIAQ_STORE_REL(&pMediaQInfo->pullPos, x_openavbMediaQLocklessNext(pMediaQInfo, pMediaQInfo->pullPos));
+					}
+					else {
+						// If head not set, set it now
+						if (pMediaQInfo->head == -1) {
+							pMediaQInfo->head = pMediaQInfo->tail;
+						}
+
+						x_openavbMediaQIncrementTail(pMediaQInfo);
+					}
 
 					pMediaQInfo->tailLocked = FALSE;
 					if (pMediaQInfo->threadSafeOn) {
-						MEDIAQ_UNLOCK();
+						MEDIAQ_UNLOCK(pMediaQInfo);
 					}
 					
 					AVB_TRACE_EXIT(AVB_TRACE_MEDIAQ_DETAIL);
@@ -737,14 +1017,27 @@ bool openavbMediaQTailItemTake(media_q_t *pMediaQ, media_q_item_t* pItem)
 		if (pMediaQ->pPvtMediaQInfo) {
 			media_q_info_t *pMediaQInfo = (media_q_info_t *)(pMediaQ->pPvtMediaQInfo);
 			if (pMediaQInfo->itemCount > 0) {
+				if (pMediaQInfo->locklessOn) {
+					x_openavbMediaQPulled(pMediaQInfo, x_openavbMediaQLocklessIdx(pMediaQInfo, pMediaQInfo->pullPos));
+
+					// Mark the item taken before the producer can see the slot as free.
+					MEDIAQ_STORE_REL(&pItem->taken, TRUE);
+					MEDIAQ_STORE_REL(&pMediaQInfo->pullPos, x_openavbMediaQLocklessNext(pMediaQInfo, pMediaQInfo->pullPos));
+					pMediaQInfo->tailLocked = FALSE;
+
+					AVB_TRACE_EXIT(AVB_TRACE_MEDIAQ_DETAIL);
+					return TRUE;
+				}
+
 				if (pMediaQInfo->tail > -1) {
 
+					x_openavbMediaQPulled(pMediaQInfo, pMediaQInfo->tail);
 					x_openavbMediaQIncrementTail(pMediaQInfo);
 
 					pItem->taken = TRUE;
 					pMediaQInfo->tailLocked = FALSE;
 					if (pMediaQInfo->threadSafeOn) {
-						MEDIAQ_UNLOCK();
+						MEDIAQ_UNLOCK(pMediaQInfo);
 					}
 					
 					AVB_TRACE_EXIT(AVB_TRACE_MEDIAQ_DETAIL);
@@ -763,15 +1056,21 @@ bool openavbMediaQTailItemGive(media_q_t *pMediaQ, media_q_item_t* pItem)
 	AVB_TRACE_ENTRY(AVB_TRACE_MEDIAQ_DETAIL);
 
 	if (pItem) {
-		pItem->taken = FALSE;
 		pItem->readIdx = 0;		// Reset read index
 		pItem->dataLen = 0;		// Clears out the data
+		// The producer may reuse the item as soon as this is seen
+		MEDIAQ_STORE_REL(&pItem->taken, FALSE);
 
 		if (pMediaQ) {
 			if (pMediaQ->pPvtMediaQInfo) {
 				media_q_info_t *pMediaQInfo = (media_q_info_t *)(pMediaQ->pPvtMediaQInfo);
+				if (pMediaQInfo->locklessOn) {
+					// Slots skipped while the item was taken are recovered by the consumer. Nothing to fix up.
+					AVB_TRACE_EXIT(AVB_TRACE_MEDIAQ_DETAIL);
+					return TRUE;
+				}
 				if (pMediaQInfo->threadSafeOn) {
-					MEDIAQ_LOCK();
+					MEDIAQ_LOCK(pMediaQInfo);
 				}
 				if (pMediaQInfo->itemCount > 0) {
 					if (pMediaQInfo->head == -1) {
@@ -787,7 +1086,7 @@ bool openavbMediaQTailItemGive(media_q_t *pMediaQ, media_q_item_t* pItem)
 					}
 				}
 				if (pMediaQInfo->threadSafeOn) {
-					MEDIAQ_UNLOCK();
+					MEDIAQ_UNLOCK(pMediaQInfo);
 				}
 			}
 		}
@@ -808,8 +1107,9 @@ bool openavbMediaQUsecTillTail(media_q_t *pMediaQ, U32 *pUsecTill)
 		if (pMediaQ->pPvtMediaQInfo) {
 			media_q_info_t *pMediaQInfo = (media_q_info_t *)(pMediaQ->pPvtMediaQInfo);
 			if (pMediaQInfo->itemCount > 0) {
-				if (pMediaQInfo->tail > -1) {
-					media_q_item_t *pTail = &pMediaQInfo->pItems[pMediaQInfo->tail];
+				int tailIdx = x_openavbMediaQTailIdx(pMediaQInfo);
+				if (tailIdx > -1) {
+					media_q_item_t *pTail = &pMediaQInfo->pItems[tailIdx];
 
 					U32 usecTill;
 					
@@ -840,39 +1140,34 @@ bool openavbMediaQIsAvailableBytes(media_q_t *pMediaQ, U32 bytes, bool ignoreTim
 		if (pMediaQ->pPvtMediaQInfo) {
 			media_q_info_t *pMediaQInfo = (media_q_info_t *)(pMediaQ->pPvtMediaQInfo);
 			if (pMediaQInfo->itemCount > 0) {
-				if (pMediaQInfo->tail > -1) {
-					// Check if tail item is ready.
-					int tailIdx = pMediaQInfo->tail;
-					int endIdx = pMediaQInfo->head > -1 ? pMediaQInfo->head : pMediaQInfo->tail;
-					if (ignoreTimestamp) {
-						while (1) {
-							media_q_item_t *pTail = &pMediaQInfo->pItems[tailIdx];
-							
-							if (!pTail->taken) {
-								byteCnt += pTail->dataLen - pTail->readIdx;
-	
-								if (byteCnt >= bytes) {
-									// Met the available byte count
-									AVB_TRACE_EXIT(AVB_TRACE_MEDIAQ_DETAIL);
-									return TRUE;
-								}
-							}
+				int tailIdx = x_openavbMediaQTailIdx(pMediaQInfo);
+				if (tailIdx > -1) {
+					U32 queuedItems, queuedBytes;
+					x_openavbMediaQQueued(pMediaQInfo, &queuedItems, &queuedBytes);
 
-							tailIdx++;
-							if (tailIdx >= pMediaQInfo->itemCount)
-								tailIdx = 0;
-							if (tailIdx == endIdx)
-								break;
-						}
+					int readiness = 1;
+					U64 nSecTime = 0;
+					if (!ignoreTimestamp) {
+						CLOCK_GETTIME64(OPENAVB_CLOCK_WALLTIME, &nSecTime);
+						readiness = x_openavbMediaQReadiness(pMediaQInfo, tailIdx, nSecTime);
+					}
+
+					if (readiness >= 0) {
+						// Either nothing or everything is ready. Only the tail item can be partially read.
+						bool bAvailable = readiness > 0 && queuedBytes - pMediaQInfo->pItems[tailIdx].readIdx >= bytes;
+						AVB_TRACE_EXIT(AVB_TRACE_MEDIAQ_DETAIL);
+						return bAvailable;
 					}
 					else {
-						U64 nSecTime;
-						CLOCK_GETTIME64(OPENAVB_CLOCK_WALLTIME, &nSecTime);
+						// Some items are still waiting for their presentation time. Accumulate the ready ones.
+						int endIdx = x_openavbMediaQEndIdx(pMediaQInfo);
+						if (endIdx == -1)
+							endIdx = tailIdx;
 						while (1) {
 							media_q_item_t *pTail = &pMediaQInfo->pItems[tailIdx];
 							assert(pTail);
 
-							if (!pTail->taken) {
+							if (x_openavbMediaQItemQueued(pMediaQInfo, tailIdx)) {
 								if (!openavbAvtpTimeIsPastTime(pTail->pAvtpTime, nSecTime))
 									break;
 
@@ -915,33 +1210,32 @@ U32 openavbMediaQCountItems(media_q_t *pMediaQ, bool ignoreTimestamp)
 		if (pMediaQ->pPvtMediaQInfo) {
 			media_q_info_t *pMediaQInfo = (media_q_info_t *)(pMediaQ->pPvtMediaQInfo);
 			if (pMediaQInfo->itemCount > 0) {
-				if (pMediaQInfo->tail > -1) {
+				int tailIdx = x_openavbMediaQTailIdx(pMediaQInfo);
+				if (tailIdx > -1) {
 					// Check if tail item is ready.
-					int tailIdx = pMediaQInfo->tail;
+					int endIdx = x_openavbMediaQEndIdx(pMediaQInfo);
 					if (ignoreTimestamp) {
-						while (1) {
-							media_q_item_t *pTail = &pMediaQInfo->pItems[tailIdx];
-
-							if (!pTail->taken) {
-								itemCnt++;
-							}
-
-							tailIdx++;
-							if (tailIdx >= pMediaQInfo->itemCount)
-								tailIdx = 0;
-							if (tailIdx == pMediaQInfo->head)
-								break;
-							if (itemCnt >= pMediaQInfo->itemCount)								
-								break;
-						}
+						U32 queuedBytes;
+						x_openavbMediaQQueued(pMediaQInfo, &itemCnt, &queuedBytes);
 					}
 					else {
 						U64 nSecTime;
 						CLOCK_GETTIME64(OPENAVB_CLOCK_WALLTIME, &nSecTime);
+						int readiness = x_openavbMediaQReadiness(pMediaQInfo, tailIdx, nSecTime);
+						if (readiness >= 0) {
+							if (readiness > 0) {
+								U32 queuedBytes;
+								x_openavbMediaQQueued(pMediaQInfo, &itemCnt, &queuedBytes);
+							}
+							AVB_TRACE_EXIT(AVB_TRACE_MEDIAQ_DETAIL);
+							return itemCnt;
+						}
+
+						// Some items are still waiting for their presentation time. Count the ready ones.
 						while (1) {
 							media_q_item_t *pTail = &pMediaQInfo->pItems[tailIdx];
 
-							if (!pTail->taken) {
+							if (x_openavbMediaQItemQueued(pMediaQInfo, tailIdx)) {
 								if (!openavbAvtpTimeIsPastTime(pTail->pAvtpTime, nSecTime))
 									break;
 
@@ -951,7 +1245,7 @@ U32 openavbMediaQCountItems(media_q_t *pMediaQ, bool ignoreTimestamp)
 							tailIdx++;
 							if (tailIdx >= pMediaQInfo->itemCount)
 								tailIdx = 0;
-							if (tailIdx == pMediaQInfo->head)
+							if (tailIdx == endIdx)
 								break;
 							if (itemCnt >= pMediaQInfo->itemCount)								
 								break;
@@ -966,6 +1260,22 @@ U32 openavbMediaQCountItems(media_q_t *pMediaQ, bool ignoreTimestamp)
 	return itemCnt;
 }
 
+U32 openavbMediaQDepth(media_q_t *pMediaQ)
+{
+	U32 itemCnt = 0;
+
+	if (pMediaQ && pMediaQ->pPvtMediaQInfo) {
+		media_q_info_t *pMediaQInfo = (media_q_info_t *)(pMediaQ->pPvtMediaQInfo);
+		// Nothing to count before openavbMediaQSetSize() allocates the items
+		if (pMediaQInfo->itemCount > 0) {
+			U32 queuedBytes;
+			x_openavbMediaQQueued(pMediaQInfo, &itemCnt, &queuedBytes);
+		}
+	}
+
+	return itemCnt;
+}
+
 bool openavbMediaQAnyReadyItems(media_q_t *pMediaQ, bool ignoreTimestamp)
 {
 	AVB_TRACE_ENTRY(AVB_TRACE_MEDIAQ_DETAIL);
@@ -978,9 +1288,9 @@ bool openavbMediaQAnyReadyItems(media_q_t *pMediaQ, bool ignoreTimestamp)
 		if (pMediaQ->pPvtMediaQInfo) {
 			media_q_info_t *pMediaQInfo = (media_q_info_t *)(pMediaQ->pPvtMediaQInfo);
 			if (pMediaQInfo->itemCount > 0) {
-				if (pMediaQInfo->tail > -1) {
+				int tailIdx = x_openavbMediaQTailIdx(pMediaQInfo);
+				if (tailIdx > -1) {
 					// Check if tail item is ready.
-					int tailIdx = pMediaQInfo->tail;
 					if (ignoreTimestamp) {
 						media_q_item_t *pTail = &pMediaQInfo->pItems[tailIdx];
 
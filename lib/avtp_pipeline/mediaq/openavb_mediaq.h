@@ -38,11 +38,13 @@ https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
 #define OPENAVB_MEDIA_Q_H 1
 
 #include "openavb_mediaq_pub.h"
+#include "openavb_hist_pub.h"
 
 // These are Public APIs. Details in openavb_mediaq_pub.h 
 //  However the declarations are included here for easy internal use. 
 media_q_t* openavbMediaQCreate();
 void openavbMediaQThreadSafeOn(media_q_t *pMediaQ);
+void openavbMediaQLocklessOn(media_q_t *pMediaQ);
 bool openavbMediaQSetSize(media_q_t *pMediaQ, int itemCount, int itemSize);
 bool openavbMediaQAllocItemMapData(media_q_t *pMediaQ, int itemPubMapSize, int itemPvtMapSize);
 bool openavbMediaQAllocItemIntfData(media_q_t *pMediaQ, int itemIntfSize);
@@ -58,4 +60,8 @@ bool openavbMediaQTailPull(media_q_t *pMediaQ);
 bool openavbMediaQUsecTillTail(media_q_t *pMediaQ, U32 *pUsecTill);
 bool openavbMediaQIsAvailableBytes(media_q_t *pMediaQ, U32 bytes, bool ignoreTimestamp);
 
+// Collect the margin (nsec) between the presentation time of the items pulled
+// from the tail and the time they are pulled into the histogram. NULL to stop.
+void openavbMediaQSetPullMarginHist(media_q_t *pMediaQ, openavb_hist_t *pHist);
+
 #endif  // OPENAVB_MEDIA_Q_H
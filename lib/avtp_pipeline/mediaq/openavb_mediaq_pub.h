@@ -100,6 +100,11 @@ typedef struct {
 	///  and interface module.
 	void *pPubMapInfo;
 
+	/// Listener only. Arrival time (gPTP wall time in nsec) of the AVTP frame
+	///  being passed to the mapping module's rx callback. Zero when receive
+	///  timestamps are not enabled (rx_timestamp) or not available.
+	U64 rxTimeNsec;
+
 	///////////////////////////
 	// Private properties
 	/// \privatesection
@@ -135,6 +140,21 @@ media_q_t* openavbMediaQCreate();
  */
 void openavbMediaQThreadSafeOn(media_q_t *pMediaQ);
 
+/** Enable lockless access for this media queue.
+ *
+ * For a media queue with exactly one producer thread (head functions) and one
+ * consumer thread (tail functions) the head and tail positions can be handed
+ * over with atomic loads and stores instead of a mutex. Items taken with
+ * openavbMediaQTailItemTake() are stepped over by the producer until they are
+ * given back. In this mode the tail related functions, including the item
+ * count and available bytes queries, must only be called from the consumer
+ * thread. If openavbMediaQThreadSafeOn() is also called mutex protection is
+ * used instead. This must be called before using the media queue.
+ *
+ * \param pMediaQ A pointer to the media_q_t structure
+ */
+void openavbMediaQLocklessOn(media_q_t *pMediaQ);
+
 /** Set size of  media queue.
  *
  * Pre-allocate all the items for the media queue. Once allocated the item
@@ -332,7 +352,8 @@ bool openavbMediaQUsecTillTail(media_q_t *pMediaQ, U32 *pUsecTill);
 /** Check if the number of bytes are available.
  *
  * Checks were the given media queue contains bytes, returns true if it does
- * false otherwise.
+ * false otherwise. Runs in constant time unless only part of the queued items
+ * have reached their presentation time.
  *
  * \param pMediaQ A pointer to the media_q_t structure.
  * \param bytes Number of bytes expected in media queue
@@ -344,7 +365,8 @@ bool openavbMediaQIsAvailableBytes(media_q_t *pMediaQ, U32 bytes, bool ignoreTim
 
 /** Count number of available MediaQ items.
  *
- * Count the number of available MediaQ items.
+ * Count the number of available MediaQ items. Runs in constant time unless
+ * only part of the queued items have reached their presentation time.
  *
  * \param pMediaQ A pointer to the media_q_t structure.
  * \param ignoreTimestamp Ignore timestamp for byte accumulation.
@@ -352,6 +374,17 @@ bool openavbMediaQIsAvailableBytes(media_q_t *pMediaQ, U32 bytes, bool ignoreTim
  */
 U32 openavbMediaQCountItems(media_q_t *pMediaQ, bool ignoreTimestamp);
 
+/** Number of queued MediaQ items, for diagnostics.
+ *
+ * Doesn't lock or change the media queue, so it can be called from either
+ * side of a lockless media queue. The count may be one off while the other
+ * side is pushing or pulling an item.
+ *
+ * \param pMediaQ A pointer to the media_q_t structure.
+ * \return The number of queued MediaQ items, whatever their presentation time.
+ */
+U32 openavbMediaQDepth(media_q_t *pMediaQ);
+
 /** Check if there are any ready MediaQ items.
  *
  * Check if there are any ready MediaQ items.
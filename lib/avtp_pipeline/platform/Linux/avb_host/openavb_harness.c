@@ -104,6 +104,9 @@ static void openavbTLSigHandler(int signal)
 	else if (signal == SIGUSR1) {
 		AVB_LOG_DEBUG("Waking up streaming thread");
 	}
+	else if (signal == SIGUSR2) {
+		openavbTLFlightDump();
+	}
 	else {
 		AVB_LOG_ERROR("Unexpected signal");
 	}
@@ -123,6 +126,8 @@ void openavbTlHarnessUsage(char *programName)
 		"  -d val     Last byte of destination address from static pool. Full address will be 91:e0:f0:00:fe:val.\n"
 		"  -I val     Use given (val) interface globally, can be overriden by giving the ifname= option to the config line.\n"
 		"  -l val     Filename of the log file to use.  If not specified, results will be logged to stderr.\n"
+		"  -m val     Serve the stream metrics for Prometheus on unix:<path> or [<host>:]<port> (host defaults to 127.0.0.1).\n"
+		"  -f val     Directory the flight recorder dumps are written to. Defaults to /tmp. Send SIGUSR2 for a dump.\n"
 		"\n"
 		"Examples:\n"
 		"  %s talker.ini\n"
@@ -137,8 +142,10 @@ void openavbTlHarnessUsage(char *programName)
 		"    Start 1 stream and override the sream_addr in the ini file.\n\n"
 		"  %s -i -s 8 -a 84:7E:40:2C:8F:DE listener.ini\n"
 		"    Work interactively with 8 streams overriding the stream_uid and stream_addr of each.\n\n"
+		"  %s -m 9100 -s 64 talker.ini\n"
+		"    Start 64 streams and serve their metrics on http://127.0.0.1:9100/metrics.\n\n"
 		,
-		programName, programName, programName, programName, programName, programName, programName);
+		programName, programName, programName, programName, programName, programName, programName, programName);
 }
 
 void openavbTlHarnessMenu()
@@ -152,6 +159,7 @@ void openavbTlHarnessMenu()
 		" 0-99         Toggle the state of the numbered stream\n"
 		" m            Display this menu\n"
 		" z            Stats\n"
+		" f            Dump the flight recorders\n"
 		" x            Exit\n"
 		);
 }
@@ -174,6 +182,8 @@ int main(int argc, char *argv[])
 	U8 destAddr[ETH_ALEN] = {0x91, 0xe0, 0xf0, 0x00, 0xfe, 0x00};
 	char *optIfnameGlobal = NULL;
 	char *optLogFileName = NULL;
+	char *optMetricsAddr = NULL;
+	char *optFlightDir = NULL;
 
 	// Talker listener vars
 	int iniIdx = 0;
@@ -193,6 +203,7 @@ int main(int argc, char *argv[])
 	sigaction(SIGINT, &sa, NULL);
 	sigaction(SIGTERM, &sa, NULL);
 	sigaction(SIGUSR1, &sa, NULL);
+	sigaction(SIGUSR2, &sa, NULL);
 
 	// Ignore SIGPIPE signals.
 	signal(SIGPIPE, SIG_IGN);
@@ -231,7 +242,7 @@ int main(int argc, char *argv[])
 
 	bool optDone = FALSE;
 	while (!optDone) {
-		int opt = getopt(argc, argv, "a:his:d:I:l:");
+		int opt = getopt(argc, argv, "a:his:d:I:l:m:f:");
 		if (opt != EOF) {
 			switch (opt) {
 				case 'a':
@@ -254,6 +265,12 @@ int main(int argc, char *argv[])
 				case 'l':
 					optLogFileName = strdup(optarg);
 					break;
+				case 'm':
+					optMetricsAddr = strdup(optarg);
+					break;
+				case 'f':
+					optFlightDir = strdup(optarg);
+					break;
 				case '?':
 				default:
 					openavbTlHarnessUsage(programName);
@@ -292,6 +309,14 @@ int main(int argc, char *argv[])
 		exit(-1);
 	}
 
+	if (optMetricsAddr && !openavbTLMetricsStart(optMetricsAddr)) {
+		AVB_LOG_ERROR("Unable to start the metrics server");
+	}
+
+	if (optFlightDir && !openavbTLFlightDir(optFlightDir)) {
+		AVB_LOG_ERROR("Unable to set the flight recorder directory");
+	}
+
 	// Populate the ini file list
 	int tlIndex = 0;
 	for (i1 = 0; i1 < iniCount; i1++) {
@@ -480,6 +505,10 @@ int main(int argc, char *argv[])
 						}
 					}
 					break;
+				case 'f':
+					// Dump the flight recorders
+					openavbTLFlightDump();
+					break;
 				case 'x':
 					// Exit
 					{
@@ -564,6 +593,15 @@ int main(int argc, char *argv[])
 		optLogFileName = NULL;
 	}
 
+	if (optMetricsAddr) {
+		free(optMetricsAddr);
+		optMetricsAddr = NULL;
+	}
+	if (optFlightDir) {
+		free(optFlightDir);
+		optFlightDir = NULL;
+	}
+
 #ifdef AVB_FEATURE_GSTREAMER
 	// If we're supporting the interface modules which use GStreamer,
 	// De-initialize GStreamer to clean up resources.
@@ -98,6 +98,9 @@ static void openavbTLSigHandler(int signal)
 	else if (signal == SIGUSR1) {
 		AVB_LOG_DEBUG("Waking up streaming thread");
 	}
+	else if (signal == SIGUSR2) {
+		openavbTLFlightDump();
+	}
 	else {
 		AVB_LOG_ERROR("Unexpected signal");
 	}
@@ -112,6 +115,8 @@ void openavbTlHostUsage(char *programName)
 		"Usage: %s [options] file...\n"
 		"  -I val     Use given (val) interface globally, can be overriden by giving the ifname= option to the config line.\n"
 		"  -l val     Filename of the log file to use.  If not specified, results will be logged to stderr.\n"
+		"  -m val     Serve the stream metrics for Prometheus on unix:<path> or [<host>:]<port> (host defaults to 127.0.0.1).\n"
+		"  -f val     Directory the flight recorder dumps are written to. Defaults to /tmp. Send SIGUSR2 for a dump.\n"
 		"\n"
 		"Examples:\n"
 		"  %s talker.ini\n"
@@ -137,6 +142,8 @@ int main(int argc, char *argv[])
 	char *programName;
 	char *optIfnameGlobal = NULL;
 	char *optLogFileName = NULL;
+	char *optMetricsAddr = NULL;
+	char *optFlightDir = NULL;
 
 	programName = strrchr(argv[0], '/');
 	programName = programName ? programName + 1 : argv[0];
@@ -152,7 +159,7 @@ int main(int argc, char *argv[])
 	// Process command line
 	bool optDone = FALSE;
 	while (!optDone) {
-		int opt = getopt(argc, argv, "hI:l:");
+		int opt = getopt(argc, argv, "hI:l:m:f:");
 		if (opt != EOF) {
 			switch (opt) {
 				case 'I':
@@ -161,6 +168,12 @@ int main(int argc, char *argv[])
 				case 'l':
 					optLogFileName = strdup(optarg);
 					break;
+				case 'm':
+					optMetricsAddr = strdup(optarg);
+					break;
+				case 'f':
+					optFlightDir = strdup(optarg);
+					break;
 				case 'h':
 				default:
 					openavbTlHostUsage(programName);
@@ -183,6 +196,14 @@ int main(int argc, char *argv[])
 		exit(-1);
 	}
 
+	if (optMetricsAddr && !openavbTLMetricsStart(optMetricsAddr)) {
+		AVB_LOG_ERROR("Unable to start the metrics server");
+	}
+
+	if (optFlightDir && !openavbTLFlightDir(optFlightDir)) {
+		AVB_LOG_ERROR("Unable to set the flight recorder directory");
+	}
+
 	// Setup signal handler
 	// We catch SIGINT and shutdown cleanly
 	bool err;
@@ -211,6 +232,13 @@ int main(int argc, char *argv[])
 		osalAVBFinalize();
 		exit(-1);
 	}
+	err = sigaction(SIGUSR2, &sa, NULL);
+	if (err)
+	{
+		AVB_LOG_ERROR("Failed to setup SIGUSR2 handler");
+		osalAVBFinalize();
+		exit(-1);
+	}
 
 	// Ignore SIGPIPE signals.
 	signal(SIGPIPE, SIG_IGN);
@@ -310,6 +338,15 @@ int main(int argc, char *argv[])
 		optLogFileName = NULL;
 	}
 
+	if (optMetricsAddr) {
+		free(optMetricsAddr);
+		optMetricsAddr = NULL;
+	}
+	if (optFlightDir) {
+		free(optFlightDir);
+		optFlightDir = NULL;
+	}
+
 #ifdef AVB_FEATURE_GSTREAMER
 	// If we're supporting the interface modules which use GStreamer,
 	// De-initialize GStreamer to clean up resources.
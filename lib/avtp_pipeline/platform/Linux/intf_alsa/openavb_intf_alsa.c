@@ -36,6 +36,7 @@ https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <poll.h>
 #include "openavb_types_pub.h"
 #include "openavb_audio_pub.h"
 #include "openavb_trace_pub.h"
@@ -53,6 +54,7 @@ https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
 
 #define PCM_DEVICE_NAME_DEFAULT	"default"
 #define PCM_ACCESS_TYPE			SND_PCM_ACCESS_RW_INTERLEAVED
+#define PCM_ACCESS_TYPE_MMAP	SND_PCM_ACCESS_MMAP_INTERLEAVED
 
 typedef struct {
 	/////////////
@@ -82,6 +84,9 @@ typedef struct {
 	// map_nv_allow_resampling
 	bool allowResampling;
 
+	// Transfer directly between the device buffer and media queue items
+	bool mmapMode;
+
 	U32 startThresholdPeriods;
 
 	U32 periodTimeUsec;
@@ -95,6 +100,10 @@ typedef struct {
 	// ALSA stream
 	snd_pcm_stream_t pcmStream;
 
+	// Poll descriptors of the capture device, for the talker to wait on
+	struct pollfd *pPollFds;
+	int nPollFds;
+
 	// ALSA read/write interval
 	U32 intervalCounter;
 
@@ -227,6 +236,113 @@ static snd_pcm_format_t x_AVBAudioFormatToAlsaFormat(avb_audio_type_t type,
 }
 
 
+// Set the access type, preferring mmap access if configured. Falls back to
+// read/write access if the device can't be mapped.
+static int x_setAccess(pvt_data_t *pPvtData, snd_pcm_hw_params_t *hwParams)
+{
+	if (pPvtData->mmapMode) {
+		int rslt = snd_pcm_hw_params_set_access(pPvtData->pcmHandle, hwParams, PCM_ACCESS_TYPE_MMAP);
+		if (rslt >= 0) {
+			return rslt;
+		}
+		AVB_LOGF_WARNING("mmap access not available, using read/write: %s", snd_strerror(rslt));
+		pPvtData->mmapMode = FALSE;
+	}
+	return snd_pcm_hw_params_set_access(pPvtData->pcmHandle, hwParams, PCM_ACCESS_TYPE);
+}
+
+// Copy up to frames captured frames from the device buffer straight into pDst.
+// Returns the number of frames copied, or a negative error like snd_pcm_readi.
+static snd_pcm_sframes_t x_mmapReadi(snd_pcm_t *pcmHandle, U8 *pDst, snd_pcm_uframes_t frames, U32 frameBytes)
+{
+	const snd_pcm_channel_area_t *areas;
+	snd_pcm_uframes_t offset, n;
+	snd_pcm_sframes_t avail, committed, total = 0;
+
+	avail = snd_pcm_avail_update(pcmHandle);
+	if (avail < 0) {
+		return avail;
+	}
+	if (avail == 0) {
+		return -EAGAIN;
+	}
+
+	while (frames > 0 && avail > 0) {
+		n = frames < (snd_pcm_uframes_t)avail ? frames : (snd_pcm_uframes_t)avail;
+		int rslt = snd_pcm_mmap_begin(pcmHandle, &areas, &offset, &n);
+		if (rslt < 0) {
+			return total ? total : rslt;
+		}
+
+		// Interleaved access: a single area describes all channels
+		memcpy(pDst, (U8 *)areas[0].addr + areas[0].first / 8 + offset * (areas[0].step / 8), n * frameBytes);
+
+		committed = snd_pcm_mmap_commit(pcmHandle, offset, n);
+		if (committed < 0) {
+			return total ? total : committed;
+		}
+		pDst += committed * frameBytes;
+		frames -= committed;
+		avail -= committed;
+		total += committed;
+		if ((snd_pcm_uframes_t)committed != n) {
+			break;
+		}
+	}
+
+	return total;
+}
+
+// Copy frames from pSrc straight into the device buffer, waiting for room if needed.
+// Returns the number of frames copied, or a negative error like snd_pcm_writei.
+static snd_pcm_sframes_t x_mmapWritei(snd_pcm_t *pcmHandle, const U8 *pSrc, snd_pcm_uframes_t frames, U32 frameBytes)
+{
+	const snd_pcm_channel_area_t *areas;
+	snd_pcm_uframes_t offset, n;
+	snd_pcm_sframes_t avail, committed, total = 0;
+
+	while (frames > 0) {
+		avail = snd_pcm_avail_update(pcmHandle);
+		if (avail < 0) {
+			return total ? total : avail;
+		}
+		if (avail == 0) {
+			// Device buffer is full; only a running stream will make room
+			if (snd_pcm_state(pcmHandle) != SND_PCM_STATE_RUNNING) {
+				break;
+			}
+			int rslt = snd_pcm_wait(pcmHandle, 1000);
+			if (rslt <= 0) {
+				return total ? total : (rslt < 0 ? rslt : -EAGAIN);
+			}
+			continue;
+		}
+
+		n = frames < (snd_pcm_uframes_t)avail ? frames : (snd_pcm_uframes_t)avail;
+		int rslt = snd_pcm_mmap_begin(pcmHandle, &areas, &offset, &n);
+		if (rslt < 0) {
+			return total ? total : rslt;
+		}
+
+		memcpy((U8 *)areas[0].addr + areas[0].first / 8 + offset * (areas[0].step / 8), pSrc, n * frameBytes);
+
+		// Commit also starts playback once the start threshold is reached
+		committed = snd_pcm_mmap_commit(pcmHandle, offset, n);
+		if (committed < 0) {
+			return total ? total : committed;
+		}
+		pSrc += committed * frameBytes;
+		frames -= committed;
+		total += committed;
+		if ((snd_pcm_uframes_t)committed != n) {
+			break;
+		}
+	}
+
+	return total;
+}
+
+
 // Each configuration name value pair for this mapping will result in this callback being called.
 void openavbIntfAlsaCfgCB(media_q_t *pMediaQ, const char *name, const char *value)
 {
@@ -383,6 +499,13 @@ void openavbIntfAlsaCfgCB(media_q_t *pMediaQ, const char *name, const char *valu
 			}
 		}
 
+		else if (strcmp(name, "intf_nv_mmap") == 0) {
+			tmp = strtol(value, &pEnd, 10);
+			if (*pEnd == '\0') {
+				pPvtData->mmapMode = (tmp == 1);
+			}
+		}
+
 		else if (strcmp(name, "intf_nv_start_threshold_periods") == 0) {
 			pPvtData->startThresholdPeriods = strtol(value, &pEnd, 10);
 		}
@@ -467,7 +590,7 @@ void openavbIntfAlsaTxInitCB(media_q_t *pMediaQ)
 		}
 
 		// Set the access type
-		rslt = snd_pcm_hw_params_set_access(pPvtData->pcmHandle, hwParams, PCM_ACCESS_TYPE);
+		rslt = x_setAccess(pPvtData, hwParams);
 		if (rslt < 0) {
 			AVB_LOGF_ERROR("snd_pcm_hw_params_set_access() error: %s", snd_strerror(rslt));
 			snd_pcm_close(pPvtData->pcmHandle);
@@ -538,6 +661,38 @@ void openavbIntfAlsaTxInitCB(media_q_t *pMediaQ)
 		snd_pcm_hw_params_free(hwParams);
 		hwParams = NULL;
 
+		// Have poll() wake the talker once a whole media queue item has been captured
+		{
+			media_q_pub_map_uncmp_audio_info_t *pPubMapUncmpAudioInfo = pMediaQ->pPubMapInfo;
+			snd_pcm_sw_params_t *swParams;
+
+			rslt = snd_pcm_sw_params_malloc(&swParams);
+			if (rslt >= 0) {
+				rslt = snd_pcm_sw_params_current(pPvtData->pcmHandle, swParams);
+				if (rslt >= 0) {
+					rslt = snd_pcm_sw_params_set_avail_min(pPvtData->pcmHandle, swParams, pPubMapUncmpAudioInfo->framesPerItem);
+				}
+				if (rslt >= 0) {
+					rslt = snd_pcm_sw_params(pPvtData->pcmHandle, swParams);
+				}
+				snd_pcm_sw_params_free(swParams);
+			}
+			if (rslt < 0) {
+				AVB_LOGF_WARNING("Unable to set capture avail_min: %s", snd_strerror(rslt));
+			}
+
+			pPvtData->nPollFds = snd_pcm_poll_descriptors_count(pPvtData->pcmHandle);
+			if (pPvtData->nPollFds > 0) {
+				pPvtData->pPollFds = calloc(pPvtData->nPollFds, sizeof(struct pollfd));
+			}
+			if (pPvtData->pPollFds) {
+				pPvtData->nPollFds = snd_pcm_poll_descriptors(pPvtData->pcmHandle, pPvtData->pPollFds, pPvtData->nPollFds);
+			}
+			else {
+				pPvtData->nPollFds = 0;
+			}
+		}
+
 		// Get ready for playback
 		rslt = snd_pcm_prepare(pPvtData->pcmHandle);
 		if (rslt < 0) {
@@ -559,7 +714,7 @@ void openavbIntfAlsaTxInitCB(media_q_t *pMediaQ)
 		{
 			media_q_pub_map_uncmp_audio_info_t *pPubMapUncmpAudioInfo = pMediaQ->pPubMapInfo;
 
-			AVB_LOGF_INFO("Finished ALSA Setup: packingFactor %d", pPubMapUncmpAudioInfo->packingFactor);
+			AVB_LOGF_INFO("Finished ALSA Setup: packingFactor %d%s", pPubMapUncmpAudioInfo->packingFactor, pPvtData->mmapMode ? " (mmap)" : "");
 		}
 	}
 	AVB_TRACE_EXIT(AVB_TRACE_INTF);
@@ -597,7 +752,13 @@ bool openavbIntfAlsaTxCB(media_q_t *pMediaQ)
 					return FALSE;
 				}
 
-				rslt = snd_pcm_readi(pPvtData->pcmHandle, pMediaQItem->pPubData + pMediaQItem->dataLen, pPubMapUncmpAudioInfo->framesPerItem - (pMediaQItem->dataLen / pPubMapUncmpAudioInfo->itemFrameSizeBytes));
+				snd_pcm_uframes_t frames = pPubMapUncmpAudioInfo->framesPerItem - (pMediaQItem->dataLen / pPubMapUncmpAudioInfo->itemFrameSizeBytes);
+				if (pPvtData->mmapMode) {
+					rslt = x_mmapReadi(pPvtData->pcmHandle, (U8 *)pMediaQItem->pPubData + pMediaQItem->dataLen, frames, pPubMapUncmpAudioInfo->itemFrameSizeBytes);
+				}
+				else {
+					rslt = snd_pcm_readi(pPvtData->pcmHandle, pMediaQItem->pPubData + pMediaQItem->dataLen, frames);
+				}
 
 				if (rslt < 0) {
 					switch(rslt) {
@@ -607,6 +768,10 @@ bool openavbIntfAlsaTxCB(media_q_t *pMediaQ)
 						if (rslt < 0) {
 							AVB_LOGF_ERROR("snd_pcm_recover: %s", snd_strerror(rslt));
 						}
+						else if (pPvtData->mmapMode) {
+							// Unlike snd_pcm_readi(), mmap access doesn't restart the capture by itself
+							snd_pcm_start(pPvtData->pcmHandle);
+						}
 						break;
 					case -EAGAIN:
 						{ IF_LOG_INTERVAL(1000) AVB_LOG_DEBUG("snd_pcm_readi() had no data available"); }
@@ -647,6 +812,39 @@ bool openavbIntfAlsaTxCB(media_q_t *pMediaQ)
 	return !moreItems;
 }
 
+// Wait on the capture device until a full media queue item can be read.
+bool openavbIntfAlsaTxWaitCB(media_q_t *pMediaQ, U32 timeoutUsec)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_INTF_DETAIL);
+
+	bool bReady = FALSE;
+
+	if (pMediaQ) {
+		media_q_pub_map_uncmp_audio_info_t *pPubMapUncmpAudioInfo = pMediaQ->pPubMapInfo;
+		pvt_data_t *pPvtData = pMediaQ->pPvtIntfInfo;
+		if (!pPvtData || !pPvtData->pcmHandle || !pPvtData->nPollFds) {
+			AVB_TRACE_EXIT(AVB_TRACE_INTF_DETAIL);
+			return FALSE;
+		}
+
+		// An error is reported as ready so the TX callback can recover from it.
+		snd_pcm_sframes_t avail = snd_pcm_avail_update(pPvtData->pcmHandle);
+		if (avail < 0 || (snd_pcm_uframes_t)avail >= pPubMapUncmpAudioInfo->framesPerItem) {
+			AVB_TRACE_EXIT(AVB_TRACE_INTF_DETAIL);
+			return TRUE;
+		}
+
+		if (poll(pPvtData->pPollFds, pPvtData->nPollFds, timeoutUsec / 1000) > 0) {
+			unsigned short revents = 0;
+			snd_pcm_poll_descriptors_revents(pPvtData->pcmHandle, pPvtData->pPollFds, pPvtData->nPollFds, &revents);
+			bReady = (revents & (POLLIN | POLLERR)) != 0;
+		}
+	}
+
+	AVB_TRACE_EXIT(AVB_TRACE_INTF_DETAIL);
+	return bReady;
+}
+
 // A call to this callback indicates that this interface module will be
 // a listener. Any listener initialization can be done in this function.
 void openavbIntfAlsaRxInitCB(media_q_t *pMediaQ)
@@ -710,7 +908,7 @@ void openavbIntfAlsaRxInitCB(media_q_t *pMediaQ)
 		}
 
 		// Set the access type
-		rslt = snd_pcm_hw_params_set_access(pPvtData->pcmHandle, hwParams, PCM_ACCESS_TYPE);
+		rslt = x_setAccess(pPvtData, hwParams);
 		if (rslt < 0) {
 			AVB_LOGF_ERROR("snd_pcm_hw_params_set_access() error: %s", snd_strerror(rslt));
 			snd_pcm_close(pPvtData->pcmHandle);
@@ -964,6 +1162,14 @@ void openavbIntfAlsaRxInitCB(media_q_t *pMediaQ)
 	AVB_TRACE_EXIT(AVB_TRACE_INTF);
 }
 
+static S32 x_writeItem(pvt_data_t *pPvtData, media_q_pub_map_uncmp_audio_info_t *pPubMapUncmpAudioInfo, media_q_item_t *pMediaQItem)
+{
+	if (pPvtData->mmapMode) {
+		return x_mmapWritei(pPvtData->pcmHandle, pMediaQItem->pPubData, pPubMapUncmpAudioInfo->framesPerItem, pPubMapUncmpAudioInfo->itemFrameSizeBytes);
+	}
+	return snd_pcm_writei(pPvtData->pcmHandle, pMediaQItem->pPubData, pPubMapUncmpAudioInfo->framesPerItem);
+}
+
 // This callback is called when acting as a listener.
 bool openavbIntfAlsaRxCB(media_q_t *pMediaQ)
 {
@@ -986,14 +1192,14 @@ bool openavbIntfAlsaRxCB(media_q_t *pMediaQ)
 				if (pMediaQItem->dataLen) {
 					S32 rslt;
 
-					rslt = snd_pcm_writei(pPvtData->pcmHandle, pMediaQItem->pPubData, pPubMapUncmpAudioInfo->framesPerItem);
+					rslt = x_writeItem(pPvtData, pPubMapUncmpAudioInfo, pMediaQItem);
 					if (rslt < 0) {
 						AVB_LOGF_ERROR("snd_pcm_writei: %s", snd_strerror(rslt));
 						rslt = snd_pcm_recover(pPvtData->pcmHandle, rslt, 0);
 						if (rslt < 0) {
 							AVB_LOGF_ERROR("snd_pcm_recover: %s", snd_strerror(rslt));
 						}
-						rslt = snd_pcm_writei(pPvtData->pcmHandle, pMediaQItem->pPubData, pPubMapUncmpAudioInfo->framesPerItem);
+						rslt = x_writeItem(pPvtData, pPubMapUncmpAudioInfo, pMediaQItem);
 					}
 					if (rslt != pPubMapUncmpAudioInfo->framesPerItem) {
 						AVB_LOGF_WARNING("Not all pcm data consumed written:%u  consumed:%u", pMediaQItem->dataLen, rslt * pPubMapUncmpAudioInfo->audioChannels);
@@ -1031,6 +1237,12 @@ void openavbIntfAlsaEndCB(media_q_t *pMediaQ)
 			return;
 		}
 
+		if (pPvtData->pPollFds) {
+			free(pPvtData->pPollFds);
+			pPvtData->pPollFds = NULL;
+			pPvtData->nPollFds = 0;
+		}
+
 		if (pPvtData->pcmHandle) {
 			snd_pcm_close(pPvtData->pcmHandle);
 			pPvtData->pcmHandle = NULL;
@@ -1108,6 +1320,7 @@ extern DLL_EXPORT bool openavbIntfAlsaInitialize(media_q_t *pMediaQ, openavb_int
 		pIntfCB->intf_end_cb = openavbIntfAlsaEndCB;
 		pIntfCB->intf_gen_end_cb = openavbIntfAlsaGenEndCB;
 		pIntfCB->intf_enable_fixed_timestamp = openavbIntfAlsaEnableFixedTimestamp;
+		pIntfCB->intf_tx_wait_cb = openavbIntfAlsaTxWaitCB;
 
 		pPvtData->ignoreTimestamp = FALSE;
 		pPvtData->pDeviceName = strdup(PCM_DEVICE_NAME_DEFAULT);
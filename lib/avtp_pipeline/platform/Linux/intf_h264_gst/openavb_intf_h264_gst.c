@@ -70,6 +70,12 @@ typedef struct pvt_data_t
 	bool asyncRx;
 	bool blockingRx;
 
+	// Async RX thread feeding appsrc from rxBufs
+	pthread_t asyncRxThread;
+	pthread_mutex_t asyncReadMutex;
+	pthread_cond_t asyncReadCond;
+	bool bAsyncRXStreaming;
+
 	gint			nWaiting;
 	bool firstSample;
 	U16 stream_uid;
@@ -360,43 +366,34 @@ bool openavbIntfH264RtpGstTxCB(media_q_t *pMediaQ)
 }
 
 // Async stuff...
-static pthread_t asyncRxThread;
-static pthread_mutex_t asyncRxMutex = PTHREAD_MUTEX_INITIALIZER;
-static pthread_mutex_t asyncReadMutex = PTHREAD_MUTEX_INITIALIZER;
-static pthread_cond_t asyncReadCond = PTHREAD_COND_INITIALIZER;
-#define LOCK() pthread_mutex_lock(&asyncRxMutex)
-#define UNLOCK() pthread_mutex_unlock(&asyncRxMutex)
-static bool bAsyncRXStreaming;
-static media_q_t *pAsyncRxMediaQ;
-//static media_q_item_t *pAsyncRxMediaQItem;
-//static bool bAsyncRXDoneWithItem;
-
 static void *openavbIntfH264RtpGstRxThreadfn(void *pv)
 {
+	media_q_t *pMediaQ = pv;
 	pvt_data_t *pPvtData;
 
-	if (!pAsyncRxMediaQ)
+	if (!pMediaQ)
 	{
 		AVB_LOG_ERROR("No async mediaQ");
 		return 0;
 	}
-	pPvtData = pAsyncRxMediaQ->pPvtIntfInfo;
+	pPvtData = pMediaQ->pPvtIntfInfo;
 	if (!pPvtData)
 	{
 		AVB_LOG_ERROR("No async RX private data.");
 		return 0;
 	}
 
-	bAsyncRXStreaming = TRUE;
-	while (bAsyncRXStreaming)
+	while (pPvtData->bAsyncRXStreaming)
 	{
 		U32 bufwr = pPvtData->bufwr;
 		U32 bufrd = pPvtData->bufrd;
 		if (bufwr == bufrd)
 		{
-			pthread_mutex_lock(&asyncReadMutex);
-			pthread_cond_wait(&asyncReadCond, &asyncReadMutex);
-			pthread_mutex_unlock(&asyncReadMutex);
+			// Recheck under the mutex so a signal from RxCB or EndCB can't be missed
+			pthread_mutex_lock(&pPvtData->asyncReadMutex);
+			while (pPvtData->bAsyncRXStreaming && pPvtData->bufwr == pPvtData->bufrd)
+				pthread_cond_wait(&pPvtData->asyncReadCond, &pPvtData->asyncReadMutex);
+			pthread_mutex_unlock(&pPvtData->asyncReadMutex);
 		}
 		else if(bufwr > bufrd)
 		{
@@ -472,17 +469,26 @@ void openavbIntfH264RtpGstRxInitCB(media_q_t *pMediaQ)
 
 	if (pPvtData->asyncRx)
 	{
-		pAsyncRxMediaQ = pMediaQ;
-		int err = pthread_mutex_init(&asyncRxMutex, 0);
+		int err = pthread_mutex_init(&pPvtData->asyncReadMutex, 0);
 		if (err)
 			AVB_LOG_ERROR("Mutex init failed");
+		err = pthread_cond_init(&pPvtData->asyncReadCond, 0);
+		if (err)
+			AVB_LOG_ERROR("Condition init failed");
 		pthread_attr_t attr;
 		struct sched_param param;
 		pthread_attr_init(&attr);
 		pthread_attr_setschedpolicy(&attr, SCHED_OTHER);
 		param.sched_priority = 0;
 		pthread_attr_setschedparam(&attr, &param);
-		pthread_create(&asyncRxThread, &attr, openavbIntfH264RtpGstRxThreadfn, NULL);
+		pPvtData->bAsyncRXStreaming = TRUE;
+		err = pthread_create(&pPvtData->asyncRxThread, &attr, openavbIntfH264RtpGstRxThreadfn, pMediaQ);
+		if (err)
+		{
+			AVB_LOG_ERROR("Async RX thread create failed");
+			pPvtData->bAsyncRXStreaming = FALSE;
+		}
+		pthread_attr_destroy(&attr);
 	}
 }
 
@@ -560,10 +566,10 @@ bool openavbIntfH264RtpGstRxCB(media_q_t *pMediaQ)
 		if (pPvtData->asyncRx)
 		{
 			pPvtData->rxBufs[pPvtData->bufwr%NBUFS] = rxBuf;
+			pthread_mutex_lock(&pPvtData->asyncReadMutex);
 			__sync_fetch_and_add(&pPvtData->bufwr, 1);
-			pthread_mutex_lock(&asyncReadMutex);
-			pthread_cond_signal(&asyncReadCond);
-			pthread_mutex_unlock(&asyncReadMutex);
+			pthread_cond_signal(&pPvtData->asyncReadCond);
+			pthread_mutex_unlock(&pPvtData->asyncReadMutex);
 		}
 		else
 		{
@@ -584,21 +590,24 @@ bool openavbIntfH264RtpGstRxCB(media_q_t *pMediaQ)
 void openavbIntfH264RtpGstEndCB(media_q_t *pMediaQ)
 {
 	AVB_TRACE_ENTRY(AVB_TRACE_INTF);
-	bAsyncRXStreaming = FALSE;
 	pvt_data_t *pPvtData = pMediaQ->pPvtIntfInfo;
 	if (!pPvtData)
 	{
 		AVB_LOG_ERROR("Private interface module data not allocated.");
 		return;
 	}
-	destroyPipeline(pMediaQ);
-	if (pPvtData->asyncRx)
+	// Stop the async thread before the pipeline it pushes into goes away
+	if (pPvtData->asyncRx && pPvtData->bAsyncRXStreaming)
 	{
-		pthread_mutex_lock(&asyncReadMutex);
-		pthread_cond_signal(&asyncReadCond);
-		pthread_mutex_unlock(&asyncReadMutex);
-		pthread_join(asyncRxThread, NULL);
+		pthread_mutex_lock(&pPvtData->asyncReadMutex);
+		pPvtData->bAsyncRXStreaming = FALSE;
+		pthread_cond_signal(&pPvtData->asyncReadCond);
+		pthread_mutex_unlock(&pPvtData->asyncReadMutex);
+		pthread_join(pPvtData->asyncRxThread, NULL);
+		pthread_cond_destroy(&pPvtData->asyncReadCond);
+		pthread_mutex_destroy(&pPvtData->asyncReadMutex);
 	}
+	destroyPipeline(pMediaQ);
 	AVB_TRACE_EXIT(AVB_TRACE_INTF);
 }
 
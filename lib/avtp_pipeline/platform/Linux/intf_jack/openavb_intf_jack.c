@@ -36,6 +36,9 @@ https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <errno.h>
+#include <time.h>
+#include <semaphore.h>
 #include "openavb_types_pub.h"
 #include "openavb_audio_pub.h"
 #include "openavb_trace_pub.h"
@@ -51,8 +54,10 @@ https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
 #include <jack/jack.h>
 #include <jack/ringbuffer.h>
 
+#include "openavb_jack_conv.h"
 
-#define DEFAULT_JACK_RINGBUFFER_SIZE 136
+// Most channels (JACK ports) of a stream
+#define JACK_MAX_CHANNELS 64
 
 
 typedef enum {
@@ -69,7 +74,7 @@ typedef struct {
 
 	// JACK Client and Server names
 	char *pJACKClientName;
-    char *pJACKServerName;
+	char *pJACKServerName;
 
 	U32 startThresholdPeriods;
 
@@ -95,9 +100,31 @@ typedef struct {
 
 
 	// JACK Client Handle
-    jack_client_t *jack_client_ctx;
-    jack_port_t **jackPorts;
-    jack_ringbuffer_t **jackRingBuffer;
+	jack_client_t *jack_client_ctx;
+	jack_port_t **jackPorts;
+	bool bTalker;
+
+	// Interleaved samples in the media queue item format, passed between
+	// the JACK process thread and the talker / listener thread
+	jack_ringbuffer_t *jackRingBuffer;
+
+	// Conversion between the JACK port buffers and interleaved samples
+	jack_conv_t conv;
+	U32 frameBytes;
+
+	// Port buffers of the current period, and room for one period of
+	// interleaved samples for when the ring wraps in the middle
+	float **ppPortBufs;
+	U8 *pPeriodBuf;
+	U32 periodBufFrames;
+
+	// Periods dropped (talker) or played as silence (listener)
+	U32 xruns;
+
+	// Posted by the JACK thread when a full media queue item is in the ring
+	sem_t itemReadySem;
+	bool bItemReadySem;
+	U32 itemBytes;
 
 	// ALSA read/write interval //required?
 	U32 intervalCounter;
@@ -113,125 +140,321 @@ typedef struct {
 } pvt_data_t;
 
 
+// Runs in the JACK real time thread; no locks, allocations or logging.
 int jack_process_period_cb( jack_nframes_t nframes, void *arg )
 {
-    pvt_data_t *pPvtData = (pvt_data_t *)arg;
-    int collectedSampleBytes = sizeof( jack_default_audio_sample_t ) * nframes;
-
-    for( int k=0; k<pPvtData->audioChannels; k++){
-        jack_default_audio_sample_t *jack_samples_in_frame
-                = jack_port_get_buffer( pPvtData->jackPorts[ k ], nframes );
-
-        int portFlags
-                = jack_port_flags( pPvtData->jackPorts[ k ] );
-
-        if(  TALKER_PORT_IS_JACK_INPUT_PORT == portFlags) {
-            if ( jack_ringbuffer_write_space( pPvtData->jackRingBuffer[ k ] ) >= collectedSampleBytes ){
-                int bytes_written
-                        = jack_ringbuffer_write( pPvtData->jackRingBuffer[ k ],
-                                                    (char*)(jack_samples_in_frame),
-                                                    collectedSampleBytes );
-            }
-        } else if( LISTENER_PORT_IS_JACK_OUTPUT_PORT == portFlags){
-            if ( jack_ringbuffer_read_space( pPvtData->jackRingBuffer[ k ] ) >= collectedSampleBytes ){
-                int bytes_written
-                        = jack_ringbuffer_read( pPvtData->jackRingBuffer[ k ],
-                                                    (char*)(jack_samples_in_frame),
-                                                    collectedSampleBytes );
-            }
-        }
-    }
+	pvt_data_t *pPvtData = (pvt_data_t *)arg;
+	size_t periodBytes = nframes * pPvtData->frameBytes;
+	jack_ringbuffer_data_t vec[2];
+	U32 k;
+
+	for (k = 0; k < pPvtData->audioChannels; k++) {
+		pPvtData->ppPortBufs[k] = jack_port_get_buffer(pPvtData->jackPorts[k], nframes);
+	}
+
+	if (pPvtData->bTalker) {
+		if (jack_ringbuffer_write_space(pPvtData->jackRingBuffer) < periodBytes) {
+			pPvtData->xruns++;
+			return 0;
+		}
+		jack_ringbuffer_get_write_vector(pPvtData->jackRingBuffer, vec);
+		if (vec[0].len >= periodBytes) {
+			openavbJackConvInterleave(&pPvtData->conv, (U8 *)vec[0].buf, pPvtData->ppPortBufs, nframes);
+			jack_ringbuffer_write_advance(pPvtData->jackRingBuffer, periodBytes);
+		}
+		else if (nframes <= pPvtData->periodBufFrames) {
+			openavbJackConvInterleave(&pPvtData->conv, pPvtData->pPeriodBuf, pPvtData->ppPortBufs, nframes);
+			jack_ringbuffer_write(pPvtData->jackRingBuffer, (char *)pPvtData->pPeriodBuf, periodBytes);
+		}
+		else {
+			pPvtData->xruns++;
+		}
+
+		// Wake the talker (tx_intf_wakeup) once it has an item to read; sem_post() is safe here
+		if (pPvtData->bItemReadySem && jack_ringbuffer_read_space(pPvtData->jackRingBuffer) >= pPvtData->itemBytes) {
+			int val;
+			if (sem_getvalue(&pPvtData->itemReadySem, &val) == 0 && val == 0) {
+				sem_post(&pPvtData->itemReadySem);
+			}
+		}
+	}
+	else {
+		if (jack_ringbuffer_read_space(pPvtData->jackRingBuffer) < periodBytes) {
+			for (k = 0; k < pPvtData->audioChannels; k++) {
+				memset(pPvtData->ppPortBufs[k], 0, nframes * sizeof(jack_default_audio_sample_t));
+			}
+			pPvtData->xruns++;
+			return 0;
+		}
+		jack_ringbuffer_get_read_vector(pPvtData->jackRingBuffer, vec);
+		if (vec[0].len >= periodBytes) {
+			openavbJackConvDeinterleave(&pPvtData->conv, pPvtData->ppPortBufs, (U8 *)vec[0].buf, nframes);
+			jack_ringbuffer_read_advance(pPvtData->jackRingBuffer, periodBytes);
+		}
+		else if (nframes <= pPvtData->periodBufFrames) {
+			jack_ringbuffer_read(pPvtData->jackRingBuffer, (char *)pPvtData->pPeriodBuf, periodBytes);
+			openavbJackConvDeinterleave(&pPvtData->conv, pPvtData->ppPortBufs, pPvtData->pPeriodBuf, nframes);
+		}
+		else {
+			pPvtData->xruns++;
+		}
+	}
 	return 0;
 }
 
-
-int jack_shutdown_cb( void *arg )
+// Called by JACK while the process callback isn't running
+int jack_buffer_size_cb( jack_nframes_t nframes, void *arg )
 {
-    pvt_data_t *pPvtData = (pvt_data_t *)arg;
+	pvt_data_t *pPvtData = (pvt_data_t *)arg;
+
+	if (nframes > pPvtData->periodBufFrames) {
+		U8 *pBuf = realloc(pPvtData->pPeriodBuf, nframes * pPvtData->frameBytes);
+		if (!pBuf) {
+			AVB_LOG_ERROR("Unable to allocate memory for JACK period buffer.");
+			return -1;
+		}
+		pPvtData->pPeriodBuf = pBuf;
+		pPvtData->periodBufFrames = nframes;
+	}
 	return 0;
 }
 
+void jack_shutdown_cb( void *arg )
+{
+	AVB_LOG_WARNING("JACK server shut down.");
+}
+
 int init_jack_ports(pvt_data_t *pPvtData, jack_port_type_constant_t tl_jack_port_type, int channelNumber)
 {
-    char portString[32];
-    sprintf( portString, "aaf_ch_%d", channelNumber );
+	char portString[32];
+	sprintf( portString, "aaf_ch_%d", channelNumber );
+
+	pPvtData->jackPorts[ channelNumber ]
+			= jack_port_register( pPvtData->jack_client_ctx,
+									portString,
+									JACK_DEFAULT_AUDIO_TYPE,
+									tl_jack_port_type, 0 );
+
+	if( NULL == pPvtData->jackPorts[ channelNumber ]){
+		AVB_LOG_ERROR("no more JACK ports available.");
+		return -1;
+	}
 
-    pPvtData->jackPorts[ channelNumber ]
-            = jack_port_register( pPvtData->jack_client_ctx,
-                                    portString,
-                                    JACK_DEFAULT_AUDIO_TYPE,
-                                    tl_jack_port_type, 0 );
+	return 0;
+}
 
-    if( NULL == pPvtData->jackPorts[ channelNumber ]){
-        AVB_LOG_ERROR("no more JACK ports available.");
-        AVB_TRACE_EXIT(AVB_TRACE_INTF);
-        return -1;
-    }
+int init_jack_client(media_q_t *pMediaQ, jack_port_type_constant_t tl_jack_port_type )
+{
+	media_q_pub_map_uncmp_audio_info_t *pPubMapUncmpAudioInfo = pMediaQ->pPubMapInfo;
+	pvt_data_t *pPvtData = pMediaQ->pPvtIntfInfo;
+	jack_options_t jackOptions = JackNullOption;
+	jack_status_t jackStatus;
+
+	if (pPvtData->audioChannels < 1 || pPvtData->audioChannels > JACK_MAX_CHANNELS) {
+		AVB_LOGF_ERROR("Invalid number of channels (%d).", pPvtData->audioChannels);
+		return -1;
+	}
 
-    pPvtData->jackRingBuffer[ channelNumber ]
-            = jack_ringbuffer_create( sizeof(jack_default_audio_sample_t) * DEFAULT_JACK_RINGBUFFER_SIZE );
+	// JACK samples are floats; the media queue items hold interleaved samples in the mapping module's format.
+	if (!openavbJackConvInit(&pPvtData->conv, pPvtData->audioChannels,
+			pPubMapUncmpAudioInfo->itemSampleSizeBytes,
+			pPubMapUncmpAudioInfo->audioType == AVB_AUDIO_TYPE_FLOAT,
+			pPubMapUncmpAudioInfo->audioEndian != AVB_AUDIO_ENDIAN_BIG)) {
+		AVB_LOGF_ERROR("Unsupported sample format (%d bytes).", pPubMapUncmpAudioInfo->itemSampleSizeBytes);
+		return -1;
+	}
+	pPvtData->frameBytes = pPvtData->audioChannels * pPubMapUncmpAudioInfo->itemSampleSizeBytes;
+	pPvtData->itemBytes = pPubMapUncmpAudioInfo->itemSize;
+	pPvtData->bTalker = (tl_jack_port_type == TALKER_PORT_IS_JACK_INPUT_PORT);
 
-    if( NULL == pPvtData->jackRingBuffer[ channelNumber ]){
-        AVB_LOG_ERROR("failed to create JACK Ringbuffer.");
-        AVB_TRACE_EXIT(AVB_TRACE_INTF);
-        return -1;
-    }
+	if (pPvtData->bTalker) {
+		pPvtData->bItemReadySem = (sem_init(&pPvtData->itemReadySem, 0, 0) == 0);
+	}
 
-    memset(pPvtData->jackRingBuffer[ channelNumber ]->buf, 0, pPvtData->jackRingBuffer[ channelNumber ]->size);
+	// Open the JACK client.
+	if (pPvtData->pJACKServerName) {
+		jackOptions |= JackServerName;
+	}
+	pPvtData->jack_client_ctx = jack_client_open( pPvtData->pJACKClientName,
+													jackOptions,
+													&jackStatus,
+													pPvtData->pJACKServerName);
+	if( NULL == pPvtData->jack_client_ctx ) {
+		AVB_LOGF_ERROR("Unable to connect to JACK server; jack_client_open() failed, status = 0x%2.0x.", jackStatus);
+		return -1;
+	}
+
+	if (jack_get_sample_rate(pPvtData->jack_client_ctx) != pPvtData->audioRate) {
+		AVB_LOGF_ERROR("JACK sample rate %u differs from the stream's %u.", jack_get_sample_rate(pPvtData->jack_client_ctx), pPvtData->audioRate);
+		return -1;
+	}
+
+	U32 nframes = jack_get_buffer_size(pPvtData->jack_client_ctx);
+
+	pPvtData->jackPorts = calloc(pPvtData->audioChannels, sizeof(jack_port_t*));
+	pPvtData->ppPortBufs = calloc(pPvtData->audioChannels, sizeof(float*));
+	pPvtData->pPeriodBuf = malloc(nframes * pPvtData->frameBytes);
+	pPvtData->periodBufFrames = nframes;
+
+	// Room for two media queue items and two JACK periods
+	pPvtData->jackRingBuffer = jack_ringbuffer_create((pPubMapUncmpAudioInfo->itemSize + nframes * pPvtData->frameBytes) * 2);
+
+	if (!pPvtData->jackPorts || !pPvtData->ppPortBufs || !pPvtData->pPeriodBuf || !pPvtData->jackRingBuffer) {
+		AVB_LOG_ERROR("Unable to allocate memory for JACK interface module.");
+		return -1;
+	}
+	if (jack_ringbuffer_mlock(pPvtData->jackRingBuffer)) {
+		AVB_LOG_WARNING("Unable to lock JACK ringbuffer in memory.");
+	}
+
+	int k;
+	for (k = 0; k < pPvtData->audioChannels; k++) {
+		if (init_jack_ports(pPvtData, tl_jack_port_type, k)) {
+			return -1;
+		}
+	}
+
+	jack_set_process_callback( pPvtData->jack_client_ctx, jack_process_period_cb, (void*)pPvtData );
+	jack_set_buffer_size_callback( pPvtData->jack_client_ctx, jack_buffer_size_cb, (void*)pPvtData );
+	jack_on_shutdown( pPvtData->jack_client_ctx, jack_shutdown_cb, (void*)pPvtData );
 
-    return 0;
+	if( jack_activate( pPvtData->jack_client_ctx ) ) {
+		AVB_LOG_ERROR("Unable to activate to JACK client.");
+		return -1;
+	}
+
+	AVB_LOGF_INFO("JACK client %s: %d channels, %u frames/period, %s conversion",
+		jack_get_client_name(pPvtData->jack_client_ctx), pPvtData->audioChannels, nframes,
+		openavbJackConvName(&pPvtData->conv));
+	return 0;
 }
 
-int init_jack_client(pvt_data_t *pPvtData, jack_port_type_constant_t tl_jack_port_type )
+
+// Each configuration name value pair for this mapping will result in this callback being called.
+void openavbIntfJACK_CfgCB(media_q_t *pMediaQ, const char *name, const char *value)
 {
-    jack_options_t jackOptions;
-    jack_status_t jackStatus;
+	AVB_TRACE_ENTRY(AVB_TRACE_INTF);
+	if (pMediaQ) {
+		char *pEnd;
+		long tmp;
+		U32 val;
 
-    pPvtData->audioRate = AVB_AUDIO_RATE_48KHZ;
-    pPvtData->audioBitDepth = AVB_AUDIO_BIT_DEPTH_32BIT;
-    pPvtData->audioType = AVB_AUDIO_TYPE_FLOAT;
+		pvt_data_t *pPvtData = pMediaQ->pPvtIntfInfo;
+		if (!pPvtData) {
+			AVB_LOG_ERROR("Private interface module data not allocated.");
+			return;
+		}
 
-    // Open the pcm device.
-    pPvtData->jack_client_ctx = jack_client_open( pPvtData->pJACKClientName,
-                                                    jackOptions,
-                                                    &jackStatus,
-                                                    pPvtData->pJACKServerName);
-    if( NULL == pPvtData->jack_client_ctx ) {
-        AVB_LOGF_ERROR("Unable to connect to JACK server; jack_client_open() failed, status = 0x%2.0x.", jackStatus);
-        AVB_TRACE_EXIT(AVB_TRACE_INTF);
-        return -1;
-    }
+		media_q_pub_map_uncmp_audio_info_t *pPubMapUncmpAudioInfo;
+		pPubMapUncmpAudioInfo = (media_q_pub_map_uncmp_audio_info_t *)pMediaQ->pPubMapInfo;
+		if (!pPubMapUncmpAudioInfo) {
+			AVB_LOG_ERROR("Public map data for audio info not allocated.");
+			return;
+		}
+
+		// The audio parameters are given to the mapping module too.
+		bool bAudioMap = pMediaQ->pMediaQDataFormat
+			&& (strcmp(pMediaQ->pMediaQDataFormat, MapUncmpAudioMediaQDataFormat) == 0
+				|| strcmp(pMediaQ->pMediaQDataFormat, MapAVTPAudioMediaQDataFormat) == 0);
+
+		if (strcmp(name, "intf_nv_ignore_timestamp") == 0) {
+			tmp = strtol(value, &pEnd, 10);
+			if (*pEnd == '\0' && tmp == 1) {
+				pPvtData->ignoreTimestamp = (tmp == 1);
+			}
+		}
+
+		else if (strcmp(name, "intf_nv_jack_client_name") == 0) {
+			if (pPvtData->pJACKClientName)
+				free(pPvtData->pJACKClientName);
+			pPvtData->pJACKClientName = strdup(value);
+		}
 
-    int nframes = jack_get_buffer_size(pPvtData->jack_client_ctx);
+		else if (strcmp(name, "intf_nv_jack_server_name") == 0) {
+			if (pPvtData->pJACKServerName)
+				free(pPvtData->pJACKServerName);
+			pPvtData->pJACKServerName = strdup(value);
+		}
 
+		else if (strcmp(name, "intf_nv_audio_rate") == 0) {
+			val = strtol(value, &pEnd, 10);
+			if (val >= AVB_AUDIO_RATE_8KHZ && val <= AVB_AUDIO_RATE_192KHZ) {
+				pPvtData->audioRate = val;
+			}
+			else {
+				AVB_LOG_ERROR("Invalid audio rate configured for intf_nv_audio_rate.");
+				pPvtData->audioRate = AVB_AUDIO_RATE_48KHZ;
+			}
+			if (bAudioMap) {
+				pPubMapUncmpAudioInfo->audioRate = pPvtData->audioRate;
+			}
+		}
 
-    jack_set_process_callback( pPvtData->jack_client_ctx, jack_process_period_cb, (void*)pPvtData );
-    jack_on_shutdown( pPvtData->jack_client_ctx, jack_shutdown_cb, (void*)pPvtData );
+		else if (strcmp(name, "intf_nv_audio_bit_depth") == 0) {
+			val = strtol(value, &pEnd, 10);
+			if (val == AVB_AUDIO_BIT_DEPTH_16BIT || val == AVB_AUDIO_BIT_DEPTH_24BIT || val == AVB_AUDIO_BIT_DEPTH_32BIT) {
+				pPvtData->audioBitDepth = val;
+			}
+			else {
+				AVB_LOG_ERROR("Invalid audio bit depth configured for intf_nv_audio_bit_depth.");
+				pPvtData->audioBitDepth = AVB_AUDIO_BIT_DEPTH_24BIT;
+			}
+			if (bAudioMap) {
+				pPubMapUncmpAudioInfo->audioBitDepth = pPvtData->audioBitDepth;
+			}
+		}
 
-    pPvtData->jackPorts
-            = (jack_port_t**) malloc( sizeof(jack_port_t*) * pPvtData->audioChannels );
+		else if (strcmp(name, "intf_nv_audio_type") == 0) {
+			if (strncasecmp(value, "float", 5) == 0)
+				pPvtData->audioType = AVB_AUDIO_TYPE_FLOAT;
+			else if (strncasecmp(value, "sign", 4) == 0
+					 || strncasecmp(value, "int", 4) == 0)
+				pPvtData->audioType = AVB_AUDIO_TYPE_INT;
+			else {
+				AVB_LOG_ERROR("Invalid audio type configured for intf_nv_audio_type.");
+				pPvtData->audioType = AVB_AUDIO_TYPE_INT;
+			}
+			if (bAudioMap) {
+				pPubMapUncmpAudioInfo->audioType = pPvtData->audioType;
+			}
+		}
 
-    pPvtData->jackRingBuffer
-            = (jack_ringbuffer_t**) malloc( sizeof(jack_ringbuffer_t*) * pPvtData->audioChannels );
+		else if (strcmp(name, "intf_nv_audio_endian") == 0) {
+			if (strncasecmp(value, "big", 3) == 0)
+				pPvtData->audioEndian = AVB_AUDIO_ENDIAN_BIG;
+			else if (strncasecmp(value, "little", 6) == 0)
+				pPvtData->audioEndian = AVB_AUDIO_ENDIAN_LITTLE;
+			else {
+				AVB_LOG_ERROR("Invalid audio type configured for intf_nv_audio_endian.");
+				pPvtData->audioEndian = AVB_AUDIO_ENDIAN_LITTLE;
+			}
+			if (bAudioMap) {
+				pPubMapUncmpAudioInfo->audioEndian = pPvtData->audioEndian;
+			}
+		}
 
-    for( int k=0; k<pPvtData->audioChannels; k++){
-        if( init_jack_ports(pPvtData, tl_jack_port_type, k) ){
-            return -1;
-        }
-    }
+		else if (strcmp(name, "intf_nv_audio_channels") == 0) {
+			val = strtol(value, &pEnd, 10);
+			if (val >= AVB_AUDIO_CHANNELS_1 && val <= JACK_MAX_CHANNELS) {
+				pPvtData->audioChannels = val;
+			}
+			else {
+				AVB_LOG_ERROR("Invalid audio channels configured for intf_nv_audio_channels.");
+				pPvtData->audioChannels = AVB_AUDIO_CHANNELS_2;
+			}
+			if (bAudioMap) {
+				pPubMapUncmpAudioInfo->audioChannels = pPvtData->audioChannels;
+			}
+		}
 
-    if( jack_activate( pPvtData->jack_client_ctx ) ) {
-        AVB_LOG_ERROR("Unable to activate to JACK client.");
-        AVB_TRACE_EXIT(AVB_TRACE_INTF);
-        return -1;
-    }
+		else if (strcmp(name, "intf_nv_clock_skew_ppb") == 0) {
+			pPvtData->clockSkewPPB = strtol(value, &pEnd, 10);
+		}
+	}
 
-    return 0;
+	AVB_TRACE_EXIT(AVB_TRACE_INTF);
 }
 
-
-// Each configuration name value pair for this mapping will result in this callback being called.
-void openavbIntfJACK_CfgCB(media_q_t *pMediaQ, const char *name, const char *value){AVB_TRACE_ENTRY(AVB_TRACE_INTF);AVB_TRACE_EXIT(AVB_TRACE_INTF);}
 void openavbIntfJACK_GenInitCB(media_q_t *pMediaQ){AVB_TRACE_ENTRY(AVB_TRACE_INTF);AVB_TRACE_EXIT(AVB_TRACE_INTF);}
 
 // A call to this callback indicates that this interface module will be
@@ -246,11 +469,11 @@ void openavbIntfJACK_TxInitCB(media_q_t *pMediaQ)
 			AVB_TRACE_EXIT(AVB_TRACE_INTF);
 			return;
 		}
-        if( init_jack_client( pPvtData, TALKER_PORT_IS_JACK_INPUT_PORT ) < 0 ){
+		if (init_jack_client(pMediaQ, TALKER_PORT_IS_JACK_INPUT_PORT) < 0) {
 			AVB_LOG_ERROR("JACK Client Initialization failed.");
 			AVB_TRACE_EXIT(AVB_TRACE_INTF);
 			return;
-        }
+		}
 
 	}
 	AVB_TRACE_EXIT(AVB_TRACE_INTF);
@@ -271,55 +494,53 @@ bool openavbIntfJACK_TxCB(media_q_t *pMediaQ)
 			AVB_TRACE_EXIT(AVB_TRACE_INTF_DETAIL);
 			return FALSE;
 		}
+		if (!pPvtData->jackRingBuffer) {
+			AVB_TRACE_EXIT(AVB_TRACE_INTF_DETAIL);
+			return FALSE;
+		}
 
 		if (pPvtData->intervalCounter++ % pPubMapUncmpAudioInfo->packingFactor != 0) {
 			AVB_TRACE_EXIT(AVB_TRACE_INTF_DETAIL);
 			return TRUE;
 		}
 
-        int k = 0;
+		if (pPvtData->xruns) {
+			IF_LOG_INTERVAL(1000) AVB_LOGF_WARNING("JACK periods dropped: %u", pPvtData->xruns);
+		}
+
 		while (moreItems) {
 			pMediaQItem = openavbMediaQHeadLock(pMediaQ);
 			if (pMediaQItem) {
+				if (pMediaQItem->itemSize < pPubMapUncmpAudioInfo->itemSize) {
+					AVB_LOG_ERROR("Media queue item not large enough for samples");
+					AVB_TRACE_EXIT(AVB_TRACE_INTF_DETAIL);
+					return FALSE;
+				}
 
-                if (pMediaQItem->itemSize < pPubMapUncmpAudioInfo->itemSize) {
-                    AVB_LOG_ERROR("Media queue item not large enough for samples");
-                    AVB_TRACE_EXIT(AVB_TRACE_INTF_DETAIL);
-                    return FALSE;
-                }
-
-                int bytes_read = 0;
-
-                for( int samplePos = 0; samplePos < pPubMapUncmpAudioInfo->framesPerItem;samplePos++){
-                    for( int k = 0; k<pPvtData->audioChannels; k++ ){
-
-                        //pPubMapUncmpAudioInfo->framesPerItem - (pMediaQItem->dataLen / pPubMapUncmpAudioInfo->itemFrameSizeBytes;
-
-                        if ( ( bytes_read = jack_ringbuffer_read_space( pPvtData->jackRingBuffer[ k ] ) ) >= pPubMapUncmpAudioInfo->itemFrameSizeBytes ) {
-                            /* READ JACK RINGBUFFER */
-                            jack_ringbuffer_read ( pPvtData->jackRingBuffer[ k ],
-                                                    (char*)/*&*/(pMediaQItem->pPubData + pMediaQItem->dataLen),
-                                                    pPubMapUncmpAudioInfo->itemFrameSizeBytes);
-                        } else {
-                            AVB_LOG_ERROR("Unhandled ringbuffer read error");
-                            openavbMediaQHeadUnlock(pMediaQ);
-                        }
-
-                        pMediaQItem->dataLen += bytes_read * pPubMapUncmpAudioInfo->itemFrameSizeBytes;
-                        if (pMediaQItem->dataLen != pPubMapUncmpAudioInfo->itemSize) {
-                            openavbMediaQHeadUnlock(pMediaQ);
-                        }
-                        else {
-                            // Always get the timestamp.  Protocols such as AAF can choose to ignore them if not needed.
-                            if (!pPvtData->fixedTimestampEnabled) {
-                                openavbAvtpTimeSetToWallTime(pMediaQItem->pAvtpTime);
-                            } else {
-                                openavbMcsAdvance(&pPvtData->mcs);
-                                openavbAvtpTimeSetToTimestampNS(pMediaQItem->pAvtpTime, pPvtData->mcs.edgeTime);
-                            }
-                            openavbMediaQHeadPush(pMediaQ);
-                        }
-                    }
+				// Whole frames of what the JACK thread has put in the ring, up to a full item
+				U32 bytes = pPubMapUncmpAudioInfo->itemSize - pMediaQItem->dataLen;
+				size_t avail = jack_ringbuffer_read_space(pPvtData->jackRingBuffer);
+				if (avail < bytes) {
+					bytes = avail - avail % pPvtData->frameBytes;
+				}
+				if (bytes) {
+					jack_ringbuffer_read(pPvtData->jackRingBuffer, (char *)pMediaQItem->pPubData + pMediaQItem->dataLen, bytes);
+					pMediaQItem->dataLen += bytes;
+				}
+
+				if (pMediaQItem->dataLen != pPubMapUncmpAudioInfo->itemSize) {
+					openavbMediaQHeadUnlock(pMediaQ);
+					break;
+				}
+				else {
+					// Always get the timestamp.  Protocols such as AAF can choose to ignore them if not needed.
+					if (!pPvtData->fixedTimestampEnabled) {
+						openavbAvtpTimeSetToWallTime(pMediaQItem->pAvtpTime);
+					} else {
+						openavbMcsAdvance(&pPvtData->mcs);
+						openavbAvtpTimeSetToTimestampNS(pMediaQItem->pAvtpTime, pPvtData->mcs.edgeTime);
+					}
+					openavbMediaQHeadPush(pMediaQ);
 				}
 			}
 			else {
@@ -332,6 +553,38 @@ bool openavbIntfJACK_TxCB(media_q_t *pMediaQ)
 	return !moreItems;
 }
 
+// Wait for the JACK process callback to have put a full media queue item into the ring.
+bool openavbIntfJACK_TxWaitCB(media_q_t *pMediaQ, U32 timeoutUsec)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_INTF_DETAIL);
+
+	if (pMediaQ) {
+		pvt_data_t *pPvtData = pMediaQ->pPvtIntfInfo;
+		if (!pPvtData || !pPvtData->jackRingBuffer || !pPvtData->bItemReadySem) {
+			AVB_TRACE_EXIT(AVB_TRACE_INTF_DETAIL);
+			return FALSE;
+		}
+
+		while (jack_ringbuffer_read_space(pPvtData->jackRingBuffer) < pPvtData->itemBytes) {
+			struct timespec timeout;
+			clock_gettime(CLOCK_REALTIME, &timeout);
+			timeout.tv_sec += timeoutUsec / MICROSECONDS_PER_SECOND;
+			timeout.tv_nsec += (timeoutUsec % MICROSECONDS_PER_SECOND) * NANOSECONDS_PER_USEC;
+			if (timeout.tv_nsec >= NANOSECONDS_PER_SECOND) {
+				timeout.tv_sec++;
+				timeout.tv_nsec -= NANOSECONDS_PER_SECOND;
+			}
+			if (sem_timedwait(&pPvtData->itemReadySem, &timeout) != 0 && errno == ETIMEDOUT) {
+				AVB_TRACE_EXIT(AVB_TRACE_INTF_DETAIL);
+				return FALSE;
+			}
+		}
+	}
+
+	AVB_TRACE_EXIT(AVB_TRACE_INTF_DETAIL);
+	return TRUE;
+}
+
 // A call to this callback indicates that this interface module will be
 // a listener. Any listener initialization can be done in this function.
 void openavbIntfJACK_RxInitCB(media_q_t *pMediaQ)
@@ -344,12 +597,12 @@ void openavbIntfJACK_RxInitCB(media_q_t *pMediaQ)
 			return;
 		}
 
-        if( init_jack_client( pPvtData, LISTENER_PORT_IS_JACK_OUTPUT_PORT ) < 0 ){
+		if (init_jack_client(pMediaQ, LISTENER_PORT_IS_JACK_OUTPUT_PORT) < 0) {
 			AVB_LOG_ERROR("JACK Client Initialization failed.");
 			AVB_TRACE_EXIT(AVB_TRACE_INTF);
 			return;
-        }
-    }
+		}
+	}
 	AVB_TRACE_EXIT(AVB_TRACE_INTF);
 }
 
@@ -359,13 +612,20 @@ bool openavbIntfJACK_RxCB(media_q_t *pMediaQ)
 	AVB_TRACE_ENTRY(AVB_TRACE_INTF_DETAIL);
 
 	if (pMediaQ) {
-		media_q_pub_map_uncmp_audio_info_t *pPubMapUncmpAudioInfo = pMediaQ->pPubMapInfo;
 		pvt_data_t *pPvtData = pMediaQ->pPvtIntfInfo;
 		if (!pPvtData) {
 			AVB_LOG_ERROR("Private interface module data not allocated.");
 			AVB_TRACE_EXIT(AVB_TRACE_INTF_DETAIL);
 			return FALSE;
 		}
+		if (!pPvtData->jackRingBuffer) {
+			AVB_TRACE_EXIT(AVB_TRACE_INTF_DETAIL);
+			return FALSE;
+		}
+
+		if (pPvtData->xruns) {
+			IF_LOG_INTERVAL(1000) AVB_LOGF_WARNING("JACK periods played as silence: %u", pPvtData->xruns);
+		}
 
 		bool moreItems = TRUE;
 
@@ -373,27 +633,12 @@ bool openavbIntfJACK_RxCB(media_q_t *pMediaQ)
 			media_q_item_t *pMediaQItem = openavbMediaQTailLock(pMediaQ, pPvtData->ignoreTimestamp);
 			if (pMediaQItem) {
 				if (pMediaQItem->dataLen) {
-
-                    int bytes_to_read = 0;
-
-                    for( int samplePos = 0; samplePos < pPubMapUncmpAudioInfo->framesPerItem;samplePos++){
-                        for( int k = 0; k<pPvtData->audioChannels; k++ ){
-
-                            if ( ( bytes_to_read = jack_ringbuffer_write_space( pPvtData->jackRingBuffer[ k ] ) ) >= pPubMapUncmpAudioInfo->itemFrameSizeBytes ) {
-                                /* READ JACK RINGBUFFER */
-                                jack_ringbuffer_write( pPvtData->jackRingBuffer[ k ],
-                                                        (char*)&(pMediaQItem->pPubData),
-                                                        pPubMapUncmpAudioInfo->itemFrameSizeBytes);
-                            } else {
-                                AVB_LOGF_ERROR("Unhandled ringbuffer write error: %s", snd_strerror(bytes_to_read));
-                                openavbMediaQHeadUnlock(pMediaQ);
-                            }
-
-                            if (bytes_to_read < pPubMapUncmpAudioInfo->framesPerItem) {
-                                AVB_LOGF_WARNING("Not all pcm data consumed written:%u  consumed:%u", pMediaQItem->dataLen, pPubMapUncmpAudioInfo->audioChannels);
-                            }
-                        }
-                    }
+					if (jack_ringbuffer_write_space(pPvtData->jackRingBuffer) < pMediaQItem->dataLen) {
+						// The JACK thread hasn't caught up yet; try again next time
+						openavbMediaQTailUnlock(pMediaQ);
+						break;
+					}
+					jack_ringbuffer_write(pPvtData->jackRingBuffer, (char *)pMediaQItem->pPubData, pMediaQItem->dataLen);
 				}
 				openavbMediaQTailPull(pMediaQ);
 			}
@@ -418,17 +663,30 @@ void openavbIntfJACK_EndCB(media_q_t *pMediaQ)
 			return;
 		}
 
-        for( int k=0; k<pPvtData->audioChannels; k++){
-            if( jack_port_unregister(pPvtData->jack_client_ctx, pPvtData->jackPorts[ k ]));
-        }
+		if (pPvtData->jack_client_ctx) {
+			// Closing the client also unregisters its ports
+			jack_deactivate(pPvtData->jack_client_ctx);
+			jack_client_close(pPvtData->jack_client_ctx);
+			pPvtData->jack_client_ctx = NULL;
+		}
 
-        jack_client_close(pPvtData->jack_client_ctx);
+		if (pPvtData->bItemReadySem) {
+			sem_destroy(&pPvtData->itemReadySem);
+			pPvtData->bItemReadySem = FALSE;
+		}
 
-        for( int k=0; k<pPvtData->audioChannels; k++){
-            jack_free( pPvtData->jackPorts[ k ] );
-            jack_ringbuffer_free( pPvtData->jackRingBuffer[ k ] );
-        }
-    }
+		if (pPvtData->jackRingBuffer) {
+			jack_ringbuffer_free(pPvtData->jackRingBuffer);
+			pPvtData->jackRingBuffer = NULL;
+		}
+		free(pPvtData->jackPorts);
+		pPvtData->jackPorts = NULL;
+		free(pPvtData->ppPortBufs);
+		pPvtData->ppPortBufs = NULL;
+		free(pPvtData->pPeriodBuf);
+		pPvtData->pPeriodBuf = NULL;
+		pPvtData->periodBufFrames = 0;
+	}
 	AVB_TRACE_EXIT(AVB_TRACE_INTF);
 }
 
@@ -542,6 +800,7 @@ extern DLL_EXPORT bool openavbIntfJACK_Initialize(media_q_t *pMediaQ, openavb_in
 		pIntfCB->intf_end_cb = openavbIntfJACK_EndCB;
 		pIntfCB->intf_gen_end_cb = openavbIntfJACK_GenEndCB;
 		pIntfCB->intf_enable_fixed_timestamp = openavbIntfJACK_EnableFixedTimestamp;
+		pIntfCB->intf_tx_wait_cb = openavbIntfJACK_TxWaitCB;
 
 		pPvtData->ignoreTimestamp = FALSE;
 		pPvtData->intervalCounter = 0;
@@ -550,6 +809,10 @@ extern DLL_EXPORT bool openavbIntfJACK_Initialize(media_q_t *pMediaQ, openavb_in
 
 		pPvtData->fixedTimestampEnabled = FALSE;
 		pPvtData->clockSkewPPB = 0;
+
+		pPvtData->pJACKClientName = strdup("openavb");
+		pPvtData->audioRate = AVB_AUDIO_RATE_48KHZ;
+		pPvtData->audioEndian = AVB_AUDIO_ENDIAN_LITTLE;
 	}
 
 	AVB_TRACE_EXIT(AVB_TRACE_INTF);
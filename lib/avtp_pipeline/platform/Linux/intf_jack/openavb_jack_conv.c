@@ -0,0 +1,411 @@
+/*************************************************************************************************************
+Copyright (c) 2012-2015, Symphony Teleca Corporation, a Harman International Industries, Incorporated company
+Copyright (c) 2016-2017, Harman International Industries, Incorporated
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS LISTED "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS LISTED BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Attributions: The inih library portion of the source code is licensed from
+Brush Technology and Ben Hoyt - Copyright (c) 2009, Brush Technology and Copyright (c) 2009, Ben Hoyt.
+Complete license and copyright information can be found at
+https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
+*************************************************************************************************************/
+
+/*
+ * MODULE SUMMARY : JACK sample conversion
+ */
+
+#include <string.h>
+#include <math.h>
+#include "openavb_jack_conv.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define JACK_CONV_X86 1
+#elif defined(__aarch64__) && !defined(__ARM_BIG_ENDIAN)
+#include <arm_neon.h>
+#define JACK_CONV_NEON 1
+#endif
+
+// Samples are handled as 32 bit words: integers in the top bits, floats as is.
+// The vector versions below give the same results bit for bit.
+static inline U32 x_toWord(const jack_conv_t *pConv, float x)
+{
+	if (pConv->bFloat) {
+		U32 w;
+		memcpy(&w, &x, sizeof(w));
+		return w;
+	}
+	// Written like max/min of SSE so a NaN ends up as minVal too
+	float v = x * pConv->scale;
+	v = v > pConv->minVal ? v : pConv->minVal;
+	v = v < pConv->maxVal ? v : pConv->maxVal;
+	return (U32)(S32)lrintf(v) << pConv->shift;
+}
+
+static inline float x_fromWord(const jack_conv_t *pConv, U32 w)
+{
+	if (pConv->bFloat) {
+		float x;
+		memcpy(&x, &w, sizeof(x));
+		return x;
+	}
+	return (float)(S32)w * (1.0f / 2147483648.0f);
+}
+
+// Frames f0 to f1 of channels c0 and up, one sample at a time
+static void x_interleaveSamples(const jack_conv_t *pConv, U8 *pOut, float * const *ppIn, U32 f0, U32 f1, U32 c0)
+{
+	const U32 sb = pConv->sampleBytes, frameBytes = pConv->channels * sb;
+	U32 f, c, j;
+
+	for (f = f0; f < f1; f++) {
+		U8 *o = pOut + f * frameBytes + c0 * sb;
+		for (c = c0; c < pConv->channels; c++) {
+			U32 w = x_toWord(pConv, ppIn[c][f]);
+			for (j = 0; j < sb; j++) {
+				*o++ = w >> pConv->byteShift[j];
+			}
+		}
+	}
+}
+
+static void x_deinterleaveSamples(const jack_conv_t *pConv, float * const *ppOut, const U8 *pIn, U32 f0, U32 f1, U32 c0)
+{
+	const U32 sb = pConv->sampleBytes, frameBytes = pConv->channels * sb;
+	U32 f, c, j;
+
+	for (f = f0; f < f1; f++) {
+		const U8 *i = pIn + f * frameBytes + c0 * sb;
+		for (c = c0; c < pConv->channels; c++) {
+			U32 w = 0;
+			for (j = 0; j < sb; j++) {
+				w |= (U32)*i++ << pConv->byteShift[j];
+			}
+			ppOut[c][f] = x_fromWord(pConv, w);
+		}
+	}
+}
+
+static void x_interleaveScalar(const jack_conv_t *pConv, U8 *pOut, float * const *ppIn, U32 nFrames)
+{
+	x_interleaveSamples(pConv, pOut, ppIn, 0, nFrames, 0);
+}
+
+static void x_deinterleaveScalar(const jack_conv_t *pConv, float * const *ppOut, const U8 *pIn, U32 nFrames)
+{
+	x_deinterleaveSamples(pConv, ppOut, pIn, 0, nFrames, 0);
+}
+
+#if JACK_CONV_X86
+// Turn 4 channel vectors of 4 frames into 4 frame vectors of 4 channels
+#define TRANSPOSE_SSE(v0, v1, v2, v3) \
+	do { \
+		__m128i t0 = _mm_unpacklo_epi32(v0, v1), t1 = _mm_unpacklo_epi32(v2, v3); \
+		__m128i t2 = _mm_unpackhi_epi32(v0, v1), t3 = _mm_unpackhi_epi32(v2, v3); \
+		v0 = _mm_unpacklo_epi64(t0, t1); \
+		v1 = _mm_unpackhi_epi64(t0, t1); \
+		v2 = _mm_unpacklo_epi64(t2, t3); \
+		v3 = _mm_unpackhi_epi64(t2, t3); \
+	} while (0)
+
+__attribute__((target("ssse3")))
+static inline __m128i x_toWordsSsse3(const jack_conv_t *pConv, __m128 x, __m128 scale, __m128 lo, __m128 hi, __m128i shift)
+{
+	if (pConv->bFloat) {
+		return _mm_castps_si128(x);
+	}
+	x = _mm_min_ps(_mm_max_ps(_mm_mul_ps(x, scale), lo), hi);
+	return _mm_sll_epi32(_mm_cvtps_epi32(x), shift);
+}
+
+__attribute__((target("ssse3")))
+static inline __m128 x_fromWordsSsse3(const jack_conv_t *pConv, __m128i w, __m128 unscale)
+{
+	if (pConv->bFloat) {
+		return _mm_castsi128_ps(w);
+	}
+	return _mm_mul_ps(_mm_cvtepi32_ps(w), unscale);
+}
+
+// Store or load 4 packed samples, touching only their bytes
+__attribute__((target("ssse3")))
+static inline void x_storePackedSsse3(U8 *p, __m128i v, U32 sb)
+{
+	if (sb == 4) {
+		_mm_storeu_si128((__m128i *)p, v);
+		return;
+	}
+	_mm_storel_epi64((__m128i *)p, v);
+	if (sb == 3) {
+		U32 t = _mm_cvtsi128_si32(_mm_srli_si128(v, 8));
+		memcpy(p + 8, &t, sizeof(t));
+	}
+}
+
+__attribute__((target("ssse3")))
+static inline __m128i x_loadPackedSsse3(const U8 *p, U32 sb)
+{
+	if (sb == 4) {
+		return _mm_loadu_si128((const __m128i *)p);
+	}
+	__m128i v = _mm_loadl_epi64((const __m128i *)p);
+	if (sb == 3) {
+		U32 t;
+		memcpy(&t, p + 8, sizeof(t));
+		v = _mm_unpacklo_epi64(v, _mm_cvtsi32_si128(t));
+	}
+	return v;
+}
+
+__attribute__((target("ssse3")))
+static void x_interleaveSsse3(const jack_conv_t *pConv, U8 *pOut, float * const *ppIn, U32 nFrames)
+{
+	const U32 sb = pConv->sampleBytes, frameBytes = pConv->channels * sb;
+	const U32 blockChannels = pConv->channels & ~3u;
+	const __m128 scale = _mm_set1_ps(pConv->scale);
+	const __m128 lo = _mm_set1_ps(pConv->minVal);
+	const __m128 hi = _mm_set1_ps(pConv->maxVal);
+	const __m128i shift = _mm_cvtsi32_si128(pConv->shift);
+	const __m128i mask = _mm_loadu_si128((const __m128i *)pConv->packMask);
+	U32 f, c;
+
+	for (f = 0; f + 4 <= nFrames; f += 4) {
+		U8 *o = pOut + f * frameBytes;
+		for (c = 0; c < blockChannels; c += 4) {
+			__m128i v0 = x_toWordsSsse3(pConv, _mm_loadu_ps(ppIn[c] + f), scale, lo, hi, shift);
+			__m128i v1 = x_toWordsSsse3(pConv, _mm_loadu_ps(ppIn[c + 1] + f), scale, lo, hi, shift);
+			__m128i v2 = x_toWordsSsse3(pConv, _mm_loadu_ps(ppIn[c + 2] + f), scale, lo, hi, shift);
+			__m128i v3 = x_toWordsSsse3(pConv, _mm_loadu_ps(ppIn[c + 3] + f), scale, lo, hi, shift);
+			TRANSPOSE_SSE(v0, v1, v2, v3);
+			x_storePackedSsse3(o + c * sb, _mm_shuffle_epi8(v0, mask), sb);
+			x_storePackedSsse3(o + frameBytes + c * sb, _mm_shuffle_epi8(v1, mask), sb);
+			x_storePackedSsse3(o + 2 * frameBytes + c * sb, _mm_shuffle_epi8(v2, mask), sb);
+			x_storePackedSsse3(o + 3 * frameBytes + c * sb, _mm_shuffle_epi8(v3, mask), sb);
+		}
+	}
+	// Channels left over from the blocks, then frames left over
+	x_interleaveSamples(pConv, pOut, ppIn, 0, f, blockChannels);
+	x_interleaveSamples(pConv, pOut, ppIn, f, nFrames, 0);
+}
+
+__attribute__((target("ssse3")))
+static void x_deinterleaveSsse3(const jack_conv_t *pConv, float * const *ppOut, const U8 *pIn, U32 nFrames)
+{
+	const U32 sb = pConv->sampleBytes, frameBytes = pConv->channels * sb;
+	const U32 blockChannels = pConv->channels & ~3u;
+	const __m128 unscale = _mm_set1_ps(1.0f / 2147483648.0f);
+	const __m128i mask = _mm_loadu_si128((const __m128i *)pConv->unpackMask);
+	U32 f, c;
+
+	for (f = 0; f + 4 <= nFrames; f += 4) {
+		const U8 *i = pIn + f * frameBytes;
+		for (c = 0; c < blockChannels; c += 4) {
+			__m128i v0 = _mm_shuffle_epi8(x_loadPackedSsse3(i + c * sb, sb), mask);
+			__m128i v1 = _mm_shuffle_epi8(x_loadPackedSsse3(i + frameBytes + c * sb, sb), mask);
+			__m128i v2 = _mm_shuffle_epi8(x_loadPackedSsse3(i + 2 * frameBytes + c * sb, sb), mask);
+			__m128i v3 = _mm_shuffle_epi8(x_loadPackedSsse3(i + 3 * frameBytes + c * sb, sb), mask);
+			TRANSPOSE_SSE(v0, v1, v2, v3);
+			_mm_storeu_ps(ppOut[c] + f, x_fromWordsSsse3(pConv, v0, unscale));
+			_mm_storeu_ps(ppOut[c + 1] + f, x_fromWordsSsse3(pConv, v1, unscale));
+			_mm_storeu_ps(ppOut[c + 2] + f, x_fromWordsSsse3(pConv, v2, unscale));
+			_mm_storeu_ps(ppOut[c + 3] + f, x_fromWordsSsse3(pConv, v3, unscale));
+		}
+	}
+	x_deinterleaveSamples(pConv, ppOut, pIn, 0, f, blockChannels);
+	x_deinterleaveSamples(pConv, ppOut, pIn, f, nFrames, 0);
+}
+#endif
+
+#if JACK_CONV_NEON
+#define TRANSPOSE_NEON(v0, v1, v2, v3) \
+	do { \
+		uint32x4x2_t a = vtrnq_u32(v0, v1), b = vtrnq_u32(v2, v3); \
+		v0 = vcombine_u32(vget_low_u32(a.val[0]), vget_low_u32(b.val[0])); \
+		v1 = vcombine_u32(vget_low_u32(a.val[1]), vget_low_u32(b.val[1])); \
+		v2 = vcombine_u32(vget_high_u32(a.val[0]), vget_high_u32(b.val[0])); \
+		v3 = vcombine_u32(vget_high_u32(a.val[1]), vget_high_u32(b.val[1])); \
+	} while (0)
+
+static inline uint32x4_t x_toWordsNeon(const jack_conv_t *pConv, float32x4_t x, float32x4_t scale, float32x4_t lo, float32x4_t hi, int32x4_t shift)
+{
+	if (pConv->bFloat) {
+		return vreinterpretq_u32_f32(x);
+	}
+	// The nm variants return the number when one operand is NaN
+	x = vminnmq_f32(vmaxnmq_f32(vmulq_f32(x, scale), lo), hi);
+	return vshlq_u32(vreinterpretq_u32_s32(vcvtnq_s32_f32(x)), shift);
+}
+
+static inline float32x4_t x_fromWordsNeon(const jack_conv_t *pConv, uint32x4_t w, float32x4_t unscale)
+{
+	if (pConv->bFloat) {
+		return vreinterpretq_f32_u32(w);
+	}
+	return vmulq_f32(vcvtq_f32_s32(vreinterpretq_s32_u32(w)), unscale);
+}
+
+static inline void x_storePackedNeon(U8 *p, uint32x4_t w, uint8x16_t mask, U32 sb)
+{
+	uint8x16_t v = vqtbl1q_u8(vreinterpretq_u8_u32(w), mask);
+	if (sb == 4) {
+		vst1q_u8(p, v);
+		return;
+	}
+	vst1_u8(p, vget_low_u8(v));
+	if (sb == 3) {
+		U32 t = vgetq_lane_u32(vreinterpretq_u32_u8(v), 2);
+		memcpy(p + 8, &t, sizeof(t));
+	}
+}
+
+static inline uint32x4_t x_loadPackedNeon(const U8 *p, uint8x16_t mask, U32 sb)
+{
+	uint8x16_t v;
+	if (sb == 4) {
+		v = vld1q_u8(p);
+	}
+	else {
+		U32 t = 0;
+		if (sb == 3) {
+			memcpy(&t, p + 8, sizeof(t));
+		}
+		v = vcombine_u8(vld1_u8(p), vreinterpret_u8_u32(vdup_n_u32(t)));
+	}
+	return vreinterpretq_u32_u8(vqtbl1q_u8(v, mask));
+}
+
+static void x_interleaveNeon(const jack_conv_t *pConv, U8 *pOut, float * const *ppIn, U32 nFrames)
+{
+	const U32 sb = pConv->sampleBytes, frameBytes = pConv->channels * sb;
+	const U32 blockChannels = pConv->channels & ~3u;
+	const float32x4_t scale = vdupq_n_f32(pConv->scale);
+	const float32x4_t lo = vdupq_n_f32(pConv->minVal);
+	const float32x4_t hi = vdupq_n_f32(pConv->maxVal);
+	const int32x4_t shift = vdupq_n_s32(pConv->shift);
+	const uint8x16_t mask = vld1q_u8(pConv->packMask);
+	U32 f, c;
+
+	for (f = 0; f + 4 <= nFrames; f += 4) {
+		U8 *o = pOut + f * frameBytes;
+		for (c = 0; c < blockChannels; c += 4) {
+			uint32x4_t v0 = x_toWordsNeon(pConv, vld1q_f32(ppIn[c] + f), scale, lo, hi, shift);
+			uint32x4_t v1 = x_toWordsNeon(pConv, vld1q_f32(ppIn[c + 1] + f), scale, lo, hi, shift);
+			uint32x4_t v2 = x_toWordsNeon(pConv, vld1q_f32(ppIn[c + 2] + f), scale, lo, hi, shift);
+			uint32x4_t v3 = x_toWordsNeon(pConv, vld1q_f32(ppIn[c + 3] + f), scale, lo, hi, shift);
+			TRANSPOSE_NEON(v0, v1, v2, v3);
+			x_storePackedNeon(o + c * sb, v0, mask, sb);
+			x_storePackedNeon(o + frameBytes + c * sb, v1, mask, sb);
+			x_storePackedNeon(o + 2 * frameBytes + c * sb, v2, mask, sb);
+			x_storePackedNeon(o + 3 * frameBytes + c * sb, v3, mask, sb);
+		}
+	}
+	x_interleaveSamples(pConv, pOut, ppIn, 0, f, blockChannels);
+	x_interleaveSamples(pConv, pOut, ppIn, f, nFrames, 0);
+}
+
+static void x_deinterleaveNeon(const jack_conv_t *pConv, float * const *ppOut, const U8 *pIn, U32 nFrames)
+{
+	const U32 sb = pConv->sampleBytes, frameBytes = pConv->channels * sb;
+	const U32 blockChannels = pConv->channels & ~3u;
+	const float32x4_t unscale = vdupq_n_f32(1.0f / 2147483648.0f);
+	const uint8x16_t mask = vld1q_u8(pConv->unpackMask);
+	U32 f, c;
+
+	for (f = 0; f + 4 <= nFrames; f += 4) {
+		const U8 *i = pIn + f * frameBytes;
+		for (c = 0; c < blockChannels; c += 4) {
+			uint32x4_t v0 = x_loadPackedNeon(i + c * sb, mask, sb);
+			uint32x4_t v1 = x_loadPackedNeon(i + frameBytes + c * sb, mask, sb);
+			uint32x4_t v2 = x_loadPackedNeon(i + 2 * frameBytes + c * sb, mask, sb);
+			uint32x4_t v3 = x_loadPackedNeon(i + 3 * frameBytes + c * sb, mask, sb);
+			TRANSPOSE_NEON(v0, v1, v2, v3);
+			vst1q_f32(ppOut[c] + f, x_fromWordsNeon(pConv, v0, unscale));
+			vst1q_f32(ppOut[c + 1] + f, x_fromWordsNeon(pConv, v1, unscale));
+			vst1q_f32(ppOut[c + 2] + f, x_fromWordsNeon(pConv, v2, unscale));
+			vst1q_f32(ppOut[c + 3] + f, x_fromWordsNeon(pConv, v3, unscale));
+		}
+	}
+	x_deinterleaveSamples(pConv, ppOut, pIn, 0, f, blockChannels);
+	x_deinterleaveSamples(pConv, ppOut, pIn, f, nFrames, 0);
+}
+#endif
+
+bool openavbJackConvInit(jack_conv_t *pConv, U32 channels, U8 sampleBytes, bool bFloat, bool bLittleEndian)
+{
+	if (!pConv || channels == 0 || sampleBytes < 2 || sampleBytes > 4 || (bFloat && sampleBytes != 4)) {
+		return FALSE;
+	}
+
+	memset(pConv, 0, sizeof(*pConv));
+	pConv->channels = channels;
+	pConv->sampleBytes = sampleBytes;
+	pConv->bFloat = bFloat;
+
+	U8 bits = sampleBytes * 8;
+	pConv->shift = 32 - bits;
+	pConv->scale = (float)(1u << (bits - 1));
+	pConv->minVal = -pConv->scale;
+	// For 32 bits, the largest float below 2^31
+	pConv->maxVal = bits < 32 ? pConv->scale - 1.0f : 2147483520.0f;
+
+	// Byte j of a sample is significance rank r (0 = most significant),
+	// byte 3 - r of a 32 bit word in a vector register.
+	U8 i, j;
+	memset(pConv->packMask, 0x80, sizeof(pConv->packMask));
+	memset(pConv->unpackMask, 0x80, sizeof(pConv->unpackMask));
+	for (j = 0; j < sampleBytes; j++) {
+		U8 r = bLittleEndian ? sampleBytes - 1 - j : j;
+		pConv->byteShift[j] = 24 - 8 * r;
+		for (i = 0; i < 4; i++) {
+			pConv->packMask[i * sampleBytes + j] = i * 4 + 3 - r;
+			pConv->unpackMask[i * 4 + 3 - r] = i * sampleBytes + j;
+		}
+	}
+
+	pConv->interleave = x_interleaveScalar;
+	pConv->deinterleave = x_deinterleaveScalar;
+#if JACK_CONV_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("ssse3")) {
+		pConv->interleave = x_interleaveSsse3;
+		pConv->deinterleave = x_deinterleaveSsse3;
+	}
+#elif JACK_CONV_NEON
+	pConv->interleave = x_interleaveNeon;
+	pConv->deinterleave = x_deinterleaveNeon;
+#endif
+	return TRUE;
+}
+
+const char *openavbJackConvName(const jack_conv_t *pConv)
+{
+#if JACK_CONV_X86
+	if (pConv->interleave == x_interleaveSsse3) {
+		return "ssse3";
+	}
+#elif JACK_CONV_NEON
+	if (pConv->interleave == x_interleaveNeon) {
+		return "neon";
+	}
+#endif
+	return "scalar";
+}
@@ -0,0 +1,93 @@
+/*************************************************************************************************************
+Copyright (c) 2012-2015, Symphony Teleca Corporation, a Harman International Industries, Incorporated company
+Copyright (c) 2016-2017, Harman International Industries, Incorporated
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS LISTED "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS LISTED BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Attributions: The inih library portion of the source code is licensed from
+Brush Technology and Ben Hoyt - Copyright (c) 2009, Brush Technology and Copyright (c) 2009, Ben Hoyt.
+Complete license and copyright information can be found at
+https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
+*************************************************************************************************************/
+
+/*
+ * HEADER SUMMARY : JACK sample conversion
+ *
+ * Converts between JACK's float buffers, one per port, and interleaved media
+ * queue samples (16, 24 or 32 bit integers or 32 bit floats, in either byte
+ * order) a whole period at a time. Float samples are scaled to the full
+ * integer range, clipped and rounded to nearest.
+ *
+ * Blocks of 4 channels by 4 frames are converted, transposed and packed in
+ * vector registers where the CPU has a byte shuffle (SSSE3, NEON). The
+ * implementation is picked at run time when the conversion is set up.
+ */
+
+#ifndef OPENAVB_JACK_CONV_H
+#define OPENAVB_JACK_CONV_H 1
+
+#include "openavb_types_pub.h"
+
+struct jack_conv;
+typedef void (*jack_conv_interleave_fn_t)(const struct jack_conv *pConv, U8 *pOut, float * const *ppIn, U32 nFrames);
+typedef void (*jack_conv_deinterleave_fn_t)(const struct jack_conv *pConv, float * const *ppOut, const U8 *pIn, U32 nFrames);
+
+typedef struct jack_conv {
+	U32 channels;
+	U8 sampleBytes;
+	// Samples are 32 bit floats; only the byte order changes
+	bool bFloat;
+	// Float to integer scaling and clipping
+	float scale;
+	float minVal;
+	float maxVal;
+	// Integers are handled in the top bits of 32
+	U8 shift;
+	// Shift of each sample byte out of those 32 bits
+	U8 byteShift[4];
+	// Byte shuffles between 4 samples in 32 bits and 4 packed samples
+	U8 packMask[16];
+	U8 unpackMask[16];
+	// Implementation picked for this conversion and CPU
+	jack_conv_interleave_fn_t interleave;
+	jack_conv_deinterleave_fn_t deinterleave;
+} jack_conv_t;
+
+// Set up a conversion. Returns FALSE for unsupported sample formats.
+bool openavbJackConvInit(jack_conv_t *pConv, U32 channels, U8 sampleBytes, bool bFloat, bool bLittleEndian);
+
+// Interleave nFrames frames of the channel buffers ppIn into pOut
+static inline void openavbJackConvInterleave(const jack_conv_t *pConv, U8 *pOut, float * const *ppIn, U32 nFrames)
+{
+	pConv->interleave(pConv, pOut, ppIn, nFrames);
+}
+
+// Split nFrames interleaved frames from pIn into the channel buffers ppOut
+static inline void openavbJackConvDeinterleave(const jack_conv_t *pConv, float * const *ppOut, const U8 *pIn, U32 nFrames)
+{
+	pConv->deinterleave(pConv, ppOut, pIn, nFrames);
+}
+
+// Name of the implementation used by a conversion (for logging)
+const char *openavbJackConvName(const jack_conv_t *pConv);
+
+#endif  // OPENAVB_JACK_CONV_H
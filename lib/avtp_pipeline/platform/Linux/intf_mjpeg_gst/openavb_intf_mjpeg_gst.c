@@ -73,6 +73,12 @@ typedef struct pvt_data_t
 	bool asyncRx;
 	bool blockingRx;
 
+	// Async RX thread feeding appsrc from rxBufs
+	pthread_t asyncRxThread;
+	pthread_mutex_t asyncReadMutex;
+	pthread_cond_t asyncReadCond;
+	bool bAsyncRXStreaming;
+
 	bool get_avtp_timestamp;        /*<! this flag indicates whether
                                         an avtp timestamp should be taken */
 	U32 frame_timestamp;            /*<! this is a timestamp of a video frame */
@@ -268,43 +274,34 @@ bool openavbIntfMjpegGstTxCB(media_q_t *pMediaQ)
 }
 
 // Async stuff...
-static pthread_t asyncRxThread;
-static pthread_mutex_t asyncRxMutex = PTHREAD_MUTEX_INITIALIZER;
-static pthread_mutex_t asyncReadMutex = PTHREAD_MUTEX_INITIALIZER;
-static pthread_cond_t asyncReadCond = PTHREAD_COND_INITIALIZER;
-#define LOCK() pthread_mutex_lock(&asyncRxMutex)
-#define UNLOCK() pthread_mutex_unlock(&asyncRxMutex)
-static bool bAsyncRXStreaming;
-static media_q_t *pAsyncRxMediaQ;
-//static media_q_item_t *pAsyncRxMediaQItem;
-//static bool bAsyncRXDoneWithItem;
-
 static void *openavbIntfMjpegGstRxThreadfn(void *pv)
 {
+	media_q_t *pMediaQ = pv;
 	pvt_data_t *pPvtData;
 
-	if (!pAsyncRxMediaQ)
+	if (!pMediaQ)
 	{
 		AVB_LOG_ERROR("No async mediaQ");
 		return 0;
 	}
-	pPvtData = pAsyncRxMediaQ->pPvtIntfInfo;
+	pPvtData = pMediaQ->pPvtIntfInfo;
 	if (!pPvtData)
 	{
 		AVB_LOG_ERROR("No async RX private data.");
 		return 0;
 	}
 
-	bAsyncRXStreaming = TRUE;
-	while (bAsyncRXStreaming)
+	while (pPvtData->bAsyncRXStreaming)
 	{
 		U32 bufwr = pPvtData->bufwr;
 		U32 bufrd = pPvtData->bufrd;
 		if (bufwr == bufrd)
 		{
-			pthread_mutex_lock(&asyncReadMutex);
-			pthread_cond_wait(&asyncReadCond, &asyncReadMutex);
-			pthread_mutex_unlock(&asyncReadMutex);
+			// Recheck under the mutex so a signal from RxCB or EndCB can't be missed
+			pthread_mutex_lock(&pPvtData->asyncReadMutex);
+			while (pPvtData->bAsyncRXStreaming && pPvtData->bufwr == pPvtData->bufrd)
+				pthread_cond_wait(&pPvtData->asyncReadCond, &pPvtData->asyncReadMutex);
+			pthread_mutex_unlock(&pPvtData->asyncReadMutex);
 		}
 		else if(bufwr > bufrd)
 		{
@@ -378,17 +375,26 @@ void openavbIntfMjpegGstRxInitCB(media_q_t *pMediaQ)
 
 	if (pPvtData->asyncRx)
 	{
-		pAsyncRxMediaQ = pMediaQ;
-		int err = pthread_mutex_init(&asyncRxMutex, 0);
+		int err = pthread_mutex_init(&pPvtData->asyncReadMutex, 0);
 		if (err)
 			AVB_LOG_ERROR("Mutex init failed");
+		err = pthread_cond_init(&pPvtData->asyncReadCond, 0);
+		if (err)
+			AVB_LOG_ERROR("Condition init failed");
 		pthread_attr_t attr;
 		struct sched_param param;
 		pthread_attr_init(&attr);
 		pthread_attr_setschedpolicy(&attr, SCHED_OTHER);
 		param.sched_priority = 0;
 		pthread_attr_setschedparam(&attr, &param);
-		pthread_create(&asyncRxThread, &attr, openavbIntfMjpegGstRxThreadfn, NULL);
+		pPvtData->bAsyncRXStreaming = TRUE;
+		err = pthread_create(&pPvtData->asyncRxThread, &attr, openavbIntfMjpegGstRxThreadfn, pMediaQ);
+		if (err)
+		{
+			AVB_LOG_ERROR("Async RX thread create failed");
+			pPvtData->bAsyncRXStreaming = FALSE;
+		}
+		pthread_attr_destroy(&attr);
 	}
 }
 
@@ -479,10 +485,10 @@ bool openavbIntfMjpegGstRxCB(media_q_t *pMediaQ)
 		if (pPvtData->asyncRx)
 		{
 			pPvtData->rxBufs[pPvtData->bufwr%NBUFS] = rxBuf;
+			pthread_mutex_lock(&pPvtData->asyncReadMutex);
 			__sync_fetch_and_add(&pPvtData->bufwr, 1);
-			pthread_mutex_lock(&asyncReadMutex);
-			pthread_cond_signal(&asyncReadCond);
-			pthread_mutex_unlock(&asyncReadMutex);
+			pthread_cond_signal(&pPvtData->asyncReadCond);
+			pthread_mutex_unlock(&pPvtData->asyncReadMutex);
 		}
 		else
 		{
@@ -503,13 +509,23 @@ bool openavbIntfMjpegGstRxCB(media_q_t *pMediaQ)
 void openavbIntfMjpegGstEndCB(media_q_t *pMediaQ)
 {
 	AVB_TRACE_ENTRY(AVB_TRACE_INTF);
-	bAsyncRXStreaming = FALSE;
 	pvt_data_t *pPvtData = pMediaQ->pPvtIntfInfo;
 	if (!pPvtData)
 	{
 		AVB_LOG_ERROR("Private interface module data not allocated.");
 		return;
 	}
+	// Stop the async thread before the pipeline it pushes into goes away
+	if (pPvtData->asyncRx && pPvtData->bAsyncRXStreaming)
+	{
+		pthread_mutex_lock(&pPvtData->asyncReadMutex);
+		pPvtData->bAsyncRXStreaming = FALSE;
+		pthread_cond_signal(&pPvtData->asyncReadCond);
+		pthread_mutex_unlock(&pPvtData->asyncReadMutex);
+		pthread_join(pPvtData->asyncRxThread, NULL);
+		pthread_cond_destroy(&pPvtData->asyncReadCond);
+		pthread_mutex_destroy(&pPvtData->asyncReadMutex);
+	}
 	if (pPvtData->pipe)
 	{
 		gst_element_set_state(pPvtData->pipe, GST_STATE_NULL);
@@ -526,13 +542,6 @@ void openavbIntfMjpegGstEndCB(media_q_t *pMediaQ)
 		gst_object_unref(pPvtData->pipe);
 		pPvtData->pipe = NULL;
 	}
-	if (pPvtData->asyncRx)
-	{
-		pthread_mutex_lock(&asyncReadMutex);
-		pthread_cond_signal(&asyncReadCond);
-		pthread_mutex_unlock(&asyncReadMutex);
-		pthread_join(asyncRxThread, NULL);
-	}
 	AVB_TRACE_EXIT(AVB_TRACE_INTF);
 }
 
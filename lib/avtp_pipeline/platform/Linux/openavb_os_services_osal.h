@@ -177,6 +177,13 @@ thread##_type	thread##_ThreadData
 	openavbTimeTimespecAddUsec(&timeout, timeoutMSec * MICROSECONDS_PER_MSEC);	\
 	err = sem_timedwait(&sem, &timeout);									\
 }
+#define SEM_TIMEDWAIT_USEC(sem, timeoutUSec, err)							\
+{																			\
+	struct timespec semTimeout;												\
+	CLOCK_GETTIME(OPENAVB_CLOCK_REALTIME, &semTimeout);							\
+	openavbTimeTimespecAddUsec(&semTimeout, timeoutUSec);					\
+	err = sem_timedwait(&sem, &semTimeout);									\
+}
 #define SEM_POST(sem, err) err = sem_post(&sem);
 #define SEM_DESTROY(sem, err) err = sem_destroy(&sem);
 #define SEM_IS_ERR_NONE(err) (0 == err)
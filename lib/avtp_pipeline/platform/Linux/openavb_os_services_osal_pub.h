@@ -87,6 +87,12 @@ typedef struct {
 #define MUTEX_UNLOCK_ALT(mutex_handle) pthread_mutex_unlock(&mutex_handle)
 #define MUTEX_DESTROY_ALT(mutex_handle) pthread_mutex_destroy(&mutex_handle)
 
+// Thread specific data. The destructor is called with the value when the thread exits.
+#define THREAD_LOCAL __thread
+#define THREAD_KEY_HANDLE(key_handle) pthread_key_t key_handle
+#define THREAD_KEY_CREATE(key_handle, destructor) pthread_key_create(&key_handle, destructor)
+#define THREAD_KEY_SET(key_handle, value) pthread_setspecific(key_handle, value)
+
 
 //	pthread_mutexattr_t   mta;
 //	pthread_mutexattr_init(&mta);
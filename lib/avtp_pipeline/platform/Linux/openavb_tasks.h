@@ -68,9 +68,18 @@ https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
 //task TalkerThread
 #define talkerThread_THREAD_STK_SIZE						THREAD_STACK_SIZE
 
+//task talkerSchedThread. Shared talker transmit worker
+#define talkerSchedThread_THREAD_STK_SIZE					THREAD_STACK_SIZE
+
 //task ListenerThread
 #define listenerThread_THREAD_STK_SIZE 						THREAD_STACK_SIZE
 
+//task avtpRxDemuxThread. Shared AVTP RX demultiplexer
+#define avtpRxDemuxThread_THREAD_STK_SIZE					THREAD_STACK_SIZE
+
+//task avtpFlightThread. AVTP flight recorder dumps
+#define avtpFlightThread_THREAD_STK_SIZE					THREAD_STACK_SIZE
+
 //task avdeccMsgThread
 #define avdeccMsgThread_THREAD_STK_SIZE						THREAD_STACK_SIZE
 
@@ -53,6 +53,208 @@ static int gPtpShmFd = -1;
 static char *gPtpMmap = NULL;
 gPtpTimeData gPtpTD;
 
+// Shortest and longest wait of the refresh thread between looks at the gPTP data
+#define PTP_REFRESH_MIN_NSEC		(NANOSECONDS_PER_MSEC)
+#define PTP_REFRESH_MAX_NSEC		(500 * NANOSECONDS_PER_MSEC)
+// How often the refresh thread reports the accuracy of the cached conversion
+#define PTP_CHECK_REPORT_SEC		60
+// Extrapolation error that gets a warning
+#define PTP_CHECK_WARN_NSEC			1000
+// Tries before a reader gives up on the published conversion
+#define PTP_CONV_READ_RETRIES		100
+
+// Conversions from CLOCK_REALTIME and from the local (network card) clock
+// to gPTP time, built from one gPTP update and extrapolated with its
+// frequency ratios until the next one.
+typedef struct {
+	// Shared memory sequence number the conversion was built from
+	uint32_t seq;
+	// CLOCK_REALTIME of the gPTP update
+	int64_t sysBase;
+	// gPTP time of the gPTP update
+	U64 ptpBase;
+	// gPTP nanoseconds per CLOCK_REALTIME nanosecond, minus 1
+	double rateAdj;
+	// Local clock time of the gPTP update
+	U64 localBase;
+	// gPTP nanoseconds per local clock nanosecond, minus 1
+	double localRateAdj;
+} ptp_conv_t;
+
+// Without the refresh thread each thread keeps its own conversion and
+// rebuilds it when the gPTP daemon publishes a new update. Readers also fall
+// back to it when they can't get the published conversion.
+static __thread ptp_conv_t tlsPtpConv;
+
+// The refresh thread publishes the conversion for the whole process in two
+// copies. The low bit of gPtpConvSeq selects the copy readers use while the
+// other one is rewritten, so a reader that preempts the refresh thread in
+// the middle of an update doesn't have to wait for it.
+static ptp_conv_t gPtpConv[2];
+static U32 gPtpConvSeq = 0;
+static bool gbPtpRefresh = FALSE;
+static bool gbPtpRefreshRun = FALSE;
+static pthread_t gPtpRefreshThread;
+
+// Largest extrapolation error seen by the refresh thread since its last report
+static S64 gPtpCheckMaxErr = 0;
+static U32 gPtpCheckUpdates = 0;
+
+// Convert a time of the local (network card) clock to gPTP time
+static U64 x_localToPTPTime(const gPtpTimeData *td, uint64_t local) {
+	uint64_t update_8021as;
+	int64_t delta_8021as;
+	int64_t delta_local;
+
+	update_8021as = td->local_time - td->ml_phoffset;
+	delta_local = local - td->local_time;
+	delta_8021as = td->ml_freqoffset * delta_local;
+	return update_8021as + delta_8021as;
+}
+
+// Convert a CLOCK_REALTIME time to gPTP time the long way, as gptplocaltime() does
+static U64 x_sysToPTPTimeDirect(const gPtpTimeData *td, int64_t sysNsec) {
+	int64_t delta_system = sysNsec - (int64_t)(td->local_time + td->ls_phoffset);
+	int64_t delta_local = td->ls_freqoffset * delta_system;
+	return x_localToPTPTime(td, td->local_time + delta_local);
+}
+
+// Fold gptplocaltime() and x_localToPTPTime() into one linear conversion
+static void x_ptpConvUpdate(ptp_conv_t *pConv, const gPtpTimeData *td, uint32_t seq) {
+	pConv->sysBase = td->local_time + td->ls_phoffset;
+	pConv->ptpBase = td->local_time - td->ml_phoffset;
+	pConv->rateAdj = (double)(td->ml_freqoffset * td->ls_freqoffset - 1.0L);
+	pConv->localBase = td->local_time;
+	pConv->localRateAdj = (double)(td->ml_freqoffset - 1.0L);
+	pConv->seq = seq;
+}
+
+static inline U64 x_ptpConvApply(const ptp_conv_t *pConv, int64_t sysNsec) {
+	// Small rate correction applied to the delta keeps full precision in the double
+	int64_t delta = sysNsec - pConv->sysBase;
+	return pConv->ptpBase + delta + (int64_t)(delta * pConv->rateAdj);
+}
+
+// Same as x_localToPTPTime(), from the cached conversion
+static inline U64 x_ptpConvApplyLocal(const ptp_conv_t *pConv, U64 localNsec) {
+	int64_t delta = localNsec - pConv->localBase;
+	return pConv->ptpBase + delta + (int64_t)(delta * pConv->localRateAdj);
+}
+
+static inline bool x_sysTime(int64_t *sysNsec) {
+	struct timespec sysTime;
+	if (clock_gettime(CLOCK_REALTIME, &sysTime) != 0) {
+		return FALSE;
+	}
+	*sysNsec = (int64_t)sysTime.tv_sec * NANOSECONDS_PER_SECOND + sysTime.tv_nsec;
+	return TRUE;
+}
+
+static void x_ptpConvPublish(const ptp_conv_t *pConv) {
+	U32 seq = __atomic_load_n(&gPtpConvSeq, __ATOMIC_RELAXED);
+	// Readers switch to copy 1 while copy 0 is rewritten, then back
+	__atomic_store_n(&gPtpConvSeq, seq + 1, __ATOMIC_RELEASE);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	gPtpConv[0] = *pConv;
+	__atomic_store_n(&gPtpConvSeq, seq + 2, __ATOMIC_RELEASE);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	gPtpConv[1] = *pConv;
+}
+
+// Returns FALSE if the conversion kept changing while it was copied
+static inline bool x_ptpConvRead(ptp_conv_t *pConv) {
+	int i;
+	for (i = 0; i < PTP_CONV_READ_RETRIES; i++) {
+		U32 seq1 = __atomic_load_n(&gPtpConvSeq, __ATOMIC_ACQUIRE);
+		*pConv = gPtpConv[seq1 & 1];
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		U32 seq2 = __atomic_load_n(&gPtpConvSeq, __ATOMIC_RELAXED);
+		if (seq1 == seq2) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+// Wait between looks at the gPTP data: half the sync interval the gPTP daemon reports
+static U64 x_ptpRefreshNsec(const gPtpTimeData *td) {
+	U64 nsec = 125 * NANOSECONDS_PER_MSEC;
+	if (td->log_sync_interval >= -20 && td->log_sync_interval <= 4) {
+		nsec = td->log_sync_interval >= 0
+			? (U64)NANOSECONDS_PER_SECOND << td->log_sync_interval
+			: (U64)NANOSECONDS_PER_SECOND >> -td->log_sync_interval;
+	}
+	nsec /= 2;
+	if (nsec < PTP_REFRESH_MIN_NSEC)
+		nsec = PTP_REFRESH_MIN_NSEC;
+	if (nsec > PTP_REFRESH_MAX_NSEC)
+		nsec = PTP_REFRESH_MAX_NSEC;
+	return nsec;
+}
+
+// Picks up gPTP updates for the whole process, so wall time reads never
+// touch the shared memory. Also checks how far the extrapolated conversion
+// was off when each update arrives.
+static void *x_ptpRefreshThreadFn(void *pv) {
+	gPtpTimeData td = gPtpTD;
+	ptp_conv_t conv;
+	struct timespec next;
+	U64 nextReportNsec = 0;
+
+	x_ptpConvRead(&conv);
+	clock_gettime(CLOCK_MONOTONIC, &next);
+
+	while (__atomic_load_n(&gbPtpRefreshRun, __ATOMIC_RELAXED)) {
+		U64 nsec = next.tv_nsec + x_ptpRefreshNsec(&td);
+		next.tv_sec += nsec / NANOSECONDS_PER_SECOND;
+		next.tv_nsec = nsec % NANOSECONDS_PER_SECOND;
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+		// A sequence number of 0 means the gPTP daemon doesn't keep one; read the data every time then.
+		uint32_t seq = gptpsequence(gPtpMmap);
+		if (seq && seq == conv.seq) {
+			continue;
+		}
+
+		uint32_t newSeq;
+		if (gptpgetdataseq(gPtpMmap, &td, &newSeq) < 0) {
+			continue;
+		}
+
+		// Self-check: cached conversion against the direct path at the same instant
+		int64_t sysNsec;
+		if (x_sysTime(&sysNsec)) {
+			S64 err = (S64)(x_ptpConvApply(&conv, sysNsec) - x_sysToPTPTimeDirect(&td, sysNsec));
+			if (err < 0)
+				err = -err;
+			if (err > gPtpCheckMaxErr)
+				gPtpCheckMaxErr = err;
+			gPtpCheckUpdates++;
+			if (err > PTP_CHECK_WARN_NSEC) {
+				IF_LOG_INTERVAL(100) AVB_LOGF_WARNING("Wall time was %" PRId64 "ns off when the gPTP update arrived", err);
+			}
+
+			U64 nowNsec = (U64)next.tv_sec * NANOSECONDS_PER_SECOND + next.tv_nsec;
+			if (nowNsec >= nextReportNsec) {
+				if (nextReportNsec) {
+					AVB_LOGF_DEBUG("Wall time cache: %u updates, max extrapolation error %" PRId64 "ns", gPtpCheckUpdates, gPtpCheckMaxErr);
+				}
+				gPtpCheckMaxErr = 0;
+				gPtpCheckUpdates = 0;
+				nextReportNsec = nowNsec + (U64)PTP_CHECK_REPORT_SEC * NANOSECONDS_PER_SECOND;
+			}
+		}
+
+		x_ptpConvUpdate(&conv, &td, newSeq);
+		x_ptpConvPublish(&conv);
+
+		// Still used by the igb launch time conversion
+		gPtpTD = td;
+	}
+
+	return NULL;
+}
+
 static bool x_timeInit(void) {
 	AVB_TRACE_ENTRY(AVB_TRACE_TIME);
 
@@ -62,7 +264,8 @@ static bool x_timeInit(void) {
 		return FALSE;
 	}
 
-	if (gptpgetdata(gPtpMmap, &gPtpTD) < 0) {
+	uint32_t seq;
+	if (gptpgetdataseq(gPtpMmap, &gPtpTD, &seq) < 0) {
 		AVB_LOG_ERROR("GPTP data fetch failed");
 		AVB_TRACE_EXIT(AVB_TRACE_TIME);
 		return FALSE;
@@ -72,36 +275,64 @@ static bool x_timeInit(void) {
 	AVB_LOGF_INFO("ml_phoffset = %" PRId64 ", ls_phoffset = %" PRId64, gPtpTD.ml_phoffset, gPtpTD.ls_phoffset);
 	AVB_LOGF_INFO("ml_freqffset = %Lf, ls_freqoffset = %Lf", gPtpTD.ml_freqoffset, gPtpTD.ls_freqoffset);
 
+	// Refresh the conversion from one thread at the gPTP sync rate
+	ptp_conv_t conv;
+	x_ptpConvUpdate(&conv, &gPtpTD, seq);
+	x_ptpConvPublish(&conv);
+	gbPtpRefreshRun = TRUE;
+	if (pthread_create(&gPtpRefreshThread, NULL, x_ptpRefreshThreadFn, NULL) == 0) {
+		__atomic_store_n(&gbPtpRefresh, TRUE, __ATOMIC_RELEASE);
+	}
+	else {
+		AVB_LOG_WARNING("Unable to start the gPTP refresh thread, reading gPTP data per thread");
+		gbPtpRefreshRun = FALSE;
+	}
+
 	AVB_TRACE_EXIT(AVB_TRACE_TIME);
 	return TRUE;
 }
 
+// The current conversion: the refresh thread's snapshot, or this thread's own copy
+static inline bool x_ptpConvGet(ptp_conv_t *pConv) {
+	if (__atomic_load_n(&gbPtpRefresh, __ATOMIC_ACQUIRE)) {
+		if (x_ptpConvRead(pConv)) {
+			return TRUE;
+		}
+		IF_LOG_INTERVAL(1000) AVB_LOG_WARNING("Published gPTP conversion busy, using this thread's own");
+	}
+
+	// A sequence number of 0 means the gPTP daemon doesn't keep one; read the data every time then.
+	uint32_t seq = gptpsequence(gPtpMmap);
+	if (!seq || seq != tlsPtpConv.seq) {
+		gPtpTimeData td;
+		if (gptpgetdataseq(gPtpMmap, &td, &seq) < 0) {
+			AVB_LOG_ERROR("GPTP data fetch failed");
+			return FALSE;
+		}
+		x_ptpConvUpdate(&tlsPtpConv, &td, seq);
+	}
+	*pConv = tlsPtpConv;
+	return TRUE;
+}
+
 static bool x_getPTPTime(U64 *timeNsec) {
 	AVB_TRACE_ENTRY(AVB_TRACE_TIME);
 
-	if (gptpgetdata(gPtpMmap, &gPtpTD) < 0) {
-		AVB_LOG_ERROR("GPTP data fetch failed");
+	ptp_conv_t conv;
+	if (!x_ptpConvGet(&conv)) {
 		AVB_TRACE_EXIT(AVB_TRACE_TIME);
 		return FALSE;
 	}
 
-	uint64_t now_local;
-	uint64_t update_8021as;
-	int64_t delta_8021as;
-	int64_t delta_local;
-
-	if (gptplocaltime(&gPtpTD, &now_local)) {
-		update_8021as = gPtpTD.local_time - gPtpTD.ml_phoffset;
-		delta_local = now_local - gPtpTD.local_time;
-		delta_8021as = gPtpTD.ml_freqoffset * delta_local;
-		*timeNsec = update_8021as + delta_8021as;
-
+	int64_t sysNsec;
+	if (!x_sysTime(&sysNsec)) {
 		AVB_TRACE_EXIT(AVB_TRACE_TIME);
-		return TRUE;
+		return FALSE;
 	}
+	*timeNsec = x_ptpConvApply(&conv, sysNsec);
 
 	AVB_TRACE_EXIT(AVB_TRACE_TIME);
-	return FALSE;
+	return TRUE;
 }
 
 bool osalAVBTimeInit(void) {
@@ -121,12 +352,61 @@ bool osalAVBTimeInit(void) {
 bool osalAVBTimeClose(void) {
 	AVB_TRACE_ENTRY(AVB_TRACE_TIME);
 
+	LOCK();
+	if (gbPtpRefreshRun) {
+		__atomic_store_n(&gbPtpRefresh, FALSE, __ATOMIC_RELEASE);
+		__atomic_store_n(&gbPtpRefreshRun, FALSE, __ATOMIC_RELAXED);
+		pthread_join(gPtpRefreshThread, NULL);
+	}
+	UNLOCK();
+
 	gptpdeinit(&gPtpShmFd, &gPtpMmap);
 
 	AVB_TRACE_EXIT(AVB_TRACE_TIME);
 	return TRUE;
 }
 
+bool osalClockWalltimeCheck(S64 *pErrNsec) {
+	AVB_TRACE_ENTRY(AVB_TRACE_TIME);
+
+	gPtpTimeData td;
+	if (gptpgetdata(gPtpMmap, &td) < 0) {
+		AVB_TRACE_EXIT(AVB_TRACE_TIME);
+		return FALSE;
+	}
+
+	// The cached conversion in use, at the same CLOCK_REALTIME instant as the direct path
+	ptp_conv_t conv;
+	if (!__atomic_load_n(&gbPtpRefresh, __ATOMIC_ACQUIRE) || !x_ptpConvRead(&conv)) {
+		x_ptpConvUpdate(&conv, &td, 0);
+	}
+
+	int64_t sysNsec;
+	if (!x_sysTime(&sysNsec)) {
+		AVB_TRACE_EXIT(AVB_TRACE_TIME);
+		return FALSE;
+	}
+	*pErrNsec = (S64)(x_ptpConvApply(&conv, sysNsec) - x_sysToPTPTimeDirect(&td, sysNsec));
+
+	AVB_TRACE_EXIT(AVB_TRACE_TIME);
+	return TRUE;
+}
+
+bool osalClockPtpOffsets(S64 *pMasterLocalNsec, S64 *pLocalSystemNsec) {
+	AVB_TRACE_ENTRY(AVB_TRACE_TIME);
+
+	gPtpTimeData td;
+	if (gptpgetdata(gPtpMmap, &td) < 0) {
+		AVB_TRACE_EXIT(AVB_TRACE_TIME);
+		return FALSE;
+	}
+	*pMasterLocalNsec = td.ml_phoffset;
+	*pLocalSystemNsec = td.ls_phoffset;
+
+	AVB_TRACE_EXIT(AVB_TRACE_TIME);
+	return TRUE;
+}
+
 bool osalClockGettime(openavb_clockId_t openavbClockId, struct timespec *getTime) {
 	AVB_TRACE_ENTRY(AVB_TRACE_TIME);
 
@@ -195,3 +475,18 @@ bool osalClockGettime64(openavb_clockId_t openavbClockId, U64 *timeNsec) {
 	return FALSE;
 }
 
+bool osalClockLocalToWalltime(U64 localNsec, U64 *timeNsec) {
+	AVB_TRACE_ENTRY(AVB_TRACE_TIME);
+
+	// Called for every received frame; stays off the shared memory like x_getPTPTime()
+	ptp_conv_t conv;
+	if (!x_ptpConvGet(&conv)) {
+		AVB_TRACE_EXIT(AVB_TRACE_TIME);
+		return FALSE;
+	}
+
+	*timeNsec = x_ptpConvApplyLocal(&conv, localNsec);
+
+	AVB_TRACE_EXIT(AVB_TRACE_TIME);
+	return TRUE;
+}
@@ -53,6 +53,9 @@ typedef enum {
 
 #define CLOCK_GETTIME(arg1, arg2) osalClockGettime(arg1, arg2)
 #define CLOCK_GETTIME64(arg1, arg2) osalClockGettime64(arg1, arg2)
+#define CLOCK_LOCAL_TO_WALLTIME(arg1, arg2) osalClockLocalToWalltime(arg1, arg2)
+#define CLOCK_WALLTIME_CHECK(arg1) osalClockWalltimeCheck(arg1)
+#define CLOCK_PTP_OFFSETS(arg1, arg2) osalClockPtpOffsets(arg1, arg2)
 
 // Initialize the AVB Time system for client usage
 bool osalAVBTimeInit(void);
@@ -66,5 +69,18 @@ bool osalClockGettime(openavb_clockId_t openavbClockId, struct timespec *getTime
 // Gets current time as U64 nSec. Returns 0 on success otherwise -1
 bool osalClockGettime64(openavb_clockId_t openavbClockId, U64 *timeNsec);
 
+// Converts a time of the gPTP local clock (the network card clock, as in
+// hardware timestamps) to wall time. Returns FALSE on failure.
+bool osalClockLocalToWalltime(U64 localNsec, U64 *timeNsec);
+
+// Compares the wall time from the cached gPTP conversion with the one
+// computed directly from the gPTP shared memory at the same instant.
+// Returns FALSE on failure.
+bool osalClockWalltimeCheck(S64 *pErrNsec);
+
+// Gets the master to local and local to system phase offsets last
+// published by the gPTP daemon. Returns FALSE on failure.
+bool osalClockPtpOffsets(S64 *pMasterLocalNsec, S64 *pLocalSystemNsec);
+
 
 #endif // _OPENAVB_TIME_OSAL_PUB_H
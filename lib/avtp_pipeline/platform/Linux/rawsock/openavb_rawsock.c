@@ -32,6 +32,9 @@ https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
 #include "sendmmsg_rawsock.h"
 #include "simple_rawsock.h"
 #include "ring_rawsock.h"
+#if AVB_FEATURE_XDP
+#include "xdp_rawsock.h"
+#endif
 #if AVB_FEATURE_PCAP
 #include "pcap_rawsock.h"
 #if AVB_FEATURE_IGB
@@ -111,6 +114,20 @@ void *openavbRawsockOpen(const char *ifname_uri, bool rx_mode, bool tx_mode, U16
 		// call constructor
 		pvRawsock = ringRawsockOpen(rawsock, ifname, rx_mode, tx_mode, ethertype, frame_size, num_frames);
 
+	} else if (strcmp(proto, "ring3") == 0) {
+
+		AVB_LOG_INFO("Using *ring3* (TPACKET_V3) buffer implementation");
+
+		// allocate memory for rawsock object
+		ring_rawsock_t *rawsock = calloc(1, sizeof(ring_rawsock_t));
+		if (!rawsock) {
+			AVB_LOG_ERROR("Creating rawsock; malloc failed");
+			return NULL;
+		}
+
+		// call constructor
+		pvRawsock = ringRawsockOpenV3(rawsock, ifname, rx_mode, tx_mode, ethertype, frame_size, num_frames);
+
 	} else if (strcmp(proto, "simple") == 0) {
 
 		AVB_LOG_INFO("Using *simple* implementation");
@@ -137,6 +154,21 @@ void *openavbRawsockOpen(const char *ifname_uri, bool rx_mode, bool tx_mode, U16
 
 		// call constructor
 		pvRawsock = sendmmsgRawsockOpen(rawsock, ifname, rx_mode, tx_mode, ethertype, frame_size, num_frames);
+#if AVB_FEATURE_XDP
+	} else if (strcmp(proto, "xdp") == 0) {
+
+		AVB_LOG_INFO("Using *xdp* implementation");
+
+		// allocate memory for rawsock object
+		xdp_rawsock_t *rawsock = calloc(1, sizeof(xdp_rawsock_t));
+		if (!rawsock) {
+			AVB_LOG_ERROR("Creating rawsock; malloc failed");
+			return NULL;
+		}
+
+		// call constructor
+		pvRawsock = xdpRawsockOpen(rawsock, ifname, rx_mode, tx_mode, ethertype, frame_size, num_frames);
+#endif
 #if AVB_FEATURE_PCAP
 	} else if (strcmp(proto, "pcap") == 0) {
 
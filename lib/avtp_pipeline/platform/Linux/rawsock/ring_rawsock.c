@@ -32,6 +32,7 @@ https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
 #include "ring_rawsock.h"
 #include "simple_rawsock.h"
 #include <linux/if_packet.h>
+#include <linux/net_tstamp.h>
 
 #include "openavb_trace.h"
 
@@ -54,8 +55,10 @@ void* ringRawsockOpen(ring_rawsock_t *rawsock, const char *ifname, bool rx_mode,
 	rawsock->pMem = (void*)(-1);
 
 	// Use version 2 headers for the MMAP packet stuff - avoids 32/64
-	// bit problems, gives nanosecond timestamps, and allows rx of vlan id
-	int val = TPACKET_V2;
+	// bit problems, gives nanosecond timestamps, and allows rx of vlan id.
+	// Version 3 has the same header fields, but packs RX frames into
+	// blocks which are handed over as a unit.
+	int val = rawsock->bTpacketV3 ? TPACKET_V3 : TPACKET_V2;
 	if (setsockopt(rawsock->sock, SOL_PACKET, PACKET_VERSION, &val, sizeof(val)) < 0) {
 		AVB_LOGF_ERROR("Creating rawsock; get PACKET_VERSION: %s", strerror(errno));
 		ringRawsockClose(rawsock);
@@ -98,17 +101,34 @@ void* ringRawsockOpen(ring_rawsock_t *rawsock, const char *ifname, bool rx_mode,
 				   rawsock->frameCount, buffersPerBlock, rawsock->blockCount);
 
 	// Fill in the kernel structure with our calculated values
-	struct tpacket_req s_packet_req;
+	struct tpacket_req3 s_packet_req;
 	memset(&s_packet_req, 0, sizeof(s_packet_req));
 	s_packet_req.tp_block_size = rawsock->blockSize;
 	s_packet_req.tp_frame_size = rawsock->bufferSize;
 	s_packet_req.tp_block_nr = rawsock->blockCount;
 	s_packet_req.tp_frame_nr = rawsock->frameCount;
+	size_t reqSize = sizeof(struct tpacket_req);
+
+	if (rawsock->bTpacketV3) {
+		// Frames are packed into a block until it is full, or the retire
+		// timeout runs out, so that one wakeup handles all the frames
+		// received in that time.
+		s_packet_req.tp_retire_blk_tov = RING_RAWSOCK_BLOCK_RETIRE_MSEC;
+		reqSize = sizeof(struct tpacket_req3);
+
+		rawsock->blockRefs = calloc(rawsock->blockCount, sizeof(int));
+		if (!rawsock->blockRefs) {
+			AVB_LOG_ERROR("Creating rawsock; malloc failed");
+			ringRawsockClose(rawsock);
+			AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
+			return NULL;
+		}
+	}
 
 	// Ask the kernel to create the TX_RING or RX_RING
 	if (rawsock->base.txMode) {
 		if (setsockopt(rawsock->sock, SOL_PACKET, PACKET_TX_RING,
-					   (char*)&s_packet_req, sizeof(s_packet_req)) < 0) {
+					   (char*)&s_packet_req, reqSize) < 0) {
 			AVB_LOGF_ERROR("Creating rawsock; TX_RING: %s", strerror(errno));
 			ringRawsockClose(rawsock);
 			AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
@@ -118,7 +138,7 @@ void* ringRawsockOpen(ring_rawsock_t *rawsock, const char *ifname, bool rx_mode,
 	}
 	else {
 		if (setsockopt(rawsock->sock, SOL_PACKET, PACKET_RX_RING,
-					   (char*)&s_packet_req, sizeof(s_packet_req)) < 0) {
+					   (char*)&s_packet_req, reqSize) < 0) {
 			AVB_LOGF_ERROR("Creating rawsock, RX_RING: %s", strerror(errno));
 			ringRawsockClose(rawsock);
 			AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
@@ -143,14 +163,19 @@ void* ringRawsockOpen(ring_rawsock_t *rawsock, const char *ifname, bool rx_mode,
 	}
 	AVB_LOGF_DEBUG("mmap: %p", rawsock->pMem);
 
-	// Initialize the memory
-	memset(rawsock->pMem, 0, rawsock->memSize);
+	// Initialize the memory.  A TPACKET_V3 ring must be left alone, as the
+	// kernel has already set up the descriptor of the block it fills first.
+	if (!rawsock->bTpacketV3) {
+		memset(rawsock->pMem, 0, rawsock->memSize);
+	}
 
 	// Initialize the state of the ring
 	rawsock->blockIndex = 0;
 	rawsock->bufferIndex = 0;
 	rawsock->buffersOut = 0;
 	rawsock->buffersReady = 0;
+	rawsock->frameOffset = 0;
+	rawsock->bLaunchTime = FALSE;
 
 	// fill virtual functions table
 	rawsock_cb_t *cb = &rawsock->base.cb;
@@ -159,6 +184,9 @@ void* ringRawsockOpen(ring_rawsock_t *rawsock, const char *ifname, bool rx_mode,
 	cb->relTxFrame = ringRawsockRelTxFrame;
 	cb->txFrameReady = ringRawsockTxFrameReady;
 	cb->send = ringRawsockSend;
+	cb->txFrameCount = ringRawsockTxFrameCount;
+	cb->txSetLaunchTime = ringRawsockTxSetLaunchTime;
+	cb->rxSetTimestamp = ringRawsockRxSetTimestamp;
 	cb->txBufLevel = ringRawsockTxBufLevel;
 	cb->rxBufLevel = ringRawsockRxBufLevel;
 	cb->getRxFrame = ringRawsockGetRxFrame;
@@ -167,10 +195,34 @@ void* ringRawsockOpen(ring_rawsock_t *rawsock, const char *ifname, bool rx_mode,
 	cb->getTXOutOfBuffers = ringRawsockGetTXOutOfBuffers;
 	cb->getTXOutOfBuffersCyclic = ringRawsockGetTXOutOfBuffersCyclic;
 
+	if (rawsock->bTpacketV3) {
+		cb->rxBufLevel = ringRawsockRxBufLevelV3;
+		cb->getRxFrame = ringRawsockGetRxFrameV3;
+		cb->rxParseHdr = ringRawsockRxParseHdrV3;
+		cb->relRxFrame = ringRawsockRelRxFrameV3;
+	}
+
 	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
 	return rawsock;
 }
 
+// Open a rawsock for RX using a TPACKET_V3 block ring
+void* ringRawsockOpenV3(ring_rawsock_t *rawsock, const char *ifname, bool rx_mode, bool tx_mode, U16 ethertype, U32 frame_size, U32 num_frames)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK);
+
+	// The block layout only helps receiving - a TX ring keeps per-frame slots
+	if (tx_mode) {
+		AVB_LOG_INFO("TPACKET_V3 is only used for RX; using TPACKET_V2 ring");
+	}
+	rawsock->bTpacketV3 = !tx_mode;
+
+	void *pvRawsock = ringRawsockOpen(rawsock, ifname, rx_mode, tx_mode, ethertype, frame_size, num_frames);
+
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
+	return pvRawsock;
+}
+
 // Close the rawsock
 void ringRawsockClose(void *pvRawsock)
 {
@@ -183,6 +235,8 @@ void ringRawsockClose(void *pvRawsock)
 			munmap(rawsock->pMem, rawsock->memSize);
 			rawsock->pMem = (void*)(-1);
 		}
+		free(rawsock->blockRefs);
+		rawsock->blockRefs = NULL;
 	}
 
 	simpleRawsockClose(pvRawsock);
@@ -320,10 +374,66 @@ bool ringRawsockRelTxFrame(void *pvRawsock, U8 *pBuffer)
 	pHdr->tp_status = TP_STATUS_KERNEL;
 	rawsock->buffersOut -= 1;
 
+	// If it is the last frame handed out, hand it out again next time.
+	// Otherwise the kernel stops sending at the unused frame.
+	int bufferIndex = rawsock->bufferIndex, blockIndex = rawsock->blockIndex;
+	if (--bufferIndex < 0) {
+		bufferIndex = (rawsock->frameCount/rawsock->blockCount) - 1;
+		if (--blockIndex < 0) {
+			blockIndex = rawsock->blockCount - 1;
+		}
+	}
+	if ((U8*)pHdr == rawsock->pMem + (blockIndex * rawsock->blockSize) + (bufferIndex * rawsock->bufferSize)) {
+		rawsock->bufferIndex = bufferIndex;
+		rawsock->blockIndex = blockIndex;
+	}
+
 	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
 	return TRUE;
 }
 
+// Tell the kernel to send the ready frames. A non-zero txtime (CLOCK_TAI)
+// is passed as an SCM_TXTIME control message and applies to all of them.
+static int ringRawsockSendTxTime(ring_rawsock_t *rawsock, U64 txtime)
+{
+	union {
+		char buf[CMSG_SPACE(sizeof(U64))];
+		struct cmsghdr align;
+	} control;
+	struct msghdr msg;
+
+	memset(&msg, 0, sizeof(msg));
+	if (txtime) {
+		msg.msg_control = control.buf;
+		msg.msg_controllen = sizeof(control.buf);
+
+		struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+		cmsg->cmsg_level = SOL_SOCKET;
+		cmsg->cmsg_type = SCM_TXTIME;
+		cmsg->cmsg_len = CMSG_LEN(sizeof(txtime));
+		memcpy(CMSG_DATA(cmsg), &txtime, sizeof(txtime));
+	}
+
+	// Linux does something dumb to wait for frames to be sent.
+	// Without MSG_DONTWAIT, CPU usage is bad.
+	int flags = MSG_DONTWAIT;
+	int sent = sendmsg(rawsock->sock, &msg, flags);
+	if (errno == EINTR) {
+		// ignore
+	}
+	else if (sent < 0) {
+		AVB_LOGF_ERROR("Send failed: %s", strerror(errno));
+		assert(0);
+	}
+	else {
+		AVB_LOGF_VERBOSE("Sent %d bytes, %d frames", sent, rawsock->buffersReady);
+		rawsock->buffersOut -= rawsock->buffersReady;
+		rawsock->buffersReady = 0;
+	}
+
+	return sent;
+}
+
 // Release a TX frame, and mark it as ready to send
 bool ringRawsockTxFrameReady(void *pvRawsock, U8 *pBuffer, unsigned int len, U64 timeNsec)
 {
@@ -336,11 +446,10 @@ bool ringRawsockTxFrameReady(void *pvRawsock, U8 *pBuffer, unsigned int len, U64
 		return FALSE;
 	}
 
-	if (timeNsec) {
-		IF_LOG_INTERVAL(1000) AVB_LOG_WARNING("launch time is unsupported in ring_rawsock");
+	if (timeNsec && !rawsock->bLaunchTime) {
+		IF_LOG_INTERVAL(1000) AVB_LOG_WARNING("launch time is not enabled but was passed to TxFrameReady");
 	}
 
-
 	volatile struct tpacket2_hdr *pHdr = (struct tpacket2_hdr*)(pBuffer - rawsock->bufHdrSize);
 	AVB_LOGF_VERBOSE("pBuffer=%p, pHdr=%p szFrame=%d, len=%d", pBuffer, pHdr, rawsock->base.frameSize, len);
 
@@ -349,7 +458,12 @@ bool ringRawsockTxFrameReady(void *pvRawsock, U8 *pBuffer, unsigned int len, U64
 	pHdr->tp_status = TP_STATUS_SEND_REQUEST;
 	rawsock->buffersReady += 1;
 
-	if (rawsock->buffersReady >= rawsock->frameCount) {
+	if (rawsock->bLaunchTime && timeNsec) {
+		// The kernel applies one launch time per send call, so frames
+		// with a launch time go out one at a time.
+		ringRawsockSendTxTime(rawsock, simpleRawsockTxTime(timeNsec));
+	}
+	else if (rawsock->buffersReady >= rawsock->frameCount) {
 		AVB_LOG_WARNING("All buffers in ready/unsent state, calling send");
 		ringRawsockSend(pvRawsock);
 	}
@@ -369,25 +483,77 @@ int ringRawsockSend(void *pvRawsock)
 		return -1;
 	}
 
-	// Linux does something dumb to wait for frames to be sent.
-	// Without MSG_DONTWAIT, CPU usage is bad.
-	int flags = MSG_DONTWAIT;
-	int sent = send(rawsock->sock, NULL, 0, flags);
-	if (errno == EINTR) {
-		// ignore
+	int sent = ringRawsockSendTxTime(rawsock, 0);
+
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+	return sent;
+}
+
+// Attach a launch time (SCM_TXTIME) to each frame sent
+bool ringRawsockTxSetLaunchTime(void *pvRawsock, bool enable)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK_DETAIL);
+	ring_rawsock_t *rawsock = (ring_rawsock_t*)pvRawsock;
+
+	if (!VALID_TX_RAWSOCK(rawsock)) {
+		AVB_LOG_ERROR("Setting TX launch time; invalid argument passed");
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+		return FALSE;
 	}
-	else if (sent < 0) {
-		AVB_LOGF_ERROR("Send failed: %s", strerror(errno));
-		assert(0);
+
+	if (enable && !rawsock->bLaunchTime && !simpleRawsockTxTimeEnable(rawsock->sock)) {
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+		return FALSE;
 	}
-	else {
-		AVB_LOGF_VERBOSE("Sent %d bytes, %d frames", sent, rawsock->buffersReady);
-		rawsock->buffersOut -= rawsock->buffersReady;
-		rawsock->buffersReady = 0;
+	rawsock->bLaunchTime = enable;
+
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+	return TRUE;
+}
+
+// Timestamp received frames. The kernel always timestamps frames in the
+// ring; this asks for the network card timestamp where there is one.
+bool ringRawsockRxSetTimestamp(void *pvRawsock, bool enable)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK);
+	ring_rawsock_t *rawsock = (ring_rawsock_t*)pvRawsock;
+
+	if (!VALID_RX_RAWSOCK(rawsock)) {
+		AVB_LOG_ERROR("Setting RX timestamps; invalid arguments");
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
+		return FALSE;
+	}
+
+	int val = enable ? SOF_TIMESTAMPING_RAW_HARDWARE : 0;
+	if (setsockopt(rawsock->sock, SOL_PACKET, PACKET_TIMESTAMP, &val, sizeof(val)) < 0) {
+		AVB_LOGF_ERROR("Setting RX timestamps; setsockopt(PACKET_TIMESTAMP) failed: %s", strerror(errno));
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
+		return FALSE;
+	}
+	if (enable) {
+		// Have the stack timestamp frames on arrival rather than when
+		// they are copied into the ring
+		simpleRawsockRxTimestampEnable(rawsock->sock);
+	}
+
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
+	return TRUE;
+}
+
+// Number of TX frames that can be held at once
+int ringRawsockTxFrameCount(void *pvRawsock)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK_DETAIL);
+	ring_rawsock_t *rawsock = (ring_rawsock_t*)pvRawsock;
+
+	if (!VALID_TX_RAWSOCK(rawsock)) {
+		AVB_LOG_ERROR("getting TX frame count; invalid arguments");
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+		return 0;
 	}
 
 	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
-	return sent;
+	return rawsock->frameCount;
 }
 
 // Count used TX buffers in ring
@@ -645,6 +811,7 @@ int ringRawsockRxParseHdr(void *pvRawsock, U8 *pBuffer, hdr_info_t *pInfo)
 	pInfo->ethertype = ntohs(pNoTag->ethertype);
 	pInfo->ts.tv_sec = pHdr->tp_sec;
 	pInfo->ts.tv_nsec = pHdr->tp_nsec;
+	pInfo->ts_hw = (pHdr->tp_status & TP_STATUS_TS_RAW_HARDWARE) ? TRUE : FALSE;
 
 	if (pInfo->ethertype == ETHERTYPE_8021Q) {
 		pInfo->vlan = TRUE;
@@ -680,6 +847,277 @@ bool ringRawsockRelRxFrame(void *pvRawsock, U8 *pBuffer)
 	return TRUE;
 }
 
+// Drop a reference on a TPACKET_V3 block, and give it back to the
+// kernel once the client holds none of its frames
+static void ringRawsockBlockPut(ring_rawsock_t *rawsock, int iBlock)
+{
+	if (--(rawsock->blockRefs[iBlock]) == 0) {
+		volatile struct tpacket_block_desc *pBlock =
+			(struct tpacket_block_desc*)(rawsock->pMem + (iBlock * rawsock->blockSize));
+		pBlock->hdr.bh1.block_status = TP_STATUS_KERNEL;
+	}
+}
+
+// Count used RX buffers in a TPACKET_V3 ring
+int ringRawsockRxBufLevelV3(void *pvRawsock)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK_DETAIL);
+	ring_rawsock_t *rawsock = (ring_rawsock_t*)pvRawsock;
+
+	int iBlock, nInUse = 0;
+	volatile struct tpacket_block_desc *pBlock;
+
+	if (!VALID_RX_RAWSOCK(rawsock)) {
+		AVB_LOG_ERROR("getting buffer level; invalid arguments");
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+		return FALSE;
+	}
+
+	for (iBlock = 0; iBlock < rawsock->blockCount; iBlock++) {
+		pBlock = (struct tpacket_block_desc*)(rawsock->pMem + (iBlock * rawsock->blockSize));
+		if (pBlock->hdr.bh1.block_status & TP_STATUS_USER)
+			nInUse += pBlock->hdr.bh1.num_pkts;
+	}
+
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+	return nInUse;
+}
+
+// Get a RX frame from a TPACKET_V3 ring
+//
+// The kernel hands over a whole block at a time.  The frames in it are
+// walked one per call, and we only wait for the kernel once the block
+// is used up.  The block goes back to the kernel when the walk is done
+// and the client has released all of its frames.
+U8* ringRawsockGetRxFrameV3(void *pvRawsock, U32 timeout, unsigned int *offset, unsigned int *len)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK_DETAIL);
+	ring_rawsock_t *rawsock = (ring_rawsock_t*)pvRawsock;
+	if (!VALID_RX_RAWSOCK(rawsock)) {
+		AVB_LOG_ERROR("Getting RX frame; invalid arguments");
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+		return NULL;
+	}
+	if (rawsock->buffersOut >= rawsock->frameCount) {
+		AVB_LOG_ERROR("Too many RX buffers in use");
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+		return NULL;
+	}
+
+	// Get pointer to active block in ring
+	volatile struct tpacket_block_desc *pBlock =
+		(struct tpacket_block_desc*)(rawsock->pMem + (rawsock->blockIndex * rawsock->blockSize));
+
+	// Starting on a new block?
+	if (rawsock->frameOffset == 0) {
+
+		// Check if block ready for user
+		if ((pBlock->hdr.bh1.block_status & TP_STATUS_USER) == 0)
+		{
+			struct timespec ts, *pts = NULL;
+			struct pollfd pfd;
+
+			// Use poll to wait for "ready to read" condition
+			if (timeout != OPENAVB_RAWSOCK_BLOCK) {
+				ts.tv_sec = timeout / MICROSECONDS_PER_SECOND;
+				ts.tv_nsec = (timeout % MICROSECONDS_PER_SECOND) * NANOSECONDS_PER_USEC;
+				pts = &ts;
+			}
+
+			pfd.fd = rawsock->sock;
+			pfd.events = POLLIN;
+			pfd.revents = 0;
+
+			int ret = ppoll(&pfd, 1, pts, NULL);
+			if (ret < 0) {
+				if (errno != EINTR) {
+					AVB_LOGF_ERROR("Getting RX frame; poll failed: %s", strerror(errno));
+				}
+				AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+				return NULL;
+			}
+			if ((pfd.revents & POLLIN) == 0) {
+				// timeout
+				AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+				return NULL;
+			}
+
+			if ((pBlock->hdr.bh1.block_status & TP_STATUS_USER) == 0) {
+				// Same as for the TPACKET_V2 ring - if we don't hold any
+				// frames, look for the block the kernel did fill.
+				if (rawsock->buffersOut == 0) {
+					int nSkipped = 0;
+					while ((pBlock->hdr.bh1.block_status & TP_STATUS_USER) == 0) {
+						if (++(rawsock->blockIndex) >= rawsock->blockCount) {
+							rawsock->blockIndex = 0;
+						}
+						pBlock = (struct tpacket_block_desc*)(rawsock->pMem + (rawsock->blockIndex * rawsock->blockSize));
+
+						if (++nSkipped > rawsock->blockCount) {
+							AVB_LOG_WARNING("Getting RX frame; no block after poll");
+							AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+							return NULL;
+						}
+					}
+					AVB_LOGF_WARNING("Getting RX frame; skipped %d empty blocks (rawsock=%p)", nSkipped, rawsock);
+				}
+				else {
+					AVB_LOG_WARNING("Getting RX frame; no block after poll");
+					AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+					return NULL;
+				}
+			}
+		}
+
+		AVB_LOGF_VERBOSE("block=%d, status=0x%4.4lx, frames=%u", rawsock->blockIndex,
+						 (unsigned long)pBlock->hdr.bh1.block_status, pBlock->hdr.bh1.num_pkts);
+
+		// Check the "losing" flag.  That indicates that the ring is full,
+		// and the kernel had to toss some frames. There is no "winning" flag.
+		if ((pBlock->hdr.bh1.block_status & TP_STATUS_LOSING)) {
+			if (!rawsock->bLosing) {
+				AVB_LOG_WARNING("Getting RX frame; mmap buffers full");
+				rawsock->bLosing = TRUE;
+			}
+		}
+		else {
+			rawsock->bLosing = FALSE;
+		}
+
+		// Hold the block while we walk through it
+		rawsock->blockRefs[rawsock->blockIndex] += 1;
+		rawsock->bufferIndex = 0;
+		rawsock->frameOffset = pBlock->hdr.bh1.offset_to_first_pkt;
+
+		if (pBlock->hdr.bh1.num_pkts == 0) {
+			ringRawsockBlockPut(rawsock, rawsock->blockIndex);
+			rawsock->frameOffset = 0;
+			if (++(rawsock->blockIndex) >= rawsock->blockCount) {
+				rawsock->blockIndex = 0;
+			}
+			AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+			return NULL;
+		}
+	}
+
+	// Get pointer to the next frame in the block
+	volatile struct tpacket3_hdr *pHdr = (struct tpacket3_hdr*)((U8*)pBlock + rawsock->frameOffset);
+	volatile U8 *pBuffer = (U8*)pHdr + rawsock->bufHdrSize;
+
+	AVB_LOGF_VERBOSE("block=%d, buffer=%d, out=%d, pBuffer=%p, pHdr=%p",
+					 rawsock->blockIndex, rawsock->bufferIndex, rawsock->buffersOut,
+					 pBuffer, pHdr);
+
+	if (pHdr->tp_status & TP_STATUS_COPY) {
+		AVB_LOG_WARNING("Frame too big for receive buffer");
+	}
+
+	// Remember that the client has another buffer
+	rawsock->blockRefs[rawsock->blockIndex] += 1;
+	rawsock->buffersOut += 1;
+
+	// Step to the next frame, or finish with this block
+	if (++(rawsock->bufferIndex) >= pBlock->hdr.bh1.num_pkts) {
+		ringRawsockBlockPut(rawsock, rawsock->blockIndex);
+		rawsock->bufferIndex = 0;
+		rawsock->frameOffset = 0;
+		if (++(rawsock->blockIndex) >= rawsock->blockCount) {
+			rawsock->blockIndex = 0;
+		}
+	}
+	else {
+		rawsock->frameOffset += pHdr->tp_next_offset;
+	}
+
+	if (pHdr->tp_snaplen < pHdr->tp_len) {
+#if (AVB_LOG_LEVEL >= AVB_LOG_LEVEL_VERBOSE)
+		AVB_LOGF_WARNING("Getting RX frame; partial frame ignored (len %d, snaplen %d)", pHdr->tp_len, pHdr->tp_snaplen);
+		AVB_LOG_BUFFER(AVB_LOG_LEVEL_VERBOSE, (const U8 *) pBuffer + (pHdr->tp_mac - rawsock->bufHdrSize), pHdr->tp_len, 16);
+#else
+		IF_LOG_INTERVAL(1000) AVB_LOGF_WARNING("Getting RX frame; partial frame ignored (len %d, snaplen %d)", pHdr->tp_len, pHdr->tp_snaplen);
+#endif
+		ringRawsockRelRxFrameV3(rawsock, (U8*)pBuffer);
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+		return NULL;
+	}
+
+	// Return pointer to the buffer and length
+	*offset = pHdr->tp_mac - rawsock->bufHdrSize;
+	*len = pHdr->tp_snaplen;
+	AVB_LOGF_VERBOSE("Good RX frame (len %d, snaplen %d)", pHdr->tp_len, pHdr->tp_snaplen);
+
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+	return (U8*)pBuffer;
+}
+
+// Parse the ethernet frame header of a frame from a TPACKET_V3 ring.
+// Returns length of header, or -1 for failure
+int ringRawsockRxParseHdrV3(void *pvRawsock, U8 *pBuffer, hdr_info_t *pInfo)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK_DETAIL);
+	ring_rawsock_t *rawsock = (ring_rawsock_t*)pvRawsock;
+	int hdrLen;
+	if (!VALID_RX_RAWSOCK(rawsock)) {
+		AVB_LOG_ERROR("Parsing Ethernet headers; invalid arguments");
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+		return -1;
+	}
+
+	volatile struct tpacket3_hdr *pHdr = (struct tpacket3_hdr*)(pBuffer - rawsock->bufHdrSize);
+	AVB_LOGF_VERBOSE("ringRawsockRxParseHdrV3: pBuffer=%p, pHdr=%p", pBuffer, pHdr);
+
+	memset(pInfo, 0, sizeof(hdr_info_t));
+
+	eth_hdr_t *pNoTag = (eth_hdr_t*)((U8*)pHdr + pHdr->tp_mac);
+	hdrLen = pHdr->tp_net - pHdr->tp_mac;
+	pInfo->shost = pNoTag->shost;
+	pInfo->dhost = pNoTag->dhost;
+	pInfo->ethertype = ntohs(pNoTag->ethertype);
+	pInfo->ts.tv_sec = pHdr->tp_sec;
+	pInfo->ts.tv_nsec = pHdr->tp_nsec;
+	pInfo->ts_hw = (pHdr->tp_status & TP_STATUS_TS_RAW_HARDWARE) ? TRUE : FALSE;
+
+	if (pInfo->ethertype == ETHERTYPE_8021Q) {
+		pInfo->vlan = TRUE;
+		pInfo->vlan_vid = pHdr->hv1.tp_vlan_tci & 0x0FFF;
+		pInfo->vlan_pcp = (pHdr->hv1.tp_vlan_tci >> 13) & 0x0007;
+		pInfo->ethertype = ntohs(*(U16*)( ((U8*)(&pNoTag->ethertype)) + 4));
+		hdrLen += 4;
+	}
+
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+	return hdrLen;
+}
+
+// Release a RX frame from a TPACKET_V3 ring held by the client
+bool ringRawsockRelRxFrameV3(void *pvRawsock, U8 *pBuffer)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK_DETAIL);
+	ring_rawsock_t *rawsock = (ring_rawsock_t*)pvRawsock;
+
+	if (!VALID_RX_RAWSOCK(rawsock) || pBuffer == NULL) {
+		AVB_LOG_ERROR("Releasing RX frame; invalid arguments");
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+		return FALSE;
+	}
+
+	// Frames can't be given back one by one, so find the block holding it
+	int iBlock = (pBuffer - rawsock->bufHdrSize - rawsock->pMem) / rawsock->blockSize;
+	AVB_LOGF_VERBOSE("ringRawsockRelRxFrameV3: pBuffer=%p, block=%d", pBuffer, iBlock);
+
+	if (iBlock < 0 || iBlock >= rawsock->blockCount || rawsock->blockRefs[iBlock] <= 0) {
+		AVB_LOG_ERROR("Releasing RX frame; buffer not held");
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+		return FALSE;
+	}
+
+	ringRawsockBlockPut(rawsock, iBlock);
+	rawsock->buffersOut -= 1;
+
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+	return TRUE;
+}
+
 unsigned long ringRawsockGetTXOutOfBuffers(void *pvRawsock)
 {
 	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK);
@@ -34,6 +34,10 @@ https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
 
 #include "rawsock_impl.h"
 
+// Timeout after which the kernel hands a partially filled TPACKET_V3
+// block to the listener, in milliseconds
+#define RING_RAWSOCK_BLOCK_RETIRE_MSEC 1
+
 // State information for raw socket
 //
 typedef struct {
@@ -67,6 +71,18 @@ typedef struct {
 	// Buffers marked ready, but not yet sent
 	int buffersReady;
 
+	// Use a TPACKET_V3 RX ring - the kernel packs frames into blocks and
+	// hands over a whole block at a time (RX only)
+	bool bTpacketV3;
+	// TPACKET_V3: offset of the next frame within the active block
+	U32 frameOffset;
+	// TPACKET_V3: references held on each block - one per frame held by
+	// the client, plus one while the block is being walked
+	int *blockRefs;
+
+	// Send each frame at its launch time (SO_TXTIME)
+	bool bLaunchTime;
+
 	// Are we losing RX packets?
 	bool bLosing;
 
@@ -79,6 +95,9 @@ typedef struct {
 // Open a rawsock for TX or RX
 void* ringRawsockOpen(ring_rawsock_t *rawsock, const char *ifname, bool rx_mode, bool tx_mode, U16 ethertype, U32 frame_size, U32 num_frames);
 
+// Open a rawsock for RX using a TPACKET_V3 block ring
+void* ringRawsockOpenV3(ring_rawsock_t *rawsock, const char *ifname, bool rx_mode, bool tx_mode, U16 ethertype, U32 frame_size, U32 num_frames);
+
 // Close the rawsock
 void ringRawsockClose(void *pvRawsock);
 
@@ -91,9 +110,18 @@ bool ringRawsockRelTxFrame(void *pvRawsock, U8 *pBuffer);
 // Release a TX frame, and mark it as ready to send
 bool ringRawsockTxFrameReady(void *pvRawsock, U8 *pBuffer, unsigned int len, U64 timeNsec);
 
+// Attach a launch time (SCM_TXTIME) to each frame sent
+bool ringRawsockTxSetLaunchTime(void *pvRawsock, bool enable);
+
+// Timestamp received frames (hardware timestamps where available)
+bool ringRawsockRxSetTimestamp(void *pvRawsock, bool enable);
+
 // Send all packets that are ready (i.e. tell kernel to send them)
 int ringRawsockSend(void *pvRawsock);
 
+// Number of TX frames that can be held at once
+int ringRawsockTxFrameCount(void *pvRawsock);
+
 // Count used TX buffers in ring
 int ringRawsockTxBufLevel(void *pvRawsock);
 
@@ -109,6 +137,18 @@ int ringRawsockRxParseHdr(void *pvRawsock, U8 *pBuffer, hdr_info_t *pInfo);
 // Release a RX frame held by the client
 bool ringRawsockRelRxFrame(void *pvRawsock, U8 *pBuffer);
 
+// Count used RX buffers in a TPACKET_V3 ring
+int ringRawsockRxBufLevelV3(void *pvRawsock);
+
+// Get a RX frame from a TPACKET_V3 ring
+U8* ringRawsockGetRxFrameV3(void *pvRawsock, U32 timeout, unsigned int *offset, unsigned int *len);
+
+// Parse the ethernet frame header of a frame from a TPACKET_V3 ring
+int ringRawsockRxParseHdrV3(void *pvRawsock, U8 *pBuffer, hdr_info_t *pInfo);
+
+// Release a RX frame from a TPACKET_V3 ring held by the client
+bool ringRawsockRelRxFrameV3(void *pvRawsock, U8 *pBuffer);
+
 unsigned long ringRawsockGetTXOutOfBuffers(void *pvRawsock);
 
 unsigned long ringRawsockGetTXOutOfBuffersCyclic(void *pvRawsock);
@@ -34,6 +34,7 @@ https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
 #include "simple_rawsock.h"
 #include <sys/socket.h>
 #include <sys/ioctl.h>
+#include <poll.h>
 #include <linux/if_packet.h>
 #include <linux/filter.h>
 
@@ -45,49 +46,43 @@ https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
 #include "openavb_log.h"
 
 
-#if USE_LAUNCHTIME
-
-#ifndef SCM_TIMEDLAUNCH
-#define SCM_TIMEDLAUNCH 0x04
-#endif
-
-#endif /* if USE_LAUNCHTIME */
-
-
+// Fill in a message header; a non-zero txtime is attached as an SCM_TXTIME
+// control message. A payload, if any, is gathered by
+// the kernel from the second iovec so it is never copied here.
 static void fillmsghdr(struct msghdr *msg, struct iovec *iov,
-#if USE_LAUNCHTIME
-					   unsigned char *cmsgbuf, uint64_t time,
-#endif
-					   void *pktdata, size_t pktlen)
+					   unsigned char *cmsgbuf, uint64_t txtime,
+					   void *pktdata, size_t pktlen,
+					   const void *payload, size_t payloadlen)
 {
 	msg->msg_name = NULL;
 	msg->msg_namelen = 0;
 
-	iov->iov_base = pktdata;
-	iov->iov_len = pktlen;
+	iov[0].iov_base = pktdata;
+	iov[0].iov_len = pktlen;
 	msg->msg_iov = iov;
 	msg->msg_iovlen = 1;
+	if (payloadlen) {
+		iov[1].iov_base = (void *)payload;
+		iov[1].iov_len = payloadlen;
+		msg->msg_iovlen = 2;
+	}
 
-#if USE_LAUNCHTIME
-	{
+	if (txtime) {
 		struct cmsghdr *cmsg;
-		uint64_t *tsptr;
 
 		msg->msg_control = cmsgbuf;
-		msg->msg_controllen = CMSG_LEN(sizeof time);
+		msg->msg_controllen = CMSG_SPACE(sizeof(txtime));
 
 		cmsg = CMSG_FIRSTHDR(msg);
 		cmsg->cmsg_level = SOL_SOCKET;
-		cmsg->cmsg_type = SCM_TIMEDLAUNCH;
-		cmsg->cmsg_len = CMSG_LEN(sizeof time);
-
-		tsptr = (uint64_t *)CMSG_DATA(cmsg);
-		*tsptr = time;
+		cmsg->cmsg_type = SCM_TXTIME;
+		cmsg->cmsg_len = CMSG_LEN(sizeof(txtime));
+		memcpy(CMSG_DATA(cmsg), &txtime, sizeof(txtime));
+	}
+	else {
+		msg->msg_control = NULL;
+		msg->msg_controllen = 0;
 	}
-#else
-	msg->msg_control = NULL;
-	msg->msg_controllen = 0;
-#endif
 
 	msg->msg_flags = 0;
 }
@@ -168,23 +163,51 @@ void* sendmmsgRawsockOpen(sendmmsg_rawsock_t* rawsock, const char *ifname, bool
 	memset(rawsock->mmsg, 0, sizeof(rawsock->mmsg));
 	memset(rawsock->miov, 0, sizeof(rawsock->miov));
 	memset(rawsock->pktbuf, 0, sizeof(rawsock->pktbuf));
-#if USE_LAUNCHTIME
 	memset(rawsock->cmsgbuf, 0, sizeof(rawsock->cmsgbuf));
-#endif
+	rawsock->bLaunchTime = FALSE;
 
 	rawsock->buffersOut = 0;
 	rawsock->buffersReady = 0;
 	rawsock->frameCount = MSG_COUNT;
 
+	// The number of buffers requested by the client sets the RX batch depth
+	rawsock->rxFrameCount = num_frames;
+	if (rawsock->rxFrameCount > RX_MSG_COUNT)
+		rawsock->rxFrameCount = RX_MSG_COUNT;
+	if (rawsock->rxFrameCount < 1)
+		rawsock->rxFrameCount = 1;
+	rawsock->rxFramesFilled = 0;
+	rawsock->rxFrameNext = 0;
+	rawsock->rxBuffersOut = 0;
+	rawsock->bRxTimestamp = FALSE;
+
+	// The RX messages always point at the same buffers
+	memset(rawsock->rxMmsg, 0, sizeof(rawsock->rxMmsg));
+	int i;
+	for (i = 0; i < rawsock->rxFrameCount; i++) {
+		rawsock->rxMiov[i].iov_base = rawsock->rxPktbuf[i];
+		rawsock->rxMiov[i].iov_len = rawsock->base.frameSize;
+		rawsock->rxMmsg[i].msg_hdr.msg_iov = &rawsock->rxMiov[i];
+		rawsock->rxMmsg[i].msg_hdr.msg_iovlen = 1;
+	}
+
 	// fill virtual functions table
 	rawsock_cb_t *cb = &rawsock->base.cb;
 	cb->close = sendmmsgRawsockClose;
 	cb->getTxFrame = sendmmsgRawsockGetTxFrame;
+	cb->relTxFrame = sendmmsgRawsockRelTxFrame;
 	cb->txSetMark = sendmmsgRawsockTxSetMark;
+	cb->txSetLaunchTime = sendmmsgRawsockTxSetLaunchTime;
 	cb->txSetHdr = sendmmsgRawsockTxSetHdr;
 	cb->txFrameReady = sendmmsgRawsockTxFrameReady;
+	cb->txFrameReadyRef = sendmmsgRawsockTxFrameReadyRef;
 	cb->send = sendmmsgRawsockSend;
+	cb->txFrameCount = sendmmsgRawsockTxFrameCount;
 	cb->getRxFrame = sendmmsgRawsockGetRxFrame;
+	cb->relRxFrame = sendmmsgRawsockRelRxFrame;
+	cb->rxBufLevel = sendmmsgRawsockRxBufLevel;
+	cb->rxParseHdr = sendmmsgRawsockRxParseHdr;
+	cb->rxSetTimestamp = sendmmsgRawsockRxSetTimestamp;
 	cb->rxMulticast = sendmmsgRawsockRxMulticast;
 	cb->getSocket = sendmmsgRawsockGetSocket;
 
@@ -238,6 +261,26 @@ U8* sendmmsgRawsockGetTxFrame(void *pvRawsock, bool blocking, unsigned int *len)
 	return  pBuffer;
 }
 
+// Release a TX frame without sending it. Only the last frame handed
+// out can be released, as the frames are sent in order.
+bool sendmmsgRawsockRelTxFrame(void *pvRawsock, U8 *pBuffer)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK_DETAIL);
+	sendmmsg_rawsock_t *rawsock = (sendmmsg_rawsock_t*)pvRawsock;
+
+	if (!VALID_TX_RAWSOCK(rawsock) || rawsock->buffersOut <= rawsock->buffersReady
+		|| pBuffer != rawsock->pktbuf[rawsock->buffersOut - 1]) {
+		AVB_LOG_ERROR("Releasing TX frame; invalid argument");
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+		return FALSE;
+	}
+
+	rawsock->buffersOut -= 1;
+
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+	return TRUE;
+}
+
 // Set the Firewall MARK on the socket
 // The mark is used by FQTSS to identify AVTP packets in kernel.
 // FQTSS creates a mark that includes the AVB class and stream index.
@@ -265,6 +308,28 @@ bool sendmmsgRawsockTxSetMark(void *pvRawsock, int mark)
 	return retval;
 }
 
+// Attach a launch time (SCM_TXTIME) to each frame sent
+bool sendmmsgRawsockTxSetLaunchTime(void *pvRawsock, bool enable)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK_DETAIL);
+	sendmmsg_rawsock_t *rawsock = (sendmmsg_rawsock_t*)pvRawsock;
+
+	if (!VALID_TX_RAWSOCK(rawsock)) {
+		AVB_LOG_ERROR("Setting TX launch time; invalid argument passed");
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+		return FALSE;
+	}
+
+	if (enable && !rawsock->bLaunchTime && !simpleRawsockTxTimeEnable(rawsock->sock)) {
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+		return FALSE;
+	}
+	rawsock->bLaunchTime = enable;
+
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+	return TRUE;
+}
+
 // Pre-set the ethernet header information that will be used on TX frames
 bool sendmmsgRawsockTxSetHdr(void *pvRawsock, hdr_info_t *pHdr)
 {
@@ -287,12 +352,43 @@ bool sendmmsgRawsockTxSetHdr(void *pvRawsock, hdr_info_t *pHdr)
 	return ret;
 }
 
+// Queue the next TX message, with an optional payload by reference
+static bool sendmmsgRawsockQueueTx(sendmmsg_rawsock_t *rawsock, U8 *pBuffer, unsigned int len, const U8 *pPayload, unsigned int payloadLen, U64 timeNsec)
+{
+	int bufidx = rawsock->buffersReady;
+	assert(pBuffer == rawsock->pktbuf[bufidx]);
+
+	// The launch time is converted to CLOCK_TAI when the frames are sent
+	U64 txtime = 0;
+	if (rawsock->bLaunchTime) {
+		if (timeNsec) {
+			txtime = timeNsec;
+		}
+		else {
+			IF_LOG_INTERVAL(1000) AVB_LOG_WARNING("launch time is enabled but not passed to TxFrameReady");
+		}
+	}
+	else if (timeNsec) {
+		IF_LOG_INTERVAL(1000) AVB_LOG_WARNING("launch time is not enabled but was passed to TxFrameReady");
+	}
+	fillmsghdr(&(rawsock->mmsg[bufidx].msg_hdr), rawsock->miov[bufidx], rawsock->cmsgbuf[bufidx],
+			   txtime, rawsock->pktbuf[bufidx], len, pPayload, payloadLen);
+	rawsock->txLaunchNsec[bufidx] = txtime;
+
+	rawsock->buffersReady += 1;
+
+	if (rawsock->buffersReady >= rawsock->frameCount) {
+		AVB_LOG_DEBUG("All TxFrame slots marked ready");
+		//sendmmsgRawsockSend(rawsock);
+	}
+	return TRUE;
+}
+
 // Release a TX frame, mark it ready to send
 bool sendmmsgRawsockTxFrameReady(void *pvRawsock, U8 *pBuffer, unsigned int len, U64 timeNsec)
 {
 	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK_DETAIL);
 	sendmmsg_rawsock_t *rawsock = (sendmmsg_rawsock_t*)pvRawsock;
-	int bufidx;
 
 	if (!VALID_TX_RAWSOCK(rawsock)) {
 		AVB_LOG_ERROR("Marking TX frame ready; invalid argument");
@@ -300,32 +396,49 @@ bool sendmmsgRawsockTxFrameReady(void *pvRawsock, U8 *pBuffer, unsigned int len,
 		return FALSE;
 	}
 
-	bufidx = rawsock->buffersReady;
-	assert(pBuffer == rawsock->pktbuf[bufidx]);
+	bool ret = sendmmsgRawsockQueueTx(rawsock, pBuffer, len, NULL, 0, timeNsec);
 
-#if USE_LAUNCHTIME
-	if (!timeNsec) {
-		IF_LOG_INTERVAL(1000) AVB_LOG_WARNING("launch time is enabled but not passed to TxFrameReady");
-	}
-	fillmsghdr(&(rawsock->mmsg[bufidx].msg_hdr), &(rawsock->miov[bufidx]), rawsock->cmsgbuf[bufidx],
-			   timeNsec, rawsock->pktbuf[bufidx], len);
-#else
-	if (timeNsec) {
-		IF_LOG_INTERVAL(1000) AVB_LOG_WARNING("launch time is not enabled but was passed to TxFrameReady");
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+	return ret;
+}
+
+// Release a TX frame holding only the header, mark it ready to send.
+// The payload is referenced until the next sendmmsgRawsockSend().
+bool sendmmsgRawsockTxFrameReadyRef(void *pvRawsock, U8 *pBuffer, unsigned int hdrLen, const U8 *pPayload, unsigned int payloadLen, U64 timeNsec)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK_DETAIL);
+	sendmmsg_rawsock_t *rawsock = (sendmmsg_rawsock_t*)pvRawsock;
+
+	if (!VALID_TX_RAWSOCK(rawsock) || (payloadLen && !pPayload)) {
+		AVB_LOG_ERROR("Marking TX frame ready; invalid argument");
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+		return FALSE;
 	}
-	fillmsghdr(&(rawsock->mmsg[bufidx].msg_hdr), &(rawsock->miov[bufidx]), rawsock->pktbuf[bufidx], len);
-#endif
 
+	bool ret = sendmmsgRawsockQueueTx(rawsock, pBuffer, hdrLen, pPayload, payloadLen, timeNsec);
 
-	rawsock->buffersReady += 1;
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+	return ret;
+}
 
-	if (rawsock->buffersReady >= rawsock->frameCount) {
-		AVB_LOG_DEBUG("All TxFrame slots marked ready");
-		//sendmmsgRawsockSend(rawsock);
+// Convert the launch times of the ready messages from gPTP to CLOCK_TAI,
+// with one sample of the offset between the clocks for the whole batch
+static void sendmmsgRawsockTxTimes(sendmmsg_rawsock_t *rawsock)
+{
+	S64 offsetNsec;
+	if (!simpleRawsockTaiOffset(&offsetNsec)) {
+		offsetNsec = 0;
+		IF_LOG_INTERVAL(1000) AVB_LOG_ERROR("Converting launch times; clock read failed");
 	}
 
-	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
-	return TRUE;
+	int i;
+	for (i = 0; i < rawsock->buffersReady; i++) {
+		if (rawsock->txLaunchNsec[i]) {
+			U64 txtime = rawsock->txLaunchNsec[i] + offsetNsec;
+			struct cmsghdr *cmsg = CMSG_FIRSTHDR(&rawsock->mmsg[i].msg_hdr);
+			memcpy(CMSG_DATA(cmsg), &txtime, sizeof(txtime));
+		}
+	}
 }
 
 // Send all packets that are ready (i.e. tell kernel to send them)
@@ -348,6 +461,9 @@ int sendmmsgRawsockSend(void *pvRawsock)
 	}
 
 	IF_LOG_INTERVAL(1000) AVB_LOGF_DEBUG("Send with %d of %d buffers ready", rawsock->buffersReady, rawsock->frameCount);
+	if (rawsock->bLaunchTime) {
+		sendmmsgRawsockTxTimes(rawsock);
+	}
 	sz = sendmmsg(rawsock->sock, rawsock->mmsg, rawsock->buffersReady, 0);
 	if (sz < 0) {
 		AVB_LOGF_ERROR("Call to sendmmsg failed! Error code was %d", sz);
@@ -368,6 +484,58 @@ int sendmmsgRawsockSend(void *pvRawsock)
 	return bytes;
 }
 
+// Number of TX frames that can be held at once
+int sendmmsgRawsockTxFrameCount(void *pvRawsock)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK_DETAIL);
+	sendmmsg_rawsock_t *rawsock = (sendmmsg_rawsock_t*)pvRawsock;
+
+	if (!VALID_TX_RAWSOCK(rawsock)) {
+		AVB_LOG_ERROR("getting TX frame count; invalid arguments");
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+		return 0;
+	}
+
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+	return rawsock->frameCount;
+}
+
+// Receive the frames that are waiting on the socket, up to the batch depth.
+// Waits up to timeout usec for the first one.
+static int sendmmsgRawsockRecv(sendmmsg_rawsock_t *rawsock, U32 timeout)
+{
+	if (rawsock->bRxTimestamp) {
+		// The kernel overwrites the control length with what it used
+		int i;
+		for (i = 0; i < rawsock->rxFrameCount; i++) {
+			rawsock->rxMmsg[i].msg_hdr.msg_controllen = sizeof(rawsock->rxCmsgbuf[i]);
+		}
+	}
+
+	// Don't wait when frames are already queued; the common case under load
+	int cnt = recvmmsg(rawsock->sock, rawsock->rxMmsg, rawsock->rxFrameCount, MSG_DONTWAIT, NULL);
+	if (cnt < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && timeout != OPENAVB_RAWSOCK_NONBLOCK) {
+		// Wait until a packet is available, or a timeout occurs.
+		struct pollfd pfd;
+		pfd.fd = rawsock->sock;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		struct timespec ts_timeout = { timeout / MICROSECONDS_PER_SECOND, (timeout % MICROSECONDS_PER_SECOND) * NANOSECONDS_PER_USEC };
+		if (ppoll(&pfd, 1, (timeout == (U32)OPENAVB_RAWSOCK_BLOCK) ? NULL : &ts_timeout, NULL) <= 0) {
+			return 0;
+		}
+		cnt = recvmmsg(rawsock->sock, rawsock->rxMmsg, rawsock->rxFrameCount, MSG_DONTWAIT, NULL);
+	}
+
+	if (cnt < 0) {
+		if (errno != EAGAIN && errno != EWOULDBLOCK) {
+			AVB_LOGF_ERROR("%s %s", __func__, strerror(errno));
+		}
+		return 0;
+	}
+	return cnt;
+}
+
 // Get a RX frame
 U8* sendmmsgRawsockGetRxFrame(void *pvRawsock, U32 timeout, unsigned int *offset, unsigned int *len)
 {
@@ -378,29 +546,111 @@ U8* sendmmsgRawsockGetRxFrame(void *pvRawsock, U32 timeout, unsigned int *offset
 		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
 		return NULL;
 	}
-// For switching to recvmmsg eventually
-//	if (rawsock->rxbuffersOut >= rawsock->rxframeCount) {
-//		AVB_LOG_ERROR("Too many RX buffers in use");
-//		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
-//		return NULL;
-//	}
-
-	int flags = 0;
 
-	U8 *pBuffer = rawsock->rxBuffer;
 	*offset = 0;
-	*len = recv(rawsock->sock, pBuffer, rawsock->base.frameSize, flags);
+	*len = 0;
 
-	if (*len == (unsigned int)(-1)) {
-		AVB_LOGF_ERROR("%s %s", __func__, strerror(errno));
-		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
-		return NULL;
+	if (rawsock->rxFrameNext >= rawsock->rxFramesFilled) {
+		// The batch is used up. Its buffers are reused, so all must be released.
+		if (rawsock->rxBuffersOut > 0) {
+			AVB_LOG_ERROR("Too many RX buffers in use");
+			AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+			return NULL;
+		}
+
+		rawsock->rxFrameNext = 0;
+		rawsock->rxFramesFilled = sendmmsgRawsockRecv(rawsock, timeout);
+		if (rawsock->rxFramesFilled == 0) {
+			AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+			return NULL;
+		}
 	}
 
+	int bufidx = rawsock->rxFrameNext++;
+	U8 *pBuffer = rawsock->rxPktbuf[bufidx];
+	*len = rawsock->rxMmsg[bufidx].msg_len;
+	rawsock->rxBuffersOut += 1;
+
 	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
 	return pBuffer;
 }
 
+// Release a RX frame
+bool sendmmsgRawsockRelRxFrame(void *pvRawsock, U8 *pFrame)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK_DETAIL);
+	sendmmsg_rawsock_t *rawsock = (sendmmsg_rawsock_t*)pvRawsock;
+	if (!VALID_RX_RAWSOCK(rawsock) || rawsock->rxBuffersOut <= 0) {
+		AVB_LOG_ERROR("Releasing RX frame; invalid arguments");
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+		return FALSE;
+	}
+
+	rawsock->rxBuffersOut -= 1;
+
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+	return TRUE;
+}
+
+// Number of received frames not yet handed out
+int sendmmsgRawsockRxBufLevel(void *pvRawsock)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK_DETAIL);
+	sendmmsg_rawsock_t *rawsock = (sendmmsg_rawsock_t*)pvRawsock;
+	if (!VALID_RX_RAWSOCK(rawsock)) {
+		AVB_LOG_ERROR("Getting RX buffer level; invalid arguments");
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+		return -1;
+	}
+
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+	return rawsock->rxFramesFilled - rawsock->rxFrameNext;
+}
+
+// Parse the ethernet frame header, adding the receive timestamp
+int sendmmsgRawsockRxParseHdr(void *pvRawsock, U8 *pBuffer, hdr_info_t *pInfo)
+{
+	sendmmsg_rawsock_t *rawsock = (sendmmsg_rawsock_t*)pvRawsock;
+
+	int hdrLen = baseRawsockRxParseHdr(pvRawsock, pBuffer, pInfo);
+	if (hdrLen >= 0 && rawsock->bRxTimestamp) {
+		int bufidx = (pBuffer - rawsock->rxPktbuf[0]) / MAX_FRAME_SIZE;
+		if (bufidx >= 0 && bufidx < rawsock->rxFramesFilled) {
+			simpleRawsockRxTimestamp(&rawsock->rxMmsg[bufidx].msg_hdr, &pInfo->ts, &pInfo->ts_hw);
+		}
+	}
+	return hdrLen;
+}
+
+// Timestamp received frames
+bool sendmmsgRawsockRxSetTimestamp(void *pvRawsock, bool enable)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK);
+	sendmmsg_rawsock_t *rawsock = (sendmmsg_rawsock_t*)pvRawsock;
+
+	if (!VALID_RX_RAWSOCK(rawsock)) {
+		AVB_LOG_ERROR("Setting RX timestamps; invalid arguments");
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
+		return FALSE;
+	}
+
+	if (enable && !rawsock->bRxTimestamp && !simpleRawsockRxTimestampEnable(rawsock->sock)) {
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
+		return FALSE;
+	}
+	rawsock->bRxTimestamp = enable;
+
+	// Point the RX messages at their control buffers
+	int i;
+	for (i = 0; i < rawsock->rxFrameCount; i++) {
+		rawsock->rxMmsg[i].msg_hdr.msg_control = enable ? rawsock->rxCmsgbuf[i] : NULL;
+		rawsock->rxMmsg[i].msg_hdr.msg_controllen = enable ? sizeof(rawsock->rxCmsgbuf[i]) : 0;
+	}
+
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
+	return TRUE;
+}
+
 // Setup the rawsock to receive multicast packets
 bool sendmmsgRawsockRxMulticast(void *pvRawsock, bool add_membership, const U8 addr[ETH_ALEN])
 {
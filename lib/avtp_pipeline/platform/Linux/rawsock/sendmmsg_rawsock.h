@@ -41,8 +41,10 @@ https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
 #include "rawsock_impl.h"
 
 #define MSG_COUNT 8
-#define MAX_FRAME_SIZE 1024
-#define USE_LAUNCHTIME 0
+// Large enough for a full MTU frame with a VLAN tag
+#define MAX_FRAME_SIZE 1536
+// Maximum number of frames received with one recvmmsg() call
+#define RX_MSG_COUNT 32
 
 
 // State information for raw socket
@@ -62,17 +64,42 @@ typedef struct {
 	// count of buffers ready to send
 	int buffersReady;
 
-	// buffer for receiving frames
-	U8 rxBuffer[1518];
-
 	struct mmsghdr mmsg[MSG_COUNT];
 
-	struct iovec miov[MSG_COUNT];
+	// header and (for frames submitted by reference) payload of each message
+	struct iovec miov[MSG_COUNT][2];
 
 	unsigned char pktbuf[MSG_COUNT][MAX_FRAME_SIZE];
-#if USE_LAUNCHTIME
 	unsigned char cmsgbuf[MSG_COUNT][CMSG_SPACE(sizeof(uint64_t))];
-#endif
+
+	// gPTP launch time of each message, converted to CLOCK_TAI on send
+	U64 txLaunchNsec[MSG_COUNT];
+
+	// attach SCM_TXTIME launch times to sent frames
+	bool bLaunchTime;
+
+	// number of frames requested per recvmmsg call
+	int rxFrameCount;
+
+	// number of frames received by the last recvmmsg call
+	int rxFramesFilled;
+
+	// index of the next received frame to hand out
+	int rxFrameNext;
+
+	// count of RX buffers taken by the client
+	int rxBuffersOut;
+
+	struct mmsghdr rxMmsg[RX_MSG_COUNT];
+
+	struct iovec rxMiov[RX_MSG_COUNT];
+
+	unsigned char rxPktbuf[RX_MSG_COUNT][MAX_FRAME_SIZE];
+
+	unsigned char rxCmsgbuf[RX_MSG_COUNT][CMSG_SPACE(sizeof(struct timespec) * 3)];
+
+	// receive timestamps are enabled
+	bool bRxTimestamp;
 } sendmmsg_rawsock_t;
 
 // Open a rawsock for TX or RX
@@ -84,23 +111,47 @@ void sendmmsgRawsockClose(void *pvRawsock);
 // Get a buffer from the simple to use for TX
 U8* sendmmsgRawsockGetTxFrame(void *pvRawsock, bool blocking, unsigned int *len);
 
+// Release a TX frame without sending it
+bool sendmmsgRawsockRelTxFrame(void *pvRawsock, U8 *pBuffer);
+
 // Set the Firewall MARK on the socket
 // The mark is used by FQTSS to identify AVTP packets in kernel.
 // FQTSS creates a mark that includes the AVB class and stream index.
 bool sendmmsgRawsockTxSetMark(void *pvRawsock, int mark);
 
+// Attach a launch time (SCM_TXTIME) to each frame sent
+bool sendmmsgRawsockTxSetLaunchTime(void *pvRawsock, bool enable);
+
 // Pre-set the ethernet header information that will be used on TX frames
 bool sendmmsgRawsockTxSetHdr(void *pvRawsock, hdr_info_t *pHdr);
 
 // Release a TX frame, and mark it as ready to send
 bool sendmmsgRawsockTxFrameReady(void *pvRawsock, U8 *pBuffer, unsigned int len, U64 timeNsec);
 
+// Mark a TX frame ready to send, the payload is sent from the caller's memory
+bool sendmmsgRawsockTxFrameReadyRef(void *pvRawsock, U8 *pBuffer, unsigned int hdrLen, const U8 *pPayload, unsigned int payloadLen, U64 timeNsec);
+
 // Send all packets that are ready (i.e. tell kernel to send them)
 int sendmmsgRawsockSend(void *pvRawsock);
 
+// Number of TX frames that can be held at once
+int sendmmsgRawsockTxFrameCount(void *pvRawsock);
+
 // Get a RX frame
 U8* sendmmsgRawsockGetRxFrame(void *pvRawsock, U32 timeout, unsigned int *offset, unsigned int *len);
 
+// Release a RX frame
+bool sendmmsgRawsockRelRxFrame(void *pvRawsock, U8 *pFrame);
+
+// Number of received frames not yet handed out
+int sendmmsgRawsockRxBufLevel(void *pvRawsock);
+
+// Parse the ethernet frame header, adding the receive timestamp
+int sendmmsgRawsockRxParseHdr(void *pvRawsock, U8 *pBuffer, hdr_info_t *pInfo);
+
+// Timestamp received frames
+bool sendmmsgRawsockRxSetTimestamp(void *pvRawsock, bool enable);
+
 // Setup the rawsock to receive multicast packets
 bool sendmmsgRawsockRxMulticast(void *pvRawsock, bool add_membership, const U8 addr[ETH_ALEN]);
 
@@ -34,7 +34,10 @@ https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
 #include <sys/ioctl.h>
 #include <linux/if_packet.h>
 #include <linux/filter.h>
+#include <linux/net_tstamp.h>
+#include <linux/errqueue.h>
 
+#include "openavb_time.h"
 #include "openavb_trace.h"
 
 #define	AVB_LOG_COMPONENT	"Raw Socket"
@@ -124,6 +127,98 @@ bool simpleAvbCheckInterface(const char *ifname, if_info_t *info)
 	return TRUE;
 }
 
+// Enable SO_TXTIME on a socket
+bool simpleRawsockTxTimeEnable(int sock)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK);
+
+	struct sock_txtime txtime;
+	memset(&txtime, 0, sizeof(txtime));
+	txtime.clockid = CLOCK_TAI;
+	txtime.flags = 0;
+
+	if (setsockopt(sock, SOL_SOCKET, SO_TXTIME, &txtime, sizeof(txtime)) < 0) {
+		AVB_LOGF_ERROR("Enabling launch time; setsockopt(SO_TXTIME) failed: %s", strerror(errno));
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
+		return FALSE;
+	}
+
+	AVB_LOG_DEBUG("SO_TXTIME OK");
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
+	return TRUE;
+}
+
+// Get the offset from gPTP time to CLOCK_TAI.
+// It is sampled on every call; gPTP is disciplined by the daemon and
+// may be adjusted at any time.
+bool simpleRawsockTaiOffset(S64 *pOffsetNsec)
+{
+	struct timespec tai;
+	U64 ptpNow, taiNow;
+
+	if (!CLOCK_GETTIME64(OPENAVB_CLOCK_WALLTIME, &ptpNow) || clock_gettime(CLOCK_TAI, &tai) < 0) {
+		return FALSE;
+	}
+	taiNow = (U64)tai.tv_sec * NANOSECONDS_PER_SECOND + tai.tv_nsec;
+	*pOffsetNsec = (S64)(taiNow - ptpNow);
+	return TRUE;
+}
+
+// Convert a gPTP launch time to CLOCK_TAI. The launch time is kept as is,
+// even when it has passed: the caller leaves enough lead for the frame to
+// reach the qdisc in time.
+U64 simpleRawsockTxTime(U64 ptpNsec)
+{
+	S64 offsetNsec;
+	if (!simpleRawsockTaiOffset(&offsetNsec)) {
+		return 0;
+	}
+	return ptpNsec + offsetNsec;
+}
+
+// Enable SO_TIMESTAMPING receive timestamps on a socket
+bool simpleRawsockRxTimestampEnable(int sock)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK);
+
+	int flags = SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE
+		| SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+
+	if (setsockopt(sock, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) < 0) {
+		AVB_LOGF_ERROR("Enabling RX timestamps; setsockopt(SO_TIMESTAMPING) failed: %s", strerror(errno));
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
+		return FALSE;
+	}
+
+	AVB_LOG_DEBUG("SO_TIMESTAMPING OK");
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
+	return TRUE;
+}
+
+// Get the receive timestamp from the control messages of a received frame.
+// The hardware timestamp is preferred over the software one.
+bool simpleRawsockRxTimestamp(struct msghdr *msg, struct timespec *ts, bool *pHw)
+{
+	struct cmsghdr *cmsg;
+	for (cmsg = CMSG_FIRSTHDR(msg); cmsg; cmsg = CMSG_NXTHDR(msg, cmsg)) {
+		if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPING) {
+			struct scm_timestamping tss;
+			memcpy(&tss, CMSG_DATA(cmsg), sizeof(tss));
+			if (tss.ts[2].tv_sec || tss.ts[2].tv_nsec) {
+				*ts = tss.ts[2];
+				*pHw = TRUE;
+				return TRUE;
+			}
+			if (tss.ts[0].tv_sec || tss.ts[0].tv_nsec) {
+				*ts = tss.ts[0];
+				*pHw = FALSE;
+				return TRUE;
+			}
+		}
+	}
+	return FALSE;
+}
+
 // Open a rawsock for TX or RX
 void* simpleRawsockOpen(simple_rawsock_t* rawsock, const char *ifname, bool rx_mode, bool tx_mode, U16 ethertype, U32 frame_size, U32 num_frames)
 {
@@ -208,6 +303,8 @@ void* simpleRawsockOpen(simple_rawsock_t* rawsock, const char *ifname, bool rx_m
 	cb->rxAVTPSubtype = simpleRawsockRxAVTPSubtype;
 	cb->getSocket = simpleRawsockGetSocket;
 	cb->relRxFrame = simpleRawsockRelRxFrame;
+	cb->rxParseHdr = simpleRawsockRxParseHdr;
+	cb->rxSetTimestamp = simpleRawsockRxSetTimestamp;
 
 	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
 	return rawsock;
@@ -375,7 +472,27 @@ U8* simpleRawsockGetRxFrame(void *pvRawsock, U32 timeout, unsigned int *offset,
 	int flags = 0;
 
 	U8 *pBuffer = rawsock->rxBuffer;
-	*len = recv(rawsock->sock, pBuffer, rawsock->base.frameSize, flags);
+	if (!rawsock->bRxTimestamp) {
+		*len = recv(rawsock->sock, pBuffer, rawsock->base.frameSize, flags);
+	}
+	else {
+		union {
+			char buf[CMSG_SPACE(sizeof(struct scm_timestamping))];
+			struct cmsghdr align;
+		} control;
+		struct iovec iov = { pBuffer, rawsock->base.frameSize };
+		struct msghdr msg;
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = control.buf;
+		msg.msg_controllen = sizeof(control.buf);
+
+		*len = recvmsg(rawsock->sock, &msg, flags);
+		if (*len != -1 && !simpleRawsockRxTimestamp(&msg, &rawsock->rxTs, &rawsock->rxTsHw)) {
+			memset(&rawsock->rxTs, 0, sizeof(rawsock->rxTs));
+		}
+	}
 
 	if (*len == -1) {
 		AVB_LOGF_ERROR("%s %s", __func__, strerror(errno));
@@ -497,3 +614,38 @@ bool simpleRawsockRelRxFrame(void *pvRawsock, U8 *pFrame)
 {
 	return true;
 }
+
+// Parse the ethernet frame header, adding the receive timestamp
+int simpleRawsockRxParseHdr(void *pvRawsock, U8 *pBuffer, hdr_info_t *pInfo)
+{
+	simple_rawsock_t *rawsock = (simple_rawsock_t*)pvRawsock;
+
+	int hdrLen = baseRawsockRxParseHdr(pvRawsock, pBuffer, pInfo);
+	if (hdrLen >= 0 && rawsock->bRxTimestamp) {
+		pInfo->ts = rawsock->rxTs;
+		pInfo->ts_hw = rawsock->rxTsHw;
+	}
+	return hdrLen;
+}
+
+// Timestamp received frames
+bool simpleRawsockRxSetTimestamp(void *pvRawsock, bool enable)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK);
+	simple_rawsock_t *rawsock = (simple_rawsock_t*)pvRawsock;
+
+	if (!VALID_RX_RAWSOCK(rawsock)) {
+		AVB_LOG_ERROR("Setting RX timestamps; invalid arguments");
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
+		return FALSE;
+	}
+
+	if (enable && !rawsock->bRxTimestamp && !simpleRawsockRxTimestampEnable(rawsock->sock)) {
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
+		return FALSE;
+	}
+	rawsock->bRxTimestamp = enable;
+
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
+	return TRUE;
+}
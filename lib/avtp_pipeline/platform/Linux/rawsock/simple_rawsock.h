@@ -34,6 +34,12 @@ https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
 
 #include "rawsock_impl.h"
 
+// Older libc headers lack the launch time socket option
+#ifndef SO_TXTIME
+#define SO_TXTIME	61
+#define SCM_TXTIME	SO_TXTIME
+#endif
+
 // State information for raw socket
 //
 typedef struct {
@@ -47,10 +53,34 @@ typedef struct {
 
 	// buffer for receiving frames
 	U8 rxBuffer[1518];
+
+	// receive timestamps are enabled
+	bool bRxTimestamp;
+	// timestamp of the frame in rxBuffer
+	struct timespec rxTs;
+	bool rxTsHw;
 } simple_rawsock_t;
 
 bool simpleAvbCheckInterface(const char *ifname, if_info_t *info);
 
+// Enable SO_TXTIME on a socket so each frame can carry an SCM_TXTIME
+// launch time (CLOCK_TAI) for the ETF / taprio qdiscs.
+bool simpleRawsockTxTimeEnable(int sock);
+
+// Get the offset to add to a gPTP time to get CLOCK_TAI
+bool simpleRawsockTaiOffset(S64 *pOffsetNsec);
+
+// Convert a gPTP launch time to the CLOCK_TAI value used by SCM_TXTIME.
+// Call it right before the frame is sent.
+U64 simpleRawsockTxTime(U64 ptpNsec);
+
+// Enable SO_TIMESTAMPING receive timestamps on a socket.
+// Hardware timestamps are used when the network card provides them.
+bool simpleRawsockRxTimestampEnable(int sock);
+
+// Get the receive timestamp from the control messages of a received frame
+bool simpleRawsockRxTimestamp(struct msghdr *msg, struct timespec *ts, bool *pHw);
+
 // Open a rawsock for TX or RX
 void* simpleRawsockOpen(simple_rawsock_t *rawsock, const char *ifname, bool rx_mode, bool tx_mode, U16 ethertype, U32 frame_size, U32 num_frames);
 
@@ -89,4 +119,10 @@ int  simpleRawsockGetSocket(void *pvRawsock);
 
 bool simpleRawsockRelRxFrame(void *pvRawsock, U8 *pFrame);
 
+// Parse the ethernet frame header, adding the receive timestamp
+int simpleRawsockRxParseHdr(void *pvRawsock, U8 *pBuffer, hdr_info_t *pInfo);
+
+// Timestamp received frames
+bool simpleRawsockRxSetTimestamp(void *pvRawsock, bool enable);
+
 #endif
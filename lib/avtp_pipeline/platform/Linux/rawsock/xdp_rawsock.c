@@ -0,0 +1,849 @@
+/*************************************************************************************************************
+Copyright (c) 2012-2015, Symphony Teleca Corporation, a Harman International Industries, Incorporated company
+Copyright (c) 2016-2017, Harman International Industries, Incorporated
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS LISTED "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS LISTED BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Attributions: The inih library portion of the source code is licensed from
+Brush Technology and Ben Hoyt - Copyright (c) 2009, Brush Technology and Copyright (c) 2009, Ben Hoyt.
+Complete license and copyright information can be found at
+https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
+*************************************************************************************************************/
+
+#include "xdp_rawsock.h"
+#include "simple_rawsock.h"
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <poll.h>
+#include <stddef.h>
+#include <linux/if_packet.h>
+#include <linux/if_link.h>
+#include <linux/bpf.h>
+
+#include "openavb_trace.h"
+
+#define	AVB_LOG_COMPONENT	"Raw Socket"
+#include "openavb_log.h"
+
+#ifndef AF_XDP
+#define AF_XDP 44
+#endif
+#ifndef SOL_XDP
+#define SOL_XDP 283
+#endif
+
+#define XDP_RING_LOAD_ACQ(pVal)			__atomic_load_n((pVal), __ATOMIC_ACQUIRE)
+#define XDP_RING_STORE_REL(pVal, val)	__atomic_store_n((pVal), (val), __ATOMIC_RELEASE)
+
+// Build one eBPF instruction
+#define XDP_INSN(c, d, s, o, i) \
+	((struct bpf_insn){ .code = (c), .dst_reg = (d), .src_reg = (s), .off = (o), .imm = (i) })
+
+
+static int xdpBpf(int cmd, union bpf_attr *attr)
+{
+	return syscall(__NR_bpf, cmd, attr, sizeof(*attr));
+}
+
+// Round up to the next power of 2, as required for the ring sizes
+static U32 xdpRoundPow2(U32 val)
+{
+	U32 pow2 = 1;
+	while (pow2 < val)
+		pow2 <<= 1;
+	return pow2;
+}
+
+// Map one of the kernel rings into our address space
+static bool xdpRingMap(xdp_rawsock_t *rawsock, xdp_ring_t *pRing, struct xdp_ring_offset *pOff,
+					   U32 size, size_t descSize, off_t pgoff)
+{
+	pRing->mapSize = pOff->desc + (size * descSize);
+	pRing->pMap = mmap(NULL, pRing->mapSize, PROT_READ | PROT_WRITE,
+					   MAP_SHARED | MAP_POPULATE, rawsock->sock, pgoff);
+	if (pRing->pMap == MAP_FAILED) {
+		pRing->pMap = NULL;
+		return FALSE;
+	}
+
+	pRing->producer = (U32*)((U8*)pRing->pMap + pOff->producer);
+	pRing->consumer = (U32*)((U8*)pRing->pMap + pOff->consumer);
+	pRing->flags = (U32*)((U8*)pRing->pMap + pOff->flags);
+	pRing->ring = (U8*)pRing->pMap + pOff->desc;
+	pRing->size = size;
+	pRing->mask = size - 1;
+	return TRUE;
+}
+
+static void xdpRingUnmap(xdp_ring_t *pRing)
+{
+	if (pRing->pMap) {
+		munmap(pRing->pMap, pRing->mapSize);
+		pRing->pMap = NULL;
+	}
+}
+
+// Put a chunk on the fill ring, for the kernel to receive into
+static void xdpFillChunk(xdp_rawsock_t *rawsock, U64 addr)
+{
+	U32 prod = *rawsock->fill.producer;
+	((U64*)rawsock->fill.ring)[prod & rawsock->fill.mask] = addr;
+	XDP_RING_STORE_REL(rawsock->fill.producer, prod + 1);
+}
+
+// Take back the TX chunks the kernel is done with
+static void xdpReclaimTx(xdp_rawsock_t *rawsock)
+{
+	U32 cons = *rawsock->comp.consumer;
+	U32 prod = XDP_RING_LOAD_ACQ(rawsock->comp.producer);
+
+	while (cons != prod) {
+		rawsock->txFree[rawsock->txFreeCount++] = ((U64*)rawsock->comp.ring)[cons & rawsock->comp.mask];
+		cons++;
+	}
+	XDP_RING_STORE_REL(rawsock->comp.consumer, cons);
+}
+
+// Wake the kernel up to process the TX ring, if it wants us to
+static void xdpKickTx(xdp_rawsock_t *rawsock)
+{
+	if (rawsock->bNeedWakeup && !(XDP_RING_LOAD_ACQ(rawsock->tx.flags) & XDP_RING_NEED_WAKEUP))
+		return;
+
+	// In copy mode the kernel sends a limited batch per call, and
+	// returns EAGAIN while frames are left on the TX ring.
+	int tries = (rawsock->txFrameCount / 32) + 1;
+	while (sendto(rawsock->sock, NULL, 0, MSG_DONTWAIT, NULL, 0) < 0) {
+		if (errno == EAGAIN && --tries > 0) {
+			xdpReclaimTx(rawsock);
+			continue;
+		}
+		if (errno != EAGAIN && errno != EBUSY && errno != ENOBUFS && errno != EINTR) {
+			IF_LOG_INTERVAL(1000) AVB_LOGF_ERROR("Send failed: %s", strerror(errno));
+		}
+		break;
+	}
+}
+
+// Load an XDP program which hands the stream data AVTPDUs (cd bit clear,
+// sv bit set) of our ethertype, tagged or not, to the socket bound to the
+// receive queue, and attach it to the interface. Everything else, AVDECC
+// and MAAP included, is passed on to the kernel stack.
+static bool xdpAttachProg(xdp_rawsock_t *rawsock)
+{
+	union bpf_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.map_type = BPF_MAP_TYPE_XSKMAP;
+	attr.key_size = sizeof(U32);
+	attr.value_size = sizeof(U32);
+	attr.max_entries = rawsock->queueId + 1;
+	rawsock->mapFd = xdpBpf(BPF_MAP_CREATE, &attr);
+	if (rawsock->mapFd < 0) {
+		AVB_LOGF_ERROR("Creating rawsock; XSKMAP: %s", strerror(errno));
+		return FALSE;
+	}
+
+	U32 key = rawsock->queueId;
+	U32 val = rawsock->sock;
+	memset(&attr, 0, sizeof(attr));
+	attr.map_fd = rawsock->mapFd;
+	attr.key = (U64)(unsigned long)&key;
+	attr.value = (U64)(unsigned long)&val;
+	attr.flags = BPF_ANY;
+	if (xdpBpf(BPF_MAP_UPDATE_ELEM, &attr) < 0) {
+		AVB_LOGF_ERROR("Creating rawsock; XSKMAP update: %s", strerror(errno));
+		return FALSE;
+	}
+
+	S32 vlanType = htons(ETHERTYPE_8021Q);
+	S32 ethType = htons(rawsock->base.ethertype);
+	struct bpf_insn prog[] = {
+		XDP_INSN(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_2, BPF_REG_1, offsetof(struct xdp_md, data), 0),
+		XDP_INSN(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_3, BPF_REG_1, offsetof(struct xdp_md, data_end), 0),
+		XDP_INSN(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_4, BPF_REG_2, 0, 0),
+		XDP_INSN(BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_4, 0, 0, sizeof(eth_vlan_hdr_t) + 2),
+		XDP_INSN(BPF_JMP | BPF_JGT | BPF_X, BPF_REG_4, BPF_REG_3, 18, 0),		// short frame -> pass
+		XDP_INSN(BPF_LDX | BPF_MEM | BPF_H, BPF_REG_5, BPF_REG_2, offsetof(eth_hdr_t, ethertype), 0),
+		XDP_INSN(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_4, BPF_REG_2, 0, 0),		// r4 = AVTP header
+		XDP_INSN(BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_4, 0, 0, sizeof(eth_hdr_t)),
+		XDP_INSN(BPF_JMP | BPF_JNE | BPF_K, BPF_REG_5, 0, 2, vlanType),
+		XDP_INSN(BPF_LDX | BPF_MEM | BPF_H, BPF_REG_5, BPF_REG_2, offsetof(eth_vlan_hdr_t, ethertype), 0),
+		XDP_INSN(BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_4, 0, 0, sizeof(eth_vlan_hdr_t) - sizeof(eth_hdr_t)),
+		XDP_INSN(BPF_JMP | BPF_JNE | BPF_K, BPF_REG_5, 0, 11, ethType),			// other ethertype -> pass
+		XDP_INSN(BPF_LDX | BPF_MEM | BPF_B, BPF_REG_5, BPF_REG_4, 0, 0),
+		XDP_INSN(BPF_JMP | BPF_JSET | BPF_K, BPF_REG_5, 0, 9, 0x80),			// control (cd bit) -> pass
+		XDP_INSN(BPF_LDX | BPF_MEM | BPF_B, BPF_REG_5, BPF_REG_4, 1, 0),
+		XDP_INSN(BPF_ALU64 | BPF_AND | BPF_K, BPF_REG_5, 0, 0, 0x80),
+		XDP_INSN(BPF_JMP | BPF_JEQ | BPF_K, BPF_REG_5, 0, 6, 0),				// no stream ID (sv bit) -> pass
+		XDP_INSN(BPF_LDX | BPF_MEM | BPF_W, BPF_REG_2, BPF_REG_1, offsetof(struct xdp_md, rx_queue_index), 0),
+		XDP_INSN(BPF_LD | BPF_DW | BPF_IMM, BPF_REG_1, BPF_PSEUDO_MAP_FD, 0, rawsock->mapFd),
+		XDP_INSN(0, 0, 0, 0, 0),
+		XDP_INSN(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_3, 0, 0, XDP_PASS),		// no socket -> pass
+		XDP_INSN(BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_redirect_map),
+		XDP_INSN(BPF_JMP | BPF_EXIT, 0, 0, 0, 0),
+		XDP_INSN(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_0, 0, 0, XDP_PASS),
+		XDP_INSN(BPF_JMP | BPF_EXIT, 0, 0, 0, 0),
+	};
+
+	memset(&attr, 0, sizeof(attr));
+	attr.prog_type = BPF_PROG_TYPE_XDP;
+	attr.insns = (U64)(unsigned long)prog;
+	attr.insn_cnt = sizeof(prog) / sizeof(prog[0]);
+	attr.license = (U64)(unsigned long)"BSD";
+	rawsock->progFd = xdpBpf(BPF_PROG_LOAD, &attr);
+	if (rawsock->progFd < 0) {
+		AVB_LOGF_ERROR("Creating rawsock; XDP program load: %s", strerror(errno));
+		return FALSE;
+	}
+
+	// Prefer the driver's native XDP support, and fall back to generic
+	// (SKB) mode which works on any interface. The link goes away when
+	// the file descriptor is closed, even if the process dies.
+	U32 modes[] = { XDP_FLAGS_DRV_MODE, XDP_FLAGS_SKB_MODE };
+	int i;
+	for (i = 0; i < 2 && rawsock->linkFd < 0; i++) {
+		memset(&attr, 0, sizeof(attr));
+		attr.link_create.prog_fd = rawsock->progFd;
+		attr.link_create.target_ifindex = rawsock->base.ifInfo.index;
+		attr.link_create.attach_type = BPF_XDP;
+		attr.link_create.flags = modes[i];
+		rawsock->linkFd = xdpBpf(BPF_LINK_CREATE, &attr);
+		if (rawsock->linkFd < 0) {
+			AVB_LOGF_DEBUG("XDP attach in %s mode: %s", (modes[i] == XDP_FLAGS_DRV_MODE) ? "native" : "generic", strerror(errno));
+		}
+		else {
+			AVB_LOGF_INFO("XDP program attached to %s in %s mode", rawsock->base.ifInfo.name,
+						  (modes[i] == XDP_FLAGS_DRV_MODE) ? "native" : "generic");
+		}
+	}
+	if (rawsock->linkFd < 0) {
+		AVB_LOGF_ERROR("Creating rawsock; XDP attach: %s", strerror(errno));
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+// Open a rawsock for TX or RX
+void* xdpRawsockOpen(xdp_rawsock_t *rawsock, const char *ifname, bool rx_mode, bool tx_mode, U16 ethertype, U32 frame_size, U32 num_frames)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK);
+
+	AVB_LOGF_DEBUG("Open, ifname=%s, rx=%d, tx=%d, ethertype=%x size=%d, num=%d",
+				   ifname, rx_mode, tx_mode, ethertype, frame_size, num_frames);
+
+	baseRawsockOpen(&rawsock->base, ifname, rx_mode, tx_mode, ethertype, frame_size, num_frames);
+
+	rawsock->sock = -1;
+	rawsock->mcastSock = -1;
+	rawsock->mapFd = -1;
+	rawsock->progFd = -1;
+	rawsock->linkFd = -1;
+	rawsock->pUmem = (void*)(-1);
+	rawsock->queueId = XDP_RAWSOCK_QUEUE_ID;
+
+	// Get info about the network device
+	if (!simpleAvbCheckInterface(ifname, &(rawsock->base.ifInfo))) {
+		AVB_LOGF_ERROR("Creating rawsock; bad interface name: %s", ifname);
+		free(rawsock);
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
+		return NULL;
+	}
+
+	// Deal with frame size.
+	if (rawsock->base.frameSize == 0) {
+		// use interface MTU as max frames size, if none specified
+		rawsock->base.frameSize = rawsock->base.ifInfo.mtu + ETH_HLEN + VLAN_HLEN;
+	}
+	else if (rawsock->base.frameSize > rawsock->base.ifInfo.mtu + ETH_HLEN + VLAN_HLEN) {
+		AVB_LOG_ERROR("Creating raswsock; requested frame size exceeds MTU");
+		free(rawsock);
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
+		return NULL;
+	}
+	if (rawsock->base.frameSize > XDP_RAWSOCK_CHUNK_SIZE - XDP_PACKET_HEADROOM) {
+		AVB_LOGF_ERROR("Creating rawsock; frame size %d too large for AF_XDP", rawsock->base.frameSize);
+		free(rawsock);
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
+		return NULL;
+	}
+
+	// Prepare default Ethernet header.
+	rawsock->base.ethHdrLen = sizeof(eth_hdr_t);
+	memset(&(rawsock->base.ethHdr.notag.dhost), 0xFF, ETH_ALEN);
+	memcpy(&(rawsock->base.ethHdr.notag.shost), &(rawsock->base.ifInfo.mac), ETH_ALEN);
+	rawsock->base.ethHdr.notag.ethertype = htons(rawsock->base.ethertype);
+
+	// Ring sizes must be a power of 2
+	if (num_frames < XDP_RAWSOCK_MIN_FRAMES)
+		num_frames = XDP_RAWSOCK_MIN_FRAMES;
+	rawsock->rxFrameCount = rx_mode ? xdpRoundPow2(num_frames) : 0;
+	rawsock->txFrameCount = tx_mode ? xdpRoundPow2(num_frames) : 0;
+
+	// Memory shared with the kernel for the frames
+	rawsock->umemSize = (size_t)(rawsock->rxFrameCount + rawsock->txFrameCount) * XDP_RAWSOCK_CHUNK_SIZE;
+	rawsock->pUmem = mmap(NULL, rawsock->umemSize, PROT_READ | PROT_WRITE,
+						  MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+	if (rawsock->pUmem == (void*)(-1)) {
+		AVB_LOGF_ERROR("Creating rawsock; UMEM: %s", strerror(errno));
+		xdpRawsockClose(rawsock);
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
+		return NULL;
+	}
+
+	// Create socket
+	rawsock->sock = socket(AF_XDP, SOCK_RAW, 0);
+	if (rawsock->sock == -1) {
+		AVB_LOGF_ERROR("Creating rawsock; opening socket: %s", strerror(errno));
+		xdpRawsockClose(rawsock);
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
+		return NULL;
+	}
+
+	struct xdp_umem_reg umemReg;
+	memset(&umemReg, 0, sizeof(umemReg));
+	umemReg.addr = (U64)(unsigned long)rawsock->pUmem;
+	umemReg.len = rawsock->umemSize;
+	umemReg.chunk_size = XDP_RAWSOCK_CHUNK_SIZE;
+	umemReg.headroom = 0;
+	if (setsockopt(rawsock->sock, SOL_XDP, XDP_UMEM_REG, &umemReg, sizeof(umemReg)) < 0) {
+		AVB_LOGF_ERROR("Creating rawsock; UMEM_REG: %s", strerror(errno));
+		xdpRawsockClose(rawsock);
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
+		return NULL;
+	}
+
+	// The fill and completion rings must exist even if unused
+	U32 fillSize = rx_mode ? rawsock->rxFrameCount : 1;
+	U32 compSize = tx_mode ? rawsock->txFrameCount : 1;
+	if (setsockopt(rawsock->sock, SOL_XDP, XDP_UMEM_FILL_RING, &fillSize, sizeof(fillSize)) < 0
+		|| setsockopt(rawsock->sock, SOL_XDP, XDP_UMEM_COMPLETION_RING, &compSize, sizeof(compSize)) < 0
+		|| (rx_mode && setsockopt(rawsock->sock, SOL_XDP, XDP_RX_RING, &rawsock->rxFrameCount, sizeof(U32)) < 0)
+		|| (tx_mode && setsockopt(rawsock->sock, SOL_XDP, XDP_TX_RING, &rawsock->txFrameCount, sizeof(U32)) < 0)) {
+		AVB_LOGF_ERROR("Creating rawsock; ring setup: %s", strerror(errno));
+		xdpRawsockClose(rawsock);
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
+		return NULL;
+	}
+
+	struct xdp_mmap_offsets off;
+	socklen_t optlen = sizeof(off);
+	if (getsockopt(rawsock->sock, SOL_XDP, XDP_MMAP_OFFSETS, &off, &optlen) < 0) {
+		AVB_LOGF_ERROR("Creating rawsock; MMAP_OFFSETS: %s", strerror(errno));
+		xdpRawsockClose(rawsock);
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
+		return NULL;
+	}
+
+	if (!xdpRingMap(rawsock, &rawsock->fill, &off.fr, fillSize, sizeof(U64), XDP_UMEM_PGOFF_FILL_RING)
+		|| !xdpRingMap(rawsock, &rawsock->comp, &off.cr, compSize, sizeof(U64), XDP_UMEM_PGOFF_COMPLETION_RING)
+		|| (rx_mode && !xdpRingMap(rawsock, &rawsock->rx, &off.rx, rawsock->rxFrameCount, sizeof(struct xdp_desc), XDP_PGOFF_RX_RING))
+		|| (tx_mode && !xdpRingMap(rawsock, &rawsock->tx, &off.tx, rawsock->txFrameCount, sizeof(struct xdp_desc), XDP_PGOFF_TX_RING))) {
+		AVB_LOGF_ERROR("Creating rawsock; ring MMAP: %s", strerror(errno));
+		xdpRawsockClose(rawsock);
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
+		return NULL;
+	}
+
+	// Hand all RX chunks to the kernel, and keep the TX chunks for us
+	U32 i;
+	for (i = 0; i < rawsock->rxFrameCount; i++) {
+		xdpFillChunk(rawsock, (U64)i * XDP_RAWSOCK_CHUNK_SIZE);
+	}
+	if (tx_mode) {
+		rawsock->txFree = calloc(rawsock->txFrameCount, sizeof(U64));
+		if (!rawsock->txFree) {
+			AVB_LOG_ERROR("Creating rawsock; malloc failed");
+			xdpRawsockClose(rawsock);
+			AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
+			return NULL;
+		}
+		for (i = 0; i < rawsock->txFrameCount; i++) {
+			rawsock->txFree[i] = (U64)(rawsock->rxFrameCount + i) * XDP_RAWSOCK_CHUNK_SIZE;
+		}
+		rawsock->txFreeCount = rawsock->txFrameCount;
+	}
+
+	// Bind to the interface queue. Zero-copy needs driver support,
+	// copy mode works everywhere, need-wakeup needs kernel 5.4.
+	struct sockaddr_xdp sxdp;
+	U16 bindFlags[] = { XDP_ZEROCOPY | XDP_USE_NEED_WAKEUP, XDP_COPY | XDP_USE_NEED_WAKEUP, XDP_COPY };
+	int ret = -1;
+	for (i = 0; i < 3 && ret < 0; i++) {
+		memset(&sxdp, 0, sizeof(sxdp));
+		sxdp.sxdp_family = AF_XDP;
+		sxdp.sxdp_ifindex = rawsock->base.ifInfo.index;
+		sxdp.sxdp_queue_id = rawsock->queueId;
+		sxdp.sxdp_flags = bindFlags[i];
+		ret = bind(rawsock->sock, (struct sockaddr*)&sxdp, sizeof(sxdp));
+		if (ret == 0) {
+			rawsock->bNeedWakeup = (bindFlags[i] & XDP_USE_NEED_WAKEUP) != 0;
+			AVB_LOGF_INFO("AF_XDP socket bound to %s queue %d (%s)", ifname, rawsock->queueId,
+						  (bindFlags[i] & XDP_ZEROCOPY) ? "zero-copy" : "copy");
+		}
+	}
+	if (ret < 0) {
+		AVB_LOGF_ERROR("Creating rawsock; bind socket: %s", strerror(errno));
+		xdpRawsockClose(rawsock);
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
+		return NULL;
+	}
+
+	if (rx_mode) {
+		if (!xdpAttachProg(rawsock)) {
+			xdpRawsockClose(rawsock);
+			AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
+			return NULL;
+		}
+
+		// AF_XDP sockets can't join multicast groups, so keep a packet
+		// socket around for that. Protocol 0 means it receives nothing.
+		rawsock->mcastSock = socket(PF_PACKET, SOCK_RAW, 0);
+		if (rawsock->mcastSock == -1) {
+			AVB_LOGF_ERROR("Creating rawsock; opening socket: %s", strerror(errno));
+			xdpRawsockClose(rawsock);
+			AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
+			return NULL;
+		}
+	}
+
+	rawsock->buffersOut = 0;
+	rawsock->buffersReady = 0;
+	rawsock->rxBuffersOut = 0;
+
+	// fill virtual functions table
+	rawsock_cb_t *cb = &rawsock->base.cb;
+	cb->close = xdpRawsockClose;
+	cb->getTxFrame = xdpRawsockGetTxFrame;
+	cb->relTxFrame = xdpRawsockRelTxFrame;
+	cb->txFrameReady = xdpRawsockTxFrameReady;
+	cb->send = xdpRawsockSend;
+	cb->txFrameCount = xdpRawsockTxFrameCount;
+	cb->txBufLevel = xdpRawsockTxBufLevel;
+	cb->rxBufLevel = xdpRawsockRxBufLevel;
+	cb->getRxFrame = xdpRawsockGetRxFrame;
+	cb->relRxFrame = xdpRawsockRelRxFrame;
+	cb->rxMulticast = xdpRawsockRxMulticast;
+	cb->getSocket = xdpRawsockGetSocket;
+	cb->getTXOutOfBuffers = xdpRawsockGetTXOutOfBuffers;
+	cb->getTXOutOfBuffersCyclic = xdpRawsockGetTXOutOfBuffersCyclic;
+
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
+	return rawsock;
+}
+
+// Close the rawsock
+void xdpRawsockClose(void *pvRawsock)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK);
+	xdp_rawsock_t *rawsock = (xdp_rawsock_t*)pvRawsock;
+
+	if (rawsock) {
+		// detach the XDP program first, so the kernel stops using the socket
+		if (rawsock->linkFd != -1) {
+			close(rawsock->linkFd);
+			rawsock->linkFd = -1;
+		}
+		if (rawsock->progFd != -1) {
+			close(rawsock->progFd);
+			rawsock->progFd = -1;
+		}
+		if (rawsock->mapFd != -1) {
+			close(rawsock->mapFd);
+			rawsock->mapFd = -1;
+		}
+		if (rawsock->mcastSock != -1) {
+			close(rawsock->mcastSock);
+			rawsock->mcastSock = -1;
+		}
+
+		xdpRingUnmap(&rawsock->fill);
+		xdpRingUnmap(&rawsock->comp);
+		xdpRingUnmap(&rawsock->rx);
+		xdpRingUnmap(&rawsock->tx);
+
+		if (rawsock->sock != -1) {
+			close(rawsock->sock);
+			rawsock->sock = -1;
+		}
+
+		if (rawsock->pUmem != (void*)(-1)) {
+			munmap(rawsock->pUmem, rawsock->umemSize);
+			rawsock->pUmem = (void*)(-1);
+		}
+
+		free(rawsock->txFree);
+		rawsock->txFree = NULL;
+	}
+
+	baseRawsockClose(rawsock);
+
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
+}
+
+// Get a buffer from the UMEM to use for TX
+U8* xdpRawsockGetTxFrame(void *pvRawsock, bool blocking, unsigned int *len)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK_DETAIL);
+	xdp_rawsock_t *rawsock = (xdp_rawsock_t*)pvRawsock;
+
+	// Displays only warning when buffer busy after second try
+	int bBufferBusyReported = 0;
+
+	if (!VALID_TX_RAWSOCK(rawsock)) {
+		AVB_LOG_ERROR("Getting TX frame; bad arguments");
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+		return NULL;
+	}
+
+	while (rawsock->txFreeCount == 0) {
+		xdpReclaimTx(rawsock);
+		if (rawsock->txFreeCount > 0)
+			break;
+
+		if (!blocking) {
+			AVB_LOG_DEBUG("Non-blocking, return NULL");
+			AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+			return NULL;
+		}
+
+		if (0 == bBufferBusyReported) {
+			if (!rawsock->txOutOfBuffer) {
+				// Display this info only once just to let know that something like this happened
+				AVB_LOGF_INFO("Getting TX frame (sock=%d): TX buffer busy", rawsock->sock);
+			}
+
+			++rawsock->txOutOfBuffer;
+			++rawsock->txOutOfBufferCyclic;
+		} else if (1 == bBufferBusyReported) {
+			//Display this warning if buffer was busy more than once because it might influence late/lost
+			AVB_LOGF_WARNING("Getting TX frame (sock=%d): TX buffer busy after usleep(50) verify if there are any lost/late frames", rawsock->sock);
+		}
+
+		++bBufferBusyReported;
+
+		// Make sure the kernel works on what we queued
+		xdpKickTx(rawsock);
+		usleep(50);
+	}
+
+	U64 addr = rawsock->txFree[--rawsock->txFreeCount];
+	rawsock->buffersOut += 1;
+
+	// Remind client how big the frame buffer is
+	if (len)
+		*len = rawsock->base.frameSize;
+
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+	return rawsock->pUmem + addr;
+}
+
+// Release a TX frame, without marking it as ready to send
+bool xdpRawsockRelTxFrame(void *pvRawsock, U8 *pBuffer)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK_DETAIL);
+	xdp_rawsock_t *rawsock = (xdp_rawsock_t*)pvRawsock;
+	if (!VALID_TX_RAWSOCK(rawsock) || pBuffer == NULL) {
+		AVB_LOG_ERROR("Releasing TX frame; invalid argument");
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+		return FALSE;
+	}
+
+	rawsock->txFree[rawsock->txFreeCount++] = pBuffer - rawsock->pUmem;
+	rawsock->buffersOut -= 1;
+
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+	return TRUE;
+}
+
+// Release a TX frame, and mark it as ready to send
+bool xdpRawsockTxFrameReady(void *pvRawsock, U8 *pBuffer, unsigned int len, U64 timeNsec)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK_DETAIL);
+	xdp_rawsock_t *rawsock = (xdp_rawsock_t*)pvRawsock;
+
+	if (!VALID_TX_RAWSOCK(rawsock) || pBuffer == NULL) {
+		AVB_LOG_ERROR("Marking TX frame ready; invalid argument");
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+		return FALSE;
+	}
+
+	if (timeNsec) {
+		IF_LOG_INTERVAL(1000) AVB_LOG_WARNING("launch time is unsupported in xdp_rawsock");
+	}
+
+	assert(len <= rawsock->base.frameSize);
+
+	// The TX ring holds as many entries as there are TX chunks,
+	// so there is always room for a chunk we handed out.
+	U32 prod = *rawsock->tx.producer;
+	struct xdp_desc *pDesc = &((struct xdp_desc*)rawsock->tx.ring)[prod & rawsock->tx.mask];
+	pDesc->addr = pBuffer - rawsock->pUmem;
+	pDesc->len = len;
+	pDesc->options = 0;
+	XDP_RING_STORE_REL(rawsock->tx.producer, prod + 1);
+
+	rawsock->buffersOut -= 1;
+	rawsock->buffersReady += 1;
+
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+	return TRUE;
+}
+
+// Send all packets that are ready (i.e. tell kernel to send them)
+int xdpRawsockSend(void *pvRawsock)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK_DETAIL);
+	xdp_rawsock_t *rawsock = (xdp_rawsock_t*)pvRawsock;
+	if (!VALID_TX_RAWSOCK(rawsock)) {
+		AVB_LOG_ERROR("Send; invalid argument");
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+		return -1;
+	}
+
+	int sent = rawsock->buffersReady;
+	if (sent > 0) {
+		xdpKickTx(rawsock);
+		rawsock->buffersReady = 0;
+	}
+
+	// Collect the frames sent so far
+	xdpReclaimTx(rawsock);
+
+	AVB_LOGF_VERBOSE("Queued %d frames", sent);
+
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+	return sent;
+}
+
+// Number of TX frames that can be held at once
+int xdpRawsockTxFrameCount(void *pvRawsock)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK_DETAIL);
+	xdp_rawsock_t *rawsock = (xdp_rawsock_t*)pvRawsock;
+
+	if (!VALID_TX_RAWSOCK(rawsock)) {
+		AVB_LOG_ERROR("getting TX frame count; invalid arguments");
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+		return 0;
+	}
+
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+	return rawsock->txFrameCount;
+}
+
+// Count TX buffers queued to the kernel and not yet completed
+int xdpRawsockTxBufLevel(void *pvRawsock)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK_DETAIL);
+	xdp_rawsock_t *rawsock = (xdp_rawsock_t*)pvRawsock;
+
+	if (!VALID_TX_RAWSOCK(rawsock)) {
+		AVB_LOG_ERROR("getting buffer level; invalid arguments");
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+		return FALSE;
+	}
+
+	xdpReclaimTx(rawsock);
+	int nInUse = rawsock->txFrameCount - rawsock->txFreeCount - rawsock->buffersOut;
+
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+	return nInUse;
+}
+
+// Count received frames not yet handed out
+int xdpRawsockRxBufLevel(void *pvRawsock)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK_DETAIL);
+	xdp_rawsock_t *rawsock = (xdp_rawsock_t*)pvRawsock;
+
+	if (!VALID_RX_RAWSOCK(rawsock)) {
+		AVB_LOG_ERROR("getting buffer level; invalid arguments");
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+		return FALSE;
+	}
+
+	int nInUse = XDP_RING_LOAD_ACQ(rawsock->rx.producer) - *rawsock->rx.consumer;
+
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+	return nInUse;
+}
+
+// Get a RX frame
+U8* xdpRawsockGetRxFrame(void *pvRawsock, U32 timeout, unsigned int *offset, unsigned int *len)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK_DETAIL);
+	xdp_rawsock_t *rawsock = (xdp_rawsock_t*)pvRawsock;
+	if (!VALID_RX_RAWSOCK(rawsock)) {
+		AVB_LOG_ERROR("Getting RX frame; invalid arguments");
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+		return NULL;
+	}
+
+	U32 cons = *rawsock->rx.consumer;
+	if (XDP_RING_LOAD_ACQ(rawsock->rx.producer) == cons) {
+		struct timespec ts, *pts = NULL;
+		struct pollfd pfd;
+
+		// Use poll to wait for "ready to read" condition.  This also
+		// wakes the driver up to refill, if it asked for that.
+		if (timeout != OPENAVB_RAWSOCK_BLOCK) {
+			ts.tv_sec = timeout / MICROSECONDS_PER_SECOND;
+			ts.tv_nsec = (timeout % MICROSECONDS_PER_SECOND) * NANOSECONDS_PER_USEC;
+			pts = &ts;
+		}
+
+		pfd.fd = rawsock->sock;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+
+		int ret = ppoll(&pfd, 1, pts, NULL);
+		if (ret < 0) {
+			if (errno != EINTR) {
+				AVB_LOGF_ERROR("Getting RX frame; poll failed: %s", strerror(errno));
+			}
+			AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+			return NULL;
+		}
+		if (XDP_RING_LOAD_ACQ(rawsock->rx.producer) == cons) {
+			// timeout
+			AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+			return NULL;
+		}
+	}
+
+	// The chunk stays ours until it goes back on the fill ring
+	struct xdp_desc *pDesc = &((struct xdp_desc*)rawsock->rx.ring)[cons & rawsock->rx.mask];
+	U8 *pBuffer = rawsock->pUmem + pDesc->addr;
+	*offset = 0;
+	*len = pDesc->len;
+	XDP_RING_STORE_REL(rawsock->rx.consumer, cons + 1);
+
+	rawsock->rxBuffersOut += 1;
+
+	AVB_LOGF_VERBOSE("Good RX frame (len %d)", *len);
+
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+	return pBuffer;
+}
+
+// Release a RX frame held by the client
+bool xdpRawsockRelRxFrame(void *pvRawsock, U8 *pBuffer)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK_DETAIL);
+	xdp_rawsock_t *rawsock = (xdp_rawsock_t*)pvRawsock;
+
+	if (!VALID_RX_RAWSOCK(rawsock) || pBuffer == NULL) {
+		AVB_LOG_ERROR("Releasing RX frame; invalid arguments");
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+		return FALSE;
+	}
+
+	// Give the whole chunk back to the kernel
+	U64 addr = (pBuffer - rawsock->pUmem) & ~((U64)XDP_RAWSOCK_CHUNK_SIZE - 1);
+	xdpFillChunk(rawsock, addr);
+	rawsock->rxBuffersOut -= 1;
+
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+	return TRUE;
+}
+
+// Setup the rawsock to receive multicast packets
+bool xdpRawsockRxMulticast(void *pvRawsock, bool add_membership, const U8 addr[ETH_ALEN])
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK_DETAIL);
+
+	xdp_rawsock_t *rawsock = (xdp_rawsock_t*)pvRawsock;
+	if (!VALID_RX_RAWSOCK(rawsock)) {
+		AVB_LOG_ERROR("Setting multicast; invalid arguments");
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+		return FALSE;
+	}
+
+	// Fill in the structure for the multicast ioctl
+	struct packet_mreq mreq;
+	memset(&mreq, 0, sizeof(struct packet_mreq));
+	mreq.mr_ifindex = rawsock->base.ifInfo.index;
+	mreq.mr_type = PACKET_MR_MULTICAST;
+	mreq.mr_alen = ETH_ALEN;
+	memcpy(&mreq.mr_address, addr, ETH_ALEN);
+
+	// And call the ioctl to add/drop the multicast address
+	int action = (add_membership ? PACKET_ADD_MEMBERSHIP : PACKET_DROP_MEMBERSHIP);
+	if (setsockopt(rawsock->mcastSock, SOL_PACKET, action,
+					(void*)&mreq, sizeof(struct packet_mreq)) < 0) {
+		AVB_LOGF_ERROR("Setting multicast; setsockopt(%s) failed: %s",
+					   (add_membership ? "PACKET_ADD_MEMBERSHIP" : "PACKET_DROP_MEMBERSHIP"),
+					   strerror(errno));
+
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+		return FALSE;
+	}
+
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+	return TRUE;
+}
+
+// Get the socket used for this rawsock; can be used for poll/select
+int xdpRawsockGetSocket(void *pvRawsock)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK);
+	xdp_rawsock_t *rawsock = (xdp_rawsock_t*)pvRawsock;
+	if (!rawsock) {
+		AVB_LOG_ERROR("Getting socket; invalid arguments");
+		AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
+		return -1;
+	}
+
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
+	return rawsock->sock;
+}
+
+unsigned long xdpRawsockGetTXOutOfBuffers(void *pvRawsock)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK);
+	unsigned long counter = 0;
+	xdp_rawsock_t *rawsock = (xdp_rawsock_t*)pvRawsock;
+
+	if(VALID_TX_RAWSOCK(rawsock)) {
+		counter = rawsock->txOutOfBuffer;
+	}
+
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
+	return counter;
+}
+
+unsigned long xdpRawsockGetTXOutOfBuffersCyclic(void *pvRawsock)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK);
+	unsigned long counter = 0;
+	xdp_rawsock_t *rawsock = (xdp_rawsock_t*)pvRawsock;
+
+	if(VALID_TX_RAWSOCK(rawsock)) {
+		counter = rawsock->txOutOfBufferCyclic;
+		rawsock->txOutOfBufferCyclic = 0;
+	}
+
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
+	return counter;
+}
@@ -0,0 +1,158 @@
+/*************************************************************************************************************
+Copyright (c) 2012-2015, Symphony Teleca Corporation, a Harman International Industries, Incorporated company
+Copyright (c) 2016-2017, Harman International Industries, Incorporated
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS LISTED "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS LISTED BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Attributions: The inih library portion of the source code is licensed from
+Brush Technology and Ben Hoyt - Copyright (c) 2009, Brush Technology and Copyright (c) 2009, Ben Hoyt.
+Complete license and copyright information can be found at
+https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
+*************************************************************************************************************/
+
+#ifndef XDP_RAWSOCK_H
+#define XDP_RAWSOCK_H
+
+#include <linux/if_xdp.h>
+
+#include "rawsock_impl.h"
+
+// Size of one frame buffer in the UMEM
+#define XDP_RAWSOCK_CHUNK_SIZE 2048
+// Smallest number of frames in each direction
+#define XDP_RAWSOCK_MIN_FRAMES 64
+// NIC queue the socket is bound to
+#define XDP_RAWSOCK_QUEUE_ID 0
+
+// Producer/consumer ring shared with the kernel
+typedef struct {
+	U32 *producer;
+	U32 *consumer;
+	U32 *flags;
+	void *ring;
+	U32 size;
+	U32 mask;
+
+	// the mmap'ed memory holding the ring
+	void *pMap;
+	size_t mapSize;
+} xdp_ring_t;
+
+// State information for raw socket
+//
+typedef struct {
+	base_rawsock_t base;
+
+	// the AF_XDP socket
+	int sock;
+
+	// packet socket used for multicast membership only
+	int mcastSock;
+
+	// NIC queue bound to the socket
+	int queueId;
+
+	// memory shared with the kernel, split into chunks of
+	// XDP_RAWSOCK_CHUNK_SIZE - RX chunks first, then TX chunks
+	U8 *pUmem;
+	size_t umemSize;
+
+	// number of RX and TX chunks
+	U32 rxFrameCount;
+	U32 txFrameCount;
+
+	// kernel rings
+	xdp_ring_t fill;
+	xdp_ring_t comp;
+	xdp_ring_t rx;
+	xdp_ring_t tx;
+
+	// kernel must be woken up through the socket when it asks for it
+	bool bNeedWakeup;
+
+	// XDP program steering our frames to the socket
+	int mapFd;
+	int progFd;
+	int linkFd;
+
+	// TX chunks not in use by the client or the kernel
+	U64 *txFree;
+	U32 txFreeCount;
+
+	// Number of TX buffers held by client
+	int buffersOut;
+	// TX buffers queued, but not yet kicked
+	int buffersReady;
+
+	// Number of RX buffers held by client
+	int rxBuffersOut;
+
+	// Number of TX buffers we experienced problems with
+	unsigned long txOutOfBuffer;
+	// Number of TX buffers we experienced problems with from the time when last stats being displayed
+	unsigned long txOutOfBufferCyclic;
+} xdp_rawsock_t;
+
+// Open a rawsock for TX or RX
+void* xdpRawsockOpen(xdp_rawsock_t *rawsock, const char *ifname, bool rx_mode, bool tx_mode, U16 ethertype, U32 frame_size, U32 num_frames);
+
+// Close the rawsock
+void xdpRawsockClose(void *pvRawsock);
+
+// Get a buffer from the UMEM to use for TX
+U8* xdpRawsockGetTxFrame(void *pvRawsock, bool blocking, unsigned int *len);
+
+// Release a TX frame, without marking it as ready to send
+bool xdpRawsockRelTxFrame(void *pvRawsock, U8 *pBuffer);
+
+// Release a TX frame, and mark it as ready to send
+bool xdpRawsockTxFrameReady(void *pvRawsock, U8 *pBuffer, unsigned int len, U64 timeNsec);
+
+// Send all packets that are ready (i.e. tell kernel to send them)
+int xdpRawsockSend(void *pvRawsock);
+
+// Number of TX frames that can be held at once
+int xdpRawsockTxFrameCount(void *pvRawsock);
+
+// Count TX buffers queued to the kernel and not yet completed
+int xdpRawsockTxBufLevel(void *pvRawsock);
+
+// Count received frames not yet handed out
+int xdpRawsockRxBufLevel(void *pvRawsock);
+
+// Get a RX frame
+U8* xdpRawsockGetRxFrame(void *pvRawsock, U32 timeout, unsigned int *offset, unsigned int *len);
+
+// Release a RX frame held by the client
+bool xdpRawsockRelRxFrame(void *pvRawsock, U8 *pBuffer);
+
+// Setup the rawsock to receive multicast packets
+bool xdpRawsockRxMulticast(void *pvRawsock, bool add_membership, const U8 addr[ETH_ALEN]);
+
+// Get the socket used for this rawsock; can be used for poll/select
+int xdpRawsockGetSocket(void *pvRawsock);
+
+unsigned long xdpRawsockGetTXOutOfBuffers(void *pvRawsock);
+
+unsigned long xdpRawsockGetTXOutOfBuffersCyclic(void *pvRawsock);
+
+#endif
@@ -0,0 +1,319 @@
+/*************************************************************************************************************
+Copyright (c) 2012-2015, Symphony Teleca Corporation, a Harman International Industries, Incorporated company
+Copyright (c) 2016-2017, Harman International Industries, Incorporated
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS LISTED "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS LISTED BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Attributions: The inih library portion of the source code is licensed from
+Brush Technology and Ben Hoyt - Copyright (c) 2009, Brush Technology and Copyright (c) 2009, Ben Hoyt.
+Complete license and copyright information can be found at
+https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
+*************************************************************************************************************/
+
+/*
+* MODULE SUMMARY : Serves the talker and listener metrics over HTTP on a unix
+* or TCP socket, for scraping by Prometheus.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+
+#include "openavb_platform.h"
+#include "openavb_osal.h"
+#include "openavb_trace.h"
+#include "openavb_tl.h"
+
+#define	AVB_LOG_COMPONENT	"Talker / Listener"
+#include "openavb_log.h"
+
+// How often the server thread checks for shutdown
+#define METRICS_POLL_MSEC			200
+// Longest a client may take to send its request or read the reply
+#define METRICS_CLIENT_TIMEOUT_SEC	2
+// Longest request header that is read before replying
+#define METRICS_REQUEST_SIZE		2048
+#define METRICS_UNIX_PREFIX			"unix:"
+#define METRICS_DEFAULT_HOST		"127.0.0.1"
+
+static int metricsSock = -1;
+static char metricsUnixPath[sizeof(((struct sockaddr_un *)0)->sun_path)];
+static bool bMetricsRunning = FALSE;
+static pthread_t metricsThread;
+
+static bool metricsWriteAll(int sock, const char *pBuf, size_t len)
+{
+	while (len > 0) {
+		ssize_t n = send(sock, pBuf, len, MSG_NOSIGNAL);
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return FALSE;
+		}
+		pBuf += n;
+		len -= n;
+	}
+	return TRUE;
+}
+
+static void metricsServeClient(int sock)
+{
+	char request[METRICS_REQUEST_SIZE];
+	size_t reqLen = 0;
+	struct timeval tv = { METRICS_CLIENT_TIMEOUT_SEC, 0 };
+
+	setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+	setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+	// Whatever is asked for, the reply is the metrics; just wait for the end of the header.
+	while (reqLen < sizeof(request) - 1) {
+		ssize_t n = recv(sock, request + reqLen, sizeof(request) - 1 - reqLen, 0);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			break;
+		}
+		reqLen += n;
+		request[reqLen] = '\0';
+		if (strstr(request, "\r\n\r\n") || strstr(request, "\n\n")) {
+			break;
+		}
+	}
+
+	size_t bodyLen = 0;
+	char *pBody = openavbTLMetricsRender(&bodyLen);
+	char header[160];
+	int headerLen;
+	if (pBody) {
+		headerLen = snprintf(header, sizeof(header),
+			"HTTP/1.0 200 OK\r\n"
+			"Content-Type: text/plain; version=0.0.4\r\n"
+			"Content-Length: %zu\r\n"
+			"\r\n", bodyLen);
+	}
+	else {
+		headerLen = snprintf(header, sizeof(header),
+			"HTTP/1.0 500 Internal Server Error\r\n"
+			"Content-Length: 0\r\n"
+			"\r\n");
+	}
+
+	if (metricsWriteAll(sock, header, headerLen) && pBody) {
+		metricsWriteAll(sock, pBody, bodyLen);
+	}
+	free(pBody);
+}
+
+static void *metricsThreadFn(void *pv)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_TL);
+
+	while (__atomic_load_n(&bMetricsRunning, __ATOMIC_RELAXED)) {
+		struct pollfd pfd = { metricsSock, POLLIN, 0 };
+		int rslt = poll(&pfd, 1, METRICS_POLL_MSEC);
+		if (rslt <= 0) {
+			if (rslt < 0 && errno != EINTR) {
+				AVB_LOGF_ERROR("Metrics poll failed: %s", strerror(errno));
+				SLEEP_MSEC(METRICS_POLL_MSEC);
+			}
+			continue;
+		}
+
+		int client = accept(metricsSock, NULL, NULL);
+		if (client < 0) {
+			continue;
+		}
+		metricsServeClient(client);
+		close(client);
+	}
+
+	AVB_TRACE_EXIT(AVB_TRACE_TL);
+	return NULL;
+}
+
+static int metricsOpenUnix(const char *path)
+{
+	struct sockaddr_un addr;
+
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		AVB_LOGF_ERROR("Metrics socket path too long: %s", path);
+		return -1;
+	}
+
+	int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (sock < 0) {
+		AVB_LOGF_ERROR("Unable to create metrics socket: %s", strerror(errno));
+		return -1;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+
+	// Remove the socket left behind by an earlier run
+	unlink(path);
+	if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		AVB_LOGF_ERROR("Unable to bind metrics socket %s: %s", path, strerror(errno));
+		close(sock);
+		return -1;
+	}
+
+	strncpy(metricsUnixPath, path, sizeof(metricsUnixPath) - 1);
+	return sock;
+}
+
+static int metricsOpenTCP(const char *hostPort)
+{
+	char host[256];
+	const char *port = hostPort;
+	const char *colon = strrchr(hostPort, ':');
+	struct addrinfo hints, *pInfo;
+	int sock = -1;
+
+	if (colon) {
+		size_t len = colon - hostPort;
+		if (len >= sizeof(host)) {
+			AVB_LOGF_ERROR("Invalid metrics address: %s", hostPort);
+			return -1;
+		}
+		memcpy(host, hostPort, len);
+		host[len] = '\0';
+		port = colon + 1;
+	}
+	else {
+		strcpy(host, METRICS_DEFAULT_HOST);
+	}
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_PASSIVE;
+	int err = getaddrinfo(host, port, &hints, &pInfo);
+	if (err) {
+		AVB_LOGF_ERROR("Invalid metrics address %s: %s", hostPort, gai_strerror(err));
+		return -1;
+	}
+
+	sock = socket(pInfo->ai_family, pInfo->ai_socktype, pInfo->ai_protocol);
+	if (sock < 0) {
+		AVB_LOGF_ERROR("Unable to create metrics socket: %s", strerror(errno));
+		freeaddrinfo(pInfo);
+		return -1;
+	}
+
+	int on = 1;
+	setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+	if (bind(sock, pInfo->ai_addr, pInfo->ai_addrlen) < 0) {
+		AVB_LOGF_ERROR("Unable to bind metrics socket %s: %s", hostPort, strerror(errno));
+		close(sock);
+		sock = -1;
+	}
+
+	freeaddrinfo(pInfo);
+	return sock;
+}
+
+EXTERN_DLL_EXPORT bool openavbTLMetricsStart(const char *addr)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_TL);
+
+	if (!addr || bMetricsRunning) {
+		AVB_LOG_ERROR("Invalid metrics address or metrics server already running");
+		AVB_TRACE_EXIT(AVB_TRACE_TL);
+		return FALSE;
+	}
+
+	metricsUnixPath[0] = '\0';
+	if (strncmp(addr, METRICS_UNIX_PREFIX, strlen(METRICS_UNIX_PREFIX)) == 0) {
+		metricsSock = metricsOpenUnix(addr + strlen(METRICS_UNIX_PREFIX));
+	}
+	else {
+		metricsSock = metricsOpenTCP(addr);
+	}
+	if (metricsSock < 0) {
+		AVB_TRACE_EXIT(AVB_TRACE_TL);
+		return FALSE;
+	}
+
+	if (listen(metricsSock, 8) < 0) {
+		AVB_LOGF_ERROR("Unable to listen on metrics socket: %s", strerror(errno));
+		openavbTLMetricsStop();
+		AVB_TRACE_EXIT(AVB_TRACE_TL);
+		return FALSE;
+	}
+
+	// Don't inherit a real-time policy from the creating thread
+	pthread_attr_t attr;
+	struct sched_param param;
+	memset(&param, 0, sizeof(param));
+	pthread_attr_init(&attr);
+	pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+	pthread_attr_setschedpolicy(&attr, SCHED_OTHER);
+	pthread_attr_setschedparam(&attr, &param);
+
+	bMetricsRunning = TRUE;
+	int err = pthread_create(&metricsThread, &attr, metricsThreadFn, NULL);
+	pthread_attr_destroy(&attr);
+	if (err) {
+		AVB_LOGF_ERROR("Unable to start the metrics thread: %s", strerror(err));
+		bMetricsRunning = FALSE;
+		openavbTLMetricsStop();
+		AVB_TRACE_EXIT(AVB_TRACE_TL);
+		return FALSE;
+	}
+
+	AVB_LOGF_INFO("Serving metrics on %s", addr);
+	AVB_TRACE_EXIT(AVB_TRACE_TL);
+	return TRUE;
+}
+
+EXTERN_DLL_EXPORT void openavbTLMetricsStop(void)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_TL);
+
+	if (bMetricsRunning) {
+		__atomic_store_n(&bMetricsRunning, FALSE, __ATOMIC_RELAXED);
+		pthread_join(metricsThread, NULL);
+	}
+
+	if (metricsSock >= 0) {
+		close(metricsSock);
+		metricsSock = -1;
+	}
+
+	if (metricsUnixPath[0]) {
+		unlink(metricsUnixPath);
+		metricsUnixPath[0] = '\0';
+	}
+
+	AVB_TRACE_EXIT(AVB_TRACE_TL);
+}
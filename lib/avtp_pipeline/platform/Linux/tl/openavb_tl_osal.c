@@ -49,6 +49,7 @@ https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
 #include "openavb_rawsock.h"
 #include "openavb_mediaq.h"
 #include "openavb_tl.h"
+#include "openavb_talker_sched.h"
 #include "openavb_avtp.h"
 
 #define	AVB_LOG_COMPONENT	"Talker / Listener"
@@ -377,6 +378,84 @@ static int openavbTLCfgCallback(void *user, const char *tlSection, const char *n
 			valOK = TRUE;
 		}
 	}
+	else if (MATCH(name, "mediaq_lockless")) {
+		errno = 0;
+		long tmp;
+		tmp = strtol(value, &pEnd, 0);
+		if (*pEnd == '\0' && errno == 0) {
+			pCfg->mediaq_lockless = (tmp == 1);
+			valOK = TRUE;
+		}
+	}
+	else if (MATCH(name, "tx_sched_group")) {
+		errno = 0;
+		long tmp;
+		tmp = strtol(value, &pEnd, 0);
+		if (*pEnd == '\0' && errno == 0
+			&& tmp >= 0
+			&& tmp <= TALKER_SCHED_MAX_GROUPS) {
+			pCfg->tx_sched_group = tmp;
+			valOK = TRUE;
+		}
+	}
+	else if (MATCH(name, "rx_demux")) {
+		errno = 0;
+		long tmp;
+		tmp = strtol(value, &pEnd, 0);
+		if (*pEnd == '\0' && errno == 0) {
+			pCfg->rx_demux = (tmp == 1);
+			valOK = TRUE;
+		}
+	}
+	else if (MATCH(name, "tx_launch_time")) {
+		errno = 0;
+		long tmp;
+		tmp = strtol(value, &pEnd, 0);
+		if (*pEnd == '\0' && errno == 0) {
+			pCfg->tx_launch_time = (tmp == 1);
+			valOK = TRUE;
+		}
+	}
+	else if (MATCH(name, "tx_launch_lead_usec")) {
+		errno = 0;
+		long tmp;
+		tmp = strtol(value, &pEnd, 10);
+		if (*pEnd == '\0' && errno == 0
+			&& tmp >= 0
+			&& tmp <= MICROSECONDS_PER_SECOND) {
+			pCfg->tx_launch_lead_usec = tmp;
+			valOK = TRUE;
+		}
+	}
+	else if (MATCH(name, "tx_intf_wakeup")) {
+		errno = 0;
+		long tmp;
+		tmp = strtol(value, &pEnd, 0);
+		if (*pEnd == '\0' && errno == 0) {
+			pCfg->tx_intf_wakeup = (tmp == 1);
+			valOK = TRUE;
+		}
+	}
+	else if (MATCH(name, "rx_timestamp")) {
+		errno = 0;
+		long tmp;
+		tmp = strtol(value, &pEnd, 0);
+		if (*pEnd == '\0' && errno == 0) {
+			pCfg->rx_timestamp = (tmp == 1);
+			valOK = TRUE;
+		}
+	}
+	else if (MATCH(name, "flight_events")) {
+		errno = 0;
+		long tmp;
+		tmp = strtol(value, &pEnd, 0);
+		if (*pEnd == '\0' && errno == 0
+			&& tmp >= 0
+			&& tmp <= AVTP_FLIGHT_MAX_EVENTS) {
+			pCfg->flight_events = tmp;
+			valOK = TRUE;
+		}
+	}
 
 	else if (MATCH(name, "friendly_name")) {
 		strncpy(pCfg->friendly_name, value, FRIENDLY_NAME_SIZE - 1);
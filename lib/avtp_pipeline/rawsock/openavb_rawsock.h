@@ -63,6 +63,7 @@ typedef struct {
 	U8  vlan_pcp;	// VLAN Priority Code Point
 	U16 vlan_vid;	// VLAN ID
 	struct timespec ts;	// RX timestamp
+	bool ts_hw;		// ts is from the network card clock, otherwise CLOCK_REALTIME
 } hdr_info_t;
 	
 	
@@ -111,6 +112,11 @@ int openavbRawsockRxParseHdr(void* rawsock, U8 *pBuffer, hdr_info_t *pInfo);
 // Release the received frame for re-use.
 bool openavbRawsockRelRxFrame(void *rawsock, U8 *pFrame);
 
+// Have the kernel (or network card, if it can) timestamp received frames.
+// The timestamp is returned in hdr_info_t by openavbRawsockRxParseHdr.
+// Returns FALSE if the implementation can't do that.
+bool openavbRawsockRxSetTimestamp(void *rawsock, bool enable);
+
 // Add (or drop) membership in link-layer multicast group
 bool openavbRawsockRxMulticast(void *rawsock, bool add_membership, const U8 buf[ETH_ALEN]);
 
@@ -133,6 +139,11 @@ bool openavbRawsockTxFillHdr(void *rawsock,
 // (used to identify packets for FQTSS in kernel)
 bool openavbRawsockTxSetMark(void *rawsock, int prio);
 
+// Have the kernel send each frame at the time passed to
+// openavbRawsockTxFrameReady (gPTP time) instead of right away.
+// Returns FALSE if the implementation can't do that.
+bool openavbRawsockTxSetLaunchTime(void *rawsock, bool enable);
+
 // Get a buffer to hold a frame for transmission.
 // Returns pointer to frame (or NULL).
 U8 *openavbRawsockGetTxFrame(void *rawsock,		// rawsock handle
@@ -148,10 +159,26 @@ bool openavbRawsockTxFrameReady(void *rawsock,	// rawsock handle
 							U32 len,	// length of frame to send
 							U64 timeNsec);	// launch time (in gPTP wall clock)
 
+// Submit a frame made of the header in the frame buffer and a payload
+// that stays in the caller's memory, and mark it "ready to send".
+// The payload must not change until the next openavbRawsockSend() returns.
+// Implementations that can't send from the caller's memory copy it.
+bool openavbRawsockTxFrameReadyRef(void *rawsock,	// rawsock handle
+							U8 *pFrame,	// pointer to frame buffer
+							U32 hdrLen,	// length of header in frame buffer
+							const U8 *pPayload,	// pointer to payload
+							U32 payloadLen,	// length of payload
+							U64 timeNsec);	// launch time (in gPTP wall clock)
+
 // Send all packets that are marked "ready to send".
 // Returns count of bytes in sent frames - or < 0 for error.
 int openavbRawsockSend(void *rawsock);
 
+// Number of TX frame buffers that can be held at the same time, i.e. gotten
+// with openavbRawsockGetTxFrame() and not yet sent. Implementations that
+// hand out the same buffer every time return 1.
+int openavbRawsockTxFrameCount(void *rawsock);
+
 // Check Tx buffer level in sockets
 int openavbRawsockTxBufLevel(void *rawsock);
 
@@ -39,13 +39,29 @@ void baseRawsockSetRxSignalMode(void *rawsock, bool rxSignalMode) {}
 int baseRawsockGetSocket(void *rawsock) { AVB_LOG_ERROR("baseRawsockGetSocket called"); return -1; }
 U8 *baseRawsockGetRxFrame(void *rawsock, U32 usecTimeout, U32 *offset, U32 *len) { AVB_LOG_ERROR("baseRawsockGetRxFrame called"); return NULL; }
 bool baseRawsockRelRxFrame(void *rawsock, U8 *pFrame) { return false; }
+bool baseRawsockRxSetTimestamp(void *rawsock, bool enable) { return false; }
 bool baseRawsockRxMulticast(void *rawsock, bool add_membership, const U8 buf[]) { return false; }
 bool baseRawsockRxAVTPSubtype(void *rawsock, U8 subtype) { return false; }
 bool baseRawsockTxSetMark(void *rawsock, int prio) { return false; }
+bool baseRawsockTxSetLaunchTime(void *rawsock, bool enable) { return false; }
 U8 *baseRawsockGetTxFrame(void *rawsock, bool blocking, U32 *size) { AVB_LOG_ERROR("baseRawsockGetTxFrame called"); return NULL; }
 bool baseRawsockRelTxFrame(void *rawsock, U8 *pBuffer) { return false; }
 bool baseRawsockTxFrameReady(void *rawsock, U8 *pFrame, U32 len, U64 timeNsec) { AVB_LOG_ERROR("baseRawsockTxFrameReady called"); return false; }
+
+// Backends that can't send from two buffers copy the payload in behind the header
+bool baseRawsockTxFrameReadyRef(void *pvRawsock, U8 *pFrame, U32 hdrLen, const U8 *pPayload, U32 payloadLen, U64 timeNsec)
+{
+	base_rawsock_t *rawsock = (base_rawsock_t*)pvRawsock;
+	if (hdrLen + payloadLen > (U32)rawsock->frameSize) {
+		AVB_LOGF_ERROR("Marking TX frame ready; %u bytes don't fit in a %d byte frame", hdrLen + payloadLen, rawsock->frameSize);
+		return false;
+	}
+	memcpy(pFrame + hdrLen, pPayload, payloadLen);
+	return rawsock->cb.txFrameReady(pvRawsock, pFrame, hdrLen + payloadLen, timeNsec);
+}
+
 int baseRawsockSend(void *rawsock) { AVB_LOG_ERROR("baseRawsockSend called"); return -1; }
+int baseRawsockTxFrameCount(void *rawsock) { return 1; }
 int baseRawsockTxBufLevel(void *rawsock) { return -1; }
 int baseRawsockRxBufLevel(void *rawsock) { return -1; }
 unsigned long baseRawsockGetTXOutOfBuffers(void *pvRawsock) { return 0; }
@@ -69,15 +85,19 @@ void* baseRawsockOpen(base_rawsock_t* rawsock, const char *ifname, bool rx_mode,
 	cb->getRxFrame = baseRawsockGetRxFrame;
 	cb->rxParseHdr = baseRawsockRxParseHdr;
 	cb->relRxFrame = baseRawsockRelRxFrame;
+	cb->rxSetTimestamp = baseRawsockRxSetTimestamp;
 	cb->rxMulticast = baseRawsockRxMulticast;
 	cb->rxAVTPSubtype = baseRawsockRxAVTPSubtype;
 	cb->txSetHdr = baseRawsockTxSetHdr;
 	cb->txFillHdr = baseRawsockTxFillHdr;
 	cb->txSetMark = baseRawsockTxSetMark;
+	cb->txSetLaunchTime = baseRawsockTxSetLaunchTime;
 	cb->getTxFrame = baseRawsockGetTxFrame;
 	cb->relTxFrame = baseRawsockRelTxFrame;
 	cb->txFrameReady = baseRawsockTxFrameReady;
+	cb->txFrameReadyRef = baseRawsockTxFrameReadyRef;
 	cb->send = baseRawsockSend;
+	cb->txFrameCount = baseRawsockTxFrameCount;
 	cb->txBufLevel = baseRawsockTxBufLevel;
 	cb->rxBufLevel = baseRawsockRxBufLevel;
 	cb->getTXOutOfBuffers = baseRawsockGetTXOutOfBuffers;
@@ -252,6 +272,16 @@ bool openavbRawsockTxSetMark(void *pvRawsock, int mark)
 	return ret;
 }
 
+bool openavbRawsockTxSetLaunchTime(void *pvRawsock, bool enable)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK);
+
+	bool ret = ((base_rawsock_t*)pvRawsock)->cb.txSetLaunchTime(pvRawsock, enable);
+
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
+	return ret;
+}
+
 bool openavbRawsockTxSetHdr(void *pvRawsock, hdr_info_t *pHdr)
 {
 	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK);
@@ -287,6 +317,18 @@ bool openavbRawsockTxFrameReady(void *pvRawsock, U8 *pBuffer, unsigned int len,
 	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK_DETAIL);
 
 	bool ret = ((base_rawsock_t*)pvRawsock)->cb.txFrameReady(pvRawsock, pBuffer, len, timeNsec);
+	AVB_TRACE_PROBE3(rawsock_tx_ready, pvRawsock, len, timeNsec);
+
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+	return ret;
+}
+
+bool openavbRawsockTxFrameReadyRef(void *pvRawsock, U8 *pBuffer, unsigned int hdrLen, const U8 *pPayload, unsigned int payloadLen, U64 timeNsec)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK_DETAIL);
+
+	bool ret = ((base_rawsock_t*)pvRawsock)->cb.txFrameReadyRef(pvRawsock, pBuffer, hdrLen, pPayload, payloadLen, timeNsec);
+	AVB_TRACE_PROBE3(rawsock_tx_ready, pvRawsock, hdrLen + payloadLen, timeNsec);
 
 	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
 	return ret;
@@ -297,6 +339,17 @@ int openavbRawsockSend(void *pvRawsock)
 	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK_DETAIL);
 
 	int ret = ((base_rawsock_t*)pvRawsock)->cb.send(pvRawsock);
+	AVB_TRACE_PROBE2(rawsock_send, pvRawsock, ret);
+
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
+	return ret;
+}
+
+int openavbRawsockTxFrameCount(void *pvRawsock)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK_DETAIL);
+
+	int ret = ((base_rawsock_t*)pvRawsock)->cb.txFrameCount(pvRawsock);
 
 	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
 	return ret;
@@ -327,6 +380,7 @@ U8 *openavbRawsockGetRxFrame(void *pvRawsock, U32 timeout, unsigned int *offset,
 	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK_DETAIL);
 
 	U8 *ret = ((base_rawsock_t*)pvRawsock)->cb.getRxFrame(pvRawsock, timeout, offset, len);
+	AVB_TRACE_PROBE2(rawsock_recv, pvRawsock, ret ? *len : 0);
 
 	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK_DETAIL);
 	return ret;
@@ -352,6 +406,16 @@ bool openavbRawsockRelRxFrame(void *pvRawsock, U8 *pBuffer)
 	return ret;
 }
 
+bool openavbRawsockRxSetTimestamp(void *pvRawsock, bool enable)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK);
+
+	bool ret = ((base_rawsock_t*)pvRawsock)->cb.rxSetTimestamp(pvRawsock, enable);
+
+	AVB_TRACE_EXIT(AVB_TRACE_RAWSOCK);
+	return ret;
+}
+
 bool openavbRawsockRxMulticast(void *pvRawsock, bool add_membership, const U8 addr[ETH_ALEN])
 {
 	AVB_TRACE_ENTRY(AVB_TRACE_RAWSOCK);
@@ -69,15 +69,19 @@ typedef struct {
 	U8* (*getRxFrame)(void* rawsock, U32 usecTimeout, U32* offset, U32* len);
 	int (*rxParseHdr)(void* rawsock, U8* pBuffer, hdr_info_t* pInfo);
 	bool (*relRxFrame)(void* rawsock, U8* pFrame);
+	bool (*rxSetTimestamp)(void* rawsock, bool enable);
 	bool (*rxMulticast)(void* rawsock, bool add_membership, const U8 buf[ETH_ALEN]);
 	bool (*rxAVTPSubtype)(void* rawsock, U8 subtype);
 	bool (*txSetHdr)(void* rawsock, hdr_info_t* pInfo);
 	bool (*txFillHdr)(void* rawsock, U8* pBuffer, U32* hdrlen);
 	bool (*txSetMark)(void* rawsock, int prio);
+	bool (*txSetLaunchTime)(void* rawsock, bool enable);
 	U8* (*getTxFrame)(void* rawsock, bool blocking, U32* size);
 	bool (*relTxFrame)(void* rawsock, U8* pBuffer);
 	bool (*txFrameReady)(void* rawsock, U8* pFrame, U32 len, U64 timeNsec);
+	bool (*txFrameReadyRef)(void* rawsock, U8* pFrame, U32 hdrLen, const U8* pPayload, U32 payloadLen, U64 timeNsec);
 	int (*send)(void* rawsock);
+	int (*txFrameCount)(void* rawsock);
 	int (*txBufLevel)(void* rawsock);
 	int (*rxBufLevel)(void* rawsock);
 	unsigned long (*getTXOutOfBuffers)(void* pvRawsock);
@@ -0,0 +1,161 @@
+#!/usr/bin/env python3
+#
+# Checks the output of run_stress.sh.
+#
+# streams.txt in the output directory lists the streams:
+#   tone <stream_uid> <hz> <wav file>
+#   echo <stream_uid> <echo string>
+#
+# Tone streams: the wav file written by the listener must be complete, all
+# channels must be equal, and every 100 ms block must be a clean sine at the
+# stream's own frequency. A block dominated by another stream's frequency
+# means data crossed between streams; a block that is not a clean sine at all
+# means lost or mangled samples.
+#
+# Echo streams: each listener prints "<echo string> <talker count> : <listener
+# count>". Every line must carry a known echo string, the talker count must
+# go up by one per line for each stream, and so must the listener count.
+#
+
+import math
+import re
+import sys
+import wave
+
+BLOCK_MSEC = 100
+MIN_PURITY = 0.9
+MIN_ECHO_LINES = 100
+
+
+_tables = {}
+
+
+def tone_power(samples, rate, hz):
+	# Power at hz relative to the total power of the block
+	key = (len(samples), rate, hz)
+	if key not in _tables:
+		w = 2.0 * math.pi * hz / rate
+		_tables[key] = ([math.cos(w * n) for n in range(len(samples))],
+			[math.sin(w * n) for n in range(len(samples))])
+	cos_t, sin_t = _tables[key]
+	total = float(sum(x * x for x in samples))
+	if total == 0.0:
+		return 0.0
+	i = sum(x * c for x, c in zip(samples, cos_t))
+	q = sum(x * s for x, s in zip(samples, sin_t))
+	return 2.0 * (i * i + q * q) / (len(samples) * total)
+
+
+def read_channel0(wav):
+	# Returns channel 0 as integers, and whether all channels were equal
+	width = wav.getsampwidth()
+	channels = wav.getnchannels()
+	data = wav.readframes(wav.getnframes())
+	frame = width * channels
+	equal = True
+	samples = []
+	for off in range(0, len(data) - frame + 1, frame):
+		s = data[off:off + width]
+		if data[off:off + frame] != s * channels:
+			equal = False
+		samples.append(int.from_bytes(s, 'little', signed=True))
+	return samples, equal
+
+
+def check_tone(uid, hz, path, all_hz):
+	errors = []
+	try:
+		wav = wave.open(path, 'rb')
+	except (IOError, EOFError, wave.Error) as e:
+		return ["stream %d: can't read %s: %s" % (uid, path, e)]
+
+	rate = wav.getframerate()
+	expected = wav.getnframes()
+	samples, equal = read_channel0(wav)
+	wav.close()
+
+	if len(samples) < expected:
+		errors.append("stream %d: %d of %d frames received" % (uid, len(samples), expected))
+	if not equal:
+		errors.append("stream %d: channels differ" % uid)
+
+	block = rate * BLOCK_MSEC // 1000
+	for start in range(0, len(samples) - block + 1, block):
+		chunk = samples[start:start + block]
+		purity = tone_power(chunk, rate, hz)
+		if purity >= MIN_PURITY:
+			continue
+		best = max(all_hz, key=lambda f: tone_power(chunk, rate, f))
+		at = start * 1000.0 / rate
+		if best != hz and tone_power(chunk, rate, best) >= MIN_PURITY:
+			errors.append("stream %d: block at %.0f ms carries %d Hz, expected %d Hz" % (uid, at, best, hz))
+		else:
+			errors.append("stream %d: block at %.0f ms is not a clean %d Hz tone (%.2f)" % (uid, at, hz, purity))
+	return errors
+
+
+def check_echo(log, echo_tags):
+	errors = []
+	line_re = re.compile(r'^(stress_echo_\d+) (\d+) : (\d+)$')
+	last = {}
+	for line in log:
+		line = line.strip()
+		if not line.startswith('stress_echo'):
+			continue
+		m = line_re.match(line)
+		if not m or m.group(1) not in echo_tags:
+			errors.append("bad echo line: %r" % line)
+			continue
+		tag, tx, rx = m.group(1), int(m.group(2)), int(m.group(3))
+		if tag in last:
+			last_tx, last_rx, count = last[tag]
+			if tx != last_tx + 1:
+				errors.append("%s: talker count %d after %d" % (tag, tx, last_tx))
+			if rx != last_rx + 1:
+				errors.append("%s: listener count %d after %d" % (tag, rx, last_rx))
+		else:
+			count = 0
+		last[tag] = (tx, rx, count + 1)
+
+	for tag in sorted(echo_tags):
+		count = last[tag][2] if tag in last else 0
+		if count < MIN_ECHO_LINES:
+			errors.append("%s: only %d lines received" % (tag, count))
+	return errors
+
+
+def main():
+	if len(sys.argv) != 2:
+		print("Usage: %s outdir" % sys.argv[0])
+		return 2
+	outdir = sys.argv[1]
+
+	tones = []
+	echo_tags = set()
+	with open(outdir + '/streams.txt') as f:
+		for line in f:
+			fields = line.split()
+			if fields[0] == 'tone':
+				tones.append((int(fields[1]), int(fields[2]), fields[3]))
+			elif fields[0] == 'echo':
+				echo_tags.add(fields[2])
+
+	errors = []
+	all_hz = [hz for uid, hz, path in tones]
+	for uid, hz, path in tones:
+		errors += check_tone(uid, hz, path, all_hz)
+
+	with open(outdir + '/harness.log', errors='replace') as f:
+		errors += check_echo(f, echo_tags)
+
+	for e in errors[:100]:
+		print(e)
+	if len(errors) > 100:
+		print("... %d more" % (len(errors) - 100))
+
+	print("%d tone streams, %d echo streams: %s" % (len(tones), len(echo_tags), "FAILED" if errors else "passed"))
+	return 1 if errors else 0
+
+
+if __name__ == '__main__':
+	sys.exit(main())
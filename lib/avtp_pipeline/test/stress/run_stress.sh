@@ -0,0 +1,119 @@
+#!/bin/bash
+# Stress test for running many streams in one openavb_harness process.
+#
+# Starts AAF, IEC 61883-6 and echo talkers together with a listener for each
+# of them, all in one harness process on one interface. The listeners receive
+# the talkers' frames through the interface, so no second machine is needed.
+# Every stream carries data that identifies it (a tone frequency or an echo
+# string), and check_stress.py verifies that each listener only got data from
+# its own talker, without gaps.
+#
+# Needs root, a harness built without endpoint support (the default), and
+# gPTP running on the interface (see run_gptp.sh).
+#
+# Usage: sudo ./run_stress.sh [-n pairs] [-t seconds] [-b bindir] [-o outdir] ifname
+
+scriptdir="$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )"
+
+pairs=8
+seconds=10
+bindir="$scriptdir/../../build/bin"
+outdir=""
+
+usage() {
+	echo "Usage: sudo $0 [-n pairs] [-t seconds] [-b bindir] [-o outdir] ifname"
+	echo "  -n pairs    Talker/listener pairs of each kind (AAF, 61883-6, echo). Default $pairs."
+	echo "  -t seconds  Seconds of audio each listener records. Default $seconds."
+	echo "  -b bindir   Directory with openavb_harness. Default $bindir."
+	echo "  -o outdir   Directory for the recordings and the harness output. Default: a new temporary directory."
+	exit 1
+}
+
+while getopts "n:t:b:o:h" opt; do
+	case $opt in
+		n) pairs=$OPTARG ;;
+		t) seconds=$OPTARG ;;
+		b) bindir=$OPTARG ;;
+		o) outdir=$OPTARG ;;
+		*) usage ;;
+	esac
+done
+shift $((OPTIND - 1))
+[ "$#" -eq 1 ] || usage
+nic=$1
+
+# dest_addr uses the last byte of 91:e0:f0:00:fe:xx for each stream
+if [ $((pairs * 3)) -gt 256 ]; then
+	echo "At most 85 pairs of each kind are supported"
+	exit 1
+fi
+
+if [ ! -x "$bindir/openavb_harness" ]; then
+	echo "openavb_harness not found in $bindir"
+	exit 1
+fi
+
+mac=$(cat /sys/class/net/$nic/address 2>/dev/null)
+if [ -z "$mac" ]; then
+	echo "Unknown interface $nic"
+	exit 1
+fi
+
+if [ -z "$outdir" ]; then
+	outdir=$(mktemp -d /tmp/avb_stress.XXXXXX)
+fi
+mkdir -p "$outdir"
+rm -f "$outdir"/*.wav "$outdir"/harness.* "$outdir"/avb.log "$outdir"/streams.txt
+
+# 48 kHz stereo; 2 bytes per sample for AAF, 3 for 61883-6
+aafBytes=$((seconds * 48000 * 2 * 2))
+iecBytes=$((seconds * 48000 * 2 * 3))
+
+# Each stream gets its own stream_uid and dest_addr. Tone streams get their
+# own frequency, a multiple of 50 Hz so a 100 ms block holds whole periods.
+# streams.txt tells check_stress.py what to expect.
+args=()
+uid=0
+for kind in aaf 61883 echo; do
+	for ((i = 0; i < pairs; i++)); do
+		dest=$(printf "91:e0:f0:00:fe:%02x" $uid)
+		common="stream_uid=$uid,dest_addr=$dest"
+		case $kind in
+			aaf|61883)
+				hz=$((200 + 50 * uid))
+				wav="$outdir/stream_$uid.wav"
+				if [ $kind = aaf ]; then bytes=$aafBytes; else bytes=$iecBytes; fi
+				args+=("$scriptdir/stress_${kind}_talker.ini,$common,intf_nv_tone_hz=$hz")
+				args+=("$scriptdir/stress_${kind}_listener.ini,$common,intf_nv_file_name_rx=$wav,intf_nv_number_of_data_bytes=$bytes")
+				echo "tone $uid $hz $wav" >> "$outdir/streams.txt"
+				;;
+			echo)
+				args+=("$scriptdir/stress_echo_talker.ini,$common,intf_nv_echo_string=stress_echo_$uid")
+				args+=("$scriptdir/stress_echo_listener.ini,$common")
+				echo "echo $uid stress_echo_$uid" >> "$outdir/streams.txt"
+				;;
+		esac
+		uid=$((uid + 1))
+	done
+done
+
+echo "Starting $((uid * 2)) streams on $nic, output in $outdir"
+
+# The ini files name the modules as ./lib*.so, so run from the bin directory.
+# The echo listeners print to stdout; keep the log out of it.
+pushd "$bindir" > /dev/null
+./openavb_harness -I "$nic" -a "$mac" -l "$outdir/avb.log" "${args[@]}" > "$outdir/harness.log" 2> "$outdir/harness.err" &
+harness=$!
+popd > /dev/null
+
+# Give the streams time to start before the recordings fill up
+sleep $((seconds + 5))
+kill -INT $harness 2>/dev/null
+wait $harness
+status=$?
+if [ $status -ne 0 ]; then
+	echo "openavb_harness exited with status $status, see $outdir/avb.log"
+	exit 1
+fi
+
+python3 "$scriptdir/check_stress.py" "$outdir"
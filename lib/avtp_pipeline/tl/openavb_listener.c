@@ -40,6 +40,7 @@ https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
 #include "openavb_trace.h"
 #include "openavb_tl.h"
 #include "openavb_avtp.h"
+#include "openavb_mediaq.h"
 #include "openavb_listener.h"
 #include "openavb_avdecc_msg_client.h"
 
@@ -74,6 +75,9 @@ bool listenerStartStream(tl_state_t *pTLState)
 		pListenerData->destAddr,
 		pCfg->raw_rx_buffers,
 		pCfg->rx_signal_mode,
+		pCfg->rx_demux,
+		pCfg->rx_timestamp,
+		pCfg->flight_events,
 		&pListenerData->avtpHandle);
 	if (IS_OPENAVB_FAILURE(rc)) {
 		AVB_LOG_ERROR("Failed to create AVTP stream");
@@ -87,6 +91,7 @@ bool listenerStartStream(tl_state_t *pTLState)
 	pListenerData->nextReportNS = nowNS + (pCfg->report_seconds * NANOSECONDS_PER_SECOND);
 	pListenerData->lastReportFrames = 0;
 	pListenerData->nextSecondNS = nowNS + NANOSECONDS_PER_SECOND;
+	pListenerData->nextMetricsNS = nowNS;
 
 	// Clear counters
 	pListenerData->nReportCalls = 0;
@@ -95,6 +100,12 @@ bool listenerStartStream(tl_state_t *pTLState)
 	// Clear stats
 	openavbListenerClearStats(pTLState);
 
+	openavbAvtpSetCBHist(pListenerData->avtpHandle,
+		&pListenerData->hists.cur[TL_HIST_RX_INTF_CB - TL_HIST_RX_INTF_CB],
+		&pListenerData->hists.cur[TL_HIST_RX_MAP_CB - TL_HIST_RX_INTF_CB]);
+	openavbMediaQSetPullMarginHist(pTLState->pMediaQ,
+		&pListenerData->hists.cur[TL_HIST_RX_MARGIN - TL_HIST_RX_INTF_CB]);
+
 	// we're good to go!
 	pTLState->bStreaming = TRUE;
 
@@ -102,6 +113,29 @@ bool listenerStartStream(tl_state_t *pTLState)
 	return TRUE;
 }
 
+// Publish the metrics snapshot of the stream
+static void listenerPublishMetrics(listener_data_t *pListenerData, tl_state_t *pTLState, bool bStreaming)
+{
+	tl_metrics_t metrics;
+	U32 lost;
+	U64 bytes;
+
+	openavbAvtpPending(pListenerData->avtpHandle, &lost, &bytes);
+
+	memset(&metrics, 0, sizeof(metrics));
+	metrics.streamID = pListenerData->streamID;
+	metrics.bStreaming = bStreaming;
+	metrics.calls = pListenerData->stats.totalCalls + pListenerData->nReportCalls;
+	metrics.frames = pListenerData->stats.totalFrames + pListenerData->nReportFrames;
+	metrics.lost = pListenerData->stats.totalLost + lost;
+	metrics.bytes = pListenerData->stats.totalBytes + bytes;
+	metrics.mqItems = openavbMediaQCountItems(pTLState->pMediaQ, TRUE);
+	metrics.mqReady = openavbMediaQCountItems(pTLState->pMediaQ, FALSE);
+	metrics.rawsockLevel = openavbAvtpRxBufferLevel(pListenerData->avtpHandle);
+
+	openavbTLMetricsPublish(pTLState, &metrics, &pListenerData->hists);
+}
+
 void listenerStopStream(tl_state_t *pTLState)
 {
 	AVB_TRACE_ENTRY(AVB_TRACE_TL);
@@ -119,6 +153,11 @@ void listenerStopStream(tl_state_t *pTLState)
 		return;
 	}
 
+	// Last snapshot, while the pending counts are still apart from the totals
+	if (pTLState->bStreaming) {
+		listenerPublishMetrics(pListenerData, pTLState, FALSE);
+	}
+
 	openavbListenerAddStat(pTLState, TL_STAT_RX_CALLS, pListenerData->nReportCalls);
 	openavbListenerAddStat(pTLState, TL_STAT_RX_FRAMES, pListenerData->nReportFrames);
 	openavbListenerAddStat(pTLState, TL_STAT_RX_LOST, openavbAvtpLost(pListenerData->avtpHandle));
@@ -131,6 +170,8 @@ void listenerStopStream(tl_state_t *pTLState)
 		openavbListenerGetStat(pTLState, TL_STAT_RX_LOST),
 		openavbListenerGetStat(pTLState, TL_STAT_RX_BYTES));
 
+	openavbMediaQSetPullMarginHist(pTLState->pMediaQ, NULL);
+
 	if (pTLState->bStreaming) {
 		openavbAvtpShutdownListener(pListenerData->avtpHandle);
 		pTLState->bStreaming = FALSE;
@@ -156,8 +197,17 @@ static inline void listenerShowStats(listener_data_t *pListenerData, tl_state_t
 	AVB_LOGRT_INFO(FALSE, LOG_RT_ITEM, FALSE, "mqbuf=%d, ", LOG_RT_DATATYPE_U32, &mqbuf);
 	AVB_LOGRT_INFO(FALSE, LOG_RT_ITEM, LOG_RT_END, "mqrdy=%d", LOG_RT_DATATYPE_U32, &mqrdy);
 
+	S32 marginMin, marginAvg, marginMax;
+	U32 marginCnt = openavbAvtpRxMargin(pListenerData->avtpHandle, &marginMin, &marginAvg, &marginMax);
+	if (marginCnt > 0) {
+		AVB_LOGRTF_INFO("RX UID:%d, arrival to presentation margin: min=%dus, avg=%dus, max=%dus (%u frames)",
+			pListenerData->streamID.uniqueID, marginMin, marginAvg, marginMax, marginCnt);
+	}
+
 	openavbListenerAddStat(pTLState, TL_STAT_RX_LOST, lost);
 	openavbListenerAddStat(pTLState, TL_STAT_RX_BYTES, bytes);
+
+	openavbTLHistsRoll(pTLState, &pListenerData->hists, TL_HIST_RX_INTF_CB, pListenerData->streamID.uniqueID);
 }
 
 static inline bool listenerDoStream(tl_state_t *pTLState)
@@ -204,6 +254,11 @@ static inline bool listenerDoStream(tl_state_t *pTLState)
 			}
 		}
 
+		if (nowNS > pListenerData->nextMetricsNS) {
+			pListenerData->nextMetricsNS = nowNS + TL_METRICS_PUBLISH_NSEC;
+			listenerPublishMetrics(pListenerData, pTLState, TRUE);
+		}
+
 		if (nowNS > pListenerData->nextSecondNS) {
 			pListenerData->nextSecondNS += NANOSECONDS_PER_SECOND;
 			bRet = TRUE;
@@ -356,6 +411,8 @@ void openavbListenerClearStats(tl_state_t *pTLState)
 	memset(&pListenerData->stats, 0, sizeof(pListenerData->stats));
 	UNLOCK_STATS();
 
+	openavbTLHistsClear(pTLState, &pListenerData->hists);
+
 	AVB_TRACE_EXIT(AVB_TRACE_TL);
 }
 
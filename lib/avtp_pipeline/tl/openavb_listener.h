@@ -59,8 +59,10 @@ typedef struct {
 	unsigned long	nReportCalls;
 	U64 			nextReportNS;
 	U64				nextSecondNS;
+	U64				nextMetricsNS;
 	unsigned long	lastReportFrames;
 	listener_stats_t stats;
+	tl_hists_t		hists;
 } listener_data_t;
 
 void openavbTLRunListener(tl_state_t *pTLState);
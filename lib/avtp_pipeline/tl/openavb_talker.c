@@ -39,6 +39,7 @@ https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
 #include "openavb_tl.h"
 #include "openavb_avtp.h"
 #include "openavb_talker.h"
+#include "openavb_talker_sched.h"
 #include "openavb_avdecc_msg_client.h"
 
 // DEBUG Uncomment to turn on logging for just this module.
@@ -49,6 +50,9 @@ https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
 
 #include "openavb_debug.h"
 
+// Longest wait for the interface module with tx_intf_wakeup, so the endpoint
+// IPC is still serviced when the media source stalls.
+#define TALKER_INTF_WAIT_USEC	100000
 
 
 bool talkerStartStream(tl_state_t *pTLState)
@@ -95,6 +99,7 @@ bool talkerStartStream(tl_state_t *pTLState)
 		pTalkerData->vlanID,
 		pTalkerData->vlanPCP,
 		pTalkerData->wakeFrames * pCfg->raw_tx_buffers,
+		pCfg->flight_events,
 		&pTalkerData->avtpHandle);
 	if (IS_OPENAVB_FAILURE(rc)) {
 		AVB_LOG_ERROR("Failed to create AVTP stream");
@@ -118,6 +123,32 @@ bool talkerStartStream(tl_state_t *pTLState)
 		pCfg->batch_factor, pTalkerData->intervalNS / 1000, SRKbps, DataKbps);
 
 
+	// With launch times the kernel paces the frames of an interval, so
+	// they can be handed over in one go as soon as we wake up.
+	if (pCfg->tx_launch_time) {
+		U32 spacingNsec = pTalkerData->intervalNS / pTalkerData->wakeFrames;
+		U32 leadNsec = pCfg->tx_launch_lead_usec * NANOSECONDS_PER_USEC;
+		if (openavbAvtpTxSetLaunchTime(pTalkerData->avtpHandle, spacingNsec, leadNsec) && pCfg->spin_wait) {
+			AVB_LOG_INFO("Launch time enabled, spin_wait not needed");
+			pCfg->spin_wait = FALSE;
+		}
+	}
+
+	// Let the clock of the interface module's media source drive the wakeups
+	pTalkerData->bIntfWakeup = FALSE;
+	if (pCfg->tx_intf_wakeup && !pCfg->tx_blocking_in_intf) {
+		if (pCfg->intf_cb.intf_tx_wait_cb) {
+			pTalkerData->bIntfWakeup = TRUE;
+			if (pCfg->spin_wait) {
+				AVB_LOG_INFO("Interface wakeups enabled, spin_wait not needed");
+				pCfg->spin_wait = FALSE;
+			}
+		}
+		else {
+			AVB_LOG_WARNING("tx_intf_wakeup not supported by the interface module, using fixed interval");
+		}
+	}
+
 	// number of intervals per report
 	pTalkerData->wakesPerReport = pCfg->report_seconds * NANOSECONDS_PER_SECOND / pTalkerData->intervalNS;
 	// counts of intervals and frames between reports
@@ -139,18 +170,59 @@ bool talkerStartStream(tl_state_t *pTLState)
 	pTalkerData->nextReportNS = nowNS + (pCfg->report_seconds * NANOSECONDS_PER_SECOND);
 	pTalkerData->lastReportFrames = 0;
 	pTalkerData->nextSecondNS = nowNS + NANOSECONDS_PER_SECOND;
+	pTalkerData->nextMetricsNS = nowNS;
 	pTalkerData->nextCycleNS = nowNS + pTalkerData->intervalNS;
 
 	// Clear stats
 	openavbTalkerClearStats(pTLState);
 
+	openavbAvtpSetCBHist(pTalkerData->avtpHandle,
+		&pTalkerData->hists.cur[TL_HIST_TX_INTF_CB - TL_HIST_TX_WAKEUP_LATE],
+		&pTalkerData->hists.cur[TL_HIST_TX_MAP_CB - TL_HIST_TX_WAKEUP_LATE]);
+
 	// we're good to go!
 	pTLState->bStreaming = TRUE;
 
+	// Hand the transmit work over to the shared scheduler if configured.
+	pTalkerData->bTxSched = FALSE;
+	if (openavbTalkerSchedEnabled(pTLState)) {
+		pTalkerData->bTxSched = openavbTalkerSchedAdd(pTLState);
+		if (!pTalkerData->bTxSched) {
+			AVB_LOG_WARNING("Transmit scheduler not available, using talker thread");
+		}
+	}
+	else if (pCfg->tx_sched_group) {
+		AVB_LOG_WARNING("tx_sched_group can't be used with spin_wait, tx_blocking_in_intf or tx_intf_wakeup, using talker thread");
+	}
+
 	AVB_TRACE_EXIT(AVB_TRACE_TL);
 	return TRUE;
 }
 
+// Publish the metrics snapshot of the stream
+static void talkerPublishMetrics(talker_data_t *pTalkerData, tl_state_t *pTLState, bool bStreaming)
+{
+	tl_metrics_t metrics;
+	void *rawsock = ((avtp_stream_t*)pTalkerData->avtpHandle)->rawsock;
+	U32 lost;
+	U64 bytes;
+
+	openavbAvtpPending(pTalkerData->avtpHandle, &lost, &bytes);
+
+	memset(&metrics, 0, sizeof(metrics));
+	metrics.streamID = pTalkerData->streamID;
+	metrics.bStreaming = bStreaming;
+	metrics.calls = pTalkerData->stats.totalCalls + pTalkerData->cntWakes;
+	metrics.frames = pTalkerData->stats.totalFrames + pTalkerData->cntFrames;
+	metrics.late = pTalkerData->stats.totalLate;
+	metrics.bytes = pTalkerData->stats.totalBytes + bytes;
+	metrics.txOutOfBuffers = openavbRawsockGetTXOutOfBuffers(rawsock);
+	metrics.mqItems = openavbMediaQCountItems(pTLState->pMediaQ, TRUE);
+	metrics.rawsockLevel = openavbAvtpTxBufferLevel(pTalkerData->avtpHandle);
+
+	openavbTLMetricsPublish(pTLState, &metrics, &pTalkerData->hists);
+}
+
 void talkerStopStream(tl_state_t *pTLState)
 {
 	AVB_TRACE_ENTRY(AVB_TRACE_TL);
@@ -168,6 +240,17 @@ void talkerStopStream(tl_state_t *pTLState)
 		return;
 	}
 
+	// Make sure the scheduler worker is done with this talker
+	if (pTalkerData->bTxSched) {
+		openavbTalkerSchedRemove(pTLState);
+		pTalkerData->bTxSched = FALSE;
+	}
+
+	// Last snapshot, while the pending counts are still apart from the totals
+	if (pTLState->bStreaming) {
+		talkerPublishMetrics(pTalkerData, pTLState, FALSE);
+	}
+
 	void *rawsock = NULL;
 	if (pTalkerData->avtpHandle) {
 		rawsock = ((avtp_stream_t*)pTalkerData->avtpHandle)->rawsock;
@@ -213,6 +296,109 @@ static inline void talkerShowStats(talker_data_t *pTalkerData, tl_state_t *pTLSt
 
 	openavbTalkerAddStat(pTLState, TL_STAT_TX_LATE, late);
 	openavbTalkerAddStat(pTLState, TL_STAT_TX_BYTES, bytes);
+
+	openavbTLHistsRoll(pTLState, &pTalkerData->hists, TL_HIST_TX_WAKEUP_LATE, pTalkerData->streamID.uniqueID);
+}
+
+// Sends the frames for one transmit interval, updates the stats and advances
+// nextCycleNS. Returns TRUE when it is time to service the endpoint IPC.
+bool talkerTxInterval(tl_state_t *pTLState)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_TL);
+
+	openavb_tl_cfg_t *pCfg = &pTLState->cfg;
+	talker_data_t *pTalkerData = pTLState->pPvtTalkerData;
+	bool bRet = FALSE;
+	U64 nowNS;
+
+	if (!pCfg->tx_blocking_in_intf && !pTalkerData->bIntfWakeup) {
+		// How late we woke up for this interval
+		if (!pCfg->spin_wait) {
+			CLOCK_GETTIME64(OPENAVB_TIMER_CLOCK, &nowNS);
+		} else {
+			CLOCK_GETTIME64(OPENAVB_CLOCK_WALLTIME, &nowNS);
+		}
+		openavbHistAdd(&pTalkerData->hists.cur[TL_HIST_TX_WAKEUP_LATE - TL_HIST_TX_WAKEUP_LATE], (S64)(nowNS - pTalkerData->nextCycleNS));
+		AVB_TRACE_PROBE2(talker_wake, pTalkerData->streamID.uniqueID, (S64)(nowNS - pTalkerData->nextCycleNS));
+	}
+	else {
+		AVB_TRACE_PROBE2(talker_wake, pTalkerData->streamID.uniqueID, 0);
+	}
+
+	if (pTalkerData->bIntfWakeup) {
+		// Send everything the interface module has produced since the last
+		// wakeup. Launch times, if enabled, pace the frames on the wire.
+		U32 nSent, nIntervals = 0;
+		do {
+			nSent = openavbAvtpTxBatch(pTalkerData->avtpHandle, pTalkerData->wakeFrames);
+			pTalkerData->cntFrames += nSent;
+		} while (nSent == pTalkerData->wakeFrames && ++nIntervals < pCfg->raw_tx_buffers);
+	}
+	else if (!pCfg->tx_blocking_in_intf) {
+		// send the frames for this interval
+		pTalkerData->cntFrames += openavbAvtpTxBatch(pTalkerData->avtpHandle, pTalkerData->wakeFrames);
+	}
+	else {
+		// Interface module block option
+		if (IS_OPENAVB_SUCCESS(openavbAvtpTx(pTalkerData->avtpHandle, TRUE, pCfg->tx_blocking_in_intf)))
+			pTalkerData->cntFrames++;
+	}
+
+	if (!pCfg->spin_wait) {
+		CLOCK_GETTIME64(OPENAVB_TIMER_CLOCK, &nowNS);
+	} else {
+		CLOCK_GETTIME64(OPENAVB_CLOCK_WALLTIME, &nowNS);
+	}
+
+	if (pTalkerData->cntWakes++ % pTalkerData->wakeRate == 0) {
+		// time to service the endpoint IPC
+		bRet = TRUE;
+
+		// Don't need to check again for another second.
+		pTalkerData->nextSecondNS = nowNS + NANOSECONDS_PER_SECOND;
+	}
+
+	if (pCfg->report_seconds > 0) {
+		if (nowNS > pTalkerData->nextReportNS) {
+			talkerShowStats(pTalkerData, pTLState);
+		  
+			openavbTalkerAddStat(pTLState, TL_STAT_TX_CALLS, pTalkerData->cntWakes);
+			openavbTalkerAddStat(pTLState, TL_STAT_TX_FRAMES, pTalkerData->cntFrames);
+
+			pTalkerData->cntFrames = 0;
+			pTalkerData->cntWakes = 0;
+			pTalkerData->nextReportNS = nowNS + (pCfg->report_seconds * NANOSECONDS_PER_SECOND);
+		}
+	} else if (pCfg->report_frames > 0 && pTalkerData->cntFrames != pTalkerData->lastReportFrames) {
+		if (pTalkerData->cntFrames % pCfg->report_frames == 1) {
+			talkerShowStats(pTalkerData, pTLState);
+			pTalkerData->lastReportFrames = pTalkerData->cntFrames;
+		}
+	}
+
+	if (nowNS > pTalkerData->nextMetricsNS) {
+		pTalkerData->nextMetricsNS = nowNS + TL_METRICS_PUBLISH_NSEC;
+		talkerPublishMetrics(pTalkerData, pTLState, TRUE);
+	}
+
+	if (nowNS > pTalkerData->nextSecondNS) {
+		pTalkerData->nextSecondNS = nowNS + NANOSECONDS_PER_SECOND;
+		bRet = TRUE;
+	}
+
+	if (!pCfg->tx_blocking_in_intf && !pTalkerData->bIntfWakeup) {
+		pTalkerData->nextCycleNS += pTalkerData->intervalNS;
+
+		if ((pTalkerData->nextCycleNS + (pCfg->max_transmit_deficit_usec * 1000)) < nowNS) {
+			// Hit max deficit time. Something must be wrong. Reset the cycle timer.	
+			// Align clock : allows for some performance gain
+			nowNS = ((nowNS + (pTalkerData->intervalNS)) / pTalkerData->intervalNS) * pTalkerData->intervalNS;
+			pTalkerData->nextCycleNS = nowNS + pTalkerData->intervalNS;
+		}				
+	}
+
+	AVB_TRACE_EXIT(AVB_TRACE_TL);
+	return bRet;
 }
 
 static inline bool talkerDoStream(tl_state_t *pTLState)
@@ -229,10 +415,12 @@ static inline bool talkerDoStream(tl_state_t *pTLState)
 	talker_data_t *pTalkerData = pTLState->pPvtTalkerData;
 	bool bRet = FALSE;
 
-	if (pTLState->bStreaming) {
-		U64 nowNS;
-
-		if (!pCfg->tx_blocking_in_intf) {
+	if (pTLState->bStreaming && !pTalkerData->bTxSched) {
+		if (pTalkerData->bIntfWakeup) {
+			// wait until the interface module has a full media queue item
+			pCfg->intf_cb.intf_tx_wait_cb(pTLState->pMediaQ, TALKER_INTF_WAIT_USEC);
+		}
+		else if (!pCfg->tx_blocking_in_intf) {
 
 			if (!pCfg->spin_wait) {
 				// sleep until the next interval
@@ -244,71 +432,12 @@ static inline bool talkerDoStream(tl_state_t *pTLState)
 			}
 
 			//AVB_DBG_INTERVAL(8000, TRUE);
-
-			// send the frames for this interval
-			int i;
-			for (i = pTalkerData->wakeFrames; i > 0; i--) {
-				if (IS_OPENAVB_SUCCESS(openavbAvtpTx(pTalkerData->avtpHandle, i == 1, pCfg->tx_blocking_in_intf)))
-					pTalkerData->cntFrames++;
-				else
-					break;
-			}
-		}
-		else {
-			// Interface module block option
-			if (IS_OPENAVB_SUCCESS(openavbAvtpTx(pTalkerData->avtpHandle, TRUE, pCfg->tx_blocking_in_intf)))
-				pTalkerData->cntFrames++;
-		}
-
-		if (!pCfg->spin_wait) {
-			CLOCK_GETTIME64(OPENAVB_TIMER_CLOCK, &nowNS);
-		} else {
-			CLOCK_GETTIME64(OPENAVB_CLOCK_WALLTIME, &nowNS);
-		}
-
-		if (pTalkerData->cntWakes++ % pTalkerData->wakeRate == 0) {
-			// time to service the endpoint IPC
-			bRet = TRUE;
-
-			// Don't need to check again for another second.
-			pTalkerData->nextSecondNS = nowNS + NANOSECONDS_PER_SECOND;
-		}
-
-		if (pCfg->report_seconds > 0) {
-			if (nowNS > pTalkerData->nextReportNS) {
-				talkerShowStats(pTalkerData, pTLState);
-			  
-				openavbTalkerAddStat(pTLState, TL_STAT_TX_CALLS, pTalkerData->cntWakes);
-				openavbTalkerAddStat(pTLState, TL_STAT_TX_FRAMES, pTalkerData->cntFrames);
-
-				pTalkerData->cntFrames = 0;
-				pTalkerData->cntWakes = 0;
-				pTalkerData->nextReportNS = nowNS + (pCfg->report_seconds * NANOSECONDS_PER_SECOND);
-			}
-		} else if (pCfg->report_frames > 0 && pTalkerData->cntFrames != pTalkerData->lastReportFrames) {
-			if (pTalkerData->cntFrames % pCfg->report_frames == 1) {
-				talkerShowStats(pTalkerData, pTLState);
-				pTalkerData->lastReportFrames = pTalkerData->cntFrames;
-			}
-		}
-
-		if (nowNS > pTalkerData->nextSecondNS) {
-			pTalkerData->nextSecondNS = nowNS + NANOSECONDS_PER_SECOND;
-			bRet = TRUE;
 		}
 
-		if (!pCfg->tx_blocking_in_intf) {
-			pTalkerData->nextCycleNS += pTalkerData->intervalNS;
-
-			if ((pTalkerData->nextCycleNS + (pCfg->max_transmit_deficit_usec * 1000)) < nowNS) {
-				// Hit max deficit time. Something must be wrong. Reset the cycle timer.	
-				// Align clock : allows for some performance gain
-				nowNS = ((nowNS + (pTalkerData->intervalNS)) / pTalkerData->intervalNS) * pTalkerData->intervalNS;
-				pTalkerData->nextCycleNS = nowNS + pTalkerData->intervalNS;
-			}				
-		}
+		bRet = talkerTxInterval(pTLState);
 	}
 	else {
+		// Not streaming, or the transmit scheduler is sending for us.
 		SLEEP_MSEC(10);
 
 		// time to service the endpoint IPC
@@ -453,6 +582,8 @@ void openavbTalkerClearStats(tl_state_t *pTLState)
 	memset(&pTalkerData->stats, 0, sizeof(pTalkerData->stats));
 	UNLOCK_STATS();
 
+	openavbTLHistsClear(pTLState, &pTalkerData->hists);
+
 	AVB_TRACE_EXIT(AVB_TRACE_TL);
 }
 
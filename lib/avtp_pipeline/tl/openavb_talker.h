@@ -62,8 +62,12 @@ typedef struct {
 	U64 			intervalNS;
 	U64 			nextReportNS;
 	U64				nextSecondNS;
+	U64				nextMetricsNS;
 	unsigned long	lastReportFrames;
+	bool			bTxSched;		// Transmitted by the shared scheduler worker
+	bool			bIntfWakeup;	// Woken by the interface module rather than the interval timer
 	talker_stats_t	stats;
+	tl_hists_t		hists;
 } talker_data_t;
 
 
@@ -74,6 +78,7 @@ void openavbTalkerAddStat(tl_state_t *pTLState, tl_stat_t stat, U64 val);
 U64 openavbTalkerGetStat(tl_state_t *pTLState, tl_stat_t stat);
 bool talkerStartStream(tl_state_t *pTLState);
 void talkerStopStream(tl_state_t *pTLState);
+bool talkerTxInterval(tl_state_t *pTLState);
 bool openavbTLRunTalkerInit(tl_state_t *pTLState);
 void openavbTLRunTalkerFinish(tl_state_t *pTLState);
 
@@ -0,0 +1,305 @@
+/*************************************************************************************************************
+Copyright (c) 2012-2015, Symphony Teleca Corporation, a Harman International Industries, Incorporated company
+Copyright (c) 2016-2017, Harman International Industries, Incorporated
+All rights reserved.
+ 
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ 
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ 
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS LISTED "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS LISTED BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ 
+Attributions: The inih library portion of the source code is licensed from 
+Brush Technology and Ben Hoyt - Copyright (c) 2009, Brush Technology and Copyright (c) 2009, Ben Hoyt. 
+Complete license and copyright information can be found at 
+https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
+*************************************************************************************************************/
+
+/*
+* MODULE SUMMARY : Shared talker transmit scheduler
+*
+* Each scheduler group owns one transmit worker thread. The talkers of a group
+* are held in a min-heap keyed on their next cycle time (nextCycleNS). The
+* worker sleeps until the earliest cycle, then services every talker that is
+* due before sleeping again. Talkers using the same transmit interval align to
+* the same cycle boundaries so they are all serviced by a single wakeup.
+*
+* The heap is protected by a per group mutex that the worker holds while it
+* transmits. Adding and removing groups is serialized with the TL state mutex.
+*/
+
+#include <stdlib.h>
+#include "openavb_platform.h"
+#include "openavb_trace.h"
+#include "openavb_tl.h"
+#include "openavb_talker.h"
+#include "openavb_talker_sched.h"
+
+// DEBUG Uncomment to turn on logging for just this module.
+//#define AVB_LOG_ON	1
+
+#define	AVB_LOG_COMPONENT	"Talker"
+#include "openavb_log.h"
+
+THREAD_TYPE(talkerSchedThread);
+
+typedef struct {
+	// Worker running flag. Changed with both the TL state mutex and the group mutex held.
+	bool bRunning;
+
+	// Min-heap of talkers ordered on nextCycleNS.
+	tl_state_t **pHeap;
+	U32 heapSize;
+	U32 heapCount;
+
+	// Protects the heap and the talkers in it from the worker.
+	MUTEX_HANDLE(mutex);
+
+	// Transmit worker thread
+	THREAD_DEFINITON(talkerSchedThread);
+} talker_sched_group_t;
+
+static talker_sched_group_t gTalkerSchedGroups[TALKER_SCHED_MAX_GROUPS];
+
+#define SCHED_LOCK(pGroup)		{ MUTEX_CREATE_ERR(); MUTEX_LOCK((pGroup)->mutex); MUTEX_LOG_ERR("Mutex lock failure"); }
+#define SCHED_UNLOCK(pGroup)	{ MUTEX_CREATE_ERR(); MUTEX_UNLOCK((pGroup)->mutex); MUTEX_LOG_ERR("Mutex unlock failure"); }
+
+#define SCHED_CYCLE_NS(pTLState)	(((talker_data_t *)(pTLState)->pPvtTalkerData)->nextCycleNS)
+
+static void talkerSchedSiftUp(talker_sched_group_t *pGroup, U32 idx)
+{
+	tl_state_t *pTLState = pGroup->pHeap[idx];
+	U64 cycleNS = SCHED_CYCLE_NS(pTLState);
+
+	while (idx > 0) {
+		U32 parent = (idx - 1) / 2;
+		if (SCHED_CYCLE_NS(pGroup->pHeap[parent]) <= cycleNS)
+			break;
+		pGroup->pHeap[idx] = pGroup->pHeap[parent];
+		idx = parent;
+	}
+	pGroup->pHeap[idx] = pTLState;
+}
+
+static void talkerSchedSiftDown(talker_sched_group_t *pGroup, U32 idx)
+{
+	tl_state_t *pTLState = pGroup->pHeap[idx];
+	U64 cycleNS = SCHED_CYCLE_NS(pTLState);
+
+	while (1) {
+		U32 child = idx * 2 + 1;
+		if (child >= pGroup->heapCount)
+			break;
+		if (child + 1 < pGroup->heapCount
+			&& SCHED_CYCLE_NS(pGroup->pHeap[child + 1]) < SCHED_CYCLE_NS(pGroup->pHeap[child]))
+			child++;
+		if (cycleNS <= SCHED_CYCLE_NS(pGroup->pHeap[child]))
+			break;
+		pGroup->pHeap[idx] = pGroup->pHeap[child];
+		idx = child;
+	}
+	pGroup->pHeap[idx] = pTLState;
+}
+
+static void *talkerSchedThreadFn(void *pv)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_TL);
+
+	talker_sched_group_t *pGroup = (talker_sched_group_t *)pv;
+	U64 nowNS, nextNS;
+
+	SCHED_LOCK(pGroup);
+	while (pGroup->bRunning && pGroup->heapCount > 0) {
+		nextNS = SCHED_CYCLE_NS(pGroup->pHeap[0]);
+		SCHED_UNLOCK(pGroup);
+
+		// sleep until the earliest talker interval
+		SLEEP_UNTIL_NSEC(nextNS);
+
+		SCHED_LOCK(pGroup);
+		CLOCK_GETTIME64(OPENAVB_TIMER_CLOCK, &nowNS);
+
+		// send the frames of every talker that is due. A talker that is behind
+		// stays at the top of the heap until it has caught up.
+		while (pGroup->bRunning && pGroup->heapCount > 0) {
+			tl_state_t *pTLState = pGroup->pHeap[0];
+			if (SCHED_CYCLE_NS(pTLState) > nowNS)
+				break;
+			talkerTxInterval(pTLState);
+			talkerSchedSiftDown(pGroup, 0);
+		}
+	}
+	SCHED_UNLOCK(pGroup);
+
+	AVB_TRACE_EXIT(AVB_TRACE_TL);
+	return NULL;
+}
+
+bool openavbTalkerSchedEnabled(tl_state_t *pTLState)
+{
+	openavb_tl_cfg_t *pCfg = &pTLState->cfg;
+
+	// The worker sleeps on the timer clock and must never block in an interface module.
+	return pCfg->tx_sched_group > 0 && !pCfg->spin_wait && !pCfg->tx_blocking_in_intf && !pCfg->tx_intf_wakeup;
+}
+
+bool openavbTalkerSchedAdd(tl_state_t *pTLState)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_TL);
+
+	openavb_tl_cfg_t *pCfg = &pTLState->cfg;
+
+	if (pCfg->tx_sched_group < 1 || pCfg->tx_sched_group > TALKER_SCHED_MAX_GROUPS) {
+		AVB_LOGF_ERROR("Invalid tx_sched_group %" PRIu32, pCfg->tx_sched_group);
+		AVB_TRACE_EXIT(AVB_TRACE_TL);
+		return FALSE;
+	}
+
+	talker_sched_group_t *pGroup = &gTalkerSchedGroups[pCfg->tx_sched_group - 1];
+	bool bStart = FALSE;
+
+	TL_LOCK();
+
+	if (!pGroup->bRunning) {
+		MUTEX_ATTR_HANDLE(mta);
+		MUTEX_ATTR_INIT(mta);
+		MUTEX_ATTR_SET_TYPE(mta, MUTEX_ATTR_TYPE_DEFAULT);
+		MUTEX_ATTR_SET_NAME(mta, "TalkerSchedMutex");
+		MUTEX_CREATE_ERR();
+		MUTEX_CREATE(pGroup->mutex, mta);
+		MUTEX_LOG_ERR("Could not create/initialize 'TalkerSchedMutex' mutex");
+		pGroup->heapCount = 0;
+		bStart = TRUE;
+	}
+
+	SCHED_LOCK(pGroup);
+
+	if (pGroup->heapCount == pGroup->heapSize) {
+		U32 heapSize = pGroup->heapSize ? pGroup->heapSize * 2 : 8;
+		tl_state_t **pHeap = realloc(pGroup->pHeap, heapSize * sizeof(tl_state_t *));
+		if (!pHeap) {
+			AVB_LOG_ERROR("Failed to allocate talker scheduler heap");
+			SCHED_UNLOCK(pGroup);
+			if (bStart) {
+				MUTEX_CREATE_ERR();
+				MUTEX_DESTROY(pGroup->mutex);
+				MUTEX_LOG_ERR("Error destroying mutex");
+			}
+			TL_UNLOCK();
+			AVB_TRACE_EXIT(AVB_TRACE_TL);
+			return FALSE;
+		}
+		pGroup->pHeap = pHeap;
+		pGroup->heapSize = heapSize;
+	}
+
+	pGroup->pHeap[pGroup->heapCount++] = pTLState;
+	talkerSchedSiftUp(pGroup, pGroup->heapCount - 1);
+
+	if (bStart) {
+		bool errResult;
+
+		pGroup->bRunning = TRUE;
+		THREAD_CREATE(talkerSchedThread, pGroup->talkerSchedThread, NULL, talkerSchedThreadFn, pGroup);
+		THREAD_CHECK_ERROR(pGroup->talkerSchedThread, "Thread / task creation failed", errResult);
+		if (errResult) {
+			pGroup->bRunning = FALSE;
+			pGroup->heapCount = 0;
+			SCHED_UNLOCK(pGroup);
+			{
+				MUTEX_CREATE_ERR();
+				MUTEX_DESTROY(pGroup->mutex);
+				MUTEX_LOG_ERR("Error destroying mutex");
+			}
+			TL_UNLOCK();
+			AVB_TRACE_EXIT(AVB_TRACE_TL);
+			return FALSE;
+		}
+
+		// The worker takes the scheduling settings of the first talker in the group.
+		if (pCfg->thread_rt_priority != 0) { THREAD_SET_RT_PRIORITY(pGroup->talkerSchedThread, pCfg->thread_rt_priority); }
+		if (pCfg->thread_affinity != 0xFFFFFFFF) { THREAD_PIN(pGroup->talkerSchedThread, pCfg->thread_affinity); }
+
+		AVB_LOGF_INFO("Started transmit scheduler group %" PRIu32, pCfg->tx_sched_group);
+	}
+
+	SCHED_UNLOCK(pGroup);
+	TL_UNLOCK();
+
+	AVB_TRACE_EXIT(AVB_TRACE_TL);
+	return TRUE;
+}
+
+void openavbTalkerSchedRemove(tl_state_t *pTLState)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_TL);
+
+	openavb_tl_cfg_t *pCfg = &pTLState->cfg;
+
+	if (pCfg->tx_sched_group < 1 || pCfg->tx_sched_group > TALKER_SCHED_MAX_GROUPS) {
+		AVB_TRACE_EXIT(AVB_TRACE_TL);
+		return;
+	}
+
+	talker_sched_group_t *pGroup = &gTalkerSchedGroups[pCfg->tx_sched_group - 1];
+	bool bStop = FALSE;
+
+	TL_LOCK();
+
+	if (!pGroup->bRunning) {
+		TL_UNLOCK();
+		AVB_TRACE_EXIT(AVB_TRACE_TL);
+		return;
+	}
+
+	SCHED_LOCK(pGroup);
+	U32 i1;
+	for (i1 = 0; i1 < pGroup->heapCount; i1++) {
+		if (pGroup->pHeap[i1] == pTLState) {
+			pGroup->pHeap[i1] = pGroup->pHeap[--pGroup->heapCount];
+			if (i1 < pGroup->heapCount) {
+				talkerSchedSiftDown(pGroup, i1);
+				talkerSchedSiftUp(pGroup, i1);
+			}
+			break;
+		}
+	}
+	if (pGroup->heapCount == 0) {
+		pGroup->bRunning = FALSE;
+		bStop = TRUE;
+	}
+	SCHED_UNLOCK(pGroup);
+
+	if (bStop) {
+		THREAD_JOIN(pGroup->talkerSchedThread, NULL);
+
+		free(pGroup->pHeap);
+		pGroup->pHeap = NULL;
+		pGroup->heapSize = 0;
+		{
+			MUTEX_CREATE_ERR();
+			MUTEX_DESTROY(pGroup->mutex);
+			MUTEX_LOG_ERR("Error destroying mutex");
+		}
+
+		AVB_LOGF_INFO("Stopped transmit scheduler group %" PRIu32, pCfg->tx_sched_group);
+	}
+
+	TL_UNLOCK();
+
+	AVB_TRACE_EXIT(AVB_TRACE_TL);
+}
@@ -0,0 +1,61 @@
+/*************************************************************************************************************
+Copyright (c) 2012-2015, Symphony Teleca Corporation, a Harman International Industries, Incorporated company
+Copyright (c) 2016-2017, Harman International Industries, Incorporated
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS LISTED "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS LISTED BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Attributions: The inih library portion of the source code is licensed from
+Brush Technology and Ben Hoyt - Copyright (c) 2009, Brush Technology and Copyright (c) 2009, Ben Hoyt.
+Complete license and copyright information can be found at
+https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
+*************************************************************************************************************/
+
+/*
+* HEADER SUMMARY : Shared talker transmit scheduler
+*
+* Talkers configured with a non-zero tx_sched_group are not transmitted from
+* their own talker thread. Instead they are registered with a transmit worker
+* thread shared by every talker of the same group. The worker keeps the
+* talkers in a min-heap ordered by their next cycle time and services all
+* talkers that are due with a single wakeup.
+*/
+
+#ifndef OPENAVB_TL_TALKER_SCHED_H
+#define OPENAVB_TL_TALKER_SCHED_H 1
+
+#include "openavb_tl.h"
+
+// Maximum number of transmit scheduler groups (worker threads)
+#define TALKER_SCHED_MAX_GROUPS		8
+
+// Returns TRUE if the talker will be transmitted by a shared scheduler worker.
+bool openavbTalkerSchedEnabled(tl_state_t *pTLState);
+
+// Hand a streaming talker over to the worker of its scheduler group.
+// The worker thread is started when the first talker of a group is added.
+bool openavbTalkerSchedAdd(tl_state_t *pTLState);
+
+// Remove a talker from its scheduler group. On return the worker is no longer
+// using the talker. The worker thread is stopped when the last talker is removed.
+void openavbTalkerSchedRemove(tl_state_t *pTLState);
+
+#endif  // OPENAVB_TL_TALKER_SCHED_H
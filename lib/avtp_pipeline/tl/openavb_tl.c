@@ -42,6 +42,8 @@ https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
 #include "openavb_talker.h"
 #include "openavb_listener.h"
 #include "openavb_avdecc_msg.h"
+#include "openavb_avtp_rx_demux.h"
+#include "openavb_avtp_flight.h"
 #include "openavb_platform.h"
 
 #define	AVB_LOG_COMPONENT	"Talker / Listener"
@@ -290,6 +292,16 @@ EXTERN_DLL_EXPORT bool openavbTLInitialize(U32 maxTL)
 		MUTEX_LOG_ERR("Error creating mutex");
 	}
 
+	if (!openavbAvtpRxDemuxInitialize()) {
+		AVB_TRACE_EXIT(AVB_TRACE_TL);
+		return FALSE;
+	}
+
+	if (!openavbAvtpFlightInitialize()) {
+		AVB_TRACE_EXIT(AVB_TRACE_TL);
+		return FALSE;
+	}
+
 	gTLHandleList = calloc(1, sizeof(tl_handle_t) * gMaxTL);
 	if (gTLHandleList) {
 		AVB_TRACE_EXIT(AVB_TRACE_TL);
@@ -305,6 +317,10 @@ EXTERN_DLL_EXPORT bool openavbTLInitialize(U32 maxTL)
 EXTERN_DLL_EXPORT bool openavbTLCleanup()
 {
 	AVB_TRACE_ENTRY(AVB_TRACE_TL);
+
+	// The metrics server walks the handle list
+	openavbTLMetricsStop();
+
 	if (gTLHandleList) {
 		free(gTLHandleList);
 		gTLHandleList = NULL;
@@ -313,6 +329,9 @@ EXTERN_DLL_EXPORT bool openavbTLCleanup()
 		return FALSE;
 	}
 
+	openavbAvtpRxDemuxFinalize();
+	openavbAvtpFlightFinalize();
+
 	{
 		MUTEX_CREATE_ERR();
 		MUTEX_DESTROY(gTLStateMutex);
@@ -323,6 +342,16 @@ EXTERN_DLL_EXPORT bool openavbTLCleanup()
 	return TRUE;
 }
 
+EXTERN_DLL_EXPORT void openavbTLFlightDump(void)
+{
+	openavbAvtpFlightDump();
+}
+
+EXTERN_DLL_EXPORT bool openavbTLFlightDir(const char *dir)
+{
+	return openavbAvtpFlightSetDir(dir);
+}
+
 EXTERN_DLL_EXPORT bool openavbGetVersion(U8 *major, U8 *minor, U8 *revision)
 {
 	if (!major || !minor || !revision) {
@@ -396,6 +425,14 @@ EXTERN_DLL_EXPORT void openavbTLInitCfg(openavb_tl_cfg_t *pCfg)
 	pCfg->spin_wait = FALSE;
 	pCfg->thread_rt_priority = 0;
 	pCfg->thread_affinity = 0xFFFFFFFF;
+	pCfg->mediaq_lockless = FALSE;
+	pCfg->tx_sched_group = 0;
+	pCfg->rx_demux = FALSE;
+	pCfg->tx_launch_time = FALSE;
+	pCfg->tx_launch_lead_usec = 500;
+	pCfg->tx_intf_wakeup = FALSE;
+	pCfg->rx_timestamp = FALSE;
+	pCfg->flight_events = 16384;
 
 	AVB_TRACE_EXIT(AVB_TRACE_TL);
 }
@@ -441,6 +478,14 @@ EXTERN_DLL_EXPORT bool openavbTLConfigure(tl_handle_t handle, openavb_tl_cfg_t *
 
 	openavbMediaQSetMaxStaleTail(pTLState->pMediaQ, pCfg->max_stale);
 
+	if (pCfg->mediaq_lockless) {
+		openavbMediaQLocklessOn(pTLState->pMediaQ);
+	}
+	else if (pCfg->role == AVB_ROLE_LISTENER && pCfg->rx_demux) {
+		// The mapping module is called from the RX demultiplexer thread.
+		openavbMediaQThreadSafeOn(pTLState->pMediaQ);
+	}
+
 	if (!openavbTLOpenLinkLibsOsal(pTLState)) {
 		AVB_LOG_ERROR("Failed to open mapping / interface library");
 		return FALSE;
@@ -741,6 +786,115 @@ EXTERN_DLL_EXPORT U64 openavbTLStat(tl_handle_t handle, tl_stat_t stat)
 	return val;
 }
 
+static const char *histNames[] = {
+	"TX wakeup late",
+	"TX intf cb",
+	"TX map cb",
+	"RX intf cb",
+	"RX map cb",
+	"RX margin",
+};
+
+void openavbTLHistsRoll(tl_state_t *pTLState, tl_hists_t *pHists, tl_hist_t first, U16 uniqueID)
+{
+	int i;
+	for (i = 0; i < TL_HIST_CNT; i++) {
+		openavb_hist_t *pHist = &pHists->cur[i];
+		if (pHist->count > 0) {
+			AVB_LOGRTF_INFO("UID:%d, %s: n=%u, p50=%.1fus, p99=%.1fus, p99.9=%.1fus, min=%.1fus, max=%.1fus",
+				uniqueID, histNames[first + i], pHist->count,
+				openavbHistPercentile(pHist, 50.0) / 1000.0,
+				openavbHistPercentile(pHist, 99.0) / 1000.0,
+				openavbHistPercentile(pHist, 99.9) / 1000.0,
+				pHist->min / 1000.0, pHist->max / 1000.0);
+		}
+	}
+
+	LOCK_STATS();
+	memcpy(pHists->last, pHists->cur, sizeof(pHists->last));
+	UNLOCK_STATS();
+
+	for (i = 0; i < TL_HIST_CNT; i++) {
+		openavbHistClear(&pHists->cur[i]);
+	}
+}
+
+void openavbTLHistsClear(tl_state_t *pTLState, tl_hists_t *pHists)
+{
+	int i;
+	LOCK_STATS();
+	for (i = 0; i < TL_HIST_CNT; i++) {
+		openavbHistClear(&pHists->cur[i]);
+		openavbHistClear(&pHists->last[i]);
+	}
+	UNLOCK_STATS();
+}
+
+bool openavbTLHistsGet(tl_state_t *pTLState, tl_hists_t *pHists, U32 idx, bool bLastInterval, openavb_hist_t *pHist)
+{
+	if (idx >= TL_HIST_CNT) {
+		return FALSE;
+	}
+
+	LOCK_STATS();
+	if (bLastInterval) {
+		memcpy(pHist, &pHists->last[idx], sizeof(*pHist));
+	}
+	else {
+		memcpy(pHist, &pHists->cur[idx], sizeof(*pHist));
+	}
+	UNLOCK_STATS();
+	return TRUE;
+}
+
+EXTERN_DLL_EXPORT bool openavbTLHist(tl_handle_t handle, tl_hist_t hist, bool bLastInterval, openavb_hist_t *pHist)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_TL);
+	bool bRet = FALSE;
+
+	tl_state_t *pTLState = (tl_state_t *)handle;
+
+	if (!pTLState || !pHist) {
+		AVB_LOG_ERROR("Invalid handle");
+		AVB_TRACE_EXIT(AVB_TRACE_TL);
+		return FALSE;
+	}
+
+	if (pTLState->cfg.role == AVB_ROLE_TALKER && pTLState->pPvtTalkerData) {
+		talker_data_t *pTalkerData = pTLState->pPvtTalkerData;
+		bRet = openavbTLHistsGet(pTLState, &pTalkerData->hists, hist - TL_HIST_TX_WAKEUP_LATE, bLastInterval, pHist);
+	}
+	else if (pTLState->cfg.role == AVB_ROLE_LISTENER && pTLState->pPvtListenerData) {
+		listener_data_t *pListenerData = pTLState->pPvtListenerData;
+		bRet = openavbTLHistsGet(pTLState, &pListenerData->hists, hist - TL_HIST_RX_INTF_CB, bLastInterval, pHist);
+	}
+
+	AVB_TRACE_EXIT(AVB_TRACE_TL);
+	return bRet;
+}
+
+EXTERN_DLL_EXPORT void openavbTLHistClear(tl_handle_t handle)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_TL);
+
+	tl_state_t *pTLState = (tl_state_t *)handle;
+
+	if (!pTLState) {
+		AVB_LOG_ERROR("Invalid handle");
+		AVB_TRACE_EXIT(AVB_TRACE_TL);
+		return;
+	}
+
+	if (pTLState->cfg.role == AVB_ROLE_TALKER && pTLState->pPvtTalkerData) {
+		openavbTLHistsClear(pTLState, &((talker_data_t *)pTLState->pPvtTalkerData)->hists);
+	}
+	else if (pTLState->cfg.role == AVB_ROLE_LISTENER && pTLState->pPvtListenerData) {
+		openavbTLHistsClear(pTLState, &((listener_data_t *)pTLState->pPvtListenerData)->hists);
+	}
+
+	AVB_TRACE_EXIT(AVB_TRACE_TL);
+}
+
 EXTERN_DLL_EXPORT void openavbTLPauseStream(tl_handle_t handle, bool bPause)
 {
 	AVB_TRACE_ENTRY(AVB_TRACE_TL);
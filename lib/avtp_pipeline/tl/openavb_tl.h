@@ -55,6 +55,44 @@ typedef struct {
 	U64 totalBytes;
 } talker_stats_t;
 
+// Histograms of one role, indexed from the role's first tl_hist_t
+#define TL_HIST_CNT 3
+typedef struct {
+	// Current report interval. Updated by the stream threads without locking.
+	openavb_hist_t cur[TL_HIST_CNT];
+	// Last complete report interval. Protected by the stats mutex.
+	openavb_hist_t last[TL_HIST_CNT];
+} tl_hists_t;
+
+// Summary of one last report interval histogram (nsec)
+typedef struct {
+	U32 count;
+	S64 min, max;
+	S64 p50, p99, p999;
+} tl_hist_summary_t;
+
+// Snapshot of a stream for the metrics endpoint. Published by the stream's
+// own thread about once a second, read without locking by the metrics server.
+typedef struct {
+	AVBStreamID_t streamID;
+	bool bStreaming;
+	// Totals since the stream was started
+	U64 calls;
+	U64 frames;
+	U64 late;				// talker only
+	U64 lost;				// listener only
+	U64 bytes;
+	U64 txOutOfBuffers;		// talker only
+	// Levels at the time of the snapshot
+	U64 mqItems;
+	U64 mqReady;			// listener only
+	U64 rawsockLevel;
+	tl_hist_summary_t hist[TL_HIST_CNT];
+} tl_metrics_t;
+
+// How often the stream threads publish their metrics snapshot
+#define TL_METRICS_PUBLISH_NSEC		NANOSECONDS_PER_SECOND
+
 THREAD_TYPE(TLThread);
 THREAD_TYPE(avdeccMsgThread);
 
@@ -104,6 +142,10 @@ typedef struct {
 	// Per stream Stats Mutex
 	MUTEX_HANDLE(statsMutex);
 
+	// Metrics snapshot, odd metricsSeq while it is being written
+	U32 metricsSeq;
+	tl_metrics_t metrics;
+
 	LINK_LIB(mapLib);
 
 	LINK_LIB(intfLib);
@@ -125,6 +167,24 @@ extern MUTEX_HANDLE(gTLStateMutex);
 #define LOCK_STATS()        { MUTEX_CREATE_ERR(); MUTEX_LOCK(pTLState->statsMutex); MUTEX_LOG_ERR("Mutex lock failure"); }
 #define UNLOCK_STATS()      { MUTEX_CREATE_ERR(); MUTEX_UNLOCK(pTLState->statsMutex); MUTEX_LOG_ERR("Mutex unlock failure"); }
 
+// Report the current histograms, then make them the last interval ones and start over.
+// first is the role's first tl_hist_t.
+void openavbTLHistsRoll(tl_state_t *pTLState, tl_hists_t *pHists, tl_hist_t first, U16 uniqueID);
+// Clear the current and last interval histograms
+void openavbTLHistsClear(tl_state_t *pTLState, tl_hists_t *pHists);
+// Copy one histogram. idx is relative to the role's first tl_hist_t.
+bool openavbTLHistsGet(tl_state_t *pTLState, tl_hists_t *pHists, U32 idx, bool bLastInterval, openavb_hist_t *pHist);
+
+////////////////
+// Metrics endpoint
+////////////////
+// Publish a metrics snapshot, adding the summaries of the last interval
+// histograms. Only called from the thread that runs the stream.
+void openavbTLMetricsPublish(tl_state_t *pTLState, tl_metrics_t *pMetrics, tl_hists_t *pHists);
+// Render the metrics of all streams in the Prometheus text format into a
+// malloc'd buffer that the caller frees. Returns NULL on failure.
+char *openavbTLMetricsRender(size_t *pLen);
+
 ////////////////
 // timespec support functions
 ////////////////
@@ -0,0 +1,332 @@
+/*************************************************************************************************************
+Copyright (c) 2012-2015, Symphony Teleca Corporation, a Harman International Industries, Incorporated company
+Copyright (c) 2016-2017, Harman International Industries, Incorporated
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS LISTED "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS LISTED BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Attributions: The inih library portion of the source code is licensed from
+Brush Technology and Ben Hoyt - Copyright (c) 2009, Brush Technology and Copyright (c) 2009, Ben Hoyt.
+Complete license and copyright information can be found at
+https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
+*************************************************************************************************************/
+
+/*
+* MODULE SUMMARY : Metrics snapshots of the talkers and listeners, rendered
+* in the Prometheus text exposition format.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <string.h>
+#include <inttypes.h>
+#include "openavb_tl.h"
+#include "openavb_trace.h"
+
+#define	AVB_LOG_COMPONENT	"Talker / Listener"
+#include "openavb_pub.h"
+#include "openavb_log.h"
+
+// Tries before giving up on a snapshot that is being rewritten
+#define METRICS_READ_RETRIES		1000
+
+// Initial size of the render buffer; doubled as needed
+#define METRICS_BUF_SIZE			16384
+
+typedef struct {
+	char *pBuf;
+	size_t len;
+	size_t size;
+	bool bFailed;
+} metrics_buf_t;
+
+typedef struct {
+	avb_role_t role;
+	char ifname[IFNAMSIZ + 10];
+	tl_metrics_t metrics;
+} metrics_stream_t;
+
+// Counters and levels, all U64 in tl_metrics_t
+typedef struct {
+	const char *name;
+	const char *type;
+	const char *help;
+	size_t offset;
+	avb_role_t role;		// AVB_ROLE_UNDEFINED for both roles
+} metrics_def_t;
+
+static const metrics_def_t metricsDefs[] = {
+	{ "openavb_stream_calls_total", "counter", "Talker intervals or listener receive calls",
+		offsetof(tl_metrics_t, calls), AVB_ROLE_UNDEFINED },
+	{ "openavb_stream_frames_total", "counter", "AVTP frames sent or received",
+		offsetof(tl_metrics_t, frames), AVB_ROLE_UNDEFINED },
+	{ "openavb_stream_bytes_total", "counter", "AVTP payload bytes sent or received",
+		offsetof(tl_metrics_t, bytes), AVB_ROLE_UNDEFINED },
+	{ "openavb_stream_late_total", "counter", "Talker intervals missed, counted at each report",
+		offsetof(tl_metrics_t, late), AVB_ROLE_TALKER },
+	{ "openavb_stream_lost_total", "counter", "AVTP frames lost according to the sequence numbers",
+		offsetof(tl_metrics_t, lost), AVB_ROLE_LISTENER },
+	{ "openavb_stream_tx_out_of_buffers_total", "counter", "Times the rawsock had no TX buffer",
+		offsetof(tl_metrics_t, txOutOfBuffers), AVB_ROLE_TALKER },
+	{ "openavb_stream_mediaq_items", "gauge", "Items in the media queue",
+		offsetof(tl_metrics_t, mqItems), AVB_ROLE_UNDEFINED },
+	{ "openavb_stream_mediaq_ready_items", "gauge", "Media queue items due for presentation",
+		offsetof(tl_metrics_t, mqReady), AVB_ROLE_LISTENER },
+	{ "openavb_stream_rawsock_frames", "gauge", "Frames held in the rawsock TX or RX buffers",
+		offsetof(tl_metrics_t, rawsockLevel), AVB_ROLE_UNDEFINED },
+};
+
+// Label values of the histograms, indexed by tl_hist_t
+static const char *metricsHistNames[] = {
+	"tx_wakeup_late",
+	"tx_intf_cb",
+	"tx_map_cb",
+	"rx_intf_cb",
+	"rx_map_cb",
+	"rx_margin",
+};
+
+void openavbTLMetricsPublish(tl_state_t *pTLState, tl_metrics_t *pMetrics, tl_hists_t *pHists)
+{
+	int i;
+
+	LOCK_STATS();
+	for (i = 0; i < TL_HIST_CNT; i++) {
+		openavb_hist_t *pHist = &pHists->last[i];
+		tl_hist_summary_t *pSummary = &pMetrics->hist[i];
+		pSummary->count = pHist->count;
+		if (pHist->count > 0) {
+			pSummary->min = pHist->min;
+			pSummary->max = pHist->max;
+			pSummary->p50 = openavbHistPercentile(pHist, 50.0);
+			pSummary->p99 = openavbHistPercentile(pHist, 99.0);
+			pSummary->p999 = openavbHistPercentile(pHist, 99.9);
+		}
+	}
+	UNLOCK_STATS();
+
+	U32 seq = __atomic_load_n(&pTLState->metricsSeq, __ATOMIC_RELAXED);
+	__atomic_store_n(&pTLState->metricsSeq, seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	pTLState->metrics = *pMetrics;
+	__atomic_store_n(&pTLState->metricsSeq, seq + 2, __ATOMIC_RELEASE);
+}
+
+// Copy the snapshot of a stream. Returns FALSE if the stream hasn't published one.
+static bool metricsRead(tl_state_t *pTLState, tl_metrics_t *pMetrics)
+{
+	int i;
+	for (i = 0; i < METRICS_READ_RETRIES; i++) {
+		U32 seq1 = __atomic_load_n(&pTLState->metricsSeq, __ATOMIC_ACQUIRE);
+		if (seq1 == 0) {
+			return FALSE;
+		}
+		*pMetrics = pTLState->metrics;
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		U32 seq2 = __atomic_load_n(&pTLState->metricsSeq, __ATOMIC_RELAXED);
+		if (!(seq1 & 1) && seq1 == seq2) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+static void metricsPrintf(metrics_buf_t *pMB, const char *fmt, ...)
+{
+	if (pMB->bFailed) {
+		return;
+	}
+
+	while (1) {
+		va_list args;
+		va_start(args, fmt);
+		int len = vsnprintf(pMB->pBuf + pMB->len, pMB->size - pMB->len, fmt, args);
+		va_end(args);
+		if (len < 0) {
+			pMB->bFailed = TRUE;
+			return;
+		}
+		if (pMB->len + len < pMB->size) {
+			pMB->len += len;
+			return;
+		}
+
+		char *pBuf = realloc(pMB->pBuf, pMB->size * 2);
+		if (!pBuf) {
+			pMB->bFailed = TRUE;
+			return;
+		}
+		pMB->pBuf = pBuf;
+		pMB->size *= 2;
+	}
+}
+
+// Print nanoseconds as seconds without going through a double
+static void metricsPrintNsec(metrics_buf_t *pMB, S64 nsec)
+{
+	U64 abs = nsec < 0 ? -(U64)nsec : (U64)nsec;
+	metricsPrintf(pMB, "%s%" PRIu64 ".%09" PRIu64 "\n", nsec < 0 ? "-" : "",
+		abs / NANOSECONDS_PER_SECOND, abs % NANOSECONDS_PER_SECOND);
+}
+
+static void metricsPrintLabels(metrics_buf_t *pMB, metrics_stream_t *pStream)
+{
+	const char *pC;
+
+	metricsPrintf(pMB, "stream=\"" STREAMID_FORMAT "\",role=\"%s\",ifname=\"",
+		STREAMID_ARGS(&pStream->metrics.streamID),
+		pStream->role == AVB_ROLE_TALKER ? "talker" : "listener");
+	for (pC = pStream->ifname; *pC; pC++) {
+		if (*pC == '"' || *pC == '\\') {
+			metricsPrintf(pMB, "\\%c", *pC);
+		}
+		else {
+			metricsPrintf(pMB, "%c", *pC);
+		}
+	}
+	metricsPrintf(pMB, "\"");
+}
+
+static void metricsPrintHeader(metrics_buf_t *pMB, const char *name, const char *type, const char *help)
+{
+	metricsPrintf(pMB, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+char *openavbTLMetricsRender(size_t *pLen)
+{
+	AVB_TRACE_ENTRY(AVB_TRACE_TL);
+
+	metrics_buf_t mb;
+	metrics_stream_t *pStreams;
+	U32 nStreams = 0;
+	U32 i1, i2;
+
+	if (!gTLHandleList) {
+		AVB_TRACE_EXIT(AVB_TRACE_TL);
+		return NULL;
+	}
+
+	pStreams = calloc(gMaxTL ? gMaxTL : 1, sizeof(metrics_stream_t));
+	mb.pBuf = malloc(METRICS_BUF_SIZE);
+	mb.size = METRICS_BUF_SIZE;
+	mb.len = 0;
+	mb.bFailed = FALSE;
+	if (!pStreams || !mb.pBuf) {
+		free(pStreams);
+		free(mb.pBuf);
+		AVB_TRACE_EXIT(AVB_TRACE_TL);
+		return NULL;
+	}
+
+	// Only copy the snapshots while holding the lock; the stream threads never wait for us.
+	TL_LOCK();
+	for (i1 = 0; i1 < gMaxTL; i1++) {
+		tl_state_t *pTLState = (tl_state_t *)gTLHandleList[i1];
+		if (pTLState && metricsRead(pTLState, &pStreams[nStreams].metrics)) {
+			pStreams[nStreams].role = pTLState->cfg.role;
+			memcpy(pStreams[nStreams].ifname, pTLState->cfg.ifname, sizeof(pStreams[nStreams].ifname));
+			pStreams[nStreams].ifname[sizeof(pStreams[nStreams].ifname) - 1] = '\0';
+			nStreams++;
+		}
+	}
+	TL_UNLOCK();
+
+	metricsPrintHeader(&mb, "openavb_stream_streaming", "gauge", "1 while the stream is streaming");
+	for (i2 = 0; i2 < nStreams; i2++) {
+		metricsPrintf(&mb, "openavb_stream_streaming{");
+		metricsPrintLabels(&mb, &pStreams[i2]);
+		metricsPrintf(&mb, "} %d\n", pStreams[i2].metrics.bStreaming ? 1 : 0);
+	}
+
+	for (i1 = 0; i1 < sizeof(metricsDefs) / sizeof(metricsDefs[0]); i1++) {
+		const metrics_def_t *pDef = &metricsDefs[i1];
+		metricsPrintHeader(&mb, pDef->name, pDef->type, pDef->help);
+		for (i2 = 0; i2 < nStreams; i2++) {
+			if (pDef->role != AVB_ROLE_UNDEFINED && pDef->role != pStreams[i2].role) {
+				continue;
+			}
+			metricsPrintf(&mb, "%s{", pDef->name);
+			metricsPrintLabels(&mb, &pStreams[i2]);
+			metricsPrintf(&mb, "} %" PRIu64 "\n", *(U64 *)((U8 *)&pStreams[i2].metrics + pDef->offset));
+		}
+	}
+
+	// Histograms of the last report interval; min and max are quantiles 0 and 1
+	metricsPrintHeader(&mb, "openavb_stream_latency_seconds", "gauge", "Latency quantiles over the last report interval");
+	for (i2 = 0; i2 < nStreams; i2++) {
+		tl_hist_t first = pStreams[i2].role == AVB_ROLE_TALKER ? TL_HIST_TX_WAKEUP_LATE : TL_HIST_RX_INTF_CB;
+		for (i1 = 0; i1 < TL_HIST_CNT; i1++) {
+			tl_hist_summary_t *pSummary = &pStreams[i2].metrics.hist[i1];
+			const char *quantiles[] = { "0", "0.5", "0.99", "0.999", "1" };
+			S64 values[] = { pSummary->min, pSummary->p50, pSummary->p99, pSummary->p999, pSummary->max };
+			int i3;
+			if (pSummary->count == 0) {
+				continue;
+			}
+			for (i3 = 0; i3 < 5; i3++) {
+				metricsPrintf(&mb, "openavb_stream_latency_seconds{");
+				metricsPrintLabels(&mb, &pStreams[i2]);
+				metricsPrintf(&mb, ",hist=\"%s\",quantile=\"%s\"} ", metricsHistNames[first + i1], quantiles[i3]);
+				metricsPrintNsec(&mb, values[i3]);
+			}
+		}
+	}
+
+	metricsPrintHeader(&mb, "openavb_stream_latency_samples", "gauge", "Samples in the last report interval latency histograms");
+	for (i2 = 0; i2 < nStreams; i2++) {
+		tl_hist_t first = pStreams[i2].role == AVB_ROLE_TALKER ? TL_HIST_TX_WAKEUP_LATE : TL_HIST_RX_INTF_CB;
+		for (i1 = 0; i1 < TL_HIST_CNT; i1++) {
+			metricsPrintf(&mb, "openavb_stream_latency_samples{");
+			metricsPrintLabels(&mb, &pStreams[i2]);
+			metricsPrintf(&mb, ",hist=\"%s\"} %u\n", metricsHistNames[first + i1], pStreams[i2].metrics.hist[i1].count);
+		}
+	}
+
+	S64 mlNsec, lsNsec, errNsec;
+	if (CLOCK_PTP_OFFSETS(&mlNsec, &lsNsec)) {
+		metricsPrintHeader(&mb, "openavb_gptp_master_local_offset_seconds", "gauge", "gPTP master to local clock phase offset");
+		metricsPrintf(&mb, "openavb_gptp_master_local_offset_seconds ");
+		metricsPrintNsec(&mb, mlNsec);
+		metricsPrintHeader(&mb, "openavb_gptp_local_system_offset_seconds", "gauge", "gPTP local to system clock phase offset");
+		metricsPrintf(&mb, "openavb_gptp_local_system_offset_seconds ");
+		metricsPrintNsec(&mb, lsNsec);
+	}
+	if (CLOCK_WALLTIME_CHECK(&errNsec)) {
+		metricsPrintHeader(&mb, "openavb_gptp_walltime_error_seconds", "gauge", "Error of the cached wall time conversion");
+		metricsPrintf(&mb, "openavb_gptp_walltime_error_seconds ");
+		metricsPrintNsec(&mb, errNsec);
+	}
+
+	free(pStreams);
+
+	if (mb.bFailed) {
+		AVB_LOG_ERROR("Unable to render the metrics");
+		free(mb.pBuf);
+		AVB_TRACE_EXIT(AVB_TRACE_TL);
+		return NULL;
+	}
+
+	*pLen = mb.len;
+	AVB_TRACE_EXIT(AVB_TRACE_TL);
+	return mb.pBuf;
+}
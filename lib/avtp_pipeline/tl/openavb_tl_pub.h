@@ -41,6 +41,7 @@ https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
 #include "openavb_map_pub.h"
 #include "openavb_intf_pub.h"
 #include "openavb_avtp_time_pub.h"
+#include "openavb_hist_pub.h"
 
 /** \file
  * Talker Listener Public Interface.
@@ -69,6 +70,22 @@ typedef enum {
 	TL_STAT_RX_BYTES,
 } tl_stat_t;
 
+/// Histograms gathered. All values are in nanoseconds.
+typedef enum {
+	/// Talker wakeup time past the scheduled transmit interval
+	TL_HIST_TX_WAKEUP_LATE,
+	/// Duration of the talker interface module tx callback
+	TL_HIST_TX_INTF_CB,
+	/// Duration of the talker mapping module tx callback
+	TL_HIST_TX_MAP_CB,
+	/// Duration of the listener interface module rx callback
+	TL_HIST_RX_INTF_CB,
+	/// Duration of the listener mapping module rx callback
+	TL_HIST_RX_MAP_CB,
+	/// Presentation time less the time the item is pulled from the media queue. Negative when late.
+	TL_HIST_RX_MARGIN,
+} tl_hist_t;
+
 /// Maximum number of configuration parameters inside INI file a host can have
 #define MAX_LIB_CFG_ITEMS 64
 
@@ -154,6 +171,22 @@ typedef struct {
 	U32 thread_affinity;
 	/// Real time priority of thread.
 	U32 thread_rt_priority;
+	/// Use the lockless single producer / single consumer media queue mode.
+	bool mediaq_lockless;
+	/// Transmit scheduler group. 0 to transmit from the talker thread.
+	U32 tx_sched_group;
+	/// Receive through the RX demultiplexer shared by all listeners on the interface.
+	bool rx_demux;
+	/// Have the kernel send each frame at its launch time (SO_TXTIME).
+	bool tx_launch_time;
+	/// Least time between handing a frame to the kernel and its launch time (usec).
+	U32 tx_launch_lead_usec;
+	/// Wake the talker when the interface module has data instead of at a fixed interval.
+	bool tx_intf_wakeup;
+	/// Timestamp received frames to measure their arrival to presentation time margin.
+	bool rx_timestamp;
+	/// Number of frames kept by the flight recorder. 0 to turn it off.
+	U32 flight_events;
 	/// Friendly name for this configuration
 	char friendly_name[FRIENDLY_NAME_SIZE];
 
@@ -374,6 +407,69 @@ tl_init_state_t openavbTLGetInitialState(tl_handle_t handle);
  */
 U64 openavbTLStat(tl_handle_t handle, tl_stat_t stat);
 
+/** Get a histogram of a running stream.
+ *
+ * The histograms are collected per report interval (report_seconds or
+ * report_frames). When a report is made the current histograms become the
+ * last interval histograms and collection starts over.
+ * Only the histograms of the stream's role are available.
+ *
+ * \param handle The handle return from openavbTLOpen()
+ * \param hist Which histogram to retrieve
+ * \param bLastInterval TRUE for the last complete report interval, FALSE for
+ *        the current one. The current histogram is updated while it is copied
+ *        and may be slightly inconsistent.
+ * \param pHist Receives a copy of the histogram
+ * \return TRUE on success or FALSE if the histogram is not available
+ */
+bool openavbTLHist(tl_handle_t handle, tl_hist_t hist, bool bLastInterval, openavb_hist_t *pHist);
+
+/** Clear the histograms of a stream.
+ *
+ * \param handle The handle return from openavbTLOpen()
+ */
+void openavbTLHistClear(tl_handle_t handle);
+
+/** Start serving the metrics of all streams.
+ *
+ * A background thread with normal (non real-time) scheduling serves the
+ * counters, queue and buffer levels and last report interval latency
+ * quantiles of every stream, plus the gPTP offsets, in the Prometheus text
+ * exposition format over HTTP. The streams publish their metrics about once
+ * a second and never wait for the metrics server.
+ * Must be called after openavbTLInitialize().
+ *
+ * \param addr Where to listen: "unix:<path>" for a unix socket, or
+ *        "[<host>:]<port>" for TCP, where host defaults to the loopback
+ *        address
+ * \return TRUE on success or FALSE on failure
+ */
+bool openavbTLMetricsStart(const char *addr);
+
+/** Stop serving the metrics.
+ */
+void openavbTLMetricsStop(void);
+
+/** Dump the flight recorders of all streams.
+ *
+ * Streams with flight_events set keep an event for each of their last frames
+ * sent or received: time, sequence number, AVTP timestamp, media queue depth
+ * and late / lost flags. A background thread writes the events of all
+ * streams to a new text file in the dump directory. Listeners also request
+ * a dump when they see a sequence gap, at most every 10 seconds. Those
+ * rotate through 8 files, avtp_flight_gap_<0-7>.txt.
+ * Only wakes the background thread, so it can be called from a signal
+ * handler. Must be called after openavbTLInitialize().
+ */
+void openavbTLFlightDump(void);
+
+/** Set the directory the flight recorder dumps are written to.
+ *
+ * \param dir The directory. Defaults to /tmp.
+ * \return TRUE on success or FALSE on failure
+ */
+bool openavbTLFlightDir(const char *dir);
+
 /** Read an ini file.
  *
  * Parses an input configuration file tp populate configuration structures, and
@@ -0,0 +1,128 @@
+/*************************************************************************************************************
+Copyright (c) 2012-2015, Symphony Teleca Corporation, a Harman International Industries, Incorporated company
+Copyright (c) 2016-2017, Harman International Industries, Incorporated
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS LISTED "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS LISTED BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Attributions: The inih library portion of the source code is licensed from
+Brush Technology and Ben Hoyt - Copyright (c) 2009, Brush Technology and Copyright (c) 2009, Ben Hoyt.
+Complete license and copyright information can be found at
+https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
+*************************************************************************************************************/
+
+/*
+* MODULE SUMMARY : Fixed memory log-linear histogram
+*/
+
+#include <string.h>
+#include "openavb_hist_pub.h"
+
+static U32 x_histIdx(U64 val)
+{
+	if (val < OPENAVB_HIST_SUB_CNT)
+		return (U32)val;
+
+	U32 msb = 63 - __builtin_clzll(val);
+	if (msb >= OPENAVB_HIST_MAX_BITS)
+		return OPENAVB_HIST_BUCKETS - 1;
+
+	U32 sub = (U32)(val >> (msb - OPENAVB_HIST_SUB_BITS)) & (OPENAVB_HIST_SUB_CNT - 1);
+	return (msb - OPENAVB_HIST_SUB_BITS + 1) * OPENAVB_HIST_SUB_CNT + sub;
+}
+
+// Largest value that falls in the bucket
+static U64 x_histBound(U32 idx)
+{
+	if (idx < OPENAVB_HIST_SUB_CNT)
+		return idx;
+
+	U32 msb = idx / OPENAVB_HIST_SUB_CNT - 1 + OPENAVB_HIST_SUB_BITS;
+	U64 sub = idx % OPENAVB_HIST_SUB_CNT;
+	return ((OPENAVB_HIST_SUB_CNT + sub + 1) << (msb - OPENAVB_HIST_SUB_BITS)) - 1;
+}
+
+void openavbHistClear(openavb_hist_t *pHist)
+{
+	memset(pHist, 0, sizeof(*pHist));
+}
+
+void openavbHistAdd(openavb_hist_t *pHist, S64 val)
+{
+	if (pHist->count == 0) {
+		pHist->min = pHist->max = val;
+	}
+	else if (val < pHist->min) {
+		pHist->min = val;
+	}
+	else if (val > pHist->max) {
+		pHist->max = val;
+	}
+	pHist->sum += val;
+	pHist->count++;
+
+	if (val >= 0)
+		pHist->pos[x_histIdx((U64)val)]++;
+	else
+		pHist->neg[x_histIdx(-(U64)val)]++;
+}
+
+S64 openavbHistPercentile(const openavb_hist_t *pHist, double percent)
+{
+	if (pHist->count == 0)
+		return 0;
+
+	// Number of values at or below the percentile
+	U64 rank = (U64)(percent * pHist->count / 100.0 + 0.5);
+	if (rank < 1)
+		rank = 1;
+	if (rank > pHist->count)
+		rank = pHist->count;
+
+	S64 val = pHist->max;
+	U64 cnt = 0;
+	int i;
+	bool bFound = FALSE;
+
+	// Negative values, largest magnitude first
+	for (i = OPENAVB_HIST_BUCKETS - 1; i >= 0 && !bFound; i--) {
+		cnt += pHist->neg[i];
+		if (cnt >= rank) {
+			// Upper bound of a negative bucket is its smallest magnitude
+			val = i > 0 ? -(S64)x_histBound(i - 1) - 1 : 0;
+			bFound = TRUE;
+		}
+	}
+	for (i = 0; i < OPENAVB_HIST_BUCKETS && !bFound; i++) {
+		cnt += pHist->pos[i];
+		if (cnt >= rank) {
+			// The last bucket has no upper bound
+			val = i < OPENAVB_HIST_BUCKETS - 1 ? (S64)x_histBound(i) : pHist->max;
+			bFound = TRUE;
+		}
+	}
+
+	if (val < pHist->min)
+		val = pHist->min;
+	if (val > pHist->max)
+		val = pHist->max;
+	return val;
+}
@@ -32,7 +32,10 @@ https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
 #include "openavb_types_pub.h"
 #include "openavb_platform_pub.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <string.h>
 #include "openavb_queue.h"
 #include "openavb_tcal_pub.h"
@@ -41,27 +44,58 @@ https://github.com/benhoyt/inih/commit/74d2ca064fb293bc60a77b0bd068075b293cf175.
 
 typedef struct {
 	U8 msg[LOG_QUEUE_MSG_SIZE];
-  	bool bRT;						// TRUE = Details are in RT queue
 } log_queue_item_t;
 
+// Argument types as they are passed through the variable argument list
+typedef enum {
+	LOG_RT_ARG_INT,
+	LOG_RT_ARG_LONG,
+	LOG_RT_ARG_LLONG,
+	LOG_RT_ARG_INTMAX,
+	LOG_RT_ARG_SIZE,
+	LOG_RT_ARG_PTRDIFF,
+	LOG_RT_ARG_DOUBLE,
+	LOG_RT_ARG_PTR,
+	LOG_RT_ARG_NONE,				// Conversion without an argument (%%)
+	LOG_RT_ARG_UNSUPPORTED
+} log_rt_arg_t;
+
 typedef struct {
-	char *pFormat;
-	log_rt_datatype_t dataType;
-	union {
-		struct timespec nowTS;
-		U16 unsignedShortVar;
-		S16 signedShortVar;
-		U32 unsignedLongVar;
-		S32 signedLongVar;
-		U64 unsignedLongLongVar;
-		S64 signedLongLongVar;
-		float floatVar;
-	} data;
+	const char *pFormat;			// NULL if the record has no text
+	const char *tag;				// NULL for the AVB_LOGRT_* fragments
+	const char *company;
+	const char *component;
+	const char *path;
+	int line;
+	struct timespec nowTS;
+	bool bBegin;
 	bool bEnd;
-} log_rt_queue_item_t;
+	U8 nArgs;
+	U8 argType[LOG_RT_MAX_ARGS];
+	union {
+		U64 intVar;
+		double doubleVar;
+		const void *ptrVar;
+	} arg[LOG_RT_MAX_ARGS];
+} log_rt_rec_t;
+
+// Single producer (the owning thread), single consumer (the log output) ring.
+// head and tail run freely, the index is taken modulo LOG_RT_RING_CNT.
+typedef struct log_rt_ring {
+	struct log_rt_ring *pNext;
+	U32 head;						// Written by the producer
+	U32 tail;						// Written by the consumer
+	U32 drops;						// Written by the producer
+	U32 dropsReported;				// Consumer only
+	bool bOwned;					// A live thread is using the ring
+	bool bDropLine;					// Producer only. Drop the rest of the current line
+	unsigned long thread;
+	U32 lineLen;					// Consumer only. The line being rendered
+	char lineMsg[LOG_FULL_MSG_LEN];
+	log_rt_rec_t rec[LOG_RT_RING_CNT];
+} log_rt_ring_t;
 
 static openavb_queue_t logQueue;
-static openavb_queue_t logRTQueue;
 static FILE *logOutputFd = NULL;
 
 static char msg[LOG_MSG_LEN] = "";
@@ -72,7 +106,12 @@ static char proc_msg[LOG_PROC_LEN] = "";
 static char thread_msg[LOG_THREAD_LEN] = "";
 static char full_msg[LOG_FULL_MSG_LEN] = "";
 
-static char rt_msg[LOG_RT_MSG_LEN] = "";
+static char rt_msg[LOG_FULL_MSG_LEN] = "";
+
+static log_rt_ring_t *logRTRings = NULL;
+static bool logRTInit = FALSE;
+static THREAD_LOCAL log_rt_ring_t *tlsLogRTRing = NULL;
+static THREAD_KEY_HANDLE(logRTRingKey);
 
 static bool loggingThreadRunning = false;
 extern void *loggingThreadFn(void *pv);
@@ -83,68 +122,383 @@ static MUTEX_HANDLE_ALT(gLogMutex);
 #define LOG_LOCK() MUTEX_LOCK_ALT(gLogMutex)
 #define LOG_UNLOCK() MUTEX_UNLOCK_ALT(gLogMutex)
 
-void avbLogRTRender(log_queue_item_t *pLogItem)
+// Called when a thread that used the RT log exits. The ring is reused by the
+// next new thread once it has been drained.
+static void logRTRingRelease(void *pv)
 {
-	if (logRTQueue) {
-	  	pLogItem->msg[0] = 0x00;
-		bool bMore = TRUE;
-		while (bMore) {
-			openavb_queue_elem_t elem = openavbQueueTailLock(logRTQueue);
-			if (elem) {
-				log_rt_queue_item_t *pLogRTItem = (log_rt_queue_item_t *)openavbQueueData(elem);
-								
-				switch (pLogRTItem->dataType) {
-					case LOG_RT_DATATYPE_CONST_STR:
-						strcat((char *)pLogItem->msg, pLogRTItem->pFormat);
-						break;
-					case LOG_RT_DATATYPE_NOW_TS:
-						snprintf(rt_msg, LOG_RT_MSG_LEN, "[%lu:%09lu] ", pLogRTItem->data.nowTS.tv_sec, pLogRTItem->data.nowTS.tv_nsec);
-						strcat((char *)pLogItem->msg, rt_msg);
-						break;
-					case LOG_RT_DATATYPE_U16:
-						snprintf(rt_msg, LOG_RT_MSG_LEN, pLogRTItem->pFormat, pLogRTItem->data.unsignedShortVar);
-						strcat((char *)pLogItem->msg, rt_msg);
-						break;
-					case LOG_RT_DATATYPE_S16:
-						snprintf(rt_msg, LOG_RT_MSG_LEN, pLogRTItem->pFormat, pLogRTItem->data.signedShortVar);
-						strcat((char *)pLogItem->msg, rt_msg);
-						break;
-					case LOG_RT_DATATYPE_U32:
-						snprintf(rt_msg, LOG_RT_MSG_LEN, pLogRTItem->pFormat, pLogRTItem->data.unsignedLongVar);
-						strcat((char *)pLogItem->msg, rt_msg);
-						break;
-					case LOG_RT_DATATYPE_S32:
-						snprintf(rt_msg, LOG_RT_MSG_LEN, pLogRTItem->pFormat, pLogRTItem->data.signedLongVar);
-						strcat((char *)pLogItem->msg, rt_msg);
-						break;
-					case LOG_RT_DATATYPE_U64:
-						snprintf(rt_msg, LOG_RT_MSG_LEN, pLogRTItem->pFormat, pLogRTItem->data.unsignedLongLongVar);
-						strcat((char *)pLogItem->msg, rt_msg);
-						break;
-					case LOG_RT_DATATYPE_S64:
-						snprintf(rt_msg, LOG_RT_MSG_LEN, pLogRTItem->pFormat, pLogRTItem->data.signedLongLongVar);
-						strcat((char *)pLogItem->msg, rt_msg);
-						break;
-					case LOG_RT_DATATYPE_FLOAT:
-						snprintf(rt_msg, LOG_RT_MSG_LEN, pLogRTItem->pFormat, pLogRTItem->data.floatVar);
-						strcat((char *)pLogItem->msg, rt_msg);
-						break;
-					default:
-						break;
-				}
+	log_rt_ring_t *pRing = (log_rt_ring_t *)pv;
+	__atomic_store_n(&pRing->bOwned, FALSE, __ATOMIC_RELEASE);
+}
 
-				if (pLogRTItem->bEnd) {
-					if (OPENAVB_TCAL_LOG_EXTRA_NEWLINE)
-						strcat((char *)pLogItem->msg, "\n");
-					bMore = FALSE;
-				}
-				openavbQueueTailPull(logRTQueue);
+static log_rt_ring_t *logRTRingGet(void)
+{
+	log_rt_ring_t *pRing = tlsLogRTRing;
+	if (pRing)
+		return pRing;
+
+	if (!logRTInit)
+		return NULL;
+
+	for (pRing = __atomic_load_n(&logRTRings, __ATOMIC_ACQUIRE); pRing; pRing = pRing->pNext) {
+		bool bOwned = FALSE;
+		if (__atomic_load_n(&pRing->tail, __ATOMIC_ACQUIRE) == __atomic_load_n(&pRing->head, __ATOMIC_RELAXED)
+			&& __atomic_compare_exchange_n(&pRing->bOwned, &bOwned, TRUE, FALSE, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+			break;
+		}
+	}
+
+	if (!pRing) {
+		// Rings are never freed, a thread may still log after avbLogExit()
+		pRing = calloc(1, sizeof(log_rt_ring_t));
+		if (!pRing)
+			return NULL;
+		pRing->bOwned = TRUE;
+		pRing->pNext = __atomic_load_n(&logRTRings, __ATOMIC_RELAXED);
+		while (!__atomic_compare_exchange_n(&logRTRings, &pRing->pNext, pRing, FALSE, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+	}
+
+	__atomic_store_n(&pRing->thread, (unsigned long)THREAD_SELF(), __ATOMIC_RELAXED);
+	pRing->bDropLine = FALSE;
+	THREAD_KEY_SET(logRTRingKey, pRing);
+	tlsLogRTRing = pRing;
+	return pRing;
+}
+
+// Get the record to fill in, or NULL if the ring is full
+static log_rt_rec_t *logRTRecGet(log_rt_ring_t *pRing, bool bBegin)
+{
+	if (bBegin)
+		pRing->bDropLine = FALSE;
+
+	if (!pRing->bDropLine) {
+		U32 head = pRing->head;
+		if (head - __atomic_load_n(&pRing->tail, __ATOMIC_ACQUIRE) < LOG_RT_RING_CNT)
+			return &pRing->rec[head & (LOG_RT_RING_CNT - 1)];
+		pRing->bDropLine = TRUE;
+	}
+
+	__atomic_store_n(&pRing->drops, pRing->drops + 1, __ATOMIC_RELAXED);
+	return NULL;
+}
+
+static void logRTRecPush(log_rt_ring_t *pRing)
+{
+	__atomic_store_n(&pRing->head, pRing->head + 1, __ATOMIC_RELEASE);
+}
+
+// Parse the conversion specification following a '%'. Moves *ppFmt past it
+// and returns the type of argument it consumes.
+static log_rt_arg_t logRTParseConv(const char **ppFmt)
+{
+	const char *p = *ppFmt;
+	log_rt_arg_t type = LOG_RT_ARG_INT;
+	bool bUnsupported = FALSE;
+
+	// flags, width and precision
+	while (*p && strchr("-+ #0'123456789.*", *p)) {
+		if (*p++ == '*')
+			bUnsupported = TRUE;
+	}
+
+	// length modifier
+	switch (*p) {
+		case 'h':
+			if (*++p == 'h')
+				p++;
+			break;
+		case 'l':
+			type = LOG_RT_ARG_LONG;
+			if (*++p == 'l') {
+				type = LOG_RT_ARG_LLONG;
+				p++;
 			}
-		  
+			break;
+		case 'q':
+			type = LOG_RT_ARG_LLONG;
+			p++;
+			break;
+		case 'j':
+			type = LOG_RT_ARG_INTMAX;
+			p++;
+			break;
+		case 'z':
+			type = LOG_RT_ARG_SIZE;
+			p++;
+			break;
+		case 't':
+			type = LOG_RT_ARG_PTRDIFF;
+			p++;
+			break;
+		case 'L':
+			bUnsupported = TRUE;
+			p++;
+			break;
+		default:
+			break;
+	}
+
+	char conv = *p;
+	if (conv)
+		p++;
+	*ppFmt = p;
+
+	switch (conv) {
+		case '%':
+			return LOG_RT_ARG_NONE;
+		case 'd':
+		case 'i':
+		case 'u':
+		case 'o':
+		case 'x':
+		case 'X':
+		case 'c':
+			break;
+		case 'f':
+		case 'F':
+		case 'e':
+		case 'E':
+		case 'g':
+		case 'G':
+		case 'a':
+		case 'A':
+			type = LOG_RT_ARG_DOUBLE;
+			break;
+		case 's':
+		case 'p':
+			type = LOG_RT_ARG_PTR;
+			break;
+		default:
+			bUnsupported = TRUE;
+			break;
+	}
+
+	return bUnsupported ? LOG_RT_ARG_UNSUPPORTED : type;
+}
+
+// Copy the raw arguments described by the format into the record
+static void logRTCaptureArgs(log_rt_rec_t *pRec, const char *fmt, va_list args)
+{
+	const char *p = fmt;
+
+	pRec->nArgs = 0;
+	while ((p = strchr(p, '%')) != NULL && pRec->nArgs < LOG_RT_MAX_ARGS) {
+		p++;
+		log_rt_arg_t type = logRTParseConv(&p);
+		if (type == LOG_RT_ARG_NONE)
+			continue;
+		if (type == LOG_RT_ARG_UNSUPPORTED)
+			break;
+
+		U8 i = pRec->nArgs++;
+		pRec->argType[i] = type;
+		switch (type) {
+			case LOG_RT_ARG_INT:
+				pRec->arg[i].intVar = (U64)va_arg(args, int);
+				break;
+			case LOG_RT_ARG_LONG:
+				pRec->arg[i].intVar = (U64)va_arg(args, long);
+				break;
+			case LOG_RT_ARG_LLONG:
+				pRec->arg[i].intVar = (U64)va_arg(args, long long);
+				break;
+			case LOG_RT_ARG_INTMAX:
+				pRec->arg[i].intVar = (U64)va_arg(args, intmax_t);
+				break;
+			case LOG_RT_ARG_SIZE:
+				pRec->arg[i].intVar = (U64)va_arg(args, size_t);
+				break;
+			case LOG_RT_ARG_PTRDIFF:
+				pRec->arg[i].intVar = (U64)va_arg(args, ptrdiff_t);
+				break;
+			case LOG_RT_ARG_DOUBLE:
+				pRec->arg[i].doubleVar = va_arg(args, double);
+				break;
+			case LOG_RT_ARG_PTR:
+				pRec->arg[i].ptrVar = va_arg(args, const void *);
+				break;
+			default:
+				break;
 		}
 	}
 }
 
+static int logRTRenderArg(char *pBuf, U32 bufSize, const char *spec, U8 type, const log_rt_rec_t *pRec, U8 i)
+{
+	switch (type) {
+		case LOG_RT_ARG_INT:
+			return snprintf(pBuf, bufSize, spec, (int)pRec->arg[i].intVar);
+		case LOG_RT_ARG_LONG:
+			return snprintf(pBuf, bufSize, spec, (long)pRec->arg[i].intVar);
+		case LOG_RT_ARG_LLONG:
+			return snprintf(pBuf, bufSize, spec, (long long)pRec->arg[i].intVar);
+		case LOG_RT_ARG_INTMAX:
+			return snprintf(pBuf, bufSize, spec, (intmax_t)pRec->arg[i].intVar);
+		case LOG_RT_ARG_SIZE:
+			return snprintf(pBuf, bufSize, spec, (size_t)pRec->arg[i].intVar);
+		case LOG_RT_ARG_PTRDIFF:
+			return snprintf(pBuf, bufSize, spec, (ptrdiff_t)pRec->arg[i].intVar);
+		case LOG_RT_ARG_DOUBLE:
+			return snprintf(pBuf, bufSize, spec, pRec->arg[i].doubleVar);
+		case LOG_RT_ARG_PTR:
+			return snprintf(pBuf, bufSize, spec, pRec->arg[i].ptrVar);
+		default:
+			return 0;
+	}
+}
+
+// Format the record text into pBuf. Anything that can't be formatted is copied as is.
+static U32 logRTRenderFmt(char *pBuf, U32 bufSize, const log_rt_rec_t *pRec)
+{
+	const char *p = pRec->pFormat;
+	U32 len = 0;
+	U8 i = 0;
+
+	while (*p && len < bufSize - 1) {
+		if (*p != '%') {
+			pBuf[len++] = *p++;
+			continue;
+		}
+
+		const char *pSpec = p++;
+		log_rt_arg_t type = logRTParseConv(&p);
+		if (type == LOG_RT_ARG_NONE) {
+			pBuf[len++] = '%';
+			continue;
+		}
+
+		char spec[32];
+		U32 specLen = p - pSpec;
+		if (type == LOG_RT_ARG_UNSUPPORTED || i >= pRec->nArgs || specLen >= sizeof(spec)) {
+			len += snprintf(pBuf + len, bufSize - len, "%s", pSpec);
+			break;
+		}
+		memcpy(spec, pSpec, specLen);
+		spec[specLen] = '\0';
+
+		int n = logRTRenderArg(pBuf + len, bufSize - len, spec, pRec->argType[i], pRec, i);
+		i++;
+		if (n > 0)
+			len += n;
+	}
+
+	if (len > bufSize - 1)
+		len = bufSize - 1;
+	pBuf[len] = '\0';
+	return len;
+}
+
+static U32 logRTRenderHdr(char *pBuf, U32 bufSize, const log_rt_ring_t *pRing, const log_rt_rec_t *pRec)
+{
+	if (!pRec->tag) {
+		// AVB_LOGRT_* lines only carry the timestamp
+		return snprintf(pBuf, bufSize, "[%lu:%09lu] ", pRec->nowTS.tv_sec, pRec->nowTS.tv_nsec);
+	}
+
+	char rtTime[LOG_TIME_LEN] = "";
+	char rtTimestamp[LOG_TIMESTAMP_LEN] = "";
+	char rtFile[LOG_FILE_LEN] = "";
+	char rtProc[LOG_PROC_LEN] = "";
+	char rtThread[LOG_THREAD_LEN] = "";
+
+	if (OPENAVB_LOG_FILE_INFO && pRec->path) {
+		const char *file = strrchr(pRec->path, '/');
+		if (!file)
+			file = strrchr(pRec->path, '\\');
+		if (file)
+			file += 1;
+		else
+			file = pRec->path;
+		snprintf(rtFile, LOG_FILE_LEN, " %s:%d", file, pRec->line);
+	}
+	if (OPENAVB_LOG_PROC_INFO) {
+		snprintf(rtProc, LOG_PROC_LEN, " P:%5.5d", GET_PID());
+	}
+	if (OPENAVB_LOG_THREAD_INFO) {
+		snprintf(rtThread, LOG_THREAD_LEN, " T:%lu", __atomic_load_n(&pRing->thread, __ATOMIC_RELAXED));
+	}
+	if (OPENAVB_LOG_TIME_INFO) {
+		time_t tNow = pRec->nowTS.tv_sec;
+		struct tm tmNow;
+		localtime_r(&tNow, &tmNow);
+
+		snprintf(rtTime, LOG_TIME_LEN, "%2.2d:%2.2d:%2.2d", tmNow.tm_hour, tmNow.tm_min, tmNow.tm_sec);
+	}
+	if (OPENAVB_LOG_TIMESTAMP_INFO) {
+		snprintf(rtTimestamp, LOG_TIMESTAMP_LEN, "%lu:%09lu", pRec->nowTS.tv_sec, pRec->nowTS.tv_nsec);
+	}
+
+	return snprintf(pBuf, bufSize, "[%s%s%s%s %s %s%s] %s: ", rtTime, rtTimestamp, rtProc, rtThread, pRec->company, pRec->component, rtFile, pRec->tag);
+}
+
+static void logRTLineAdd(log_rt_ring_t *pRing, U32 len)
+{
+	pRing->lineLen += len;
+	if (pRing->lineLen > sizeof(pRing->lineMsg) - 1)
+		pRing->lineLen = sizeof(pRing->lineMsg) - 1;
+}
+
+static void logRTLineDone(log_rt_ring_t *pRing, char *pBuf, U32 bufSize)
+{
+	if (OPENAVB_TCAL_LOG_EXTRA_NEWLINE)
+		logRTLineAdd(pRing, snprintf(pRing->lineMsg + pRing->lineLen, sizeof(pRing->lineMsg) - pRing->lineLen, "\n"));
+	snprintf(pBuf, bufSize, "%s", pRing->lineMsg);
+	pRing->lineLen = 0;
+}
+
+// Render the next complete line from the RT rings into pBuf.
+// Returns FALSE if there is nothing to output. There must only be one caller at a time.
+static bool logRTRenderLine(char *pBuf, U32 bufSize)
+{
+	log_rt_ring_t *pRing;
+
+	for (pRing = __atomic_load_n(&logRTRings, __ATOMIC_ACQUIRE); pRing; pRing = pRing->pNext) {
+		U32 drops = __atomic_load_n(&pRing->drops, __ATOMIC_RELAXED);
+		if (drops != pRing->dropsReported) {
+			snprintf(pBuf, bufSize, "[RT log T:%lu] %u records dropped\n", __atomic_load_n(&pRing->thread, __ATOMIC_RELAXED), drops - pRing->dropsReported);
+			pRing->dropsReported = drops;
+			return TRUE;
+		}
+
+		U32 tail = pRing->tail;
+		while (tail != __atomic_load_n(&pRing->head, __ATOMIC_ACQUIRE)) {
+			log_rt_rec_t *pRec = &pRing->rec[tail & (LOG_RT_RING_CNT - 1)];
+
+			if (pRec->bBegin && pRing->lineLen) {
+				// The end of the previous line was dropped
+				logRTLineAdd(pRing, snprintf(pRing->lineMsg + pRing->lineLen, sizeof(pRing->lineMsg) - pRing->lineLen, "..."));
+				logRTLineDone(pRing, pBuf, bufSize);
+				return TRUE;
+			}
+
+			if (pRec->bBegin)
+				logRTLineAdd(pRing, logRTRenderHdr(pRing->lineMsg, sizeof(pRing->lineMsg), pRing, pRec));
+			if (pRec->pFormat)
+				logRTLineAdd(pRing, logRTRenderFmt(pRing->lineMsg + pRing->lineLen, sizeof(pRing->lineMsg) - pRing->lineLen, pRec));
+			bool bEnd = pRec->bEnd;
+
+			__atomic_store_n(&pRing->tail, ++tail, __ATOMIC_RELEASE);
+
+			if (bEnd) {
+				logRTLineDone(pRing, pBuf, bufSize);
+				return TRUE;
+			}
+		}
+	}
+	return FALSE;
+}
+
+// Without the logging thread the RT messages are output by the thread logging them
+static void logRTOutputDirect(void)
+{
+	if (!OPENAVB_LOG_FROM_THREAD && !OPENAVB_LOG_PULL_MODE) {
+		LOG_LOCK();
+		while (logRTRenderLine(rt_msg, sizeof(rt_msg)))
+			fputs(rt_msg, logOutputFd);
+		fflush(logOutputFd);
+		LOG_UNLOCK();
+	}
+}
+
 extern U32 DLL_EXPORT avbLogGetMsg(U8 *pBuf, U32 bufSize)
 {
 	U32 dataLen = 0;
@@ -153,9 +507,6 @@ extern U32 DLL_EXPORT avbLogGetMsg(U8 *pBuf, U32 bufSize)
 		if (elem) {
 			log_queue_item_t *pLogItem = (log_queue_item_t *)openavbQueueData(elem);
 			
-			if (pLogItem->bRT)
-				avbLogRTRender(pLogItem);
-			
 			dataLen = strlen((const char *)pLogItem->msg);
 			if (dataLen <= bufSize)
 				memcpy(pBuf, (U8 *)pLogItem->msg, dataLen);
@@ -165,6 +516,13 @@ extern U32 DLL_EXPORT avbLogGetMsg(U8 *pBuf, U32 bufSize)
 			return dataLen;
 		}
 	}
+
+	LOG_LOCK();
+	if (logRTRenderLine(rt_msg, sizeof(rt_msg))) {
+		dataLen = strlen(rt_msg);
+		memcpy(pBuf, (U8 *)rt_msg, dataLen <= bufSize ? dataLen : bufSize);
+	}
+	LOG_UNLOCK();
 	return dataLen;
 }
 
@@ -182,15 +540,16 @@ void *loggingThreadFn(void *pv)
 			if (elem) {
 				log_queue_item_t *pLogItem = (log_queue_item_t *)openavbQueueData(elem);
 
-				if (pLogItem->bRT)
-					avbLogRTRender(pLogItem);
-
 				fputs((const char *)pLogItem->msg, logOutputFd);
 				openavbQueueTailPull(logQueue);
 				more = TRUE;
 				flush = TRUE;
 			}
 		}
+		while (logRTRenderLine(rt_msg, sizeof(rt_msg))) {
+			fputs(rt_msg, logOutputFd);
+			flush = TRUE;
+		}
 		if (flush)
 			fflush(logOutputFd);
 	} while (loggingThreadRunning);
@@ -212,9 +571,11 @@ extern void DLL_EXPORT avbLogInitEx(FILE* file)
 		printf("Failed to initialize logging facility\n");
 	}
 	
-	logRTQueue = openavbQueueNewQueue(sizeof(log_rt_queue_item_t), LOG_RT_QUEUE_CNT);
-	if (!logRTQueue) {
-		printf("Failed to initialize logging RT facility\n");
+	if (!logRTInit) {
+		if (THREAD_KEY_CREATE(logRTRingKey, logRTRingRelease) == 0)
+			logRTInit = TRUE;
+		else
+			printf("Failed to initialize logging RT facility\n");
 	}
 
 	// Start the logging task
@@ -306,7 +667,6 @@ extern void DLL_EXPORT avbLogFn(
 				openavb_queue_elem_t elem = openavbQueueHeadLock(logQueue);
 				if (elem) {
 					log_queue_item_t *pLogItem = (log_queue_item_t *)openavbQueueData(elem);
-					pLogItem->bRT = FALSE;
 					strncpy((char *)pLogItem->msg, full_msg, LOG_QUEUE_MSG_LEN);
 					openavbQueueHeadPush(logQueue);
 				}
@@ -321,93 +681,108 @@ extern void DLL_EXPORT avbLogFn(
 
 extern void DLL_EXPORT avbLogRT(int level, bool bBegin, bool bItem, bool bEnd, char *pFormat, log_rt_datatype_t dataType, void *pVar)
 {
-	if (logRTQueue) {
-		if (bBegin) {
-			LOG_LOCK();
-
-			openavb_queue_elem_t elem = openavbQueueHeadLock(logRTQueue);
-			if (elem) {
-				log_rt_queue_item_t *pLogRTItem = (log_rt_queue_item_t *)openavbQueueData(elem);
-				pLogRTItem->bEnd = FALSE;
-				pLogRTItem->pFormat = NULL;
-				pLogRTItem->dataType = LOG_RT_DATATYPE_NOW_TS;
-				CLOCK_GETTIME(OPENAVB_CLOCK_REALTIME, &pLogRTItem->data.nowTS);
-				openavbQueueHeadPush(logRTQueue);
+	log_rt_ring_t *pRing = logRTRingGet();
+	if (!pRing)
+		return;
+
+	log_rt_rec_t *pRec = logRTRecGet(pRing, bBegin);
+	if (pRec) {
+		pRec->tag = NULL;
+		pRec->bBegin = bBegin;
+		pRec->bEnd = bEnd;
+		pRec->pFormat = NULL;
+		pRec->nArgs = 0;
+		if (bBegin)
+			CLOCK_GETTIME(OPENAVB_CLOCK_REALTIME, &pRec->nowTS);
+
+		if (bItem && pFormat) {
+			pRec->pFormat = pFormat;
+
+			// Store the value as the type the format expects
+			const char *p = strchr(pFormat, '%');
+			while (p && *++p == '%')
+				p = strchr(p + 1, '%');
+			log_rt_arg_t type = p ? logRTParseConv(&p) : LOG_RT_ARG_UNSUPPORTED;
+
+			if (type == LOG_RT_ARG_DOUBLE) {
+				if (dataType == LOG_RT_DATATYPE_FLOAT) {
+					pRec->arg[0].doubleVar = *(float *)pVar;
+					pRec->nArgs = 1;
+				}
 			}
-		}
-
-		if (bItem) {
-			openavb_queue_elem_t elem = openavbQueueHeadLock(logRTQueue);
-			if (elem) {
-				log_rt_queue_item_t *pLogRTItem = (log_rt_queue_item_t *)openavbQueueData(elem);
-				if (bEnd)
-					pLogRTItem->bEnd = TRUE;
-				else
-					pLogRTItem->bEnd = FALSE;
-				pLogRTItem->pFormat = pFormat;
-				pLogRTItem->dataType = dataType;
-
-				switch (pLogRTItem->dataType) {
-					case LOG_RT_DATATYPE_CONST_STR:
-						break;
+			else if (type != LOG_RT_ARG_PTR && type != LOG_RT_ARG_UNSUPPORTED) {
+				pRec->nArgs = 1;
+				switch (dataType) {
 					case LOG_RT_DATATYPE_U16:
-						pLogRTItem->data.unsignedLongVar = *(U16 *)pVar;
+						pRec->arg[0].intVar = *(U16 *)pVar;
 						break;
 					case LOG_RT_DATATYPE_S16:
-						pLogRTItem->data.signedLongVar = *(S16 *)pVar;
+						pRec->arg[0].intVar = (U64)(S64)*(S16 *)pVar;
 						break;
 					case LOG_RT_DATATYPE_U32:
-						pLogRTItem->data.unsignedLongVar = *(U32 *)pVar;
+						pRec->arg[0].intVar = *(U32 *)pVar;
 						break;
 					case LOG_RT_DATATYPE_S32:
-						pLogRTItem->data.signedLongVar = *(S32 *)pVar;
+						pRec->arg[0].intVar = (U64)(S64)*(S32 *)pVar;
 						break;
 					case LOG_RT_DATATYPE_U64:
-						pLogRTItem->data.unsignedLongLongVar = *(U64 *)pVar;
+						pRec->arg[0].intVar = *(U64 *)pVar;
 						break;
 					case LOG_RT_DATATYPE_S64:
-						pLogRTItem->data.signedLongLongVar = *(S64 *)pVar;
-						break;
-					case LOG_RT_DATATYPE_FLOAT:
-						pLogRTItem->data.floatVar = *(float *)pVar;
+						pRec->arg[0].intVar = (U64)*(S64 *)pVar;
 						break;
 					default:
+						pRec->nArgs = 0;
 						break;
 				}
-				openavbQueueHeadPush(logRTQueue);
 			}
+			pRec->argType[0] = type;
 		}
 
-		if (!bItem && bEnd) {
-			openavb_queue_elem_t elem = openavbQueueHeadLock(logRTQueue);
-			if (elem) {
-				log_rt_queue_item_t *pLogRTItem = (log_rt_queue_item_t *)openavbQueueData(elem);
-				pLogRTItem->bEnd = TRUE;
-				pLogRTItem->pFormat = NULL;
-				pLogRTItem->dataType = LOG_RT_DATATYPE_NONE;
-				openavbQueueHeadPush(logRTQueue);
-			}
-		}
+		logRTRecPush(pRing);
+	}
 
-		if (bEnd) {
-			if (logQueue) {
-				openavb_queue_elem_t elem = openavbQueueHeadLock(logQueue);
-				if (elem) {
-					log_queue_item_t *pLogItem = (log_queue_item_t *)openavbQueueData(elem);
-					pLogItem->bRT = TRUE;
-					if (OPENAVB_LOG_FROM_THREAD) {
-						openavbQueueHeadPush(logQueue);
-					} else {
-						avbLogRTRender(pLogItem);
-						fputs((const char *)pLogItem->msg, logOutputFd);
-						fflush(logOutputFd);
-						openavbQueueHeadUnlock(logQueue);
-					}
-				}
-			}
+	if (bEnd)
+		logRTOutputDirect();
+}
 
-			LOG_UNLOCK();
+extern void DLL_EXPORT avbLogRTFn(
+	int level,
+	const char *tag,
+	const char *company,
+	const char *component,
+	const char *path,
+	int line,
+	const char *fmt,
+	...)
+{
+	if (level <= AVB_LOG_LEVEL) {
+		log_rt_ring_t *pRing = logRTRingGet();
+		if (!pRing)
+			return;
+
+		log_rt_rec_t *pRec = logRTRecGet(pRing, TRUE);
+		if (pRec) {
+			va_list args;
+			va_start(args, fmt);
+
+			pRec->pFormat = fmt;
+			pRec->tag = tag;
+			pRec->company = company;
+			pRec->component = component;
+			pRec->path = path;
+			pRec->line = line;
+			pRec->bBegin = TRUE;
+			pRec->bEnd = TRUE;
+			CLOCK_GETTIME(OPENAVB_CLOCK_REALTIME, &pRec->nowTS);
+			logRTCaptureArgs(pRec, fmt, args);
+
+			va_end(args);
+
+			logRTRecPush(pRing);
 		}
+
+		logRTOutputDirect();
 	}
 }
 
@@ -69,6 +69,89 @@ int gptpdeinit(int *shm_fd, char **shm_map)
 	return ret;
 }
 
+/* Attempts at a lockless read before taking the mutex */
+#define GPTP_SEQLOCK_RETRIES 100
+
+/* Set once the mutex fallback has been reported, so it is reported once */
+static int gptp_warned_no_seq;
+static int gptp_warned_retries;
+
+static gPtpShmSeq *gptpshmseq(const char *shm_map)
+{
+	return (gPtpShmSeq *)(shm_map + GPTP_SHM_SEQ_OFFSET);
+}
+
+/**
+ * @brief Get the sequence number of the ptp data in IPC memory
+ * @param shm_map [in] Pointer to mapping
+ * @return The sequence number, which changes with every update and is odd
+ *	while an update is in progress. 0 if the writer doesn't keep one.
+ */
+
+uint32_t gptpsequence(const char *shm_map)
+{
+	if (NULL == shm_map) {
+		return 0;
+	}
+	gPtpShmSeq *shm_seq = gptpshmseq(shm_map);
+	if (__atomic_load_n(&shm_seq->magic, __ATOMIC_ACQUIRE) != GPTP_SHM_SEQLOCK_MAGIC) {
+		return 0;
+	}
+	return __atomic_load_n(&shm_seq->seq, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Read the ptp data from IPC memory, along with its sequence number.
+ *	Doesn't take the mutex if the writer keeps the sequence counter.
+ * @param shm_map [in] Pointer to mapping
+ * @param td [inout] Struct to read the data into
+ * @param seq [out] Sequence number of the data read, 0 if the writer doesn't keep one
+ * @return 0 for success, negative for failure
+ */
+
+int gptpgetdataseq(char *shm_map, gPtpTimeData *td, uint32_t *seq)
+{
+	int i;
+	uint32_t seq1, seq2;
+
+	if (NULL == shm_map || NULL == td || NULL == seq) {
+		return -1;
+	}
+
+	gPtpShmSeq *shm_seq = gptpshmseq(shm_map);
+	if (__atomic_load_n(&shm_seq->magic, __ATOMIC_ACQUIRE) == GPTP_SHM_SEQLOCK_MAGIC) {
+		for (i = 0; i < GPTP_SEQLOCK_RETRIES; i++) {
+			seq1 = __atomic_load_n(&shm_seq->seq, __ATOMIC_ACQUIRE);
+			if (seq1 & 1) {
+				/* Writer busy */
+				continue;
+			}
+			memcpy(td, shm_map + GPTP_SHM_DATA_OFFSET, sizeof(*td));
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+			seq2 = __atomic_load_n(&shm_seq->seq, __ATOMIC_RELAXED);
+			if (seq1 == seq2) {
+				*seq = seq1;
+				return 0;
+			}
+		}
+		if (!__atomic_exchange_n(&gptp_warned_retries, 1, __ATOMIC_RELAXED)) {
+			fprintf(stderr, "gPTP data changed during %d lockless reads, reading it under the mutex\n",
+				GPTP_SEQLOCK_RETRIES);
+		}
+	}
+	else if (!__atomic_exchange_n(&gptp_warned_no_seq, 1, __ATOMIC_RELAXED)) {
+		fprintf(stderr, "gPTP daemon doesn't write the data with gptpsetdata(), reading it under the mutex\n");
+	}
+
+	/* Old writer, or the data keeps changing under us */
+	pthread_mutex_lock((pthread_mutex_t *) shm_map);
+	memcpy(td, shm_map + GPTP_SHM_DATA_OFFSET, sizeof(*td));
+	*seq = gptpsequence(shm_map);
+	pthread_mutex_unlock((pthread_mutex_t *) shm_map);
+
+	return 0;
+}
+
 /**
  * @brief Read the ptp data from IPC memory
  * @param shm_map [in] Pointer to mapping
@@ -77,12 +160,35 @@ int gptpdeinit(int *shm_fd, char **shm_map)
  */
 
 int gptpgetdata(char *shm_map, gPtpTimeData *td)
+{
+	uint32_t seq;
+	return gptpgetdataseq(shm_map, td, &seq);
+}
+
+/**
+ * @brief Write the ptp data to IPC memory (gPTP daemon side). Takes the
+ *	mutex for readers that use it and updates the sequence counter for
+ *	lockless readers.
+ * @param shm_map [in] Pointer to mapping
+ * @param td [in] Data to write
+ * @return 0 for success, negative for failure
+ */
+
+int gptpsetdata(char *shm_map, const gPtpTimeData *td)
 {
 	if (NULL == shm_map || NULL == td) {
 		return -1;
 	}
+
+	gPtpShmSeq *shm_seq = gptpshmseq(shm_map);
+
 	pthread_mutex_lock((pthread_mutex_t *) shm_map);
-	memcpy(td, shm_map + sizeof(pthread_mutex_t), sizeof(*td));
+	uint32_t seq = __atomic_load_n(&shm_seq->seq, __ATOMIC_RELAXED);
+	__atomic_store_n(&shm_seq->seq, seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	memcpy(shm_map + GPTP_SHM_DATA_OFFSET, td, sizeof(*td));
+	__atomic_store_n(&shm_seq->seq, seq + 2, __ATOMIC_RELEASE);
+	__atomic_store_n(&shm_seq->magic, GPTP_SHM_SEQLOCK_MAGIC, __ATOMIC_RELEASE);
 	pthread_mutex_unlock((pthread_mutex_t *) shm_map);
 
 	return 0;
@@ -3,7 +3,6 @@
 
 #include <inttypes.h>
 
-#define SHM_SIZE (4*8 + sizeof(pthread_mutex_t)) /* 3 - 64 bit and 2 - 32 bits */
 #define SHM_NAME  "/ptp"
 
 typedef long double FrequencyRatio;
@@ -35,6 +34,29 @@ typedef struct {
 	uint16_t port_number;					/* The portNumber field of the interface, or 0x0000 if not supported */
 } gPtpTimeData;
 
+/*
+ * Shared memory layout: the pthread mutex, the gPtpTimeData, then a
+ * sequence counter for lockless readers. A writer that keeps the counter
+ * sets magic to GPTP_SHM_SEQLOCK_MAGIC and makes seq odd while it updates
+ * the data. Readers fall back to the mutex when the magic isn't there, so
+ * old writers (which only know the mutex and data) keep working.
+ *
+ * The lockless path needs a gPTP daemon that writes the data with
+ * gptpsetdata(). The daemon is not part of this tree (it is the
+ * daemons/gptp submodule). Until it calls gptpsetdata(), every read takes
+ * the mutex, and gptpgetdataseq() says so once on stderr.
+ */
+typedef struct {
+	uint32_t magic;
+	uint32_t seq;
+} gPtpShmSeq;
+
+#define GPTP_SHM_SEQLOCK_MAGIC 0x67505451
+
+#define GPTP_SHM_DATA_OFFSET (sizeof(pthread_mutex_t))
+#define GPTP_SHM_SEQ_OFFSET ((GPTP_SHM_DATA_OFFSET + sizeof(gPtpTimeData) + 7) & ~(size_t)7)
+#define SHM_SIZE (GPTP_SHM_SEQ_OFFSET + sizeof(gPtpShmSeq))
+
 /*TODO fix this*/
 #ifndef false
 typedef enum { false = 0, true = 1 } bool;
@@ -43,6 +65,9 @@ typedef enum { false = 0, true = 1 } bool;
 int gptpinit(int *shm_fd, char **shm_map);
 int gptpdeinit(int *shm_fd, char **shm_map);
 int gptpgetdata(char *shm_mmap, gPtpTimeData *td);
+int gptpgetdataseq(char *shm_mmap, gPtpTimeData *td, uint32_t *seq);
+uint32_t gptpsequence(const char *shm_mmap);
+int gptpsetdata(char *shm_mmap, const gPtpTimeData *td);
 int gptpscaling(char *shm_mmap, gPtpTimeData *td);
 bool gptplocaltime(const gPtpTimeData * td, uint64_t* now_local);
 bool gptpmaster2local(const gPtpTimeData *td, const uint64_t master, uint64_t *local);